@@ -0,0 +1,426 @@
+#include <time.h>
+#include <zlib.h>
+
+#include "blocking_queue.hxx"
+#include "stage_profile.hxx"
+#include "test_helpers.hxx"
+
+import std;
+import moirai.app;
+import moirai.http;
+import moirai.json_utils;
+import moirai.search_document;
+import moirai.search_writer;
+import moirai.solver_wrapper;
+
+// Runs loads through the whole pipeline at full speed: an in-memory source in
+// place of FileReader, solver threads over the test fixture graph, and search
+// writers posting to an in-process OpenSearch stand-in. Latency runs from the
+// moment a load is handed to the load queue to the moment the _bulk request
+// carrying its document is answered, so under saturation it includes the time
+// spent waiting in the queues.
+//
+// CPU time is reported twice: per thread role, where whatever the process
+// spent outside the named threads is the fan-out pool, and per stage from the
+// StageTimer totals, which also count the pool and prefetcher threads.
+
+namespace {
+
+constexpr std::string_view LOAD_ID_PREFIX = "bench-";
+constexpr std::size_t SOURCE_BATCH = 256;
+constexpr std::size_t PIPELINE_QUEUE_CAPACITY = 4096;
+constexpr std::size_t WAYBILLS_PER_BAG = 4;
+
+using Clock = std::chrono::steady_clock;
+
+auto env_size(const char* name, std::size_t fallback, bool allow_zero = false)
+    -> std::size_t {
+  const char* value = std::getenv(name);
+  if (value == nullptr || std::string_view{value}.empty()) {
+    return fallback;
+  }
+  std::size_t parsed{};
+  const std::string_view input{value};
+  const auto [ptr, error] =
+    std::from_chars(input.data(), input.data() + input.size(), parsed);
+  if (error != std::errc{} || ptr != input.data() + input.size() ||
+      (!allow_zero && parsed == 0)) {
+    throw std::runtime_error(std::format("Invalid {} value '{}'", name, input));
+  }
+  return parsed;
+}
+
+auto cpu_time(clockid_t clock) -> std::chrono::nanoseconds {
+  timespec now{};
+  ::clock_gettime(clock, &now);
+  return std::chrono::seconds{now.tv_sec} + std::chrono::nanoseconds{now.tv_nsec};
+}
+
+auto thread_cpu_time() -> std::chrono::nanoseconds {
+  return cpu_time(CLOCK_THREAD_CPUTIME_ID);
+}
+
+auto milliseconds(std::chrono::nanoseconds elapsed) -> double {
+  return static_cast<double>(elapsed.count()) / 1e6;
+}
+
+// CPU time summed over the threads of one pipeline stage.
+struct StageCpu {
+  std::atomic<std::int64_t> nanoseconds{0};
+
+  void add(std::chrono::nanoseconds elapsed) {
+    nanoseconds.fetch_add(elapsed.count(), std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] auto milliseconds() const -> double {
+    return ::milliseconds(std::chrono::nanoseconds{nanoseconds.load()});
+  }
+};
+
+// Loads from A to C on the fixture graph, with start times spread over a
+// morning so the path cache sees more than one interval. Every fourth load is
+// a bag of waybills.
+auto make_loads(std::size_t count) -> std::vector<std::string> {
+  std::vector<std::string> loads;
+  loads.reserve(count);
+  for (std::size_t index = 0; index < count; ++index) {
+    const auto minute = index % 480;
+    const auto time =
+      std::format("2026-06-08 {:02}:{:02}:00", minute / 60, minute % 60);
+    std::string load = std::format(
+      R"({{"id":"{}{}","location":"A","destination":"C","time":"{}",)"
+      R"("ipdd_destination":"2026-06-09 00:00:00","cs_slid":"SLID",)"
+      R"("cs_act":"ACT","pid":"PID")",
+      LOAD_ID_PREFIX, index, time);
+    if (index % 4 == 3) {
+      load += R"(,"items":[)";
+      for (std::size_t waybill = 0; waybill < WAYBILLS_PER_BAG; ++waybill) {
+        load += std::format(
+          R"({}{{"id":"{}{}-{}","cn":"D","ipdd_destination":"2026-06-09 12:00:00"}})",
+          waybill == 0 ? "" : ",", LOAD_ID_PREFIX, index, waybill);
+      }
+      load += "]";
+    }
+    load += "}";
+    loads.push_back(moirai::make_padded_payload(load));
+  }
+  return loads;
+}
+
+// The load a document id was generated from: bench-<load>[-<waybill>].
+auto load_index(std::string_view id) -> std::optional<std::size_t> {
+  if (!id.starts_with(LOAD_ID_PREFIX)) {
+    return std::nullopt;
+  }
+  id.remove_prefix(LOAD_ID_PREFIX.size());
+  std::size_t index{};
+  const auto [ptr, error] =
+    std::from_chars(id.data(), id.data() + id.size(), index);
+  if (error != std::errc{}) {
+    return std::nullopt;
+  }
+  return index;
+}
+
+auto gunzip(std::string_view input, std::string& output) -> bool {
+  z_stream stream{};
+  if (inflateInit2(&stream, MAX_WBITS + 16) != Z_OK) {
+    return false;
+  }
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+  stream.avail_in = static_cast<uInt>(input.size());
+  output.clear();
+  int result = Z_OK;
+  while (result == Z_OK) {
+    const auto previous_size = output.size();
+    output.resize(previous_size + std::max<std::size_t>(input.size() * 4, 4096));
+    stream.next_out = reinterpret_cast<Bytef*>(output.data() + previous_size);
+    stream.avail_out = static_cast<uInt>(output.size() - previous_size);
+    result = inflate(&stream, Z_NO_FLUSH);
+    output.resize(output.size() - stream.avail_out);
+  }
+  inflateEnd(&stream);
+  return result == Z_STREAM_END;
+}
+
+// Stands in for OpenSearch behind one search writer. The index does not exist
+// at first, so the writer creates it; every _bulk request is answered after
+// `latency` with one created item per document, and each document's latency
+// is taken against when its load was enqueued.
+class FakeSearch {
+public:
+  FakeSearch(const std::vector<Clock::time_point>& enqueued,
+             std::chrono::milliseconds latency)
+    : m_enqueued(enqueued), m_latency(latency) {}
+
+  auto operator()(std::string_view method, const moirai::Uri& uri,
+                  std::string_view body,
+                  const std::vector<std::string>& headers)
+      -> moirai::HttpResponse {
+    (void)uri;
+    (void)headers;
+    if (method == "HEAD") {
+      return {.status_code = 404, .body = {}};
+    }
+    if (method != "POST") {
+      return {.status_code = 200, .body = R"({"acknowledged":true})"};
+    }
+
+    const auto cpu_started = thread_cpu_time();
+    std::string_view bulk = body;
+    if (body.starts_with("\x1f\x8b")) {
+      if (!gunzip(body, m_inflated)) {
+        return {.status_code = 400, .body = R"({"error":"bad gzip"})"};
+      }
+      bulk = m_inflated;
+    }
+
+    std::vector<std::size_t> loads;
+    std::size_t items = 0;
+    std::string response = std::format(
+      R"({{"took":{},"errors":false,"items":[)", m_latency.count());
+    bool action = true;
+    for (const auto line : std::views::split(bulk, '\n')) {
+      const std::string_view text(line.begin(), line.end());
+      if (text.empty()) {
+        continue;
+      }
+      if (std::exchange(action, !action)) {
+        constexpr std::string_view ID_FIELD = R"("_id":")";
+        const auto start = text.find(ID_FIELD);
+        const auto id = start == std::string_view::npos
+                          ? std::string_view{}
+                          : text.substr(start + ID_FIELD.size(),
+                                        text.find('"', start + ID_FIELD.size()) -
+                                          start - ID_FIELD.size());
+        if (const auto load = load_index(id); load.has_value()) {
+          loads.push_back(*load);
+        }
+        response += std::format(
+          R"({}{{"index":{{"_index":"moirai-bench","_id":"{}","_version":1,)"
+          R"("result":"created","_shards":{{"total":2,"successful":2,)"
+          R"("failed":0}},"_seq_no":{},"_primary_term":1,"status":201}}}})",
+          items++ == 0 ? "" : ",", id, m_documents);
+        ++m_documents;
+      }
+    }
+    response += "]}";
+    m_cpu += thread_cpu_time() - cpu_started;
+
+    std::this_thread::sleep_for(m_latency);
+    const auto answered = Clock::now();
+    for (const auto load : loads) {
+      if (load < m_enqueued.size()) {
+        m_latencies.push_back(answered - m_enqueued[load]);
+        m_loads.push_back(load);
+      }
+    }
+    return {.status_code = 200, .body = std::move(response)};
+  }
+
+  [[nodiscard]] auto latencies() const -> const std::vector<Clock::duration>& {
+    return m_latencies;
+  }
+  [[nodiscard]] auto loads() const -> const std::vector<std::size_t>& {
+    return m_loads;
+  }
+  [[nodiscard]] auto cpu() const -> std::chrono::nanoseconds { return m_cpu; }
+
+private:
+  const std::vector<Clock::time_point>& m_enqueued;
+  std::chrono::milliseconds m_latency;
+  std::string m_inflated;
+  std::uint64_t m_documents{0};
+  std::vector<Clock::duration> m_latencies;
+  std::vector<std::size_t> m_loads;
+  std::chrono::nanoseconds m_cpu{};
+};
+
+auto percentile_ms(const std::vector<Clock::duration>& sorted, double rank)
+    -> double {
+  if (sorted.empty()) {
+    return 0.0;
+  }
+  const auto index = std::min(
+    sorted.size() - 1,
+    static_cast<std::size_t>(rank * static_cast<double>(sorted.size())));
+  return std::chrono::duration<double, std::milli>(sorted[index]).count();
+}
+
+} // namespace
+
+auto main() -> int {
+  auto& app = moirai::Application::instance();
+  app.logger().set_level("error");
+
+  const auto load_count = env_size("MOIRAI_BENCH_PIPELINE_LOADS", 20'000);
+  const auto solver_threads =
+    env_size("MOIRAI_BENCH_PIPELINE_SOLVERS",
+             std::max(3U, std::thread::hardware_concurrency()) - 2);
+  const auto writer_threads = env_size("MOIRAI_BENCH_PIPELINE_WRITERS", 2);
+  const auto latency = std::chrono::milliseconds{
+    env_size("MOIRAI_BENCH_BULK_LATENCY_MS", 20, true)};
+
+  auto loads = make_loads(load_count);
+  std::vector<Clock::time_point> enqueued(load_count);
+
+  BlockingQueue<std::string> node_queue{1};
+  BlockingQueue<std::string> edge_queue{1};
+  BlockingQueue<std::string> load_queue{PIPELINE_QUEUE_CAPACITY};
+  BlockingQueue<SearchDocument> solution_queue{PIPELINE_QUEUE_CAPACITY};
+
+  const auto timings = moirai_tests::fixture_path("timings.json");
+  SolverWrapper wrapper(
+    SolverWrapper::RuntimeQueues{.node = &node_queue,
+                                 .edge = &edge_queue,
+                                 .load = &load_queue,
+                                 .solution = &solution_queue},
+    moirai_tests::endpoints(),
+    timings,
+    moirai_tests::default_fake_http());
+  std::vector<std::unique_ptr<SolverWrapper>> solvers;
+  for (std::size_t index = 1; index < solver_threads; ++index) {
+    solvers.push_back(std::make_unique<SolverWrapper>(
+      SolverWrapper::RuntimeQueues{.node = nullptr,
+                                   .edge = nullptr,
+                                   .load = &load_queue,
+                                   .solution = &solution_queue},
+      wrapper.get_solver(),
+      timings,
+      wrapper.shared_state()));
+  }
+
+  auto index_config = SearchIndexConfig::from_environment();
+  index_config.metrics_interval = std::chrono::seconds{0};
+  std::vector<std::unique_ptr<FakeSearch>> sinks;
+  std::vector<std::unique_ptr<SearchWriter>> writers;
+  for (std::size_t index = 0; index < writer_threads; ++index) {
+    auto* sink =
+      sinks.emplace_back(std::make_unique<FakeSearch>(enqueued, latency)).get();
+    writers.push_back(std::make_unique<SearchWriter>(
+      moirai::parse_uri("http://search.bench:9200"),
+      "bench",
+      "bench",
+      "moirai-bench",
+      &solution_queue,
+      index_config,
+      [sink](std::string_view method,
+             const moirai::Uri& uri,
+             std::string_view body,
+             const std::vector<std::string>& headers) {
+        return (*sink)(method, uri, body, headers);
+      }));
+  }
+
+  StageProfile::enable(true);
+  StageCpu source_cpu;
+  StageCpu solve_cpu;
+  StageCpu write_cpu;
+  StageCpu prefetch_cpu;
+  std::atomic<std::size_t> active_solvers{solver_threads};
+  const auto process_started = cpu_time(CLOCK_PROCESS_CPUTIME_ID);
+  const auto started = Clock::now();
+  {
+    // Stops once the source closes the load queue.
+    const std::jthread prefetcher([&](const std::stop_token& stop_token) {
+      wrapper.run_prefetcher(stop_token);
+      prefetch_cpu.add(thread_cpu_time());
+    });
+    std::vector<std::jthread> threads;
+    threads.emplace_back([&] {
+      for (std::size_t begin = 0; begin < loads.size();
+           begin += SOURCE_BATCH) {
+        const auto count = std::min(SOURCE_BATCH, loads.size() - begin);
+        std::fill_n(enqueued.begin() + static_cast<std::ptrdiff_t>(begin),
+                    count,
+                    Clock::now());
+        (void)load_queue.wait_enqueue_bulk(
+          std::span(loads).subspan(begin, count));
+      }
+      load_queue.close();
+      source_cpu.add(thread_cpu_time());
+    });
+
+    for (std::size_t index = 0; index < solver_threads; ++index) {
+      auto* solver = index == 0 ? &wrapper : solvers[index - 1].get();
+      threads.emplace_back([&, solver] {
+        solver->run(std::stop_token{});
+        solve_cpu.add(thread_cpu_time());
+        if (active_solvers.fetch_sub(1) == 1) {
+          solution_queue.close();
+        }
+      });
+    }
+    for (const auto& writer : writers) {
+      threads.emplace_back([&write_cpu, writer = writer.get()] {
+        writer->run(std::stop_token{});
+        write_cpu.add(thread_cpu_time());
+      });
+    }
+  }
+  const auto elapsed = std::chrono::duration<double>(Clock::now() - started);
+  const auto process_ms =
+    milliseconds(cpu_time(CLOCK_PROCESS_CPUTIME_ID) - process_started);
+
+  std::vector<Clock::duration> latencies;
+  std::vector<std::size_t> acknowledged;
+  std::chrono::nanoseconds sink_cpu{};
+  for (const auto& sink : sinks) {
+    latencies.insert(
+      latencies.end(), sink->latencies().begin(), sink->latencies().end());
+    acknowledged.insert(
+      acknowledged.end(), sink->loads().begin(), sink->loads().end());
+    sink_cpu += sink->cpu();
+  }
+  std::ranges::sort(latencies);
+  std::ranges::sort(acknowledged);
+  const auto documents = acknowledged.size();
+  acknowledged.erase(std::ranges::unique(acknowledged).begin(),
+                     acknowledged.end());
+  const auto loads_acknowledged = acknowledged.size();
+
+  // Writer threads also run the stand-in, whose CPU time is reported apart.
+  const auto sink_ms = milliseconds(sink_cpu);
+  const auto write_ms = write_cpu.milliseconds() - sink_ms;
+  const auto pool_ms =
+    std::max(process_ms - source_cpu.milliseconds() - solve_cpu.milliseconds() -
+               write_cpu.milliseconds() - prefetch_cpu.milliseconds(),
+             0.0);
+  const auto stage_ms = [](PipelineStage stage) {
+    return milliseconds(StageProfile::total(stage));
+  };
+  std::println(
+    "pipeline: loads={} documents={} solvers={} writers={} "
+    "bulk_latency_ms={} seconds={:.3f} loads_per_sec={:.0f} "
+    "documents_per_sec={:.0f}",
+    load_count, documents, solver_threads, writer_threads, latency.count(),
+    elapsed.count(), static_cast<double>(load_count) / elapsed.count(),
+    static_cast<double>(documents) / elapsed.count());
+  std::println(
+    "pipeline-cpu: process_ms={:.1f} source_ms={:.1f} solve_ms={:.1f} "
+    "pool_ms={:.1f} prefetch_ms={:.1f} write_ms={:.1f} sink_ms={:.1f} "
+    "solve_us_per_load={:.2f} write_us_per_document={:.2f}",
+    process_ms, source_cpu.milliseconds(), solve_cpu.milliseconds(), pool_ms,
+    prefetch_cpu.milliseconds(), write_ms, sink_ms,
+    (solve_cpu.milliseconds() + pool_ms) * 1e3 /
+      static_cast<double>(std::max<std::size_t>(load_count, 1)),
+    write_ms * 1e3 / static_cast<double>(std::max<std::size_t>(documents, 1)));
+  std::println(
+    "pipeline-stages: decode_ms={:.1f} document_ms={:.1f} "
+    "find_paths_ms={:.1f} prefetch_ms={:.1f} serialize_ms={:.1f} "
+    "bulk_assembly_ms={:.1f} gzip_ms={:.1f}",
+    stage_ms(PipelineStage::decode), stage_ms(PipelineStage::document),
+    stage_ms(PipelineStage::find_paths), stage_ms(PipelineStage::prefetch),
+    stage_ms(PipelineStage::serialize), stage_ms(PipelineStage::bulk_assembly),
+    stage_ms(PipelineStage::gzip));
+  std::println("pipeline-latency: p50_ms={:.2f} p99_ms={:.2f} max_ms={:.2f}",
+               percentile_ms(latencies, 0.50), percentile_ms(latencies, 0.99),
+               percentile_ms(latencies, 1.0));
+
+  if (loads_acknowledged != load_count) {
+    std::println(std::cerr, "pipeline: only {} of {} loads reached the sink",
+                 loads_acknowledged, load_count);
+    return 1;
+  }
+  return 0;
+}
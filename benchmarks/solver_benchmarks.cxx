@@ -1,10 +1,18 @@
 #include <nlohmann/json.hpp>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "blocking_queue.hxx"
+#include "concurrent_cache.hxx"
 
 import std;
 import moirai.date_utils;
 import moirai.json_utils;
+import moirai.load_capture;
+import moirai.load_payload;
 import moirai.route_schedule;
 import moirai.solver;
+import moirai.solver_wrapper;
 import moirai.transportation;
 
 #ifndef MOIRAI_TEST_FIXTURE_DIR
@@ -283,6 +291,17 @@ auto make_load_queries(const Solver& solver, const std::filesystem::path& fixtur
     }
   };
 
+  if (moirai::is_load_capture(fixture)) {
+    moirai::LoadCaptureReader capture(fixture);
+    while (const auto record = capture.next()) {
+      auto parsed = moirai::parse_json(std::string(record->payload));
+      if (parsed.has_value()) {
+        extract_from_record(*parsed);
+      }
+    }
+    return queries;
+  }
+
   if (fixture.extension() == ".jsonl") {
     std::string line;
     while (std::getline(input, line)) {
@@ -443,6 +462,67 @@ auto run_suite(std::string_view name, const BenchmarkGraph& graph) -> bool {
   return passed;
 }
 
+// Replays loads through find_paths on `threads` solver threads sharing one
+// path cache, the way the server runs them. Threads take loads in file order,
+// so a burst of loads for one hub pair misses on several threads at once.
+// Returns the number of solves behind the cache.
+auto replay_loads(const BenchmarkGraph& graph,
+                  std::span<const LoadQuery> queries, unsigned threads,
+                  bool coalesce) -> std::uint64_t {
+  static const auto timings_path = [] {
+    auto path = std::filesystem::temp_directory_path() /
+                "moirai-bench-empty-timings.json";
+    std::ofstream(path) << "[]";
+    return path;
+  }();
+  static BlockingQueue<std::string> load_queue;
+  static BlockingQueue<SearchDocument> solution_queue;
+  const SolverWrapper::RuntimeQueues queues{
+      .node = nullptr,
+      .edge = nullptr,
+      .load = &load_queue,
+      .solution = &solution_queue,
+  };
+
+  ::setenv("MOIRAI_PATH_CACHE_INFLIGHT_TIMEOUT_MS", coalesce ? "100" : "0", 1);
+  auto cache = std::make_shared<PathCache>(65'536);
+  std::atomic<std::size_t> next{0};
+  const auto started = std::chrono::steady_clock::now();
+  {
+    std::vector<std::jthread> workers;
+    workers.reserve(threads);
+    for (unsigned worker = 0; worker < threads; ++worker) {
+      workers.emplace_back([&] {
+        SolverWrapper wrapper(queues, graph.solver, timings_path,
+                              {.path_cache = cache});
+        std::vector<std::tuple<std::string, std::int32_t, std::string>>
+            packages;
+        for (auto index = next.fetch_add(1); index < queries.size();
+             index = next.fetch_add(1)) {
+          const auto& query = queries[index];
+          (void)wrapper.find_paths(
+              std::format("replay-{}", index),
+              graph.solver->get_node(query.source)->code,
+              graph.solver->get_node(query.target)->code,
+              static_cast<std::int32_t>(query.start.time_since_epoch().count()),
+              DURATION{0}, query.start + CLOCK::duration{3 * 24 * 60},
+              DURATION{0}, packages);
+        }
+      });
+    }
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - started;
+  const auto solves = cache->solves.load();
+  const auto inflight = cache->inflight.metrics();
+  std::println(
+      "load-replay: threads={} coalesce={} loads={} solves={} "
+      "coalesced_waits={} coalesce_timeouts={} ms={}",
+      threads, coalesce, queries.size(), solves, inflight.coalesced_waits,
+      inflight.timeouts,
+      std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+  return solves;
+}
+
 auto run_production_fixture_suite() -> bool {
   const char* routes_fixture = std::getenv("MOIRAI_BENCH_ROUTES_FIXTURE");
   if (routes_fixture == nullptr || std::string_view{routes_fixture}.empty()) {
@@ -479,8 +559,464 @@ auto run_production_fixture_suite() -> bool {
           ->find_path<PathTraversalMode::FORWARD, VehicleType::SURFACE>(
             query.source, query.target, query.start);
       });
+
+      // One thread cannot duplicate a solve, so its count is the baseline.
+      const auto threads = std::max(4U, std::thread::hardware_concurrency());
+      const auto baseline = replay_loads(graph, queries, 1, true);
+      const auto uncoalesced = replay_loads(graph, queries, threads, false);
+      const auto coalesced = replay_loads(graph, queries, threads, true);
+      std::println("load-replay: duplicate_solves uncoalesced={} coalesced={}",
+                   static_cast<std::int64_t>(uncoalesced - baseline),
+                   static_cast<std::int64_t>(coalesced - baseline));
+    }
+  }
+  return passed;
+}
+
+// Hammers a path cache from 32 solver threads with a skewed query mix (most
+// lookups on a small set of hub pairs), inserting on miss the way find_paths
+// does. `lookup` returns whether the key hit.
+template <typename Lookup>
+auto run_cache_contention(std::string_view name, double max_ns_per_op,
+                          Lookup&& lookup) -> std::pair<bool, double> {
+  constexpr int THREADS = 32;
+  constexpr int LOOKUPS_PER_THREAD = 100'000;
+  std::atomic<std::uint64_t> hits{0};
+  const auto started = std::chrono::steady_clock::now();
+  {
+    std::vector<std::jthread> workers;
+    workers.reserve(THREADS);
+    for (int worker = 0; worker < THREADS; ++worker) {
+      workers.emplace_back([&, worker] {
+        std::mt19937 random(static_cast<std::uint32_t>(worker));
+        std::uniform_int_distribution<std::uint32_t> percent(0, 99);
+        std::uniform_int_distribution<std::uint32_t> hub(0, 511);
+        std::uniform_int_distribution<std::uint32_t> tail(0, 49'999);
+        std::uint64_t local_hits = 0;
+        for (int index = 0; index < LOOKUPS_PER_THREAD; ++index) {
+          const auto pair = percent(random) < 90 ? hub(random) : tail(random);
+          const auto bucket = static_cast<std::uint32_t>(29'600'000 + pair % 7);
+          local_hits += lookup(static_cast<NodeId>(pair % 1024),
+                               static_cast<NodeId>(pair / 1024), bucket)
+                            ? 1U
+                            : 0U;
+        }
+        hits.fetch_add(local_hits, std::memory_order_relaxed);
+      });
+    }
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - started;
+  const auto total_ops = static_cast<double>(THREADS) * LOOKUPS_PER_THREAD;
+  const auto ns_per_op =
+      static_cast<double>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+              .count()) *
+      THREADS / total_ops;
+  std::println("{}: threads={} ns/op={} hit_ratio={}", name, THREADS,
+               ns_per_op, static_cast<double>(hits.load()) / total_ops);
+  if (ns_per_op > max_ns_per_op) {
+    std::println(std::cerr, "{}: exceeded {} ns/op ceiling", name,
+                 max_ns_per_op);
+    return {false, ns_per_op};
+  }
+  return {true, ns_per_op};
+}
+
+auto run_cache_contention_benchmarks() -> bool {
+  const PathCacheEntry value{.found = true};
+
+  ConcurrentCache<PathCacheEntry> string_cache(65'536);
+  const auto [string_passed, string_ns] = run_cache_contention(
+      "path-cache-string-keys", 20'000.0,
+      [&](NodeId source, NodeId target, std::uint32_t bucket) {
+        auto key = std::format("{}:{}:{}:{}", "F:S", source, target, bucket);
+        if (string_cache.find(key) != nullptr) {
+          return true;
+        }
+        string_cache.insert(std::move(key), value);
+        return false;
+      });
+
+  // The packed cache keys by pair and keeps one interval per query time, the
+  // way find_paths uses it.
+  PathCache packed_cache(65'536);
+  const auto [packed_passed, packed_ns] = run_cache_contention(
+      "path-cache-packed-keys", 5'000.0,
+      [&](NodeId source, NodeId target, std::uint32_t bucket) {
+        const auto key = make_path_cache_key(
+            PathTraversalMode::FORWARD, VehicleType::SURFACE, source, target);
+        const auto query = CLOCK{CLOCK::duration{bucket}};
+        if (packed_cache.visit(*key, [&](const PathCacheIntervals& intervals) {
+              return find_path_interval(intervals, query) != nullptr;
+            })) {
+          return true;
+        }
+        const PathCacheInterval interval{
+            .valid_from = query,
+            .valid_until = query,
+            .solved_at = query,
+            .entry = value,
+        };
+        packed_cache.update(*key, [&](const PathCacheIntervals* current) {
+          return merge_path_interval(current, interval,
+                                     PathTraversalMode::FORWARD);
+        });
+        return false;
+      });
+
+  std::println("path-cache-contention: packed speedup={}x",
+               string_ns / packed_ns);
+  return string_passed && packed_passed;
+}
+
+// What one handoff did: whether the load decoded, and the payload bytes
+// copied on the way from the broker buffer to the decoder.
+struct HandoffResult {
+  bool decoded{false};
+  std::size_t copied_bytes{0};
+};
+
+// Kafka -> load queue -> solver handoff for one payload. The legacy path
+// copies the broker buffer into a string, copies that into the queue and has
+// the decoder copy it again into a padded buffer; the padded path copies once
+// and decodes where the bytes landed. Copies are observed, not assumed: the
+// queue hop counts when the dequeued string's bytes moved, and the decoder's
+// copies come from decode_copied_bytes().
+template <typename Handoff>
+auto run_payload_handoff(std::string_view name, std::string_view buffer,
+                         Handoff&& handoff) -> double {
+  constexpr int MESSAGES = 20'000;
+  BlockingQueue<std::string> queue;
+  std::array<std::string, 1> dequeued;
+  std::size_t objects = 0;
+  std::size_t copied_bytes = 0;
+  const auto started = std::chrono::steady_clock::now();
+  for (int index = 0; index < MESSAGES; ++index) {
+    const auto result = handoff(queue, dequeued);
+    objects += result.decoded ? 1U : 0U;
+    copied_bytes += result.copied_bytes;
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - started;
+  const auto ns_per_message =
+      static_cast<double>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+              .count()) /
+      MESSAGES;
+  std::println("{}: payload_bytes={} copied_bytes_per_message={} "
+               "ns/message={} parsed={}",
+               name, buffer.size(), copied_bytes / MESSAGES, ns_per_message,
+               objects);
+  return ns_per_message;
+}
+
+auto run_payload_handoff_benchmarks() -> bool {
+  std::string buffer = R"({"id":"bench-load","location":"A","destination":"B",)"
+                       R"("time":"2026-06-08 08:00:00","items":[)";
+  for (int index = 0; index < 200; ++index) {
+    buffer += std::format(
+        R"({}{{"id":"wb-{}","cn":"B","ipdd_destination":"2026-06-10 18:00:00"}})",
+        index == 0 ? "" : ",", index);
+  }
+  buffer += "]}";
+
+  std::vector<moirai::LoadItem> items;
+  // The string built from the broker buffer is always a copy; the queue hop
+  // and the decoder are measured.
+  const auto deliver = [&](BlockingQueue<std::string>& queue,
+                           std::array<std::string, 1>& dequeued,
+                           const char* produced) {
+    (void)queue.wait_dequeue_bulk(std::span(dequeued), std::stop_token{});
+    HandoffResult result{.decoded = false, .copied_bytes = buffer.size()};
+    if (dequeued[0].data() != produced) {
+      result.copied_bytes += dequeued[0].size();
+    }
+    const auto decoder_before = moirai::decode_copied_bytes();
+    result.decoded = moirai::decode_load(dequeued[0], items).has_value();
+    result.copied_bytes += moirai::decode_copied_bytes() - decoder_before;
+    return result;
+  };
+  const auto legacy_ns = run_payload_handoff(
+      "payload-handoff-legacy", buffer,
+      [&](BlockingQueue<std::string>& queue,
+          std::array<std::string, 1>& dequeued) {
+        const std::string data(buffer);
+        (void)queue.wait_enqueue(data);
+        return deliver(queue, dequeued, data.data());
+      });
+  const auto padded_ns = run_payload_handoff(
+      "payload-handoff-padded", buffer,
+      [&](BlockingQueue<std::string>& queue,
+          std::array<std::string, 1>& dequeued) {
+        auto payload = moirai::make_padded_payload(buffer);
+        const char* produced = payload.data();
+        (void)queue.wait_enqueue(std::move(payload));
+        return deliver(queue, dequeued, produced);
+      });
+  std::println("payload-handoff: padded speedup={}x", legacy_ns / padded_ns);
+  return true;
+}
+
+// Solver-side decode of one load: the DOM path builds a tape for the whole
+// payload, looks each field up and copies it out; the on-demand path walks the
+// object once and keeps views. Both visit every waybill.
+template <typename Decode>
+auto run_load_decode(std::string_view name,
+                     const std::vector<std::string>& payloads, Decode&& decode)
+    -> double {
+  constexpr std::size_t DECODES = 50'000;
+  std::size_t fields = 0;
+  const auto started = std::chrono::steady_clock::now();
+  for (std::size_t index = 0; index < DECODES; ++index) {
+    fields += decode(payloads[index % payloads.size()]);
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - started;
+  const auto ns_per_load =
+      static_cast<double>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+              .count()) /
+      static_cast<double>(DECODES);
+  std::println("{}: loads={} ns/load={} fields={}", name, payloads.size(),
+               ns_per_load, fields);
+  return ns_per_load;
+}
+
+auto decode_load_dom(const std::string& payload) -> std::size_t {
+  const auto data = moirai::parse_padded_json(payload);
+  if (!data.has_value() || !data->is_object()) {
+    return 0;
+  }
+  std::size_t fields = 0;
+  std::string copy;
+  for (const char* key : {"id", "location", "destination", "time", "oc",
+                          "ipdd_destination", "cs_slid", "cs_act", "pid"}) {
+    if (const auto value = moirai::find_string_member(*data, key);
+        value.has_value()) {
+      copy = std::string(*value);
+      ++fields;
+    }
+  }
+  const auto* items = moirai::find_array_member(*data, "items");
+  if (items == nullptr) {
+    items = moirai::find_array_member(*data, "item");
+  }
+  if (items != nullptr) {
+    for (const auto& waybill : *items) {
+      for (const char* key : {"id", "cn", "ipdd_destination"}) {
+        fields += moirai::find_string_member(waybill, key).has_value() ? 1U : 0U;
+      }
+    }
+  }
+  return fields;
+}
+
+auto decode_load_on_demand(const std::string& payload) -> std::size_t {
+  thread_local std::vector<moirai::LoadItem> waybills;
+  const auto load = moirai::decode_load(payload, waybills);
+  if (!load.has_value()) {
+    return 0;
+  }
+  auto fields = static_cast<std::size_t>(std::popcount(
+      static_cast<std::uint16_t>(load->present & ~moirai::LoadFields::ITEMS)));
+  for (const auto& waybill : waybills) {
+    fields += static_cast<std::size_t>(std::popcount(waybill.present));
+  }
+  return fields;
+}
+
+// Solver batches of `batch` loads decoded one parse per load and through one
+// document stream per batch, as SolverWrapper::run does with
+// MOIRAI_LOAD_BATCH_DECODE off and on.
+void run_load_batch_decode(std::string_view suite,
+                           const std::vector<std::string>& loads) {
+  // A multiple of every batch size, so each run decodes the same loads.
+  constexpr std::size_t DECODES = 102'400;
+  std::vector<moirai::LoadItem> waybills;
+  for (const std::size_t batch : {1U, 16U, 64U, 256U}) {
+    std::vector<std::string> payloads;
+    payloads.reserve(batch);
+    for (std::size_t index = 0; index < batch; ++index) {
+      payloads.push_back(loads[index % loads.size()]);
+    }
+
+    std::size_t decoded = 0;
+    const auto single_started = std::chrono::steady_clock::now();
+    for (std::size_t done = 0; done < DECODES; done += batch) {
+      for (const auto& payload : payloads) {
+        decoded += moirai::decode_load(payload, waybills).has_value() ? 1U : 0U;
+      }
+    }
+    const auto single_elapsed =
+        std::chrono::steady_clock::now() - single_started;
+
+    std::size_t batched = 0;
+    const auto batch_started = std::chrono::steady_clock::now();
+    for (std::size_t done = 0; done < DECODES; done += batch) {
+      batched += moirai::decode_loads(
+          payloads, waybills,
+          [&](std::size_t,
+              const std::expected<moirai::LoadFields,
+                                  moirai::LoadDecodeError>& load) {
+            decoded += load.has_value() ? 1U : 0U;
+          });
+    }
+    const auto batch_elapsed = std::chrono::steady_clock::now() - batch_started;
+
+    const auto per_load = [&](auto elapsed) {
+      return static_cast<double>(
+                 std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                     .count()) /
+             static_cast<double>(DECODES);
+    };
+    std::println("load-batch-decode-{}: batch={} single ns/load={} "
+                 "stream ns/load={} streamed={} decoded={}",
+                 suite, batch, per_load(single_elapsed),
+                 per_load(batch_elapsed), batched, decoded);
+  }
+}
+
+// Padded payloads of a .jsonl or capture load fixture; empty for other
+// fixtures.
+auto read_load_payloads(const std::filesystem::path& fixture)
+    -> std::vector<std::string> {
+  std::vector<std::string> payloads;
+  if (moirai::is_load_capture(fixture)) {
+    moirai::LoadCaptureReader capture(fixture);
+    while (const auto record = capture.next()) {
+      payloads.push_back(moirai::make_padded_payload(record->payload));
+    }
+  } else if (fixture.extension() == ".jsonl") {
+    std::ifstream input(fixture);
+    std::string line;
+    while (std::getline(input, line)) {
+      if (!line.empty()) {
+        payloads.push_back(moirai::make_padded_payload(line));
+      }
+    }
+  }
+  return payloads;
+}
+
+// Decodes the load fixtures, a synthetic 200-waybill bag and, when
+// MOIRAI_BENCH_LOADS_FIXTURE names a .jsonl or capture file, its production
+// loads.
+auto run_load_decode_benchmarks() -> bool {
+  std::vector<std::string> payloads;
+  for (const char* name : {"load_normal.json", "load_with_items.json"}) {
+    std::ifstream input(std::filesystem::path{MOIRAI_TEST_FIXTURE_DIR} / name);
+    payloads.push_back(moirai::make_padded_payload(
+        std::string(std::istreambuf_iterator<char>(input), {})));
+  }
+  std::string bag = R"({"id":"bench-load","location":"A","destination":"B",)"
+                    R"("time":"2026-06-08 08:00:00","items":[)";
+  for (int index = 0; index < 200; ++index) {
+    bag += std::format(
+        R"({}{{"id":"wb-{}","cn":"B","ipdd_destination":"2026-06-10 18:00:00"}})",
+        index == 0 ? "" : ",", index);
+  }
+  bag += "]}";
+  payloads.push_back(moirai::make_padded_payload(bag));
+
+  bool passed = true;
+  const auto compare = [&](std::string_view suite,
+                           const std::vector<std::string>& loads) {
+    const auto dom_ns = run_load_decode(
+        std::format("load-decode-{}-dom", suite), loads, decode_load_dom);
+    const auto on_demand_ns =
+        run_load_decode(std::format("load-decode-{}-on-demand", suite), loads,
+                        decode_load_on_demand);
+    const auto dom_fields = std::ranges::fold_left(
+        loads | std::views::transform(decode_load_dom), std::size_t{0},
+        std::plus<>{});
+    const auto on_demand_fields = std::ranges::fold_left(
+        loads | std::views::transform(decode_load_on_demand), std::size_t{0},
+        std::plus<>{});
+    passed &= dom_fields == on_demand_fields;
+    std::println("load-decode-{}: on-demand speedup={}x fields_match={}",
+                 suite, dom_ns / on_demand_ns, dom_fields == on_demand_fields);
+  };
+  compare("fixtures", payloads);
+  run_load_batch_decode("fixtures", payloads);
+
+  const char* loads_fixture = std::getenv("MOIRAI_BENCH_LOADS_FIXTURE");
+  if (loads_fixture != nullptr && !std::string_view{loads_fixture}.empty()) {
+    const auto production = read_load_payloads(loads_fixture);
+    if (!production.empty()) {
+      compare("production", production);
+      run_load_batch_decode("production", production);
+    }
+  }
+  return passed;
+}
+
+// Records loads the way --record-to does and replays them the way FileReader
+// does: the reader thread's cost per record, and replay throughput, for each
+// capture codec.
+auto run_load_capture_benchmark(moirai::CaptureCodec codec) -> bool {
+  constexpr std::size_t LOADS = 200'000;
+  std::vector<std::string> loads;
+  loads.reserve(LOADS);
+  for (std::size_t index = 0; index < LOADS; ++index) {
+    loads.push_back(std::format(
+        R"({{"id":"bag-{}","location":"IND110037AAB","destination":)"
+        R"("IND560300AAA","time":"2026-06-08 08:{:02}:00","items":[)"
+        R"({{"id":"wb-{}","cn":"B","ipdd_destination":"2026-06-10 18:00:00"}}]}})",
+        index % 5'000, index % 60, index));
+  }
+  const auto path = std::filesystem::temp_directory_path() /
+                    std::format("moirai-bench-{}-{}.cap",
+                                ::getpid(),
+                                std::to_underlying(codec));
+
+  moirai::LoadRecorder::Metrics metrics;
+  std::chrono::steady_clock::duration record_elapsed{};
+  {
+    moirai::LoadRecorder recorder(path, codec);
+    const auto started = std::chrono::steady_clock::now();
+    for (std::size_t index = 0; index < loads.size(); ++index) {
+      recorder.record(moirai::LoadRecord{
+        .timestamp_ms = static_cast<std::int64_t>(index),
+        .partition = static_cast<std::int32_t>(index % 12),
+        .offset = static_cast<std::int64_t>(index),
+        .payload = loads[index],
+      });
     }
+    record_elapsed = std::chrono::steady_clock::now() - started;
+    recorder.close();
+    metrics = recorder.metrics();
+  }
+
+  std::size_t replayed = 0;
+  std::size_t bytes = 0;
+  const auto started = std::chrono::steady_clock::now();
+  moirai::LoadCaptureReader capture(path);
+  while (const auto record = capture.next()) {
+    bytes += record->payload.size();
+    ++replayed;
   }
+  const auto replay_elapsed = std::chrono::steady_clock::now() - started;
+  std::filesystem::remove(path);
+
+  const auto seconds = [](auto elapsed) {
+    return std::chrono::duration<double>(elapsed).count();
+  };
+  const bool matched = replayed == metrics.records &&
+                       metrics.records + metrics.dropped == loads.size();
+  std::println(
+      "load-capture: codec={} loads={} record ns/load={} dropped={} ratio={} "
+      "replay MB/s={} replayed={}",
+      codec == moirai::CaptureCodec::zlib ? "zlib" : "stored",
+      loads.size(),
+      seconds(record_elapsed) * 1e9 / static_cast<double>(loads.size()),
+      metrics.dropped,
+      static_cast<double>(metrics.raw_bytes) /
+        static_cast<double>(std::max<std::uint64_t>(metrics.stored_bytes, 1)),
+      static_cast<double>(bytes) / 1e6 / seconds(replay_elapsed), replayed);
+  return matched;
+}
+
+auto run_load_capture_benchmarks() -> bool {
+  bool passed = run_load_capture_benchmark(moirai::CaptureCodec::stored);
+  passed = run_load_capture_benchmark(moirai::CaptureCodec::zlib) && passed;
   return passed;
 }
 
@@ -489,6 +1025,10 @@ auto run_production_fixture_suite() -> bool {
 auto main() -> int {
   bool passed = true;
   passed &= run_build_benchmarks();
+  passed &= run_cache_contention_benchmarks();
+  passed &= run_payload_handoff_benchmarks();
+  passed &= run_load_decode_benchmarks();
+  passed &= run_load_capture_benchmarks();
   passed &= run_suite("small", make_graph("small", 16, 4));
   passed &= run_suite("medium", make_graph("medium", 600, 10));
   passed &= run_suite("large", make_graph("large", 2400, 16));
@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <condition_variable>
 #include <cstddef>
+#include <iterator>
 #include <limits>
 #include <mutex>
 #include <span>
@@ -64,6 +65,78 @@ public:
     return true;
   }
 
+  // Moves `items` into the queue in order, admitting as many at a time as the
+  // capacity allows, with one wake-up per admitted chunk rather than one per
+  // item. Returns false once the queue closes or a stop is requested; items
+  // not admitted by then are left in `items`.
+  auto wait_enqueue_bulk(std::span<T> items,
+                         const std::stop_token &stop_token = {}) -> bool {
+    size_t enqueued = 0;
+    while (enqueued < items.size()) {
+      size_t admitted = items.size() - enqueued;
+      {
+        std::unique_lock lock(m_state_mutex);
+        if (m_bounded) {
+          m_not_full.wait(lock, stop_token, [this]() -> bool {
+            return m_closed || (m_size + m_pending_pushes) < m_capacity;
+          });
+        }
+
+        if (m_closed || stop_token.stop_requested()) {
+          return false;
+        }
+
+        if (m_bounded) {
+          admitted =
+              std::min(admitted, m_capacity - m_size - m_pending_pushes);
+        }
+        m_pending_pushes += admitted;
+      }
+
+      if (!m_queue.enqueue_bulk(
+              std::make_move_iterator(items.begin() +
+                                      static_cast<std::ptrdiff_t>(enqueued)),
+              admitted)) {
+        std::scoped_lock lock(m_state_mutex);
+        m_pending_pushes -= admitted;
+        if (m_bounded) {
+          m_not_full.notify_all();
+        }
+        return false;
+      }
+
+      {
+        std::scoped_lock lock(m_state_mutex);
+        m_pending_pushes -= admitted;
+        if (m_closed) {
+          T discarded;
+          for (size_t dropped = 0; dropped < admitted;) {
+            if (m_queue.try_dequeue(discarded)) {
+              ++dropped;
+            } else {
+              std::this_thread::yield();
+            }
+          }
+          if (m_bounded) {
+            m_not_full.notify_all();
+          }
+          return false;
+        }
+        m_size += admitted;
+      }
+
+      if (admitted == 1) {
+        m_not_empty.notify_one();
+      } else {
+        m_not_empty.notify_all();
+      }
+      enqueued += admitted;
+    }
+    return true;
+  }
+
+  [[nodiscard]] auto capacity() const -> size_t { return m_capacity; }
+
   [[nodiscard]] auto size_approx() const -> size_t {
     std::scoped_lock lock(m_state_mutex);
     return m_size;
@@ -0,0 +1,249 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Eviction policies for ConcurrentCache and PackedKeyCache.
+//
+// A cache keeps one policy instance per shard and drives it under the shard's
+// exclusive lock: admit() for every new entry, victim() when the shard is
+// full. The cache then erases the returned entry. Hits never touch the
+// policy; they only bump the entry's saturating `frequency` through
+// touch_entry(), which is safe under a shared lock or no lock at all.
+//
+// Handles are stable pointers to cache entries exposing
+// `std::atomic<std::uint8_t> frequency` and `std::uint64_t hash`.
+//
+// Both policies keep their queues in fixed-size ring buffers, so admission
+// and eviction are O(1) (amortized over re-queued entries) and allocate
+// nothing once a shard is warm.
+
+inline constexpr std::uint8_t MAX_ENTRY_FREQUENCY = 3;
+
+template <typename Handle>
+void touch_entry(Handle handle) {
+  const auto frequency = handle->frequency.load(std::memory_order_relaxed);
+  if (frequency < MAX_ENTRY_FREQUENCY) {
+    handle->frequency.store(static_cast<std::uint8_t>(frequency + 1),
+                            std::memory_order_relaxed);
+  }
+}
+
+// Fixed-capacity FIFO ring.
+template <typename T>
+class EvictionRing {
+public:
+  explicit EvictionRing(std::size_t capacity)
+    : m_items(std::max<std::size_t>(capacity, 1)) {}
+
+  [[nodiscard]] auto size() const -> std::size_t { return m_size; }
+  [[nodiscard]] auto empty() const -> bool { return m_size == 0; }
+  [[nodiscard]] auto full() const -> bool { return m_size == m_items.size(); }
+
+  void push_back(T item) {
+    m_items[(m_head + m_size) % m_items.size()] = item;
+    ++m_size;
+  }
+
+  auto pop_front() -> T {
+    const auto item = m_items[m_head];
+    m_head = (m_head + 1) % m_items.size();
+    --m_size;
+    return item;
+  }
+
+private:
+  std::vector<T> m_items;
+  std::size_t m_head{0};
+  std::size_t m_size{0};
+};
+
+// CLOCK over a ring of entries with a persistent hand: entries with a
+// non-zero frequency get a second chance, everything else is evicted in
+// insertion order.
+template <typename Handle>
+class ClockEviction {
+public:
+  struct Counters {
+    std::uint64_t second_chances{};
+
+    auto operator+=(const Counters& other) -> Counters& {
+      second_chances += other.second_chances;
+      return *this;
+    }
+  };
+
+  explicit ClockEviction(std::size_t capacity)
+    : m_ring(capacity) {}
+
+  void admit(Handle handle) { m_ring.push_back(handle); }
+
+  auto victim() -> Handle {
+    while (true) {
+      const auto handle = m_ring.pop_front();
+      if (handle->frequency.load(std::memory_order_relaxed) == 0) {
+        return handle;
+      }
+      handle->frequency.store(0, std::memory_order_relaxed);
+      m_ring.push_back(handle);
+      ++m_counters.second_chances;
+    }
+  }
+
+  // CLOCK admits every entry.
+  [[nodiscard]] auto admission_rejects() const -> std::uint64_t { return 0; }
+  [[nodiscard]] auto counters() const -> const Counters& { return m_counters; }
+
+private:
+  EvictionRing<Handle> m_ring;
+  Counters m_counters;
+};
+
+// S3-FIFO: new entries go to a small probationary FIFO (10% of the shard).
+// Entries hit while on probation move to the main FIFO; the rest are evicted
+// and remembered in a ghost FIFO of key hashes, so a key that returns soon
+// is admitted straight to main. One-off keys therefore never displace main
+// entries, which keeps hot hub pairs resident through a burst of unique
+// queries. Main entries with a non-zero frequency are re-queued with the
+// frequency decremented.
+template <typename Handle>
+class S3FifoEviction {
+public:
+  struct Counters {
+    std::uint64_t promotions{};
+    std::uint64_t ghost_admissions{};
+    std::uint64_t main_requeues{};
+    std::uint64_t main_evictions{};
+
+    auto operator+=(const Counters& other) -> Counters& {
+      promotions += other.promotions;
+      ghost_admissions += other.ghost_admissions;
+      main_requeues += other.main_requeues;
+      main_evictions += other.main_evictions;
+      return *this;
+    }
+  };
+
+  explicit S3FifoEviction(std::size_t capacity)
+    : m_small_target(std::max<std::size_t>(capacity / 10, 1))
+    , m_small(capacity)
+    , m_main(capacity)
+    , m_ghost(capacity)
+    , m_ghost_index(std::bit_ceil(std::max<std::size_t>(capacity * 2, 2)))
+  {}
+
+  void admit(Handle handle) {
+    handle->frequency.store(0, std::memory_order_relaxed);
+    if (is_ghost(handle->hash)) {
+      m_main.push_back(handle);
+      ++m_counters.ghost_admissions;
+      return;
+    }
+    m_small.push_back(handle);
+  }
+
+  auto victim() -> Handle {
+    while (true) {
+      if (!m_small.empty() &&
+          (m_small.size() >= m_small_target || m_main.empty())) {
+        const auto handle = m_small.pop_front();
+        if (handle->frequency.load(std::memory_order_relaxed) > 0) {
+          handle->frequency.store(0, std::memory_order_relaxed);
+          m_main.push_back(handle);
+          ++m_counters.promotions;
+          continue;
+        }
+        remember_ghost(handle->hash);
+        ++m_admission_rejects;
+        return handle;
+      }
+
+      const auto handle = m_main.pop_front();
+      const auto frequency = handle->frequency.load(std::memory_order_relaxed);
+      if (frequency > 0) {
+        handle->frequency.store(static_cast<std::uint8_t>(frequency - 1),
+                                std::memory_order_relaxed);
+        m_main.push_back(handle);
+        ++m_counters.main_requeues;
+        continue;
+      }
+      ++m_counters.main_evictions;
+      return handle;
+    }
+  }
+
+  // Entries evicted from probation without ever being hit.
+  [[nodiscard]] auto admission_rejects() const -> std::uint64_t {
+    return m_admission_rejects;
+  }
+  [[nodiscard]] auto counters() const -> const Counters& { return m_counters; }
+
+private:
+  struct GhostBucket {
+    std::uint64_t hash{0};
+    std::uint32_t count{0};
+  };
+
+  // Exact multiset of the hashes in the ghost ring: open addressing with
+  // linear probing and backward-shift deletion, sized to twice the ring.
+  // Caches pick shards by the low hash bits, so buckets are chosen by the top
+  // bits of a Fibonacci hash instead.
+  auto ghost_home(std::uint64_t hash) const -> std::size_t {
+    const auto bits = std::countr_zero(m_ghost_index.size());
+    return static_cast<std::size_t>((hash * 0x9e3779b97f4a7c15ULL) >>
+                                    (64 - bits));
+  }
+
+  auto ghost_find(std::uint64_t hash) const -> std::size_t {
+    const auto mask = m_ghost_index.size() - 1;
+    auto index = ghost_home(hash);
+    while (m_ghost_index[index].count != 0 &&
+           m_ghost_index[index].hash != hash) {
+      index = (index + 1) & mask;
+    }
+    return index;
+  }
+
+  auto is_ghost(std::uint64_t hash) const -> bool {
+    return m_ghost_index[ghost_find(hash)].count != 0;
+  }
+
+  void remember_ghost(std::uint64_t hash) {
+    if (m_ghost.full()) {
+      forget_ghost(m_ghost.pop_front());
+    }
+    m_ghost.push_back(hash);
+    auto& bucket = m_ghost_index[ghost_find(hash)];
+    bucket.hash = hash;
+    ++bucket.count;
+  }
+
+  void forget_ghost(std::uint64_t hash) {
+    const auto mask = m_ghost_index.size() - 1;
+    auto hole = ghost_find(hash);
+    if (m_ghost_index[hole].count == 0 || --m_ghost_index[hole].count != 0) {
+      return;
+    }
+    for (auto index = (hole + 1) & mask; m_ghost_index[index].count != 0;
+         index = (index + 1) & mask) {
+      const auto home = ghost_home(m_ghost_index[index].hash);
+      if (((index - home) & mask) >= ((index - hole) & mask)) {
+        m_ghost_index[hole] = m_ghost_index[index];
+        m_ghost_index[index].count = 0;
+        hole = index;
+      }
+    }
+  }
+
+  std::size_t m_small_target;
+  EvictionRing<Handle> m_small;
+  EvictionRing<Handle> m_main;
+  EvictionRing<std::uint64_t> m_ghost;
+  std::vector<GhostBucket> m_ghost_index;
+  std::uint64_t m_admission_rejects{0};
+  Counters m_counters;
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "cache_eviction.hxx"
+
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
@@ -14,23 +16,34 @@
 #include <utility>
 #include <vector>
 
-// Sharded concurrent cache with CLOCK eviction.
+// Sharded concurrent cache with pluggable eviction (cache_eviction.hxx).
 //
 // Design:
 // - N shards (power-of-two), each with its own hash map + shared_mutex
-// - Reads take shared_lock (multiple concurrent readers per shard)
+// - Reads take shared_lock (multiple concurrent readers per shard) and only
+//   bump the entry's atomic frequency
 // - Writes take unique_lock (exclusive per shard, but shards are independent)
-// - CLOCK eviction per shard when shard exceeds capacity/N entries
+// - Each shard owns an Eviction policy instance; when the shard exceeds
+//   capacity/N entries the policy names a victim in O(1)
 // - Entries stored as shared_ptr for zero-copy reads
 //
+// S3-FIFO is the default: a burst of one-off keys is evicted from probation
+// without displacing entries that have been hit. ClockEviction is kept for
+// comparing hit rates on replayed traffic.
+//
 // With 64 shards and 8 solver threads, probability of two threads hitting
 // the same shard simultaneously is ~12%. Of those, read-read doesn't block.
 // Write-write and write-read on the same shard block briefly — but writes
 // (cache misses) are the minority once the cache warms up.
 
-template <typename Value>
+template <typename Value,
+          template <typename> class Eviction = S3FifoEviction>
 class ConcurrentCache {
+  struct SlotData;
+
 public:
+  using Policy = Eviction<SlotData*>;
+
   struct Entry {
     std::string key;
     Value value;
@@ -41,6 +54,8 @@ public:
     std::uint64_t misses{};
     std::uint64_t evictions{};
     std::size_t occupied{};
+    std::uint64_t admission_rejects{};
+    typename Policy::Counters policy{};
   };
 
   explicit ConcurrentCache(std::size_t capacity,
@@ -48,10 +63,10 @@ public:
     : m_shard_count(next_power_of_two(shard_count))
     , m_shard_mask(m_shard_count - 1)
     , m_shard_capacity(capacity / m_shard_count + 1)
-    , m_shards(m_shard_count)
   {
-    for (auto& shard : m_shards) {
-      shard.entries.reserve(m_shard_capacity);
+    m_shards.reserve(m_shard_count);
+    for (std::size_t index = 0; index < m_shard_count; ++index) {
+      m_shards.push_back(std::make_unique<Shard>(m_shard_capacity));
     }
   }
 
@@ -59,67 +74,65 @@ public:
   auto operator=(const ConcurrentCache&) -> ConcurrentCache& = delete;
 
   auto find(std::string_view key) const -> std::shared_ptr<const Entry> {
-    auto& shard = shard_for(key);
+    const auto hash = hash_key(key);
+    auto& shard = shard_for(hash);
     std::shared_lock lock(shard.mutex);
     auto iter = shard.entries.find(key);
     if (iter == shard.entries.end()) {
       m_misses.fetch_add(1, std::memory_order_relaxed);
       return nullptr;
     }
-    iter->second.referenced.store(true, std::memory_order_relaxed);
+    touch_entry(&iter->second);
     m_hits.fetch_add(1, std::memory_order_relaxed);
     return iter->second.entry;
   }
 
   void insert(std::string key, Value value) {
+    const auto hash = hash_key(key);
     auto entry = std::make_shared<const Entry>(
       Entry{key, std::move(value)});
-    auto& shard = shard_for(key);
+    auto& shard = shard_for(hash);
     std::unique_lock lock(shard.mutex);
 
+    auto existing = shard.entries.find(std::string_view{key});
+    if (existing != shard.entries.end()) {
+      existing->second.entry = std::move(entry);
+      return;
+    }
+
     if (shard.entries.size() >= m_shard_capacity) {
-      evict_one(shard);
+      const auto* victim = shard.policy.victim();
+      shard.entries.erase(
+        shard.entries.find(std::string_view{victim->entry->key}));
+      m_evictions.fetch_add(1, std::memory_order_relaxed);
     }
 
-    auto [iter, inserted] = shard.entries.try_emplace(
-      std::move(key), SlotData{});
+    auto [iter, inserted] = shard.entries.try_emplace(std::move(key));
     iter->second.entry = std::move(entry);
-    iter->second.referenced.store(true, std::memory_order_relaxed);
+    iter->second.hash = hash;
+    shard.policy.admit(&iter->second);
   }
 
   auto metrics() const -> Metrics {
-    std::size_t total_occupied = 0;
-    for (const auto& shard : m_shards) {
-      std::shared_lock lock(shard.mutex);
-      total_occupied += shard.entries.size();
-    }
-    return Metrics{
+    Metrics metrics{
       .hits = m_hits.load(std::memory_order_relaxed),
       .misses = m_misses.load(std::memory_order_relaxed),
       .evictions = m_evictions.load(std::memory_order_relaxed),
-      .occupied = total_occupied,
     };
+    for (const auto& shard : m_shards) {
+      std::shared_lock lock(shard->mutex);
+      metrics.occupied += shard->entries.size();
+      metrics.admission_rejects += shard->policy.admission_rejects();
+      metrics.policy += shard->policy.counters();
+    }
+    return metrics;
   }
 
 private:
   struct SlotData {
     std::shared_ptr<const Entry> entry;
-    mutable std::atomic<bool> referenced{true};
-
-    SlotData() = default;
-    explicit SlotData(std::shared_ptr<const Entry> e)
-      : entry(std::move(e)), referenced(true) {}
-    SlotData(SlotData&& other) noexcept
-      : entry(std::move(other.entry))
-      , referenced(other.referenced.load(std::memory_order_relaxed)) {}
-    auto operator=(SlotData&& other) noexcept -> SlotData& {
-      entry = std::move(other.entry);
-      referenced.store(other.referenced.load(std::memory_order_relaxed),
-                       std::memory_order_relaxed);
-      return *this;
-    }
-    SlotData(const SlotData&) = delete;
-    auto operator=(const SlotData&) -> SlotData& = delete;
+    std::uint64_t hash{0};
+    mutable std::atomic<std::uint8_t> frequency{0};
   };
 
   struct TransparentHash {
@@ -140,8 +153,15 @@ private:
   };
 
   struct Shard {
+    explicit Shard(std::size_t capacity)
+      : policy(capacity)
+    {
+      entries.reserve(capacity);
+    }
+
     mutable std::shared_mutex mutex;
     std::unordered_map<std::string, SlotData, TransparentHash, TransparentEqual> entries;
+    Policy policy;
   };
 
   static auto next_power_of_two(std::size_t value) -> std::size_t {
@@ -156,34 +176,18 @@ private:
     return value + 1;
   }
 
-  auto shard_for(std::string_view key) const -> Shard& {
-    const auto hash = std::hash<std::string_view>{}(key);
-    return m_shards[hash & m_shard_mask];
+  static auto hash_key(std::string_view key) -> std::uint64_t {
+    return std::hash<std::string_view>{}(key);
   }
 
-  void evict_one(Shard& shard) {
-    // CLOCK sweep: find an unreferenced entry and erase it
-    for (std::size_t pass = 0; pass < 2; ++pass) {
-      for (auto iter = shard.entries.begin(); iter != shard.entries.end(); ++iter) {
-        if (iter->second.referenced.exchange(false, std::memory_order_relaxed)) {
-          continue;
-        }
-        shard.entries.erase(iter);
-        m_evictions.fetch_add(1, std::memory_order_relaxed);
-        return;
-      }
-    }
-    // All referenced after 2 passes — evict the first entry
-    if (!shard.entries.empty()) {
-      shard.entries.erase(shard.entries.begin());
-      m_evictions.fetch_add(1, std::memory_order_relaxed);
-    }
+  auto shard_for(std::uint64_t hash) const -> Shard& {
+    return *m_shards[hash & m_shard_mask];
   }
 
   std::size_t m_shard_count;
   std::size_t m_shard_mask;
   std::size_t m_shard_capacity;
-  mutable std::vector<Shard> m_shards;
+  std::vector<std::unique_ptr<Shard>> m_shards;
 
   mutable std::atomic<std::uint64_t> m_hits{0};
   mutable std::atomic<std::uint64_t> m_misses{0};
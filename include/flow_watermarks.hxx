@@ -0,0 +1,43 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+// When the Kafka reader pauses and resumes the partitions feeding one load
+// queue.
+//
+// Design:
+// - A queue pauses at `high_percent` of its capacity, but no later than the
+//   point where one more poll of `poll_size` loads might not fit. Every load
+//   of a poll can belong to the same lane, so with small lane queues the
+//   percentage alone would let a poll park the reader in the bulk enqueue
+// - It resumes at `low_percent`, kept below the pause point so the two
+//   never flap on the same occupancy
+// - The reader caps the poll size at the smallest load queue. A queue that
+//   only just fits one poll then pauses as soon as it holds anything and
+//   resumes once it is empty
+// - Unbounded queues never pause; the caller skips them
+
+struct FlowWatermarks {
+  std::size_t pause_at{0};
+  std::size_t resume_at{0};
+
+  static auto for_queue(std::size_t capacity,
+                        std::size_t poll_size,
+                        std::size_t high_percent,
+                        std::size_t low_percent) -> FlowWatermarks {
+    const auto headroom = capacity - std::min(poll_size, capacity);
+    const auto pause_at = std::max<std::size_t>(
+      std::min(capacity * high_percent / 100, headroom), 1);
+    const auto resume_at =
+      std::min(capacity * low_percent / 100, pause_at - 1);
+    return FlowWatermarks{.pause_at = pause_at, .resume_at = resume_at};
+  }
+
+  // Whether a queue holding `queued` loads should be paused, given whether
+  // it is paused now.
+  [[nodiscard]] auto paused(bool paused_now, std::size_t queued) const
+    -> bool {
+    return paused_now ? queued > resume_at : queued >= pause_at;
+  }
+};
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Approximate top-k counter for packed 64-bit keys (Space-Saving).
+//
+// Design:
+// - N mutex-protected shards (power-of-two), each tracking at most
+//   capacity / N keys in a flat vector plus a key -> slot index
+// - A key that is not tracked in a full shard takes over the slot with the
+//   smallest count and inherits that count (+1). `error` keeps the inherited
+//   part, so count - error is a guaranteed lower bound
+// - Every tracked key carries the payload of its latest record() call
+// - decay() halves every count, so keys that stopped arriving age out over
+//   a few calls instead of holding their slot forever
+// - With a sample period P > 1, each thread passes only every P-th record()
+//   on, weighted P, so hot paths pay a thread-local increment for the rest
+//   instead of a shard lock and a scan of a full shard
+//
+// Any key seen more than total / capacity times is guaranteed to be tracked
+// (unsampled; sampled counts are estimates of the same order).
+
+template <typename Payload>
+class HeavyHitters {
+public:
+  struct Item {
+    std::uint64_t key{0};
+    std::uint64_t count{0};
+    std::uint64_t error{0};
+    Payload payload{};
+  };
+
+  // `sample_period` is rounded up to a power of two.
+  explicit HeavyHitters(std::size_t capacity, std::size_t shard_count = 16,
+                        std::size_t sample_period = 1)
+    : m_shard_mask(std::bit_ceil(std::max<std::size_t>(shard_count, 1)) - 1)
+    , m_shard_capacity(std::max<std::size_t>(capacity / (m_shard_mask + 1), 1))
+    , m_sample_mask(std::bit_ceil(std::max<std::size_t>(sample_period, 1)) - 1)
+  {
+    m_shards.reserve(m_shard_mask + 1);
+    for (std::size_t index = 0; index <= m_shard_mask; ++index) {
+      m_shards.push_back(std::make_unique<Shard>());
+      m_shards.back()->items.reserve(m_shard_capacity);
+      m_shards.back()->index.reserve(m_shard_capacity);
+    }
+  }
+
+  // Not synchronised with record(); set it before records start.
+  void set_sample_period(std::size_t sample_period) {
+    m_sample_mask = std::bit_ceil(std::max<std::size_t>(sample_period, 1)) - 1;
+  }
+
+  void record(std::uint64_t key, const Payload& payload) {
+    if (m_sample_mask != 0) {
+      thread_local std::uint64_t calls = 0;
+      if ((++calls & m_sample_mask) != 0) {
+        return;
+      }
+    }
+    const std::uint64_t weight = m_sample_mask + 1;
+    auto& shard = shard_for(key);
+    std::lock_guard lock(shard.mutex);
+    if (const auto found = shard.index.find(key); found != shard.index.end()) {
+      auto& item = shard.items[found->second];
+      item.count += weight;
+      item.payload = payload;
+      return;
+    }
+    if (shard.items.size() < m_shard_capacity) {
+      shard.index.emplace(key, shard.items.size());
+      shard.items.push_back(
+        Item{.key = key, .count = weight, .error = 0, .payload = payload});
+      return;
+    }
+
+    const auto minimum = std::ranges::min_element(shard.items, {}, &Item::count);
+    shard.index.erase(minimum->key);
+    shard.index.emplace(key,
+                        static_cast<std::size_t>(minimum - shard.items.begin()));
+    *minimum = Item{.key = key,
+                    .count = minimum->count + weight,
+                    .error = minimum->count,
+                    .payload = payload};
+  }
+
+  // The `count` most frequent keys, most frequent first.
+  [[nodiscard]] auto top(std::size_t count) const -> std::vector<Item> {
+    std::vector<Item> items;
+    for (const auto& shard : m_shards) {
+      std::lock_guard lock(shard->mutex);
+      items.insert(items.end(), shard->items.begin(), shard->items.end());
+    }
+    count = std::min(count, items.size());
+    std::ranges::partial_sort(items, items.begin() + count, std::greater<>{},
+                              &Item::count);
+    items.resize(count);
+    return items;
+  }
+
+  void decay() {
+    for (auto& shard : m_shards) {
+      std::lock_guard lock(shard->mutex);
+      std::size_t kept = 0;
+      for (auto& item : shard->items) {
+        item.count /= 2;
+        item.error /= 2;
+        if (item.count != 0) {
+          shard->items[kept++] = item;
+        }
+      }
+      shard->items.resize(kept);
+      shard->index.clear();
+      for (std::size_t index = 0; index < kept; ++index) {
+        shard->index.emplace(shard->items[index].key, index);
+      }
+    }
+  }
+
+private:
+  struct Shard {
+    std::mutex mutex;
+    std::vector<Item> items;
+    std::unordered_map<std::uint64_t, std::size_t> index;
+  };
+
+  auto shard_for(std::uint64_t key) -> Shard& {
+    return *m_shards[((key * 0x9e3779b97f4a7c15ULL) >> 32U) & m_shard_mask];
+  }
+
+  std::size_t m_shard_mask;
+  std::size_t m_shard_capacity;
+  std::size_t m_sample_mask;
+  std::vector<std::unique_ptr<Shard>> m_shards;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// Maps the partitions of the load topic to solver lanes for the Kafka reader.
+//
+// Design:
+// - A partition keeps its lane once mapped, also while revoked, so the new
+//   messages of a partition that comes back queue behind the ones still
+//   waiting in its lane
+// - A new partition goes to the lane with the fewest active partitions, the
+//   lowest such lane on a tie
+// - assign() and revoke() take what a rebalance hands over: the whole
+//   assignment under the eager protocol, only the change under the
+//   cooperative one. Both keep the counts right
+//
+// Not thread-safe. librdkafka runs the rebalance callback on the thread that
+// polls, which is the only thread that routes messages.
+
+class LaneMap {
+  struct Assignment {
+    std::size_t lane{0};
+    bool active{false};
+  };
+
+public:
+  explicit LaneMap(std::size_t lane_count) : m_active(lane_count, 0) {}
+
+  // Returns the lane of `partition`, mapping or reactivating it if needed.
+  auto lane_for(std::int32_t partition) -> std::size_t {
+    auto [found, inserted] = m_partitions.try_emplace(partition);
+    auto& assignment = found->second;
+    if (inserted) {
+      assignment.lane = static_cast<std::size_t>(
+        std::ranges::min_element(m_active) - m_active.begin());
+    }
+    if (!assignment.active) {
+      assignment.active = true;
+      ++m_active[assignment.lane];
+    }
+    return assignment.lane;
+  }
+
+  // Partitions are mapped in ascending order, so the lanes do not depend on
+  // the order the rebalance lists them in.
+  void assign(std::vector<std::int32_t> partitions) {
+    std::ranges::sort(partitions);
+    for (const auto partition : partitions) {
+      (void)lane_for(partition);
+    }
+  }
+
+  void revoke(std::span<const std::int32_t> partitions) {
+    for (const auto partition : partitions) {
+      const auto found = m_partitions.find(partition);
+      if (found != m_partitions.end() && found->second.active) {
+        found->second.active = false;
+        --m_active[found->second.lane];
+      }
+    }
+  }
+
+  // The lane `partition` is mapped to, active or not.
+  auto lane_of(std::int32_t partition) const -> std::optional<std::size_t> {
+    const auto found = m_partitions.find(partition);
+    if (found == m_partitions.end()) {
+      return std::nullopt;
+    }
+    return found->second.lane;
+  }
+
+  auto active_partitions(std::size_t lane) const -> std::size_t {
+    return m_active[lane];
+  }
+
+  auto lane_count() const -> std::size_t { return m_active.size(); }
+
+private:
+  std::vector<std::size_t> m_active;
+  std::unordered_map<std::int32_t, Assignment> m_partitions;
+};
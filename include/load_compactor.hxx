@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Drops loads that a newer load of the same bag superseded while both were
+// waiting in a load queue. OpenSearch upserts by waybill, so only the newest
+// scan of a bag needs solving.
+//
+// Design:
+// - The reader calls admit() for a load before enqueueing it; a solver calls
+//   superseded() for every load it dequeues, before solving it
+// - Each tracked (queue, id) pair keeps a fingerprint of its newest admitted
+//   payload and a count of its loads still queued. A dequeued load is stale
+//   if its own payload is not the newest. The payload itself is what ties a
+//   dequeued load to its admission, so the answer does not depend on the
+//   order in which solvers sharing a queue get to check their loads
+// - Identical payloads are one scan; all of them are solved
+// - Pairs are hashed to 64 bits and spread over N mutex-protected shards
+//   (power-of-two). A pair leaves the index when its last load is dequeued,
+//   so the index holds at most one entry per queued load. `capacity` bounds
+//   it as well; loads admitted while the index is full are not tracked and
+//   never dropped
+//
+// admit() must come before the enqueue: a solver that dequeues the load
+// first would otherwise find no entry, and the late admit would leave a
+// count that never drains.
+
+class LoadCompactor {
+  struct Entry {
+    std::uint64_t newest{0};
+    std::uint32_t queued{0};
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<std::uint64_t, Entry> queued;
+  };
+
+public:
+  struct Metrics {
+    std::uint64_t tracked{};
+    std::uint64_t untracked{};
+    std::uint64_t superseded{};
+  };
+
+  explicit LoadCompactor(std::size_t capacity, std::size_t shard_count = 16)
+    : m_shards(std::bit_ceil(std::max<std::size_t>(shard_count, 1)))
+    , m_shard_mask(m_shards.size() - 1)
+    , m_shard_capacity(std::max<std::size_t>(capacity / m_shards.size(), 1)) {}
+
+  LoadCompactor(const LoadCompactor&) = delete;
+  auto operator=(const LoadCompactor&) -> LoadCompactor& = delete;
+
+  // Records a load of `id` with body `payload` about to enter `queue`.
+  // Returns false if the index is full and the load is not tracked.
+  auto admit(const void* queue, std::string_view id, std::string_view payload)
+    -> bool {
+    const auto key = key_for(queue, id);
+    const auto fingerprint = std::hash<std::string_view>{}(payload);
+    auto& shard = shard_for(key);
+    std::lock_guard lock(shard.mutex);
+    if (const auto found = shard.queued.find(key); found != shard.queued.end()) {
+      found->second.newest = fingerprint;
+      ++found->second.queued;
+    } else if (shard.queued.size() < m_shard_capacity) {
+      shard.queued.emplace(key, Entry{.newest = fingerprint, .queued = 1});
+    } else {
+      m_untracked.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    m_tracked.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Called once for each load dequeued from `queue`, with the payload it was
+  // admitted with. Returns true if a newer load of `id` was admitted since,
+  // in which case this one can be dropped.
+  auto superseded(const void* queue,
+                  std::string_view id,
+                  std::string_view payload) -> bool {
+    const auto key = key_for(queue, id);
+    const auto fingerprint = std::hash<std::string_view>{}(payload);
+    auto& shard = shard_for(key);
+    std::lock_guard lock(shard.mutex);
+    const auto found = shard.queued.find(key);
+    if (found == shard.queued.end()) {
+      return false;
+    }
+    const bool stale = found->second.newest != fingerprint;
+    if (--found->second.queued == 0) {
+      shard.queued.erase(found);
+    }
+    if (stale) {
+      m_superseded.fetch_add(1, std::memory_order_relaxed);
+    }
+    return stale;
+  }
+
+  auto metrics() const -> Metrics {
+    return Metrics{
+      .tracked = m_tracked.load(std::memory_order_relaxed),
+      .untracked = m_untracked.load(std::memory_order_relaxed),
+      .superseded = m_superseded.load(std::memory_order_relaxed),
+    };
+  }
+
+private:
+  static auto key_for(const void* queue, std::string_view id)
+    -> std::uint64_t {
+    const auto scope = static_cast<std::uint64_t>(
+      reinterpret_cast<std::uintptr_t>(queue));
+    return std::hash<std::string_view>{}(id) ^
+           (scope * 0x9e3779b97f4a7c15ULL);
+  }
+
+  auto shard_for(std::uint64_t key) -> Shard& {
+    return m_shards[((key * 0x9e3779b97f4a7c15ULL) >> 32U) & m_shard_mask];
+  }
+
+  std::vector<Shard> m_shards;
+  std::size_t m_shard_mask;
+  std::size_t m_shard_capacity;
+  std::atomic<std::uint64_t> m_tracked{0};
+  std::atomic<std::uint64_t> m_untracked{0};
+  std::atomic<std::uint64_t> m_superseded{0};
+};
@@ -0,0 +1,562 @@
+#pragma once
+
+#include "cache_eviction.hxx"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Sharded open-addressing cache keyed by packed 64-bit integers.
+//
+// Design:
+// - N shards (power-of-two), each a linear-probing slot table sized to at
+//   least twice its capacity, plus a mutex that only writers take
+// - Slots hold an atomic key and an atomic pointer to a node. A node stays
+//   with its key for as long as the key is cached; inserting or updating
+//   the key again swaps the node's immutable payload instead
+// - Readers take no lock: they check the node's own key, so a slot rewritten
+//   underneath them reads as a miss, never as another key's value
+// - Unlinked nodes, replaced payloads and replaced tables are retired and
+//   freed in batches once every reader that could still hold them has
+//   finished. Readers announce themselves on two-phase counters striped by
+//   thread, so concurrent hits do not share a cache line
+// - Each shard owns an Eviction policy (cache_eviction.hxx) that picks
+//   victims in O(1); evicted slots become tombstones, and a shard's table is
+//   rebuilt once tombstones pile up
+//
+// Keys 0 and 1 are reserved for empty and tombstone slots; inserting them is
+// a no-op.
+
+template <typename Value,
+          template <typename> class Eviction = S3FifoEviction>
+class PackedKeyCache {
+  struct Node;
+
+public:
+  using Policy = Eviction<Node*>;
+
+  static constexpr std::uint64_t EMPTY_KEY = 0;
+  static constexpr std::uint64_t TOMBSTONE_KEY = 1;
+
+  struct Metrics {
+    std::uint64_t hits{};
+    std::uint64_t misses{};
+    std::uint64_t evictions{};
+    std::size_t occupied{};
+    std::uint64_t admission_rejects{};
+    typename Policy::Counters policy{};
+  };
+
+  explicit PackedKeyCache(std::size_t capacity,
+                          std::size_t shard_count = 64)
+    : m_shard_count(std::bit_ceil(std::max<std::size_t>(shard_count, 1)))
+    , m_shard_mask(m_shard_count - 1)
+    , m_shard_shift(static_cast<unsigned>(std::countr_zero(m_shard_count)))
+    , m_shard_capacity(capacity / m_shard_count + 1)
+  {
+    m_shards.reserve(m_shard_count);
+    for (std::size_t index = 0; index < m_shard_count; ++index) {
+      m_shards.push_back(std::make_unique<Shard>(m_shard_capacity));
+    }
+  }
+
+  PackedKeyCache(const PackedKeyCache&) = delete;
+  auto operator=(const PackedKeyCache&) -> PackedKeyCache& = delete;
+
+  ~PackedKeyCache() {
+    for (auto& shard : m_shards) {
+      const auto* table = shard->table.load(std::memory_order_relaxed);
+      for (std::size_t index = 0; index <= table->mask; ++index) {
+        delete table->slots[index].node.load(std::memory_order_relaxed);
+      }
+      delete table;
+    }
+    for (const auto* node : m_retired_nodes) {
+      delete node;
+    }
+    for (const auto* payload : m_retired_payloads) {
+      delete payload;
+    }
+    for (const auto* table : m_retired_tables) {
+      delete table;
+    }
+  }
+
+  // Calls visitor(value) on the cached value without copying it, inside the
+  // read-side section. The visitor returns whether the value answered the
+  // query, which is what the hit and miss counters record.
+  template <typename Visitor>
+  auto visit(std::uint64_t key, Visitor&& visitor) const -> bool {
+    const ReadGuard guard(*this);
+    const auto hit = visit_node(lookup(key), visitor);
+    (hit ? guard.stripe().hits : guard.stripe().misses)
+      .fetch_add(1, std::memory_order_relaxed);
+    return hit;
+  }
+
+  // visit() without touching the hit and miss counters, for re-reading a key
+  // whose miss was already counted.
+  template <typename Visitor>
+  auto peek(std::uint64_t key, Visitor&& visitor) const -> bool {
+    const ReadGuard guard(*this);
+    return visit_node(lookup(key), visitor);
+  }
+
+  // Visits every key under one read-side section, calling
+  // visitor(index, value) for keys[index]. Home slots are prefetched before
+  // any of them is probed.
+  template <typename Visitor>
+  void visit_many(std::span<const std::uint64_t> keys,
+                  Visitor&& visitor) const {
+    const ReadGuard guard(*this);
+#if defined(__GNUC__) || defined(__clang__)
+    for (const auto key : keys) {
+      const auto hash = mix(key);
+      const auto* table =
+        shard_for(hash).table.load(std::memory_order_acquire);
+      __builtin_prefetch(&table->slots[(hash >> m_shard_shift) & table->mask]);
+    }
+#endif
+    std::uint64_t hits = 0;
+    for (std::size_t index = 0; index < keys.size(); ++index) {
+      hits += visit_node(lookup(keys[index]), [&](const Value& value) {
+        return visitor(index, value);
+      }) ? 1U : 0U;
+    }
+    guard.stripe().hits.fetch_add(hits, std::memory_order_relaxed);
+    guard.stripe().misses.fetch_add(keys.size() - hits,
+                                    std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] auto shard_count() const -> std::size_t {
+    return m_shard_count;
+  }
+
+  // Calls visitor(key, value) for every entry of one shard, inside a
+  // read-side section of its own, so walking the whole cache shard by shard
+  // never holds back reclamation for long. Entries inserted or evicted
+  // during the walk may or may not be visited. Hit counters and eviction
+  // state are left alone.
+  template <typename Visitor>
+  void for_each_in_shard(std::size_t shard, Visitor&& visitor) const {
+    const ReadGuard guard(*this);
+    const auto* table = m_shards[shard]->table.load(std::memory_order_acquire);
+    for (std::size_t index = 0; index <= table->mask; ++index) {
+      const auto& slot = table->slots[index];
+      const auto key = slot.key.load(std::memory_order_acquire);
+      if (key == EMPTY_KEY || key == TOMBSTONE_KEY) {
+        continue;
+      }
+      const auto* node = slot.node.load(std::memory_order_acquire);
+      if (node != nullptr && node->key == key) {
+        visitor(key, node->payload.load(std::memory_order_acquire)->value);
+      }
+    }
+  }
+
+  auto find(std::uint64_t key) const -> std::optional<Value> {
+    std::optional<Value> result;
+    visit(key, [&](const Value& value) {
+      result = value;
+      return true;
+    });
+    return result;
+  }
+
+  // results[i] answers keys[i].
+  void find_many(std::span<const std::uint64_t> keys,
+                 std::span<std::optional<Value>> results) const {
+    std::ranges::fill(results, std::nullopt);
+    visit_many(keys, [&](std::size_t index, const Value& value) {
+      results[index] = value;
+      return true;
+    });
+  }
+
+  void insert(std::uint64_t key, Value value) {
+    update(key, [&](const Value*) { return std::move(value); });
+  }
+
+  // Replaces the value for `key` with update(current), where current is the
+  // cached value or nullptr, under the shard's write lock. Concurrent updates
+  // of one key therefore see each other's results.
+  template <typename Update>
+  void update(std::uint64_t key, Update&& update) {
+    if (key == EMPTY_KEY || key == TOMBSTONE_KEY) {
+      return;
+    }
+
+    const auto hash = mix(key);
+    auto& shard = shard_for(hash);
+    Retired retired;
+    {
+      std::lock_guard lock(shard.mutex);
+      auto* table = shard.table.load(std::memory_order_relaxed);
+      auto index = (hash >> m_shard_shift) & table->mask;
+      std::optional<std::size_t> free_slot;
+      for (std::size_t probe = 0; probe <= table->mask; ++probe) {
+        auto& slot = table->slots[index];
+        const auto slot_key = slot.key.load(std::memory_order_relaxed);
+        if (slot_key == key) {
+          auto* node = slot.node.load(std::memory_order_relaxed);
+          auto payload = std::make_unique<const Payload>(
+            update(&node->payload.load(std::memory_order_relaxed)->value));
+          retired.payload = node->payload.exchange(payload.release(),
+                                                   std::memory_order_acq_rel);
+          break;
+        }
+        if (slot_key == TOMBSTONE_KEY && !free_slot.has_value()) {
+          free_slot = index;
+        }
+        if (slot_key == EMPTY_KEY) {
+          free_slot = free_slot.value_or(index);
+          break;
+        }
+        index = (index + 1) & table->mask;
+      }
+
+      if (retired.payload == nullptr && free_slot.has_value()) {
+        auto payload = std::make_unique<const Payload>(
+          update(static_cast<const Value*>(nullptr)));
+        if (shard.size >= m_shard_capacity) {
+          retired.node = evict(shard, *table);
+        }
+        auto* node = new Node(key, hash, payload.release());
+        node->slot = *free_slot;
+        auto& slot = table->slots[*free_slot];
+        if (slot.key.load(std::memory_order_relaxed) == TOMBSTONE_KEY) {
+          --shard.tombstones;
+        }
+        slot.node.store(node, std::memory_order_relaxed);
+        slot.key.store(key, std::memory_order_release);
+        shard.policy.admit(node);
+        ++shard.size;
+
+        if ((shard.size + shard.tombstones) * 4 > (table->mask + 1) * 3) {
+          retired.table = table;
+          shard.table.store(rebuild(shard, *table), std::memory_order_release);
+        }
+      }
+    }
+    retire(retired);
+  }
+
+  // update() for a key that is already cached. Returns false, leaving the
+  // cache as it was, when the key is not cached.
+  template <typename Update>
+  auto update_existing(std::uint64_t key, Update&& update) -> bool {
+    if (key == EMPTY_KEY || key == TOMBSTONE_KEY) {
+      return false;
+    }
+
+    const auto hash = mix(key);
+    auto& shard = shard_for(hash);
+    Retired retired;
+    {
+      std::lock_guard lock(shard.mutex);
+      const auto* table = shard.table.load(std::memory_order_relaxed);
+      auto index = (hash >> m_shard_shift) & table->mask;
+      for (std::size_t probe = 0; probe <= table->mask; ++probe) {
+        const auto& slot = table->slots[index];
+        const auto slot_key = slot.key.load(std::memory_order_relaxed);
+        if (slot_key == EMPTY_KEY) {
+          break;
+        }
+        if (slot_key == key) {
+          auto* node = slot.node.load(std::memory_order_relaxed);
+          auto payload = std::make_unique<const Payload>(
+            update(node->payload.load(std::memory_order_relaxed)->value));
+          retired.payload = node->payload.exchange(payload.release(),
+                                                   std::memory_order_acq_rel);
+          break;
+        }
+        index = (index + 1) & table->mask;
+      }
+    }
+    if (retired.payload == nullptr) {
+      return false;
+    }
+    retire(retired);
+    return true;
+  }
+
+  auto metrics() const -> Metrics {
+    Metrics metrics{
+      .evictions = m_evictions.load(std::memory_order_relaxed),
+    };
+    for (const auto& stripe : m_stripes) {
+      metrics.hits += stripe.hits.load(std::memory_order_relaxed);
+      metrics.misses += stripe.misses.load(std::memory_order_relaxed);
+    }
+    for (const auto& shard : m_shards) {
+      std::lock_guard lock(shard->mutex);
+      metrics.occupied += shard->size;
+      metrics.admission_rejects += shard->policy.admission_rejects();
+      metrics.policy += shard->policy.counters();
+    }
+    return metrics;
+  }
+
+private:
+  static constexpr std::size_t READER_STRIPES = 64;
+  static constexpr std::size_t RETIRE_BATCH = 256;
+
+  struct Payload {
+    explicit Payload(Value payload_value)
+      : value(std::move(payload_value)) {}
+
+    Value value;
+  };
+
+  struct Node {
+    Node(std::uint64_t node_key, std::uint64_t node_hash,
+         const Payload* node_payload)
+      : key(node_key)
+      , hash(node_hash)
+      , payload(node_payload) {}
+
+    Node(const Node&) = delete;
+    auto operator=(const Node&) -> Node& = delete;
+
+    ~Node() { delete payload.load(std::memory_order_relaxed); }
+
+    std::uint64_t key;
+    std::uint64_t hash;
+    std::atomic<const Payload*> payload;
+    std::atomic<std::uint8_t> frequency{0};
+    // Slot index in the shard's current table; writers only.
+    std::size_t slot{0};
+  };
+
+  struct Slot {
+    std::atomic<std::uint64_t> key{EMPTY_KEY};
+    std::atomic<Node*> node{nullptr};
+  };
+
+  struct Table {
+    explicit Table(std::size_t slot_count)
+      : mask(slot_count - 1)
+      , slots(std::make_unique<Slot[]>(slot_count)) {}
+
+    std::size_t mask;
+    std::unique_ptr<Slot[]> slots;
+  };
+
+  struct Shard {
+    explicit Shard(std::size_t capacity)
+      : table(new Table(slot_count_for(capacity)))
+      , policy(capacity) {}
+
+    mutable std::mutex mutex;
+    std::atomic<Table*> table;
+    std::size_t size{0};
+    std::size_t tombstones{0};
+    Policy policy;
+  };
+
+  struct Retired {
+    const Node* node{nullptr};
+    const Payload* payload{nullptr};
+    const Table* table{nullptr};
+  };
+
+  struct alignas(64) ReaderStripe {
+    std::array<std::atomic<std::uint64_t>, 2> readers{};
+    std::atomic<std::uint64_t> hits{0};
+    std::atomic<std::uint64_t> misses{0};
+  };
+
+  // Announces a reader on its stripe for the current phase. The fence pairs
+  // with the one in wait_for_readers(): either the writer sees this reader's
+  // count, or this reader sees the writer's unlinks.
+  class ReadGuard {
+  public:
+    explicit ReadGuard(const PackedKeyCache& cache)
+      : m_stripe(cache.m_stripes[reader_stripe_index()])
+      , m_phase(cache.m_read_phase.load(std::memory_order_acquire) & 1U)
+    {
+      m_stripe.readers[m_phase].fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    ReadGuard(const ReadGuard&) = delete;
+    auto operator=(const ReadGuard&) -> ReadGuard& = delete;
+
+    ~ReadGuard() {
+      m_stripe.readers[m_phase].fetch_sub(1, std::memory_order_release);
+    }
+
+    auto stripe() const -> ReaderStripe& { return m_stripe; }
+
+  private:
+    ReaderStripe& m_stripe;
+    std::size_t m_phase;
+  };
+
+  static auto slot_count_for(std::size_t capacity) -> std::size_t {
+    return std::bit_ceil(std::max<std::size_t>(capacity * 2, 8));
+  }
+
+  static auto mix(std::uint64_t key) -> std::uint64_t {
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return key;
+  }
+
+  static auto reader_stripe_index() -> std::size_t {
+    static std::atomic<std::size_t> next_stripe{0};
+    thread_local const std::size_t stripe =
+      next_stripe.fetch_add(1, std::memory_order_relaxed) % READER_STRIPES;
+    return stripe;
+  }
+
+  auto shard_for(std::uint64_t hash) const -> Shard& {
+    return *m_shards[hash & m_shard_mask];
+  }
+
+  template <typename Visitor>
+  static auto visit_node(Node* node, Visitor&& visitor) -> bool {
+    if (node == nullptr) {
+      return false;
+    }
+    touch_entry(node);
+    return visitor(node->payload.load(std::memory_order_acquire)->value);
+  }
+
+  auto lookup(std::uint64_t key) const -> Node* {
+    const auto hash = mix(key);
+    const auto* table = shard_for(hash).table.load(std::memory_order_acquire);
+    auto index = (hash >> m_shard_shift) & table->mask;
+    for (std::size_t probe = 0; probe <= table->mask; ++probe) {
+      const auto& slot = table->slots[index];
+      const auto slot_key = slot.key.load(std::memory_order_acquire);
+      if (slot_key == EMPTY_KEY) {
+        return nullptr;
+      }
+      if (slot_key == key) {
+        auto* node = slot.node.load(std::memory_order_acquire);
+        if (node != nullptr && node->key == key) {
+          return node;
+        }
+      }
+      index = (index + 1) & table->mask;
+    }
+    return nullptr;
+  }
+
+  // Unlinks the policy's victim, leaving a tombstone in its slot.
+  auto evict(Shard& shard, Table& table) -> const Node* {
+    auto* node = shard.policy.victim();
+    auto& slot = table.slots[node->slot];
+    slot.key.store(TOMBSTONE_KEY, std::memory_order_release);
+    slot.node.store(nullptr, std::memory_order_release);
+    --shard.size;
+    ++shard.tombstones;
+    m_evictions.fetch_add(1, std::memory_order_relaxed);
+    return node;
+  }
+
+  // Copies live slots into a fresh table; the nodes themselves are shared.
+  auto rebuild(Shard& shard, const Table& table) -> Table* {
+    auto* fresh = new Table(table.mask + 1);
+    for (std::size_t index = 0; index <= table.mask; ++index) {
+      auto* node = table.slots[index].node.load(std::memory_order_relaxed);
+      if (node == nullptr) {
+        continue;
+      }
+      auto target = (node->hash >> m_shard_shift) & fresh->mask;
+      while (fresh->slots[target].key.load(std::memory_order_relaxed) !=
+             EMPTY_KEY) {
+        target = (target + 1) & fresh->mask;
+      }
+      node->slot = target;
+      fresh->slots[target].node.store(node, std::memory_order_relaxed);
+      fresh->slots[target].key.store(node->key, std::memory_order_relaxed);
+    }
+    shard.tombstones = 0;
+    return fresh;
+  }
+
+  void retire(const Retired& retired) {
+    if (retired.node == nullptr && retired.payload == nullptr &&
+        retired.table == nullptr) {
+      return;
+    }
+
+    std::lock_guard lock(m_retire_mutex);
+    if (retired.node != nullptr) {
+      m_retired_nodes.push_back(retired.node);
+    }
+    if (retired.payload != nullptr) {
+      m_retired_payloads.push_back(retired.payload);
+    }
+    if (retired.table != nullptr) {
+      m_retired_tables.push_back(retired.table);
+    }
+    if (m_retired_nodes.size() + m_retired_payloads.size() +
+          m_retired_tables.size() <
+        RETIRE_BATCH) {
+      return;
+    }
+
+    wait_for_readers();
+    for (const auto* node : m_retired_nodes) {
+      delete node;
+    }
+    for (const auto* payload : m_retired_payloads) {
+      delete payload;
+    }
+    for (const auto* table : m_retired_tables) {
+      delete table;
+    }
+    m_retired_nodes.clear();
+    m_retired_payloads.clear();
+    m_retired_tables.clear();
+  }
+
+  // Flips the read phase twice, each time waiting for readers of the phase
+  // just left. A reader that sampled the phase before a flip but announced
+  // itself after the wait is caught by the second flip, so everything retired
+  // before this call is unreachable when it returns.
+  void wait_for_readers() {
+    for (int flip = 0; flip < 2; ++flip) {
+      const auto previous =
+        m_read_phase.fetch_xor(1, std::memory_order_acq_rel) & 1U;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      for (const auto& stripe : m_stripes) {
+        while (stripe.readers[previous].load(std::memory_order_acquire) !=
+               0) {
+          std::this_thread::yield();
+        }
+      }
+    }
+  }
+
+  std::size_t m_shard_count;
+  std::size_t m_shard_mask;
+  unsigned m_shard_shift;
+  std::size_t m_shard_capacity;
+  std::vector<std::unique_ptr<Shard>> m_shards;
+
+  mutable std::array<ReaderStripe, READER_STRIPES> m_stripes{};
+  std::atomic<std::size_t> m_read_phase{0};
+  std::mutex m_retire_mutex;
+  std::vector<const Node*> m_retired_nodes;
+  std::vector<const Payload*> m_retired_payloads;
+  std::vector<const Table*> m_retired_tables;
+
+  std::atomic<std::uint64_t> m_evictions{0};
+};
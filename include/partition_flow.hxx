@@ -0,0 +1,93 @@
+#pragma once
+
+#include "flow_watermarks.hxx"
+
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+// Which load queues of the Kafka reader have their partitions paused.
+//
+// Design:
+// - One entry per load queue: each lane, or the shared queue. A queue flips
+//   between paused and running by its FlowWatermarks
+// - librdkafka hands out the partitions of a rebalance unpaused, while the
+//   queue they feed may still be paused. to_pause() picks those partitions so
+//   the reader pauses them again before its next poll; the watermarks alone
+//   would not, since the queue's state did not change
+// - The caller does the pausing and owns the consumer; this only keeps the
+//   state, so it can be tested without a broker
+//
+// Not thread-safe. Only the polling thread, which also runs the rebalance
+// callback, touches it.
+
+class PartitionFlow {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit PartitionFlow(std::vector<FlowWatermarks> watermarks)
+      : m_watermarks(std::move(watermarks)),
+        m_paused_since(m_watermarks.size()) {}
+
+  [[nodiscard]] auto queue_count() const -> std::size_t {
+    return m_watermarks.size();
+  }
+
+  [[nodiscard]] auto paused(std::size_t queue) const -> bool {
+    return m_paused_since[queue].has_value();
+  }
+
+  [[nodiscard]] auto paused_since(std::size_t queue) const
+      -> const std::optional<Clock::time_point>& {
+    return m_paused_since[queue];
+  }
+
+  // Whether `queue`, now holding `queued` loads, should switch between paused
+  // and running.
+  [[nodiscard]] auto flips(std::size_t queue, std::size_t queued) const
+      -> bool {
+    return m_watermarks[queue].paused(paused(queue), queued) != paused(queue);
+  }
+
+  // Records the queue's new state. Returns how long it was paused when this
+  // resumes it, zero otherwise.
+  auto set_paused(std::size_t queue, bool paused, Clock::time_point now)
+      -> Clock::duration {
+    auto& since = m_paused_since[queue];
+    if (paused) {
+      if (!since) {
+        since = now;
+      }
+      return Clock::duration::zero();
+    }
+    const auto elapsed = since ? now - *since : Clock::duration::zero();
+    since.reset();
+    return elapsed;
+  }
+
+  // The partitions of `assigned` that feed a paused queue. `queue_of` maps a
+  // partition to its queue, or to nullopt for one without a queue.
+  template <typename QueueOf>
+    requires std::invocable<const QueueOf&, std::int32_t>
+  [[nodiscard]] auto to_pause(std::span<const std::int32_t> assigned,
+                              const QueueOf& queue_of) const
+      -> std::vector<std::int32_t> {
+    std::vector<std::int32_t> selected;
+    for (const auto partition : assigned) {
+      const std::optional<std::size_t> queue = queue_of(partition);
+      if (queue.has_value() && paused(*queue)) {
+        selected.push_back(partition);
+      }
+    }
+    return selected;
+  }
+
+private:
+  std::vector<FlowWatermarks> m_watermarks;
+  std::vector<std::optional<Clock::time_point>> m_paused_since;
+};
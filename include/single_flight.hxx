@@ -0,0 +1,167 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// In-flight deduplication for work keyed by packed 64-bit integers.
+//
+// Design:
+// - The first caller to join() a key leads: it does the work and publishes
+//   the result somewhere the others can read it (the path cache). Dropping
+//   its Ticket, on return or by exception, releases the key
+// - Later callers for the same key follow: join() parks them until the
+//   leader releases or the timeout passes. They then read the published
+//   result and only do the work themselves if it is not there
+// - Keys are spread over N mutex-protected shards (power-of-two). Each flight
+//   owns its condition variable, so a release wakes only that key's followers
+//
+// The timeout bounds how long a follower trusts a slow leader; a follower
+// that times out does the work without registering, so at most one
+// duplicate runs per timeout.
+
+class SingleFlight {
+  struct Flight {
+    std::condition_variable released;
+    bool done{false};
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<std::uint64_t, std::shared_ptr<Flight>> flights;
+  };
+
+public:
+  struct Metrics {
+    std::uint64_t leaders{};
+    std::uint64_t coalesced_waits{};
+    std::uint64_t timeouts{};
+  };
+
+  class Ticket {
+  public:
+    Ticket() = default;
+
+    Ticket(Ticket&& other) noexcept
+      : m_owner(std::exchange(other.m_owner, nullptr))
+      , m_key(other.m_key)
+      , m_flight(std::move(other.m_flight)) {}
+
+    auto operator=(Ticket&& other) noexcept -> Ticket& {
+      if (this != &other) {
+        release();
+        m_owner = std::exchange(other.m_owner, nullptr);
+        m_key = other.m_key;
+        m_flight = std::move(other.m_flight);
+      }
+      return *this;
+    }
+
+    Ticket(const Ticket&) = delete;
+    auto operator=(const Ticket&) -> Ticket& = delete;
+
+    ~Ticket() { release(); }
+
+    [[nodiscard]] auto leader() const -> bool { return m_owner != nullptr; }
+
+  private:
+    friend class SingleFlight;
+
+    Ticket(SingleFlight* owner, std::uint64_t key,
+           std::shared_ptr<Flight> flight)
+      : m_owner(owner)
+      , m_key(key)
+      , m_flight(std::move(flight)) {}
+
+    void release() {
+      if (m_owner != nullptr) {
+        m_owner->release(m_key, *m_flight);
+        m_owner = nullptr;
+      }
+    }
+
+    SingleFlight* m_owner{nullptr};
+    std::uint64_t m_key{0};
+    std::shared_ptr<Flight> m_flight;
+  };
+
+  explicit SingleFlight(std::size_t shard_count = 64)
+    : m_shards(std::bit_ceil(std::max<std::size_t>(shard_count, 1)))
+    , m_shard_mask(m_shards.size() - 1) {}
+
+  SingleFlight(const SingleFlight&) = delete;
+  auto operator=(const SingleFlight&) -> SingleFlight& = delete;
+
+  // Returns a leading ticket if no flight for `key` is running; otherwise
+  // waits up to `timeout` for it and returns a following ticket.
+  auto join(std::uint64_t key, std::chrono::milliseconds timeout) -> Ticket {
+    auto& shard = shard_for(key);
+    std::unique_lock lock(shard.mutex);
+    auto [found, inserted] = shard.flights.try_emplace(key);
+    if (inserted) {
+      found->second = std::make_shared<Flight>();
+      m_leaders.fetch_add(1, std::memory_order_relaxed);
+      return Ticket(this, key, found->second);
+    }
+
+    const auto flight = found->second;
+    m_coalesced_waits.fetch_add(1, std::memory_order_relaxed);
+    if (!flight->released.wait_for(lock, timeout,
+                                   [&] { return flight->done; })) {
+      m_timeouts.fetch_add(1, std::memory_order_relaxed);
+    }
+    return Ticket{};
+  }
+
+  // Leads a flight for `key` if none is running; otherwise returns an empty
+  // ticket at once. Counts nothing, for speculative work that should simply
+  // skip keys someone is already on.
+  auto try_join(std::uint64_t key) -> Ticket {
+    auto& shard = shard_for(key);
+    std::lock_guard lock(shard.mutex);
+    auto [found, inserted] = shard.flights.try_emplace(key);
+    if (!inserted) {
+      return Ticket{};
+    }
+    found->second = std::make_shared<Flight>();
+    return Ticket(this, key, found->second);
+  }
+
+  auto metrics() const -> Metrics {
+    return Metrics{
+      .leaders = m_leaders.load(std::memory_order_relaxed),
+      .coalesced_waits = m_coalesced_waits.load(std::memory_order_relaxed),
+      .timeouts = m_timeouts.load(std::memory_order_relaxed),
+    };
+  }
+
+private:
+  auto shard_for(std::uint64_t key) -> Shard& {
+    return m_shards[((key * 0x9e3779b97f4a7c15ULL) >> 32U) & m_shard_mask];
+  }
+
+  void release(std::uint64_t key, Flight& flight) {
+    auto& shard = shard_for(key);
+    {
+      std::lock_guard lock(shard.mutex);
+      flight.done = true;
+      shard.flights.erase(key);
+    }
+    flight.released.notify_all();
+  }
+
+  std::vector<Shard> m_shards;
+  std::size_t m_shard_mask;
+  std::atomic<std::uint64_t> m_leaders{0};
+  std::atomic<std::uint64_t> m_coalesced_waits{0};
+  std::atomic<std::uint64_t> m_timeouts{0};
+};
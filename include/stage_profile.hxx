@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <time.h>
+
+// Thread-CPU time per pipeline stage, summed over every thread that runs it.
+//
+// Design:
+// - Off by default. A StageTimer then costs one relaxed load, so the solver
+//   and writer keep their timers in production builds
+// - When on, a timer reads CLOCK_THREAD_CPUTIME_ID when it starts and ends
+//   and adds the difference to its stage
+// - Timers nest per thread: starting one charges the time so far to the
+//   enclosing stage and ending it resumes that stage, so each stage gets only
+//   its own time. Decoding a batch, for one, excludes the loads solved from
+//   inside the decode callback
+// - Fan-out workers and the prefetcher run timers too, so their work lands
+//   in the stage it belongs to rather than in no thread's total
+
+enum class PipelineStage : std::uint8_t {
+  decode,
+  document,
+  find_paths,
+  prefetch,
+  serialize,
+  bulk_assembly,
+  gzip,
+};
+
+inline constexpr std::size_t PIPELINE_STAGE_COUNT = 7;
+
+// The stage a thread is timing and when it last charged that stage.
+struct StageMark {
+  std::optional<PipelineStage> stage;
+  std::chrono::nanoseconds mark{};
+};
+
+class StageProfile {
+public:
+  static void enable(bool enabled) {
+    s_enabled.store(enabled, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] static auto enabled() -> bool {
+    return s_enabled.load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] static auto total(PipelineStage stage)
+    -> std::chrono::nanoseconds {
+    return std::chrono::nanoseconds{
+      s_totals[static_cast<std::size_t>(stage)].load(std::memory_order_relaxed)
+    };
+  }
+
+  [[nodiscard]] static auto thread_time() -> std::chrono::nanoseconds {
+    timespec now{};
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return std::chrono::seconds{ now.tv_sec } +
+           std::chrono::nanoseconds{ now.tv_nsec };
+  }
+
+private:
+  friend class StageTimer;
+
+  static void charge(PipelineStage stage, std::chrono::nanoseconds elapsed) {
+    s_totals[static_cast<std::size_t>(stage)].fetch_add(
+      elapsed.count(), std::memory_order_relaxed);
+  }
+
+  static inline std::atomic<bool> s_enabled{ false };
+  static inline std::array<std::atomic<std::int64_t>, PIPELINE_STAGE_COUNT>
+    s_totals{};
+  static inline thread_local StageMark t_current{};
+};
+
+class StageTimer {
+public:
+  explicit StageTimer(PipelineStage stage) {
+    if (!StageProfile::enabled()) {
+      return;
+    }
+    m_active = true;
+    const auto now = StageProfile::thread_time();
+    auto& current = StageProfile::t_current;
+    if (current.stage.has_value()) {
+      StageProfile::charge(*current.stage, now - current.mark);
+    }
+    m_outer = current.stage;
+    current = { .stage = stage, .mark = now };
+  }
+
+  StageTimer(const StageTimer&) = delete;
+  auto operator=(const StageTimer&) -> StageTimer& = delete;
+
+  ~StageTimer() {
+    if (!m_active) {
+      return;
+    }
+    const auto now = StageProfile::thread_time();
+    auto& current = StageProfile::t_current;
+    StageProfile::charge(*current.stage, now - current.mark);
+    current = { .stage = m_outer, .mark = now };
+  }
+
+private:
+  bool m_active{ false };
+  std::optional<PipelineStage> m_outer;
+};
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Work-stealing executor for short-lived task graphs (graph startup).
+//
+// Design:
+// - One deque per worker. Owners push/pop at the back (LIFO keeps nested
+//   fan-out cache-warm), thieves steal from the front (FIFO takes the oldest
+//   and usually largest piece of work).
+// - Submissions from threads outside the pool are spread round-robin.
+// - TaskGroup::wait() runs queued tasks while it waits, so a task can fan out
+//   and join its children without parking a worker or deadlocking a
+//   single-worker pool.
+// - With nothing to run, a waiter blocks on an activity counter that every
+//   submission and every group completion bumps, so it wakes as soon as there
+//   is a task to help with or its group is done.
+//
+// Each deque has its own mutex. Startup tasks are coarse (HTTP fetches, page
+// parses, route expansion chunks), so lock-free Chase-Lev deques would not pay
+// for their complexity here.
+
+class WorkStealingExecutor {
+public:
+  using Task = std::function<void()>;
+
+  class TaskGroup;
+
+  explicit WorkStealingExecutor(std::size_t worker_count)
+    : m_queues(std::max<std::size_t>(1, worker_count))
+  {
+    m_workers.reserve(m_queues.size());
+    for (std::size_t index = 0; index < m_queues.size(); ++index) {
+      m_workers.emplace_back([this, index](const std::stop_token& stop_token) {
+        worker_loop(index, stop_token);
+      });
+    }
+  }
+
+  WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+  auto operator=(const WorkStealingExecutor&) -> WorkStealingExecutor& = delete;
+
+  ~WorkStealingExecutor()
+  {
+    for (auto& worker : m_workers) {
+      worker.request_stop();
+    }
+    m_idle.notify_all();
+    m_workers.clear();
+  }
+
+  [[nodiscard]] auto worker_count() const -> std::size_t
+  {
+    return m_queues.size();
+  }
+
+  [[nodiscard]] auto steals() const -> std::uint64_t
+  {
+    return m_steals.load(std::memory_order_relaxed);
+  }
+
+  void submit(Task task)
+  {
+    const auto index = home_queue();
+    m_queued.fetch_add(1, std::memory_order_release);
+    {
+      std::scoped_lock lock(m_queues[index].mutex);
+      m_queues[index].tasks.push_back(std::move(task));
+    }
+    {
+      std::scoped_lock lock(m_idle_mutex);
+    }
+    m_idle.notify_one();
+    notify_activity();
+  }
+
+  // Runs one queued task on the calling thread. Returns false when every deque
+  // is empty.
+  auto try_run_one() -> bool
+  {
+    auto task = take(home_queue());
+    if (!task.has_value()) {
+      return false;
+    }
+    (*task)();
+    return true;
+  }
+
+private:
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  struct WorkerBinding {
+    const WorkStealingExecutor* executor = nullptr;
+    std::size_t index = 0;
+  };
+
+  // Read before looking for work; wait_for_activity() then returns once
+  // anything was submitted or a group completed since.
+  [[nodiscard]] auto activity() const -> std::uint64_t
+  {
+    return m_activity.load(std::memory_order_acquire);
+  }
+
+  void wait_for_activity(std::uint64_t seen) const
+  {
+    m_activity.wait(seen, std::memory_order_acquire);
+  }
+
+  void notify_activity()
+  {
+    m_activity.fetch_add(1, std::memory_order_release);
+    m_activity.notify_all();
+  }
+
+  static auto binding() -> WorkerBinding&
+  {
+    thread_local WorkerBinding current;
+    return current;
+  }
+
+  auto home_queue() -> std::size_t
+  {
+    const auto& current = binding();
+    if (current.executor == this) {
+      return current.index;
+    }
+    return m_next_queue.fetch_add(1, std::memory_order_relaxed) %
+           m_queues.size();
+  }
+
+  auto take(std::size_t home) -> std::optional<Task>
+  {
+    {
+      auto& queue = m_queues[home];
+      std::scoped_lock lock(queue.mutex);
+      if (!queue.tasks.empty()) {
+        auto task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        m_queued.fetch_sub(1, std::memory_order_acq_rel);
+        return task;
+      }
+    }
+
+    for (std::size_t offset = 1; offset < m_queues.size(); ++offset) {
+      auto& victim = m_queues[(home + offset) % m_queues.size()];
+      std::scoped_lock lock(victim.mutex);
+      if (!victim.tasks.empty()) {
+        auto task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        m_queued.fetch_sub(1, std::memory_order_acq_rel);
+        m_steals.fetch_add(1, std::memory_order_relaxed);
+        return task;
+      }
+    }
+    return std::nullopt;
+  }
+
+  void worker_loop(std::size_t index, const std::stop_token& stop_token)
+  {
+    binding() = WorkerBinding{.executor = this, .index = index};
+    while (!stop_token.stop_requested()) {
+      if (auto task = take(index); task.has_value()) {
+        (*task)();
+        continue;
+      }
+
+      std::unique_lock lock(m_idle_mutex);
+      m_idle.wait(lock, stop_token, [this]() {
+        return m_queued.load(std::memory_order_acquire) > 0;
+      });
+    }
+  }
+
+  std::vector<WorkerQueue> m_queues;
+  std::atomic<std::size_t> m_next_queue{0};
+  std::atomic<std::size_t> m_queued{0};
+  std::atomic<std::uint64_t> m_steals{0};
+  std::atomic<std::uint64_t> m_activity{0};
+  std::mutex m_idle_mutex;
+  std::condition_variable_any m_idle;
+  std::vector<std::jthread> m_workers;
+};
+
+// Tracks a set of tasks submitted to one executor. wait() helps drain the
+// executor until every task in the group finished and rethrows the first
+// exception a task raised.
+class WorkStealingExecutor::TaskGroup {
+public:
+  explicit TaskGroup(WorkStealingExecutor& executor)
+    : m_executor(executor)
+  {
+  }
+
+  TaskGroup(const TaskGroup&) = delete;
+  auto operator=(const TaskGroup&) -> TaskGroup& = delete;
+
+  ~TaskGroup()
+  {
+    try {
+      wait();
+    } catch (...) {
+      // Destruction without an explicit wait() drops task failures.
+    }
+  }
+
+  void run(Task task)
+  {
+    m_pending.fetch_add(1, std::memory_order_acq_rel);
+    m_executor.submit([this, task = std::move(task)]() {
+      std::exception_ptr error;
+      try {
+        task();
+      } catch (...) {
+        error = std::current_exception();
+      }
+      // The last completion is published under the lock: wait() re-acquires
+      // it before returning, so the group cannot be destroyed while a task
+      // still touches it.
+      std::scoped_lock lock(m_mutex);
+      if (error && !m_error) {
+        m_error = error;
+      }
+      if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        m_executor.notify_activity();
+      }
+    });
+  }
+
+  void wait()
+  {
+    while (m_pending.load(std::memory_order_acquire) > 0) {
+      const auto seen = m_executor.activity();
+      if (m_executor.try_run_one()) {
+        continue;
+      }
+      if (m_pending.load(std::memory_order_acquire) == 0) {
+        break;
+      }
+      m_executor.wait_for_activity(seen);
+    }
+
+    std::exception_ptr error;
+    {
+      std::scoped_lock lock(m_mutex);
+      error = std::exchange(m_error, nullptr);
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+private:
+  WorkStealingExecutor& m_executor;
+  std::atomic<std::size_t> m_pending{0};
+  std::mutex m_mutex;
+  std::exception_ptr m_error;
+};
+
+// Runs body(index) for every index in [0, count) with at most max_workers
+// tasks in flight. Indices are claimed in ascending order, so callers that
+// consume results in order see the prefix complete first.
+template<typename Body>
+void
+parallel_for(WorkStealingExecutor& executor,
+             std::size_t count,
+             std::size_t max_workers,
+             Body&& body)
+{
+  const auto workers = std::min(count, std::max<std::size_t>(1, max_workers));
+  if (workers <= 1) {
+    for (std::size_t index = 0; index < count; ++index) {
+      body(index);
+    }
+    return;
+  }
+
+  std::atomic<std::size_t> next{0};
+  WorkStealingExecutor::TaskGroup group(executor);
+  for (std::size_t worker = 0; worker < workers; ++worker) {
+    group.run([&]() {
+      for (auto index = next.fetch_add(1, std::memory_order_relaxed);
+           index < count;
+           index = next.fetch_add(1, std::memory_order_relaxed)) {
+        body(index);
+      }
+    });
+  }
+  group.wait();
+}
@@ -7,13 +7,53 @@ export module moirai.file_reader;
 export import std;
 export import moirai.scan_reader;
 
+// Replays newline-delimited load payloads from local files, then follows
+// them for appended lines. Capture files written by --record-to are replayed
+// once instead. Each file is read on its own thread.
 export class FileReader : public ScanReader {
+public:
+  struct Metrics {
+    std::uint64_t lines{};
+    std::uint64_t bytes{};
+    std::uint64_t wakeups{};
+  };
+
 private:
-  std::filesystem::path m_load_file;
+  std::vector<std::filesystem::path> m_load_files;
+  std::atomic<std::uint64_t> m_lines{0};
+  std::atomic<std::uint64_t> m_bytes{0};
+  std::atomic<std::uint64_t> m_wakeups{0};
+
+  // Reads `path` from the start and follows it until stopped, through
+  // truncation and rotation.
+  void follow(const std::filesystem::path& path,
+              const std::stop_token& stop_token);
+
+  // Enqueues every load of the capture file `path`.
+  void replay(const std::filesystem::path& path,
+              const std::stop_token& stop_token);
+
+  // Moves `batch` into the load queue. Returns false once the queue stops
+  // accepting.
+  auto enqueue_batch(std::vector<std::string>& batch,
+                     const std::stop_token& stop_token) -> bool;
+
+  // Splits `text` into lines and enqueues them in bulk, unparsed. Returns the
+  // bytes consumed: through the last newline, or all of `text` when
+  // `final_line` says an unterminated tail is complete. Returns nullopt once
+  // the load queue stops accepting.
+  auto enqueue_lines(std::string_view text, bool final_line,
+                     std::vector<std::string>& batch,
+                     const std::stop_token& stop_token)
+      -> std::optional<std::size_t>;
 
 public:
   FileReader(const std::string& datafile, BlockingQueue<std::string>* load_queue);
+  FileReader(std::vector<std::filesystem::path> datafiles,
+             BlockingQueue<std::string>* load_queue);
   ~FileReader() override;
 
   void run(std::stop_token stop_token) override;
+
+  [[nodiscard]] auto metrics() const -> Metrics;
 };
@@ -20,6 +20,10 @@ struct HttpResponse {
   std::string body;
 };
 
+// Receives response body bytes as they arrive. Returning false aborts the
+// transfer.
+using HttpBodySink = std::function<bool(std::string_view)>;
+
 class HttpClient {
 private:
   std::shared_ptr<void> m_handle;
@@ -38,6 +42,53 @@ public:
             const std::vector<std::string>& headers = {}) -> HttpResponse;
 };
 
+struct HttpPoolStats {
+  std::uint64_t requests{0};
+  std::uint64_t new_connections{0};
+
+  [[nodiscard]] auto reused_connections() const -> std::uint64_t {
+    return requests - std::min(requests, new_connections);
+  }
+};
+
+// Thread-safe client for API fan-out. Easy handles are recycled so their
+// keep-alive connections survive between calls, and one curl share handle
+// holds the DNS and TLS session caches for all of them. Live connections are
+// not put in the share: libcurl does not support using one connection cache
+// from concurrent threads.
+class HttpClientPool {
+private:
+  std::shared_ptr<void> m_state;
+
+public:
+  HttpClientPool();
+
+  auto request(std::string_view method, const Uri& uri,
+               std::string_view body = {},
+               const std::vector<std::string>& headers = {}) -> HttpResponse;
+
+  auto get(const Uri& uri, const std::vector<std::string>& headers = {})
+      -> HttpResponse;
+
+  // See http_get_stream().
+  auto get_stream(const Uri& uri, const std::vector<std::string>& headers,
+                  const HttpBodySink& sink) -> HttpResponse;
+
+  // Runs the GETs as concurrent transfers on one curl multi handle, keeping at
+  // most max_in_flight active and multiplexing them over HTTP/2 when the
+  // server supports it. Results follow the order of uris; transport failures
+  // are returned as errors rather than thrown.
+  auto get_many(const std::vector<Uri>& uris,
+                const std::vector<std::string>& headers,
+                std::size_t max_in_flight)
+      -> std::vector<std::expected<HttpResponse, std::string>>;
+
+  [[nodiscard]] auto stats() const -> HttpPoolStats;
+};
+
+// Process-wide pool behind http_request() and friends.
+auto shared_http_pool() -> HttpClientPool&;
+
 auto parse_uri(const std::string& input) -> Uri;
 
 auto with_query_parameters(
@@ -54,6 +105,12 @@ auto http_request(std::string_view method, const Uri& uri,
 auto http_get(const Uri& uri, const std::vector<std::string>& headers = {})
     -> HttpResponse;
 
+// Streams a successful (2xx) response body into `sink` instead of buffering
+// it; the returned body is empty in that case. Error responses are buffered as
+// usual so callers can log them.
+auto http_get_stream(const Uri& uri, const std::vector<std::string>& headers,
+                     const HttpBodySink& sink) -> HttpResponse;
+
 auto http_post(const Uri& uri, std::string_view body,
                const std::vector<std::string>& headers = {}) -> HttpResponse;
 
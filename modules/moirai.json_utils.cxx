@@ -36,6 +36,34 @@ inline auto parse_json(JsonParser& parser, std::string_view input)
   return result.value_unsafe();
 }
 
+// Bytes simdjson may read past the end of a document. A buffer with this much
+// spare capacity after its contents is parsed in place instead of copied.
+inline constexpr std::size_t JSON_PADDING = simdjson::SIMDJSON_PADDING;
+
+// Copies `input` into a string whose capacity leaves JSON_PADDING spare bytes,
+// so parse_padded_json() can read it where it lies. Moving the string keeps
+// the allocation, and with it the padding.
+inline auto make_padded_payload(std::string_view input) -> std::string {
+  std::string payload;
+  payload.reserve(input.size() + JSON_PADDING);
+  payload.assign(input);
+  return payload;
+}
+
+// Parses without copying when `input` carries the padding; otherwise simdjson
+// falls back to its own padded copy.
+inline auto parse_padded_json(const std::string& input)
+    -> std::optional<Json> {
+  auto& parser = thread_local_parser();
+  auto result = parser.parse(input.data(), input.size(),
+                             input.capacity() - input.size() < JSON_PADDING);
+  if (result.error() != simdjson::SUCCESS) {
+    return std::nullopt;
+  }
+
+  return result.value_unsafe();
+}
+
 inline auto parse_json(std::istream& input) -> std::optional<Json> {
   std::string content(std::istreambuf_iterator<char>(input), {});
   return parse_json(content);
@@ -182,5 +210,251 @@ inline auto find_integer_member(const Json& object, const char* key)
   return get_integer<Integer>(*value);
 }
 
+// Reads one string member of a top-level JSON object without parsing the
+// document; only strings and nesting are tracked. Returns the raw text
+// between the quotes, escapes left as they are, or nullopt if the member is
+// missing or not a string. Meant for routing decisions on hot paths where
+// the payload is parsed properly later.
+inline auto peek_string_member(std::string_view json, std::string_view key)
+    -> std::optional<std::string_view> {
+  const auto is_space = [](char chr) {
+    return chr == ' ' || chr == '\n' || chr == '\r' || chr == '\t';
+  };
+  const auto string_end = [&json](std::size_t quote) -> std::size_t {
+    for (auto index = quote + 1; index < json.size(); ++index) {
+      if (json[index] == '\\') {
+        ++index;
+      } else if (json[index] == '"') {
+        return index;
+      }
+    }
+    return std::string_view::npos;
+  };
+  const auto skip_space = [&](std::size_t index) {
+    while (index < json.size() && is_space(json[index])) {
+      ++index;
+    }
+    return index;
+  };
+
+  int depth = 0;
+  bool expect_key = false;
+  for (std::size_t index = skip_space(0); index < json.size(); ++index) {
+    const char chr = json[index];
+    if (depth == 0 && chr != '{') {
+      return std::nullopt;
+    }
+    switch (chr) {
+    case '{':
+    case '[':
+      ++depth;
+      expect_key = depth == 1;
+      break;
+    case '}':
+    case ']':
+      if (--depth <= 0) {
+        return std::nullopt;
+      }
+      break;
+    case ',':
+      expect_key = depth == 1;
+      break;
+    case '"': {
+      const auto end = string_end(index);
+      if (end == std::string_view::npos) {
+        return std::nullopt;
+      }
+      if (expect_key) {
+        expect_key = false;
+        if (json.substr(index + 1, end - index - 1) == key) {
+          auto value = skip_space(end + 1);
+          if (value >= json.size() || json[value] != ':') {
+            return std::nullopt;
+          }
+          value = skip_space(value + 1);
+          if (value >= json.size() || json[value] != '"') {
+            return std::nullopt;
+          }
+          const auto value_end = string_end(value);
+          if (value_end == std::string_view::npos) {
+            return std::nullopt;
+          }
+          return json.substr(value + 1, value_end - value - 1);
+        }
+      }
+      index = end;
+      break;
+    }
+    default:
+      break;
+    }
+  }
+  return std::nullopt;
+}
+
+// Splits the elements of one array member of a top-level JSON object out of a
+// byte stream fed in arbitrary pieces, so large API dumps never have to be
+// held whole. Only structure is tracked (strings, escapes, nesting); callers
+// validate each element when they parse it.
+class JsonArrayStreamSplitter {
+public:
+  using ElementCallback = std::function<void(std::string_view)>;
+
+  JsonArrayStreamSplitter(std::string member, ElementCallback on_element)
+      : m_member(std::move(member)), m_on_element(std::move(on_element)) {}
+
+  // Returns false once the input is known not to be a JSON object.
+  auto feed(std::string_view bytes) -> bool {
+    m_element_begin = 0;
+    for (std::size_t index = 0; index < bytes.size() && !m_failed; ++index) {
+      const char chr = bytes[index];
+      if (m_in_string) {
+        if (m_escaped) {
+          m_escaped = false;
+        } else if (chr == '\\') {
+          m_escaped = true;
+        } else if (chr == '"') {
+          m_in_string = false;
+          continue;
+        }
+        if (m_depth == 1) {
+          m_string.push_back(chr);
+        }
+        continue;
+      }
+      consume(bytes, index, chr);
+    }
+    if (m_in_element && !m_failed) {
+      m_element.append(bytes.substr(m_element_begin));
+    }
+    return !m_failed;
+  }
+
+  [[nodiscard]] auto failed() const -> bool { return m_failed; }
+
+  // True once the top-level object has been closed.
+  [[nodiscard]] auto complete() const -> bool { return m_complete; }
+
+  [[nodiscard]] auto found_member() const -> bool { return m_found; }
+
+  [[nodiscard]] auto elements() const -> std::size_t { return m_elements; }
+
+private:
+  static auto is_space(char chr) -> bool {
+    return chr == ' ' || chr == '\n' || chr == '\r' || chr == '\t';
+  }
+
+  void start_element(std::size_t index, bool scalar) {
+    m_in_element = true;
+    m_scalar = scalar;
+    m_element_begin = index;
+    m_element.clear();
+  }
+
+  void finish_element(std::string_view bytes, std::size_t end) {
+    const auto tail = bytes.substr(m_element_begin, end - m_element_begin);
+    if (m_element.empty()) {
+      m_on_element(tail);
+    } else {
+      m_element.append(tail);
+      m_on_element(m_element);
+      m_element.clear();
+    }
+    m_in_element = false;
+    ++m_elements;
+  }
+
+  void consume(std::string_view bytes, std::size_t index, char chr) {
+    if (!m_started) {
+      if (is_space(chr)) {
+        return;
+      }
+      m_failed = chr != '{';
+      m_started = true;
+      m_depth = 1;
+      return;
+    }
+    if (m_complete) {
+      m_failed = !is_space(chr);
+      return;
+    }
+
+    const bool element_slot = m_in_array && m_depth == 2 && !m_in_element;
+    switch (chr) {
+    case '"':
+      if (element_slot) {
+        start_element(index, true);
+      }
+      m_in_string = true;
+      if (m_depth == 1) {
+        m_string.clear();
+      }
+      break;
+    case ':':
+      if (m_depth == 1) {
+        m_key = m_string;
+      }
+      break;
+    case '{':
+    case '[':
+      if (element_slot) {
+        start_element(index, false);
+      }
+      if (m_depth == 1 && chr == '[' && m_key == m_member) {
+        m_in_array = true;
+        m_found = true;
+      }
+      ++m_depth;
+      break;
+    case '}':
+    case ']':
+      if (m_in_element && m_scalar && m_depth == 2) {
+        finish_element(bytes, index);
+      }
+      if (--m_depth < 0) {
+        m_failed = true;
+        return;
+      }
+      if (m_in_element && !m_scalar && m_depth == 2) {
+        finish_element(bytes, index + 1U);
+      } else if (m_in_array && m_depth == 1) {
+        m_in_array = false;
+      }
+      m_complete = m_depth == 0;
+      break;
+    case ',':
+      if (m_in_element && m_scalar && m_depth == 2) {
+        finish_element(bytes, index);
+      }
+      if (m_depth == 1) {
+        m_key.clear();
+      }
+      break;
+    default:
+      if (element_slot && !is_space(chr)) {
+        start_element(index, true);
+      }
+      break;
+    }
+  }
+
+  std::string m_member;
+  ElementCallback m_on_element;
+  std::string m_element;
+  std::string m_string;
+  std::string m_key;
+  std::size_t m_element_begin{0};
+  std::size_t m_elements{0};
+  int m_depth{0};
+  bool m_started{false};
+  bool m_complete{false};
+  bool m_failed{false};
+  bool m_found{false};
+  bool m_in_array{false};
+  bool m_in_element{false};
+  bool m_scalar{false};
+  bool m_in_string{false};
+  bool m_escaped{false};
+};
 
 } // namespace moirai
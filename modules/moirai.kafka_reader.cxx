@@ -1,11 +1,16 @@
 module;
 
 #include "blocking_queue_fwd.hxx"
+#include "flow_watermarks.hxx"
+#include "lane_map.hxx"
+#include "load_compactor.hxx"
+#include "partition_flow.hxx"
 #include <librdkafka/rdkafkacpp.h>
 
 export module moirai.kafka_reader;
 
 export import std;
+export import moirai.load_capture;
 export import moirai.scan_reader;
 export import moirai.utils;
 
@@ -15,6 +20,30 @@ public:
     BlockingQueue<std::string>* node;
     BlockingQueue<std::string>* edge;
     BlockingQueue<std::string>* load;
+    // Partition-affine mode: one queue per solver lane. Loads then bypass
+    // `load` and go to the lane their partition is mapped to.
+    std::vector<BlockingQueue<std::string>*> lanes{};
+    // Set when loads superseded by a newer scan of the same bag are dropped.
+    LoadCompactor* compactor{nullptr};
+    // Set when consumed loads are recorded to a capture file.
+    moirai::LoadRecorder* recorder{nullptr};
+  };
+
+  // Each payload is copied once, out of librdkafka's buffer into the padded
+  // string the solver parses in place, so payload_bytes is also the bytes
+  // the reader copies. cpu_time is the reader thread's own CPU time over
+  // run().
+  struct Metrics {
+    std::uint64_t messages{};
+    std::uint64_t polls{};
+    std::uint64_t payload_bytes{};
+    std::chrono::nanoseconds cpu_time{};
+    std::vector<std::uint64_t> lane_messages{};
+    std::uint64_t lane_rebalances{};
+    // Flow control: how often a queue's partitions were paused, and for how
+    // long in total (summed over lanes).
+    std::uint64_t pauses{};
+    std::chrono::nanoseconds paused_time{};
   };
 
 private:
@@ -22,7 +51,26 @@ private:
     void operator()(RdKafka::KafkaConsumer* consumer) const;
   };
 
+  // Applies the group assignment, keeps the partition -> lane map in step
+  // with it and pauses newly assigned partitions whose queue is paused.
+  class Rebalancer : public RdKafka::RebalanceCb {
+  public:
+    explicit Rebalancer(KafkaReader& reader) : m_reader(reader) {}
+
+    void rebalance_cb(RdKafka::KafkaConsumer* consumer,
+                      RdKafka::ErrorCode error,
+                      std::vector<RdKafka::TopicPartition*>& partitions)
+        override;
+
+  private:
+    KafkaReader& m_reader;
+  };
+
   std::string m_broker_url;
+  // Declared before the consumer: closing it can still call the rebalancer.
+  std::vector<BlockingQueue<std::string>*> m_lanes;
+  LaneMap m_lane_map;
+  std::unique_ptr<Rebalancer> m_rebalancer;
   std::unique_ptr<RdKafka::KafkaConsumer, ConsumerDeleter> m_consumer;
   const size_t m_batch_size;
   const std::chrono::milliseconds m_timeout;
@@ -32,6 +80,37 @@ private:
   std::unordered_map<std::string, std::string> m_properties;
   BlockingQueue<std::string>* m_node_queue;
   BlockingQueue<std::string>* m_edge_queue;
+  LoadCompactor* m_load_compactor;
+  moirai::LoadRecorder* m_recorder;
+  bool m_consume_batch;
+  bool m_flow_control;
+  std::size_t m_pause_high_percent;
+  std::size_t m_resume_low_percent;
+  // Messages taken per poll: --batch-size, capped so that one poll fits in
+  // the smallest load queue.
+  std::size_t m_poll_size;
+  // Pause state of each load queue: one per lane, or the shared one.
+  PartitionFlow m_flow;
+  Metrics m_metrics;
+
+  auto queue_for(const std::string& topic) const
+      -> BlockingQueue<std::string>*;
+  void assign_lanes(const std::vector<RdKafka::TopicPartition*>& partitions);
+  void revoke_lanes(const std::vector<RdKafka::TopicPartition*>& partitions);
+  auto flow_queue(std::size_t index) const -> BlockingQueue<std::string>*;
+  auto flow_queue_of(std::int32_t partition) const
+      -> std::optional<std::size_t>;
+  void apply_flow_control();
+  void set_paused(std::size_t index, bool paused);
+  void pause_assigned(
+      const std::vector<RdKafka::TopicPartition*>& partitions);
+  void consume_messages(const std::stop_token& stop_token);
+  void consume_batches(const std::stop_token& stop_token);
+  void admit_load(const BlockingQueue<std::string>* queue,
+                  std::string_view payload);
+  void record_load(std::string_view payload, std::int64_t timestamp_ms,
+                   std::int32_t partition, std::int64_t offset);
+  void log_metrics() const;
 
 public:
   KafkaReader(const std::string& broker_url, size_t batch_size,
@@ -47,5 +126,7 @@ public:
   auto dispatch_message(const RdKafka::Message& message,
                         const std::stop_token& stop_token) -> bool;
 
+  [[nodiscard]] auto metrics() const -> const Metrics&;
+
   void run(std::stop_token stop_token) override;
 };
@@ -0,0 +1,108 @@
+export module moirai.load_capture;
+
+export import std;
+
+export namespace moirai {
+
+// A consumed load and where it came from. `timestamp_ms` is the Kafka message
+// timestamp (-1 when the broker has none); loads that did not come from Kafka
+// carry partition and offset -1.
+struct LoadRecord {
+  std::int64_t timestamp_ms{-1};
+  std::int32_t partition{-1};
+  std::int64_t offset{-1};
+  std::string_view payload;
+};
+
+// Capture files hold loads in a compact binary log:
+//
+//   file   := magic "MOIRCAP1" frame*
+//   frame  := codec:u8 pad:u8[3] raw_bytes:u32 stored_bytes:u32 records:u32
+//             data:u8[stored_bytes]
+//   record := timestamp_ms:i64 offset:i64 partition:i32 length:u32
+//             payload:u8[length]
+//
+// Integers are little-endian. `data` is the frame's records, stored as is
+// (codec 0) or zlib-compressed (codec 1). A frame cut short by a crash ends
+// the capture.
+auto is_load_capture(const std::filesystem::path& path) -> bool;
+
+// How a recorder writes its frames. Stored frames replay at memory speed.
+// zlib frames are several times smaller, but inflating them makes replay
+// CPU-bound. A zlib frame that would not shrink is stored.
+enum class CaptureCodec : std::uint8_t {
+  stored = 0,
+  zlib = 1,
+};
+
+// Appends loads to a capture file. record() only copies the load into a
+// pending frame under a mutex; a writer thread compresses and writes frames,
+// so the caller never waits on compression or disk. Loads recorded while the
+// writer is too far behind are dropped and counted.
+class LoadRecorder {
+public:
+  struct Metrics {
+    std::uint64_t records{};
+    std::uint64_t dropped{};
+    std::uint64_t frames{};
+    std::uint64_t raw_bytes{};
+    std::uint64_t stored_bytes{};
+  };
+
+  // Truncates `path`. Throws std::runtime_error if it cannot be opened.
+  explicit LoadRecorder(const std::filesystem::path& path,
+                        CaptureCodec codec = CaptureCodec::stored);
+  LoadRecorder(const LoadRecorder&) = delete;
+  auto operator=(const LoadRecorder&) -> LoadRecorder& = delete;
+  ~LoadRecorder();
+
+  void record(const LoadRecord& record);
+
+  // Writes what is pending and stops the writer. Later records are dropped.
+  void close();
+
+  [[nodiscard]] auto metrics() const -> Metrics;
+
+private:
+  std::filesystem::path m_path;
+  std::ofstream m_output;
+  CaptureCodec m_codec;
+  mutable std::mutex m_mutex;
+  std::condition_variable m_ready;
+  std::string m_pending;
+  std::uint32_t m_pending_records{0};
+  bool m_closing{false};
+  Metrics m_metrics;
+  std::jthread m_writer;
+
+  void write_frames();
+  auto write_frame(std::string_view raw, std::uint32_t records) -> bool;
+};
+
+// Reads a capture file frame by frame. Records come back in the order they
+// were recorded.
+class LoadCaptureReader {
+public:
+  // Throws std::runtime_error if `path` cannot be opened or is not a capture.
+  explicit LoadCaptureReader(const std::filesystem::path& path);
+
+  // Returns the next record, or nullopt at the end of the capture. The
+  // payload view is valid until the next call. Throws std::runtime_error on a
+  // corrupt frame.
+  auto next() -> std::optional<LoadRecord>;
+
+  // Whether the capture ended in a partly written frame.
+  [[nodiscard]] auto truncated() const -> bool { return m_truncated; }
+
+private:
+  std::filesystem::path m_path;
+  std::ifstream m_input;
+  std::string m_stored;
+  std::string m_frame;
+  std::size_t m_position{0};
+  bool m_truncated{false};
+
+  auto read_frame() -> bool;
+};
+
+} // namespace moirai
@@ -0,0 +1,91 @@
+export module moirai.load_payload;
+
+export import std;
+
+export namespace moirai {
+
+// One load as decoded by decode_load(): a single on-demand pass over the
+// payload that keeps string views instead of copies. The views point into the
+// decoding thread's parser and stay valid until that thread decodes its next
+// load.
+struct LoadFields {
+  static constexpr std::uint16_t ID = 1U << 0U;
+  static constexpr std::uint16_t LOCATION = 1U << 1U;
+  static constexpr std::uint16_t DESTINATION = 1U << 2U;
+  static constexpr std::uint16_t TIME = 1U << 3U;
+  static constexpr std::uint16_t ORIGIN_CENTER = 1U << 4U;
+  static constexpr std::uint16_t IPDD_DESTINATION = 1U << 5U;
+  static constexpr std::uint16_t CS_SLID = 1U << 6U;
+  static constexpr std::uint16_t CS_ACT = 1U << 7U;
+  static constexpr std::uint16_t PID = 1U << 8U;
+  static constexpr std::uint16_t ITEMS = 1U << 9U;
+  static constexpr std::uint16_t REQUIRED = ID | LOCATION | DESTINATION | TIME;
+
+  // Fields that were present as strings (or, for ITEMS, as an array).
+  std::uint16_t present{0};
+  std::string_view id;
+  std::string_view location;
+  std::string_view destination;
+  std::string_view event_time;
+  std::string_view origin_center;
+  std::string_view ipdd_destination;
+  std::string_view cs_slid;
+  std::string_view cs_act;
+  std::string_view pid;
+
+  [[nodiscard]] auto has(std::uint16_t fields) const -> bool {
+    return (present & fields) == fields;
+  }
+};
+
+struct LoadItem {
+  static constexpr std::uint8_t ID = 1U << 0U;
+  static constexpr std::uint8_t CN = 1U << 1U;
+  static constexpr std::uint8_t IPDD_DESTINATION = 1U << 2U;
+  static constexpr std::uint8_t REQUIRED = ID | CN | IPDD_DESTINATION;
+
+  std::size_t index{0};
+  std::uint8_t present{0};
+  std::string_view id;
+  std::string_view cn;
+  std::string_view ipdd_destination;
+
+  [[nodiscard]] auto has(std::uint8_t fields) const -> bool {
+    return (present & fields) == fields;
+  }
+};
+
+enum class LoadDecodeError : std::uint8_t {
+  INVALID_JSON,
+  NOT_AN_OBJECT,
+  MISSING_REQUIRED,
+};
+
+// Decodes a load payload in one pass, replacing the contents of `items` with
+// its waybills in order (one entry per array element, objects or not). The
+// first occurrence of a key wins, fields of the wrong type count as absent,
+// and `items` falls back to `item` when it is not an array.
+auto decode_load(const std::string& payload, std::vector<LoadItem>& items)
+    -> std::expected<LoadFields, LoadDecodeError>;
+
+using LoadVisitor = std::function<void(
+    std::size_t, const std::expected<LoadFields, LoadDecodeError>&)>;
+
+// Decodes a batch of payloads through one simdjson document stream, so
+// structural indexing runs once over the whole batch instead of once per
+// load. Calls `visit` with each payload's index, in order, and its result as
+// decode_load() would return it; `items` holds that load's waybills during
+// the call, and the views are only valid until `visit` returns. Payloads the
+// stream cannot map one to one (malformed or multi-document ones, and
+// everything after them) are decoded singly. Returns how many were decoded
+// from the stream.
+auto decode_loads(std::span<const std::string> payloads,
+                  std::vector<LoadItem>& items, const LoadVisitor& visit)
+    -> std::size_t;
+
+// Payload bytes the calling thread's decoder has copied so far: payloads
+// without parser padding copied by decode_load(), and batches laid out in the
+// decode_loads() arena. Padded payloads decoded singly add nothing.
+auto decode_copied_bytes() -> std::uint64_t;
+
+} // namespace moirai
@@ -10,3 +10,8 @@ auto parse_path(const Path&) -> std::vector<SearchPathLocation>;
 
 export template <PathTraversalMode P>
 void parse_path_into(const Path&, std::vector<SearchPathLocation>&);
+
+// Packs a solver path into an immutable handle for the path cache and search
+// documents. Steps without a node are dropped.
+export template <PathTraversalMode P>
+auto compact_path(const Path&) -> CompactPathHandle;
@@ -2,6 +2,7 @@ export module moirai.search_document;
 
 export import std;
 export import moirai.date_utils;
+export import moirai.transportation;
 
 export struct SearchPathLocation {
   std::string code;
@@ -15,8 +16,103 @@ export struct SearchPathLocation {
   bool has_departure{false};
 };
 
+// One hop of a solved path. The pointers refer into the solver graph, which
+// is immutable once built and outlives every document that references it.
+export struct CompactPathHop {
+  const TransportCenter* node{nullptr};
+  const TransportEdge* outbound{nullptr};
+  CLOCK distance{};
+};
+
+// Solved path shared by the path cache and every document served from it.
+// Codes, names and formatted timestamps are only produced by
+// append_path_locations(), once per serialized document.
+export struct CompactPath {
+  PathTraversalMode mode{PathTraversalMode::FORWARD};
+  std::vector<CompactPathHop> hops;
+};
+
+export using CompactPathHandle = std::shared_ptr<const CompactPath>;
+
+// Expands path steps (PathStep or CompactPathHop) into search locations.
+// Forward steps carry the arrival at each node; reverse steps carry the
+// latest departure, so arrivals are rebuilt from the previous outbound edge.
+export template <PathTraversalMode P, typename Steps>
+void append_path_locations(const Steps& steps,
+                           std::vector<SearchPathLocation>& response) {
+  response.reserve(response.size() + std::size(steps));
+  if (std::empty(steps)) {
+    return;
+  }
+
+  auto arrival = std::begin(steps)->distance;
+  for (const auto& step : steps) {
+    if (step.node == nullptr) {
+      continue;
+    }
+    if constexpr (P == PathTraversalMode::FORWARD) {
+      arrival = step.distance;
+    }
+
+    SearchPathLocation entry;
+    entry.code = step.node->code;
+    entry.facility_name = step.node->name;
+    entry.arrival = format_clock(arrival);
+    entry.arrival_ts = arrival.time_since_epoch().count() * 60;
+    if (step.outbound != nullptr) {
+      const auto departure =
+        P == PathTraversalMode::FORWARD
+          ? get_departure(step.distance, step.outbound->departure)
+          : step.distance;
+      entry.route = step.outbound->route_prefix;
+      entry.route_name = step.outbound->name;
+      entry.departure = format_clock(departure);
+      entry.departure_ts = departure.time_since_epoch().count() * 60;
+      entry.has_departure = true;
+      if constexpr (P == PathTraversalMode::REVERSE) {
+        arrival = step.distance + step.outbound->duration;
+      }
+    }
+    response.push_back(std::move(entry));
+  }
+}
+
+// A document section holds either expanded `locations` or a shared `path`
+// handle; the path cache and solver always produce the handle.
 export struct SearchPathSection {
   std::vector<SearchPathLocation> locations;
+  CompactPathHandle path;
+
+  [[nodiscard]] auto size() const -> std::size_t {
+    return path != nullptr ? path->hops.size() : locations.size();
+  }
+
+  [[nodiscard]] auto empty() const -> bool { return size() == 0; }
+
+  // Returns the section's locations, expanding `path` into `storage` when
+  // the section only holds a handle.
+  [[nodiscard]] auto resolve(std::vector<SearchPathLocation>& storage) const
+      -> std::span<const SearchPathLocation> {
+    if (path == nullptr) {
+      return locations;
+    }
+    storage.clear();
+    if (path->mode == PathTraversalMode::FORWARD) {
+      append_path_locations<PathTraversalMode::FORWARD>(path->hops, storage);
+    } else {
+      append_path_locations<PathTraversalMode::REVERSE>(path->hops, storage);
+    }
+    return storage;
+  }
+
+  [[nodiscard]] auto expand() const -> std::vector<SearchPathLocation> {
+    std::vector<SearchPathLocation> storage;
+    const auto resolved = resolve(storage);
+    if (path == nullptr) {
+      return {resolved.begin(), resolved.end()};
+    }
+    return storage;
+  }
 };
 
 export struct SearchDocument {
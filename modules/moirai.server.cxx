@@ -24,10 +24,14 @@ private:
   std::string m_route_uri;
   std::string m_route_token;
 
-  std::string m_scans_query_file;
+  std::vector<std::filesystem::path> m_scans_query_files;
+  std::filesystem::path m_record_to;
 
   bool m_help_requested = false;
   bool m_local_mode = false;
+  bool m_partition_lanes = false;
+  bool m_compact_loads = false;
+  bool m_record_compress = false;
   std::string m_command_name = "moirai";
 
   void display_help() const;
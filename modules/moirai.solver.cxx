@@ -2,6 +2,7 @@ export module moirai.solver;
 
 export import std;
 import moirai.date_utils;
+import moirai.route_schedule;
 import moirai.transportation;
 
 export using NodeId = std::uint32_t;
@@ -20,6 +21,15 @@ export struct PathStep {
 
 export struct Path {
   std::vector<PathStep> steps;
+  // Query times (starts for forward paths, deadlines for reverse paths) for
+  // which these steps and the time at the far end stay optimal.
+  CLOCK valid_from{};
+  CLOCK valid_until{};
+  // Steps [anchored_begin, anchored_end) are reached without waiting for a
+  // scheduled departure, so their times move with the query time inside the
+  // validity interval: a prefix of forward paths, a suffix of reverse paths.
+  std::size_t anchored_begin{0};
+  std::size_t anchored_end{0};
 
   [[nodiscard]] auto empty() const -> bool { return steps.empty(); }
   [[nodiscard]] explicit operator bool() const { return !empty(); }
@@ -55,6 +65,10 @@ export struct SolverGraphStats {
   std::size_t incoming_storage{};
   double average_out_degree{};
   std::uint32_t max_out_degree{};
+  std::size_t colocation_hubs{};
+  std::size_t custody_edges{};
+  // All-pairs custody edges the co-location hubs made unnecessary.
+  std::size_t custody_edges_saved{};
 };
 
 export struct TransparentStringHash {
@@ -96,6 +110,7 @@ private:
   mutable std::vector<std::uint32_t> m_incoming_offsets;
   mutable std::mutex m_csr_mutex;
   mutable std::atomic_bool m_csr_dirty{true};
+  std::atomic<std::uint64_t> m_graph_version{0};
   std::unordered_map<std::string,
                      NodeId,
                      TransparentStringHash,
@@ -106,10 +121,21 @@ private:
                      TransparentStringHash,
                      TransparentStringEqual>
       m_edge_by_name;
+  std::vector<std::uint8_t> m_colocation_hub;
+  mutable std::unordered_map<std::uint64_t, TransportEdge> m_colocation_hops;
+  mutable std::shared_mutex m_colocation_mutex;
+  std::size_t m_colocation_hubs{0};
+  std::size_t m_custody_edges{0};
+  std::size_t m_custody_pairs{0};
 
   [[nodiscard]] auto valid_node(NodeId node) const -> bool;
+  [[nodiscard]] auto is_colocation_hub(NodeId node) const -> bool;
+  [[nodiscard]] auto colocation_hop(NodeId source, NodeId target) const
+      -> const TransportEdge*;
+  void collapse_colocation_hops(Path& path) const;
   void invalidate_graph();
   void rebuild_csr() const;
+  void rebuild_csr_parallel(std::size_t workers) const;
   [[nodiscard]] auto outgoing_edges(NodeId node) const -> std::span<const EdgeId>;
   [[nodiscard]] auto incoming_edges(NodeId node) const -> std::span<const EdgeId>;
   [[nodiscard]] auto build_forward_path(NodeId source, NodeId target,
@@ -152,9 +178,52 @@ public:
                               const std::shared_ptr<TransportEdge>& route)
       -> EdgeId;
 
+  // Inserts every spec whose endpoints exist, exactly as calling add_edge on
+  // each spec in order would: same edge ids, same code deduplication, same
+  // CSR. Schedules and edge records are built in parallel for large batches.
+  // Returns one id per spec (the existing id for duplicate codes,
+  // INVALID_EDGE when an endpoint is unknown). Specs that were inserted are
+  // moved from.
+  [[nodiscard]] auto add_edges_bulk(std::span<RouteEdgeSpec> specs)
+      -> std::vector<EdgeId>;
+
+  // Makes custody moves between any two co-located facilities free. Large
+  // groups get a virtual hub node with one zero-cost edge in and one out per
+  // member instead of k*(k-1) direct CUSTODY-a-b edges; paths through the hub
+  // still report the direct CUSTODY-a-b hop. Small groups, where a hub would
+  // not save edges, keep the direct edges. Invalid members are skipped.
+  // Returns the number of edges added.
+  auto add_colocation_group(std::string_view group,
+                            std::span<const NodeId> members) -> std::size_t;
+
   [[nodiscard]] auto find_edge(std::string_view edge_code) const
       -> std::optional<EdgeId>;
 
+  // Ids of the graph records a Path points into, and back, so solved paths
+  // can be persisted and reattached to an identical graph. edge_id() returns
+  // INVALID_EDGE for custody hops through a co-location hub, which are not
+  // graph edges; custody_hop() rebuilds those from their two members and
+  // returns nullptr when no hub joins them. Unknown records map to
+  // INVALID_NODE, INVALID_EDGE or nullptr.
+  [[nodiscard]] auto node_id(const TransportCenter* node) const -> NodeId;
+  [[nodiscard]] auto edge_id(const TransportEdge* edge) const -> EdgeId;
+  [[nodiscard]] auto node_record(NodeId node) const -> const TransportCenter*;
+  [[nodiscard]] auto edge_record(EdgeId edge) const -> const TransportEdge*;
+  [[nodiscard]] auto custody_hop(NodeId source, NodeId target) const
+      -> const TransportEdge*;
+
+  // Stable 64-bit hash of everything a solve depends on: node codes and
+  // co-location hubs, and each edge's code, endpoints, weekly schedules,
+  // durations, vehicle and movement. Equal fingerprints mean equal ids and
+  // equal paths for every query.
+  [[nodiscard]] auto graph_fingerprint() const -> std::uint64_t;
+
+  // Bumped by every node or edge change. Results solved under an older
+  // version may no longer hold; unlike graph_fingerprint() this is O(1) and
+  // only meaningful within one process. The server never changes the graph
+  // after startup, so in production it stays put.
+  [[nodiscard]] auto graph_version() const -> std::uint64_t;
+
   [[nodiscard]] auto show() const -> std::string;
 
   [[nodiscard]] auto show_all() const -> std::string;
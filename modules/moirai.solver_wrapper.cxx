@@ -2,6 +2,11 @@ module;
 
 #include "blocking_queue_fwd.hxx"
 #include "concurrent_cache.hxx"
+#include "heavy_hitters.hxx"
+#include "load_compactor.hxx"
+#include "packed_key_cache.hxx"
+#include "single_flight.hxx"
+#include "work_stealing_executor.hxx"
 
 export module moirai.solver_wrapper;
 
@@ -12,31 +17,256 @@ export import moirai.search_document;
 export import moirai.solver;
 export import moirai.transportation;
 
+// Cache hits share the compact path with every document built from them, so
+// a hit costs a reference count rather than a copy of the expanded path.
 export struct PathCacheEntry {
-  std::vector<SearchPathLocation> locations;
+  CompactPathHandle path;
   CLOCK first_distance{};
   CLOCK last_distance{};
   bool found{false};
 };
 
-export using PathCache = ConcurrentCache<PathCacheEntry>;
+// One solve cached for every query time in [valid_from, valid_until]: start
+// times for forward queries, deadlines for reverse ones. Hops in
+// [anchored_begin, anchored_end) were reached without waiting for a
+// departure, so at() moves their times from solved_at to the query time.
+export struct PathCacheInterval {
+  CLOCK valid_from{};
+  CLOCK valid_until{};
+  CLOCK solved_at{};
+  std::uint32_t anchored_begin{0};
+  std::uint32_t anchored_end{0};
+  // Solver::graph_version() the interval was solved on. Unreachable results
+  // stop counting once it changes, since any new edge might connect the pair.
+  // The server builds the graph once at startup, so this only matters for a
+  // runtime graph update path, which does not exist yet.
+  std::uint64_t graph_version{0};
+  // Solved by the idle-time prefetcher and not hit since.
+  bool prefetched{false};
+  PathCacheEntry entry;
+
+  [[nodiscard]] auto contains(CLOCK query) const -> bool {
+    return valid_from <= query && query <= valid_until;
+  }
+
+  // The entry a solve at `query` would have produced. Shares the cached path
+  // unless anchored hop times have to move.
+  [[nodiscard]] auto at(CLOCK query) const -> PathCacheEntry;
+};
+
+// Cached solves for one (mode, vehicle, source, target), ordered by
+// valid_from. Intervals never overlap.
+export using PathCacheIntervals = std::vector<PathCacheInterval>;
+
+export inline constexpr std::size_t PATH_CACHE_MAX_INTERVALS = 16;
+// Keys the hot-pair sketch tracks; the prefetcher works on the top of these.
+export inline constexpr std::size_t PATH_CACHE_HOT_KEYS = 4'096;
+// Lookups sampled into the sketch: one in this many per solver thread.
+export inline constexpr std::size_t PATH_CACHE_HOT_KEY_SAMPLE = 16;
+
+// Path cache shared by every solver thread. Threads that miss on the same key
+// at once wait on `inflight` for one solve instead of each running it.
+// A sample of lookups feeds `hot_keys` with their query time, which tells
+// the prefetcher what to solve ahead while the load queues are empty.
+export struct PathCache : PackedKeyCache<PathCacheIntervals> {
+  using PackedKeyCache::PackedKeyCache;
+
+  SingleFlight inflight;
+  HeavyHitters<CLOCK> hot_keys{PATH_CACHE_HOT_KEYS, 16,
+                               PATH_CACHE_HOT_KEY_SAMPLE};
+  // Solver runs behind this cache, coalesced or not.
+  std::atomic<std::uint64_t> solves{0};
+  // Intervals the prefetcher solved, and how many of them a load later hit.
+  std::atomic<std::uint64_t> prefetched{0};
+  std::atomic<std::uint64_t> prefetch_hits{0};
+  // Lookups answered with a cached "unreachable", which skip the search.
+  std::atomic<std::uint64_t> unreachable_hits{0};
+};
+
+// Wraps a solver result for the cache. Unreachable pairs stay unreachable at
+// every query time.
+export auto make_path_cache_interval(PathTraversalMode mode, const Path& path,
+                                     CLOCK query) -> PathCacheInterval;
+
+export auto find_path_interval(const PathCacheIntervals& intervals,
+                               CLOCK query) -> const PathCacheInterval*;
+
+// As above, skipping an unreachable result solved on a graph version other
+// than `graph_version`.
+export auto find_path_interval(const PathCacheIntervals& intervals,
+                               CLOCK query,
+                               std::uint64_t graph_version)
+  -> const PathCacheInterval*;
+
+// Returns `current` with `added` merged in. Overlapping intervals with the
+// same arrival (forward) or departure (reverse) are joined, keeping the path
+// that stays feasible the longest: the one with the latest start or the
+// earliest deadline. Overlaps that disagree can only come from a graph that
+// changed under the cache and are replaced by `added`. Beyond
+// PATH_CACHE_MAX_INTERVALS, the intervals furthest from `added` are dropped.
+export auto merge_path_interval(const PathCacheIntervals* current,
+                                PathCacheInterval added,
+                                PathTraversalMode mode) -> PathCacheIntervals;
+
+// Packs a path query into a PathCache key: 1 bit traversal mode, 3 bits
+// vehicle and 29 bits each for source and target node. Query times are not
+// part of the key; they select an interval inside the entry. The top bit is
+// always set, so keys never collide with the reserved empty and tombstone
+// keys. Queries that do not fit are not cached.
+export inline auto make_path_cache_key(PathTraversalMode mode,
+                                       VehicleType vehicle,
+                                       NodeId source,
+                                       NodeId target)
+    -> std::optional<std::uint64_t> {
+  constexpr unsigned NODE_BITS = 29;
+  constexpr unsigned VEHICLE_BITS = 3;
+  if ((source >> NODE_BITS) != 0 || (target >> NODE_BITS) != 0 ||
+      (static_cast<unsigned>(vehicle) >> VEHICLE_BITS) != 0) {
+    return std::nullopt;
+  }
+
+  return (std::uint64_t{1} << 63U) |
+         (static_cast<std::uint64_t>(mode == PathTraversalMode::REVERSE)
+          << 62U) |
+         (static_cast<std::uint64_t>(vehicle) << 59U) |
+         (static_cast<std::uint64_t>(source) << NODE_BITS) | target;
+}
+
+// The paths last served for one bag, kept so its scan at the next facility
+// on the route can be answered without a search.
+export struct BagItinerary {
+  NodeId target{INVALID_NODE};
+  PathCacheEntry earliest;
+  // bag_pdd the ultimate path was solved for.
+  CLOCK deadline{};
+  PathCacheEntry ultimate;
+};
+
+// Itineraries keyed by bag id. `hits` counts re-scans answered from the
+// stored earliest path, `misses` bags seen for the first time (or evicted)
+// and `deviations` re-scans the stored path could not answer: off route,
+// early, past its next departure or bound for another target.
+export struct BagItineraryCache : ConcurrentCache<BagItinerary> {
+  using ConcurrentCache::ConcurrentCache;
+
+  std::atomic<std::uint64_t> hits{0};
+  std::atomic<std::uint64_t> misses{0};
+  std::atomic<std::uint64_t> deviations{0};
+};
+
+// The rest of a forward path for a bag that reached `node` at `arrival`.
+// Every suffix of an earliest-arrival path is itself earliest from its first
+// hop, and a later arrival cannot do better, so the suffix stays optimal from
+// the predicted arrival until the bag would miss its next scheduled
+// departure. Hops up to that departure are re-timed to `arrival`. An earlier
+// arrival might catch an earlier departure and has to be solved.
+export auto earliest_path_suffix(const PathCacheEntry& earliest,
+                                 const TransportCenter* node,
+                                 CLOCK arrival)
+  -> std::optional<PathCacheEntry>;
+
+// The rest of a reverse path from `node` on. Reverse paths are read off the
+// latest-departure tree of their deadline, so the suffix is what a solve from
+// `node` for the same deadline returns.
+export auto ultimate_path_suffix(const PathCacheEntry& ultimate,
+                                 const TransportCenter* node)
+  -> std::optional<PathCacheEntry>;
+
+// A facility code that loads named as source or target but the graph does
+// not know, with the number of such loads.
+export struct MissingFacility {
+  std::string code;
+  std::uint64_t loads{0};
+};
+
+// Facility codes whose loads are tracked in the missing-facility sketch.
+export inline constexpr std::size_t MISSING_FACILITY_KEYS = 1'024;
+// Loads per missing facility code, shared by every solver thread.
+export using MissingFacilitySketch = HeavyHitters<std::string>;
+
+// Size and timing of one path cache snapshot written or read.
+export struct PathCacheSnapshotStats {
+  std::size_t entries{0};
+  std::size_t intervals{0};
+  std::size_t bytes{0};
+  // Blocks that failed validation on load; their entries are skipped.
+  std::size_t corrupt_blocks{0};
+  std::int64_t elapsed_ms{0};
+};
+
+// Writes every cached key with its intervals and compact paths to `path`,
+// one block per cache shard, tagged with the solver's graph fingerprint.
+// Paths are stored as node and edge ids. The snapshot is written beside
+// `path` and renamed over it, so a crash mid-write keeps the previous one.
+export auto save_path_cache(const PathCache& cache, const Solver& solver,
+                            const std::filesystem::path& path)
+  -> std::expected<PathCacheSnapshotStats, std::string>;
+
+// Inserts a snapshot written by save_path_cache() into `cache`, decoding its
+// blocks on up to `threads` threads (0: one per hardware thread). Fails
+// without touching the cache when the file is unreadable, of another format
+// version, or fingerprinted against a different graph.
+export auto load_path_cache(PathCache& cache, const Solver& solver,
+                            const std::filesystem::path& path,
+                            std::size_t threads = 0)
+  -> std::expected<PathCacheSnapshotStats, std::string>;
+
+// The query a PathCache key was packed from.
+export struct PathCacheQuery {
+  PathTraversalMode mode{PathTraversalMode::FORWARD};
+  VehicleType vehicle{VehicleType::SURFACE};
+  NodeId source{INVALID_NODE};
+  NodeId target{INVALID_NODE};
+};
+
+export inline auto unpack_path_cache_key(std::uint64_t key) -> PathCacheQuery {
+  constexpr unsigned NODE_BITS = 29;
+  constexpr std::uint64_t NODE_MASK = (std::uint64_t{1} << NODE_BITS) - 1;
+  return PathCacheQuery{
+    .mode = ((key >> 62U) & 1U) != 0 ? PathTraversalMode::REVERSE
+                                     : PathTraversalMode::FORWARD,
+    .vehicle = static_cast<VehicleType>((key >> 59U) & 0b111U),
+    .source = static_cast<NodeId>((key >> NODE_BITS) & NODE_MASK),
+    .target = static_cast<NodeId>(key & NODE_MASK),
+  };
+}
 
 export struct PathCacheConfig {
   bool enabled{true};
   std::size_t max_entries{65'536};
-  std::uint32_t bucket_minutes{1};
+  // How long a miss waits for an identical solve already in flight; zero
+  // disables coalescing.
+  std::chrono::milliseconds inflight_timeout{100};
+  // Snapshot loaded at startup and written on shutdown; empty disables.
+  std::filesystem::path snapshot_path;
+  // Also write the snapshot this often while running; zero only writes it
+  // on shutdown.
+  std::chrono::seconds snapshot_interval{0};
+  // Hottest keys the idle-time prefetcher keeps solved ahead; zero disables
+  // it.
+  std::size_t prefetch_pairs{256};
+  // How far past a key's latest query time the prefetcher solves.
+  std::chrono::minutes prefetch_horizon{12 * 60};
+  // Bags whose latest paths are kept for their next scan; zero disables the
+  // itinerary cache.
+  std::size_t itinerary_entries{262'144};
 };
 
 export class SolverWrapper {
 public:
   using HttpGet = std::function<moirai::HttpResponse(
       const moirai::Uri&, const std::vector<std::string>&)>;
+  using HttpStream = std::function<moirai::HttpResponse(
+      const moirai::Uri&, const std::vector<std::string>&,
+      const moirai::HttpBodySink&)>;
 
   struct RuntimeQueues {
     BlockingQueue<std::string>* node;
     BlockingQueue<std::string>* edge;
     BlockingQueue<std::string>* load;
     BlockingQueue<SearchDocument>* solution;
+    // Shared with the reader when superseded loads are dropped.
+    LoadCompactor* compactor{nullptr};
   };
 
   struct InitEndpoints {
@@ -55,6 +285,18 @@ public:
 
   using FacilityProfiles = std::unordered_map<std::string, FacilityProfile>;
 
+  // What secondary solver threads share with the primary, so every thread
+  // sees the same bags and paths, counts into one list and splits large
+  // loads over one set of workers. A null member gets a private instance
+  // where the configuration enables it.
+  struct SharedState {
+    std::shared_ptr<PathCache> path_cache;
+    std::shared_ptr<FacilityProfiles> facility_profiles;
+    std::shared_ptr<BagItineraryCache> itineraries;
+    std::shared_ptr<MissingFacilitySketch> missing_facilities;
+    std::shared_ptr<WorkStealingExecutor> load_fanout;
+  };
+
 private:
   std::shared_ptr<Solver> m_solver;
 
@@ -72,20 +314,61 @@ private:
   BlockingQueue<std::string>* m_edge_queue{nullptr};
   BlockingQueue<std::string>& m_load_queue;
   BlockingQueue<SearchDocument>& m_solution_queue;
+  LoadCompactor* m_load_compactor{nullptr};
+  // Decode each dequeued batch of loads through one document stream rather
+  // than one parse per load.
+  bool m_batch_decode{true};
   HttpGet m_http_get;
+  HttpStream m_http_stream;
+  moirai::HttpClientPool* m_http_pool{nullptr};
   std::shared_ptr<PathCache> m_path_cache;
   PathCacheConfig m_cache_config;
+  std::shared_ptr<BagItineraryCache> m_itineraries;
+  std::shared_ptr<MissingFacilitySketch> m_missing_facilities =
+    std::make_shared<MissingFacilitySketch>(MISSING_FACILITY_KEYS);
+  // Loads with at least this many distinct children split their deadline
+  // computation over m_load_fanout; zero keeps every load on its solver
+  // thread.
+  std::size_t m_fanout_min_children{0};
+  std::shared_ptr<WorkStealingExecutor> m_load_fanout;
+
+  // Route branch state shared between the expansion tasks and the in-order
+  // edge inserter during startup. Defined in the implementation unit.
+  struct StartupRoutes;
+
+  void load_facilities(WorkStealingExecutor& executor, std::int16_t first_page);
+
+  void fetch_routes(WorkStealingExecutor& executor, StartupRoutes& routes);
+
+  void insert_routes(StartupRoutes& routes);
+
+  // Uses `shared` as the fan-out pool when given, else starts one.
+  void init_load_fanout(std::shared_ptr<WorkStealingExecutor> shared = nullptr);
+
+  // Solves one query and merges the result into the path cache under `key`.
+  auto solve_path(PathTraversalMode mode, std::optional<std::uint64_t> key,
+                  NodeId source, NodeId target, CLOCK query,
+                  bool prefetch = false) const -> PathCacheInterval;
+
+  // Clears the prefetched mark of the interval starting at `valid_from`,
+  // counting a prefetch hit if this call cleared it.
+  void claim_prefetch_hit(std::uint64_t key, CLOCK valid_from) const;
 
 public:
+  // Secondary solver threads pass the primary's shared_state().
   SolverWrapper(RuntimeQueues queues, const std::shared_ptr<Solver>& solver,
                 const std::filesystem::path& center_timings_filename,
-                std::shared_ptr<PathCache> cache = nullptr,
-                std::shared_ptr<FacilityProfiles> facility_profiles = nullptr,
+                SharedState shared = {},
                 HttpGet http_get = moirai::http_get);
 
+  // Without an explicit http_get, startup requests go through the shared
+  // pooled client: facility details run as async transfers and the route dump
+  // is streamed. A custom http_get (tests, replays) serves every request, and
+  // routes are fed to the splitter from its buffered body unless http_stream
+  // is given as well.
   SolverWrapper(RuntimeQueues queues, InitEndpoints endpoints,
                 const std::filesystem::path& center_timings_filename,
-                HttpGet http_get = moirai::http_get);
+                HttpGet http_get = nullptr, HttpStream http_stream = nullptr);
 
   void init_timings(const std::filesystem::path& facility_timings_filename);
 
@@ -100,8 +383,28 @@ public:
 
   [[nodiscard]] auto get_solver() const -> std::shared_ptr<Solver>;
   [[nodiscard]] auto get_cache() const -> std::shared_ptr<PathCache>;
+  [[nodiscard]] auto get_itineraries() const
+      -> std::shared_ptr<BagItineraryCache>;
   [[nodiscard]] auto get_facility_profiles() const
       -> std::shared_ptr<FacilityProfiles>;
+  [[nodiscard]] auto get_missing_facility_sketch() const
+      -> std::shared_ptr<MissingFacilitySketch>;
+  // Null when large loads are not split.
+  [[nodiscard]] auto get_load_fanout() const
+      -> std::shared_ptr<WorkStealingExecutor>;
+  [[nodiscard]] auto shared_state() const -> SharedState;
+
+  // The `count` missing facilities with the most loads, most first. Codes
+  // added to the graph since their loads were seen are left out.
+  [[nodiscard]] auto missing_facilities(std::size_t count) const
+      -> std::vector<MissingFacility>;
+
+  // Logs the most frequent missing facilities as `Missing facility:` lines.
+  void log_missing_facilities() const;
+
+  // Logs the missing facilities every MISSING_FACILITY_REPORT_INTERVAL until
+  // stopped. The server runs this for the primary wrapper only.
+  void run_missing_facility_reports(const std::stop_token& stop_token) const;
 
   auto find_paths(
       std::string bag, std::string bag_source, std::string bag_target,
@@ -111,4 +414,29 @@ public:
       const -> SearchDocument;
 
   void run(const std::stop_token& stop_token);
+
+  // Writes the path cache snapshot if one is configured, logging the
+  // outcome.
+  void save_path_cache_snapshot() const;
+
+  // Writes the snapshot every snapshot_interval until stopped. Returns at
+  // once when periodic snapshots are not configured.
+  void run_path_cache_snapshots(const std::stop_token& stop_token) const;
+
+  // One prefetch pass: for each of the prefetch_pairs hottest keys, solves
+  // the queries after its latest one, up to prefetch_horizon, that no cached
+  // interval covers yet. Stops as soon as a load is queued on any of
+  // `load_queues` (this wrapper's own queue when empty). Returns the number
+  // of solves.
+  auto prefetch_hot_pairs(
+      const std::stop_token& stop_token,
+      std::span<BlockingQueue<std::string>* const> load_queues = {}) const
+      -> std::size_t;
+
+  // Runs prefetch passes at the lowest thread priority whenever every one of
+  // `load_queues` is empty, until stopped. In lane mode pass every lane;
+  // by default only this wrapper's queue is watched.
+  void run_prefetcher(
+      const std::stop_token& stop_token,
+      std::vector<BlockingQueue<std::string>*> load_queues = {}) const;
 };
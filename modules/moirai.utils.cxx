@@ -33,3 +33,11 @@ export auto get_encoded_credentials(const std::string& username,
     -> std::string;
 
 export void to_lower(std::string& value);
+
+// Environment settings. An unset or empty variable yields `fallback`; a value
+// that does not parse throws std::runtime_error naming the variable.
+// Booleans accept 1/true/yes/on and 0/false/no/off in any case.
+export auto parse_bool_env(std::string_view name, bool fallback) -> bool;
+
+export auto parse_size_env(std::string_view name, std::size_t fallback,
+                           bool allow_zero = false) -> std::size_t;
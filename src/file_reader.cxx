@@ -1,71 +1,323 @@
 module;
 
 #include "blocking_queue.hxx"
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 module moirai.file_reader;
 
 import std;
 import moirai.app;
 import moirai.json_utils;
+import moirai.load_capture;
 import moirai.scan_reader;
 
 namespace {
 constexpr auto FILE_POLL_INTERVAL = std::chrono::milliseconds{200};
+// An unterminated last line is taken as complete once the file has not
+// grown for this long, so replay files without a trailing newline lose
+// nothing while a writer part way through a line is not split.
+constexpr auto FILE_TAIL_QUIET = std::chrono::seconds{1};
+constexpr std::size_t FILE_ENQUEUE_BATCH = 256;
+// Files are read with pread() in blocks of this size, doubled for a line
+// that does not fit. A mapping would fault with SIGBUS if the file were
+// truncated while the reader waits for room in the load queue.
+constexpr std::size_t FILE_READ_BLOCK = std::size_t{4} << 20U;
+// Moves and deletes only wake the reader; it notices a replaced file by
+// comparing inodes, which also works without a watch.
+constexpr std::uint32_t FILE_WATCH_EVENTS =
+    IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVE_SELF | IN_DELETE_SELF;
+
+class UniqueFd {
+public:
+  explicit UniqueFd(int fd) : m_fd(fd) {}
+  UniqueFd(const UniqueFd &) = delete;
+  auto operator=(const UniqueFd &) -> UniqueFd & = delete;
+  ~UniqueFd() { reset(-1); }
+
+  [[nodiscard]] auto get() const -> int { return m_fd; }
+
+  void reset(int fd) {
+    if (m_fd >= 0) {
+      ::close(m_fd);
+    }
+    m_fd = fd;
+  }
+
+private:
+  int m_fd;
+};
+
+auto file_size(int fd) -> std::optional<std::uint64_t> {
+  struct stat status {};
+  if (::fstat(fd, &status) != 0) {
+    return std::nullopt;
+  }
+  return static_cast<std::uint64_t>(status.st_size);
 }
 
+// Blocks until inotify reports a change to the watched file, the poll
+// interval passes or a stop is requested. Without a watch it just sleeps
+// for the interval.
+void wait_for_change(int notify_fd, const std::stop_token &stop_token) {
+  if (notify_fd < 0) {
+    moirai::wait_for(stop_token, FILE_POLL_INTERVAL);
+    return;
+  }
+  pollfd watch{.fd = notify_fd, .events = POLLIN, .revents = 0};
+  if (::poll(&watch, 1, static_cast<int>(FILE_POLL_INTERVAL.count())) > 0) {
+    alignas(inotify_event) std::array<char, 4096> events{};
+    while (::read(notify_fd, events.data(), events.size()) > 0) {
+    }
+  }
+}
+
+// True once `path` names a different file than `fd`, as after a rotation
+// that moved or deleted the followed file and created a new one. False while
+// nothing is at `path` yet.
+auto replaced(int fd, const std::filesystem::path &path) -> bool {
+  struct stat opened {};
+  struct stat named {};
+  if (::fstat(fd, &opened) != 0 || ::stat(path.c_str(), &named) != 0) {
+    return false;
+  }
+  return opened.st_dev != named.st_dev || opened.st_ino != named.st_ino;
+}
+
+auto is_blank(std::string_view line) -> bool {
+  return line.find_first_not_of(" \t\r") == std::string_view::npos;
+}
+
+} // namespace
+
 FileReader::FileReader(const std::string &datafile,
                        BlockingQueue<std::string> *load_queue)
-    : ScanReader(load_queue), m_load_file(datafile) {}
+    : FileReader(std::vector<std::filesystem::path>{datafile}, load_queue) {}
+
+FileReader::FileReader(std::vector<std::filesystem::path> datafiles,
+                       BlockingQueue<std::string> *load_queue)
+    : ScanReader(load_queue), m_load_files(std::move(datafiles)) {}
 
 FileReader::~FileReader() = default;
 
+auto FileReader::metrics() const -> Metrics {
+  return Metrics{
+      .lines = m_lines.load(std::memory_order_relaxed),
+      .bytes = m_bytes.load(std::memory_order_relaxed),
+      .wakeups = m_wakeups.load(std::memory_order_relaxed),
+  };
+}
+
 void FileReader::run(std::stop_token stop_token) {
+  if (m_load_files.size() == 1) {
+    follow(m_load_files.front(), stop_token);
+  } else {
+    std::vector<std::jthread> readers;
+    readers.reserve(m_load_files.size());
+    for (const auto &path : m_load_files) {
+      readers.emplace_back([this, &path, stop_token] {
+        follow(path, stop_token);
+      });
+    }
+  }
+
+  const auto totals = metrics();
+  moirai::Application::instance().logger().information(
+      "File reader metrics: files={} lines={} bytes={} wakeups={}",
+      m_load_files.size(), totals.lines, totals.bytes, totals.wakeups);
+}
+
+auto FileReader::enqueue_lines(std::string_view text, bool final_line,
+                               std::vector<std::string> &batch,
+                               const std::stop_token &stop_token)
+    -> std::optional<std::size_t> {
+  const auto take = [&](std::string_view line) -> bool {
+    if (!line.empty() && line.back() == '\r') {
+      line.remove_suffix(1);
+    }
+    if (is_blank(line)) {
+      return true;
+    }
+    m_bytes.fetch_add(line.size(), std::memory_order_relaxed);
+    batch.push_back(moirai::make_padded_payload(line));
+    return batch.size() < FILE_ENQUEUE_BATCH ||
+           enqueue_batch(batch, stop_token);
+  };
+
+  // memchr is the newline scanner: glibc vectorises it, so this stays a
+  // SIMD pass over the block.
+  std::size_t consumed = 0;
+  while (consumed < text.size()) {
+    const auto *newline = static_cast<const char *>(
+        std::memchr(text.data() + consumed, '\n', text.size() - consumed));
+    if (newline == nullptr) {
+      break;
+    }
+    const auto end = static_cast<std::size_t>(newline - text.data());
+    if (!take(text.substr(consumed, end - consumed))) {
+      return std::nullopt;
+    }
+    consumed = end + 1;
+  }
+  if (final_line && consumed < text.size()) {
+    if (!take(text.substr(consumed))) {
+      return std::nullopt;
+    }
+    consumed = text.size();
+  }
+  if (!batch.empty() && !enqueue_batch(batch, stop_token)) {
+    return std::nullopt;
+  }
+  return consumed;
+}
+
+auto FileReader::enqueue_batch(std::vector<std::string> &batch,
+                               const std::stop_token &stop_token) -> bool {
+  const auto accepted =
+      m_load_queue.wait_enqueue_bulk(std::span(batch), stop_token);
+  m_lines.fetch_add(batch.size(), std::memory_order_relaxed);
+  batch.clear();
+  return accepted;
+}
+
+void FileReader::replay(const std::filesystem::path &path,
+                        const std::stop_token &stop_token) {
   auto &app = moirai::Application::instance();
-  std::ifstream load_file_stream(m_load_file);
-  std::streampos last_position = 0;
+  try {
+    moirai::LoadCaptureReader capture(path);
+    std::vector<std::string> batch;
+    batch.reserve(FILE_ENQUEUE_BATCH);
+    while (const auto record = capture.next()) {
+      m_bytes.fetch_add(record->payload.size(), std::memory_order_relaxed);
+      batch.push_back(moirai::make_padded_payload(record->payload));
+      if (batch.size() == FILE_ENQUEUE_BATCH &&
+          !enqueue_batch(batch, stop_token)) {
+        return;
+      }
+    }
+    if (!batch.empty() && !enqueue_batch(batch, stop_token)) {
+      return;
+    }
+    if (capture.truncated()) {
+      app.logger().information("FR: {} ends in a partly written frame",
+                               path.string());
+    }
+  } catch (const std::exception &exc) {
+    app.logger().error("FR: Error replaying {}: {}", path.string(),
+                       exc.what());
+  }
+}
 
-  if (!load_file_stream.is_open() || load_file_stream.fail()) {
-    app.logger().error("FR: Error opening file: {}", m_load_file.string());
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+void FileReader::follow(const std::filesystem::path &path,
+                        const std::stop_token &stop_token) {
+  if (moirai::is_load_capture(path)) {
+    replay(path, stop_token);
     return;
   }
 
+  auto &app = moirai::Application::instance();
+  UniqueFd file(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+  if (file.get() < 0) {
+    app.logger().error("FR: Error opening file: {}", path.string());
+    return;
+  }
+
+  const UniqueFd notify(::inotify_init1(IN_NONBLOCK | IN_CLOEXEC));
+  int watch = notify.get() < 0 ? -1
+                               : ::inotify_add_watch(notify.get(), path.c_str(),
+                                                     FILE_WATCH_EVENTS);
+  if (watch < 0) {
+    app.logger().information(
+        "FR: Cannot watch {} for changes; polling every {}ms", path.string(),
+        FILE_POLL_INTERVAL.count());
+  }
+  const int notify_fd = watch < 0 ? -1 : notify.get();
+
+  std::vector<std::string> batch;
+  batch.reserve(FILE_ENQUEUE_BATCH);
+  std::string block;
+  std::size_t block_size = FILE_READ_BLOCK;
+  std::uint64_t offset = 0;
+  std::uint64_t last_size = 0;
+  auto last_growth = std::chrono::steady_clock::now();
   while (!stop_token.stop_requested()) {
     try {
-      load_file_stream.seekg(0, std::ios::end);
-      auto filesize = load_file_stream.tellg();
-
-      for (auto current = last_position; current < filesize;
-           current = load_file_stream.tellg()) {
-        load_file_stream.seekg(last_position, std::ios::beg);
-        std::string input;
-        if (!std::getline(load_file_stream, input)) {
-          load_file_stream.clear();
+      // Checked before the read, so the old file is drained, its
+      // unterminated tail included, before the reader moves on.
+      const bool rotated = replaced(file.get(), path);
+      const auto size = file_size(file.get());
+      if (!size.has_value()) {
+        app.logger().error("FR: Error reading file: {}", path.string());
+        return;
+      }
+      if (*size < offset) {
+        app.logger().information(
+            "FR: {} was truncated; reading from the start", path.string());
+        offset = 0;
+      }
+      const auto now = std::chrono::steady_clock::now();
+      if (*size != last_size) {
+        last_size = *size;
+        last_growth = now;
+      }
+
+      const bool quiet = rotated || now - last_growth >= FILE_TAIL_QUIET;
+      while (offset < *size) {
+        block.resize(static_cast<std::size_t>(
+            std::min<std::uint64_t>(*size - offset, block_size)));
+        const auto got = ::pread(file.get(), block.data(), block.size(),
+                                 static_cast<off_t>(offset));
+        if (got < 0) {
+          app.logger().error("FR: Error reading file: {}", path.string());
+          return;
+        }
+        if (got == 0) {
+          // Truncated since the size was taken; the next pass starts over.
           break;
         }
-        last_position = load_file_stream.tellg();
-        if (last_position == std::streampos{-1}) {
-          load_file_stream.clear();
-          load_file_stream.seekg(0, std::ios::end);
-          last_position = load_file_stream.tellg();
+        const auto text =
+            std::string_view(block).substr(0, static_cast<std::size_t>(got));
+        const auto consumed = enqueue_lines(
+            text, quiet && offset + text.size() == *size, batch, stop_token);
+        if (!consumed.has_value()) {
+          return;
         }
-        const auto payload = moirai::parse_json(input);
-        if (!payload.has_value()) {
-          app.logger().error("Payload is not valid JSON");
-          continue;
+        offset += *consumed;
+        if (*consumed == 0) {
+          if (text.size() < block_size) {
+            // Only part of a line so far; wait for the rest.
+            break;
+          }
+          block_size *= 2;
         }
+      }
 
-        if (payload->is_object()) {
-          if (!m_load_queue.wait_enqueue(input, stop_token)) {
-            return;
+      if (rotated && offset >= *size) {
+        if (const int next = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            next >= 0) {
+          app.logger().information(
+              "FR: {} was replaced; following the new file", path.string());
+          file.reset(next);
+          offset = 0;
+          last_size = 0;
+          last_growth = now;
+          if (notify_fd >= 0) {
+            ::inotify_rm_watch(notify_fd, watch);
+            watch = ::inotify_add_watch(notify_fd, path.c_str(),
+                                        FILE_WATCH_EVENTS);
           }
-        } else {
-          app.logger().error("Payload is not an object");
+          continue;
         }
       }
     } catch (const std::exception &exc) {
       app.logger().error("FR: Error occurred: {}", exc.what());
     }
 
-    moirai::wait_for(stop_token, FILE_POLL_INTERVAL);
+    wait_for_change(notify_fd, stop_token);
+    m_wakeups.fetch_add(1, std::memory_order_relaxed);
   }
 }
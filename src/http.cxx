@@ -28,13 +28,33 @@ curl_global_state() -> CurlGlobal&
   return state;
 }
 
+struct WriteTarget
+{
+  CURL* curl{ nullptr };
+  std::string* body{ nullptr };
+  const moirai::HttpBodySink* sink{ nullptr };
+  bool aborted{ false };
+};
+
 auto
 write_callback(char* buffer, size_t size, size_t nmemb, void* userdata)
   -> size_t
 {
-  auto* output = static_cast<std::string*>(userdata);
-  output->append(buffer, size * nmemb);
-  return size * nmemb;
+  auto* target = static_cast<WriteTarget*>(userdata);
+  const auto bytes = size * nmemb;
+  if (target->sink != nullptr) {
+    long status_code = 0;
+    curl_easy_getinfo(target->curl, CURLINFO_RESPONSE_CODE, &status_code);
+    if (status_code >= 200 && status_code < 300) {
+      if (!(*target->sink)(std::string_view{ buffer, bytes })) {
+        target->aborted = true;
+        return 0;
+      }
+      return bytes;
+    }
+  }
+  target->body->append(buffer, bytes);
+  return bytes;
 }
 
 auto
@@ -61,26 +81,32 @@ cleanup_curl(void* handle)
   }
 }
 
-auto
-perform_request(CURL* curl,
-                std::string_view method,
-                const moirai::Uri& uri,
-                const std::vector<std::string>& headers,
-                std::string_view body) -> moirai::HttpResponse
+// Owns the header list and request body of one transfer; both must outlive
+// it.
+struct RequestBuffers
 {
-  (void)curl_global_state();
+  curl_slist* header_list{ nullptr };
+  std::string request_body;
 
-  if (curl == nullptr) {
-    throw std::runtime_error("Invalid CURL easy handle");
-  }
+  RequestBuffers() = default;
+  RequestBuffers(const RequestBuffers&) = delete;
+  auto operator=(const RequestBuffers&) -> RequestBuffers& = delete;
 
-  moirai::HttpResponse response;
-  curl_slist* header_list = nullptr;
-  std::string request_body;
+  ~RequestBuffers() { curl_slist_free_all(header_list); }
+};
 
+void
+prepare_request(CURL* curl,
+                std::string_view method,
+                const moirai::Uri& uri,
+                const std::vector<std::string>& headers,
+                std::string_view body,
+                RequestBuffers& buffers,
+                WriteTarget& write_target)
+{
   curl_easy_reset(curl);
   for (const auto& header : headers) {
-    header_list = curl_slist_append(header_list, header.c_str());
+    buffers.header_list = curl_slist_append(buffers.header_list, header.c_str());
   }
 
   curl_easy_setopt(curl, CURLOPT_URL, uri.str().c_str());
@@ -94,10 +120,10 @@ perform_request(CURL* curl,
   curl_easy_setopt(curl, CURLOPT_TCP_NODELAY, 1L);
   curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
   curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, &write_callback);
-  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response.body);
+  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &write_target);
 
-  if (header_list != nullptr) {
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, header_list);
+  if (buffers.header_list != nullptr) {
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, buffers.header_list);
   }
 
   const std::string method_name{ method };
@@ -110,25 +136,201 @@ perform_request(CURL* curl,
   }
 
   if (method_name != "GET" && method_name != "HEAD") {
-    request_body.assign(body);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request_body.c_str());
-    curl_easy_setopt(
-      curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(request_body.size()));
+    buffers.request_body.assign(body);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, buffers.request_body.c_str());
+    curl_easy_setopt(curl,
+                     CURLOPT_POSTFIELDSIZE,
+                     static_cast<long>(buffers.request_body.size()));
   }
+}
+
+auto
+perform_request(CURL* curl,
+                std::string_view method,
+                const moirai::Uri& uri,
+                const std::vector<std::string>& headers,
+                std::string_view body,
+                const moirai::HttpBodySink* sink = nullptr)
+  -> moirai::HttpResponse
+{
+  (void)curl_global_state();
+
+  if (curl == nullptr) {
+    throw std::runtime_error("Invalid CURL easy handle");
+  }
+
+  moirai::HttpResponse response;
+  WriteTarget write_target{ .curl = curl, .body = &response.body, .sink = sink };
+  RequestBuffers buffers;
+  prepare_request(curl, method, uri, headers, body, buffers, write_target);
 
   const CURLcode result = curl_easy_perform(curl);
   if (result != CURLE_OK) {
-    std::string message = curl_easy_strerror(result);
-    curl_slist_free_all(header_list);
-    throw std::runtime_error(message);
+    throw std::runtime_error(
+      write_target.aborted ? std::string{ "Response stream aborted by consumer" }
+                           : std::string{ curl_easy_strerror(result) });
   }
 
   curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.status_code);
-
-  curl_slist_free_all(header_list);
   return response;
 }
 
+auto
+new_connections(CURL* curl) -> std::uint64_t
+{
+  long connects = 0;
+  curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+  return connects > 0 ? static_cast<std::uint64_t>(connects) : 0U;
+}
+
+class PoolState
+{
+public:
+  PoolState()
+  {
+    (void)curl_global_state();
+    m_share = curl_share_init();
+    if (m_share == nullptr) {
+      throw std::runtime_error("Failed to create CURL share handle");
+    }
+    curl_share_setopt(m_share, CURLSHOPT_LOCKFUNC, &lock_share);
+    curl_share_setopt(m_share, CURLSHOPT_UNLOCKFUNC, &unlock_share);
+    curl_share_setopt(m_share, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+  }
+
+  PoolState(const PoolState&) = delete;
+  auto operator=(const PoolState&) -> PoolState& = delete;
+
+  ~PoolState()
+  {
+    for (auto* multi : m_idle_multis) {
+      curl_multi_cleanup(multi);
+    }
+    for (auto* curl : m_idle_handles) {
+      curl_easy_cleanup(curl);
+    }
+    curl_share_cleanup(m_share);
+  }
+
+  // Easy handles keep their share binding and live connections across
+  // curl_easy_reset(), so a recycled handle reuses its keep-alive connection.
+  auto acquire_handle() -> CURL*
+  {
+    {
+      std::scoped_lock lock(m_idle_mutex);
+      if (!m_idle_handles.empty()) {
+        auto* curl = m_idle_handles.back();
+        m_idle_handles.pop_back();
+        return curl;
+      }
+    }
+    CURL* curl = curl_easy_init();
+    if (curl == nullptr) {
+      throw std::runtime_error("Failed to create CURL easy handle");
+    }
+    curl_easy_setopt(curl, CURLOPT_SHARE, m_share);
+    return curl;
+  }
+
+  void release_handle(CURL* curl)
+  {
+    std::scoped_lock lock(m_idle_mutex);
+    m_idle_handles.push_back(curl);
+  }
+
+  // Multi handles own the connection cache of their transfers; keeping them
+  // idle between calls keeps those connections warm for the next batch.
+  auto acquire_multi() -> CURLM*
+  {
+    {
+      std::scoped_lock lock(m_idle_mutex);
+      if (!m_idle_multis.empty()) {
+        auto* multi = m_idle_multis.back();
+        m_idle_multis.pop_back();
+        return multi;
+      }
+    }
+    CURLM* multi = curl_multi_init();
+    if (multi == nullptr) {
+      throw std::runtime_error("Failed to create CURL multi handle");
+    }
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    return multi;
+  }
+
+  void release_multi(CURLM* multi)
+  {
+    std::scoped_lock lock(m_idle_mutex);
+    m_idle_multis.push_back(multi);
+  }
+
+  void record(CURL* curl)
+  {
+    m_requests.fetch_add(1, std::memory_order_relaxed);
+    m_new_connections.fetch_add(new_connections(curl),
+                                std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] auto stats() const -> moirai::HttpPoolStats
+  {
+    return { .requests = m_requests.load(std::memory_order_relaxed),
+             .new_connections =
+               m_new_connections.load(std::memory_order_relaxed) };
+  }
+
+private:
+  static void lock_share(CURL* /*curl*/,
+                         curl_lock_data data,
+                         curl_lock_access /*access*/,
+                         void* userdata)
+  {
+    static_cast<PoolState*>(userdata)->m_share_locks.at(data).lock();
+  }
+
+  static void unlock_share(CURL* /*curl*/, curl_lock_data data, void* userdata)
+  {
+    static_cast<PoolState*>(userdata)->m_share_locks.at(data).unlock();
+  }
+
+  CURLSH* m_share{ nullptr };
+  std::array<std::mutex, CURL_LOCK_DATA_LAST> m_share_locks;
+  std::mutex m_idle_mutex;
+  std::vector<CURL*> m_idle_handles;
+  std::vector<CURLM*> m_idle_multis;
+  std::atomic<std::uint64_t> m_requests{ 0 };
+  std::atomic<std::uint64_t> m_new_connections{ 0 };
+};
+
+// Returns a recycled easy handle to its pool when the request scope ends.
+class PooledHandle
+{
+public:
+  explicit PooledHandle(PoolState& state)
+    : m_state(state)
+    , m_curl(state.acquire_handle())
+  {
+  }
+
+  PooledHandle(const PooledHandle&) = delete;
+  auto operator=(const PooledHandle&) -> PooledHandle& = delete;
+
+  ~PooledHandle() { m_state.release_handle(m_curl); }
+
+  [[nodiscard]] auto get() const -> CURL* { return m_curl; }
+
+private:
+  PoolState& m_state;
+  CURL* m_curl;
+};
+
+auto
+pool_state(const std::shared_ptr<void>& state) -> PoolState&
+{
+  return *static_cast<PoolState*>(state.get());
+}
+
 } // namespace
 
 namespace moirai {
@@ -189,6 +391,168 @@ HttpClient::post(const Uri& uri,
   return request("POST", uri, body, headers);
 }
 
+HttpClientPool::HttpClientPool()
+  : m_state(std::make_shared<PoolState>())
+{
+}
+
+auto
+HttpClientPool::request(std::string_view method,
+                        const Uri& uri,
+                        std::string_view body,
+                        const std::vector<std::string>& headers)
+  -> HttpResponse
+{
+  auto& state = pool_state(m_state);
+  const PooledHandle handle(state);
+  auto response = perform_request(handle.get(), method, uri, headers, body);
+  state.record(handle.get());
+  return response;
+}
+
+auto
+HttpClientPool::get(const Uri& uri, const std::vector<std::string>& headers)
+  -> HttpResponse
+{
+  return request("GET", uri, {}, headers);
+}
+
+auto
+HttpClientPool::get_stream(const Uri& uri,
+                           const std::vector<std::string>& headers,
+                           const HttpBodySink& sink) -> HttpResponse
+{
+  auto& state = pool_state(m_state);
+  const PooledHandle handle(state);
+  auto response = perform_request(handle.get(), "GET", uri, headers, {}, &sink);
+  state.record(handle.get());
+  return response;
+}
+
+auto
+HttpClientPool::get_many(const std::vector<Uri>& uris,
+                         const std::vector<std::string>& headers,
+                         std::size_t max_in_flight)
+  -> std::vector<std::expected<HttpResponse, std::string>>
+{
+  struct Transfer
+  {
+    CURL* curl{ nullptr };
+    HttpResponse response;
+    WriteTarget write_target;
+    RequestBuffers buffers;
+  };
+
+  // Detaches unfinished transfers if the loop throws, so every handle goes
+  // back to the pool clean.
+  struct MultiLease
+  {
+    PoolState& state;
+    CURLM* multi;
+    std::vector<Transfer>& transfers;
+
+    ~MultiLease()
+    {
+      for (auto& transfer : transfers) {
+        if (transfer.curl != nullptr) {
+          curl_multi_remove_handle(multi, transfer.curl);
+          state.release_handle(transfer.curl);
+        }
+      }
+      state.release_multi(multi);
+    }
+  };
+
+  auto& state = pool_state(m_state);
+  std::vector<std::expected<HttpResponse, std::string>> results(uris.size());
+  std::vector<Transfer> transfers(uris.size());
+  const MultiLease lease{ .state = state,
+                          .multi = state.acquire_multi(),
+                          .transfers = transfers };
+  CURLM* multi = lease.multi;
+  const auto limit = std::max<std::size_t>(1, max_in_flight);
+  std::size_t next = 0;
+  std::size_t active = 0;
+
+  const auto start_transfer = [&](std::size_t index) {
+    auto& transfer = transfers[index];
+    transfer.curl = state.acquire_handle();
+    transfer.write_target = WriteTarget{ .curl = transfer.curl,
+                                         .body = &transfer.response.body };
+    prepare_request(transfer.curl,
+                    "GET",
+                    uris[index],
+                    headers,
+                    {},
+                    transfer.buffers,
+                    transfer.write_target);
+    // Wait for an HTTP/2 connection to multiplex on instead of opening one
+    // connection per transfer.
+    curl_easy_setopt(transfer.curl, CURLOPT_PIPEWAIT, 1L);
+    curl_easy_setopt(
+      transfer.curl, CURLOPT_PRIVATE, reinterpret_cast<void*>(index));
+    curl_multi_add_handle(multi, transfer.curl);
+    ++active;
+  };
+
+  const auto finish_transfer = [&](CURL* curl, CURLcode result) {
+    void* private_data = nullptr;
+    curl_easy_getinfo(curl, CURLINFO_PRIVATE, &private_data);
+    const auto index = reinterpret_cast<std::size_t>(private_data);
+    auto& transfer = transfers[index];
+    if (result == CURLE_OK) {
+      curl_easy_getinfo(
+        curl, CURLINFO_RESPONSE_CODE, &transfer.response.status_code);
+      results[index] = std::move(transfer.response);
+    } else {
+      results[index] = std::unexpected{ std::string{
+        curl_easy_strerror(result) } };
+    }
+    state.record(curl);
+    curl_multi_remove_handle(multi, curl);
+    state.release_handle(curl);
+    transfer.curl = nullptr;
+    --active;
+  };
+
+  while (next < uris.size() || active > 0) {
+    while (active < limit && next < uris.size()) {
+      start_transfer(next++);
+    }
+
+    int running = 0;
+    if (const auto code = curl_multi_perform(multi, &running);
+        code != CURLM_OK) {
+      throw std::runtime_error(curl_multi_strerror(code));
+    }
+
+    int queued = 0;
+    while (CURLMsg* message = curl_multi_info_read(multi, &queued)) {
+      if (message->msg == CURLMSG_DONE) {
+        finish_transfer(message->easy_handle, message->data.result);
+      }
+    }
+
+    if (active > 0) {
+      curl_multi_poll(multi, nullptr, 0, 1000, nullptr);
+    }
+  }
+  return results;
+}
+
+auto
+HttpClientPool::stats() const -> HttpPoolStats
+{
+  return pool_state(m_state).stats();
+}
+
+auto
+shared_http_pool() -> HttpClientPool&
+{
+  static HttpClientPool pool;
+  return pool;
+}
+
 auto
 parse_uri(const std::string& input) -> Uri
 {
@@ -291,8 +655,7 @@ http_request(std::string_view method,
              std::string_view body,
              const std::vector<std::string>& headers) -> HttpResponse
 {
-  HttpClient client;
-  return client.request(method, uri, body, headers);
+  return shared_http_pool().request(method, uri, body, headers);
 }
 
 auto
@@ -302,6 +665,14 @@ http_get(const Uri& uri, const std::vector<std::string>& headers)
   return http_request("GET", uri, {}, headers);
 }
 
+auto
+http_get_stream(const Uri& uri,
+                const std::vector<std::string>& headers,
+                const HttpBodySink& sink) -> HttpResponse
+{
+  return shared_http_pool().get_stream(uri, headers, sink);
+}
+
 auto
 http_post(const Uri& uri,
           std::string_view body,
@@ -1,18 +1,33 @@
 module;
 
 #include "blocking_queue.hxx"
+#include "load_compactor.hxx"
+#include <librdkafka/rdkafka.h>
 #include <librdkafka/rdkafkacpp.h>
+#include <time.h>
 
 module moirai.kafka_reader;
 
 import std;
 import moirai.app;
+import moirai.json_utils;
+import moirai.load_capture;
 import moirai.scan_reader;
 import moirai.utils;
 
 namespace {
 
 constexpr auto IMMEDIATE_POLL_TIMEOUT = std::chrono::milliseconds{0};
+// Least wait after a failed batch poll, for a zero --batch-timeout.
+constexpr auto CONSUME_ERROR_MIN_BACKOFF = std::chrono::milliseconds{100};
+constexpr std::string_view CONSUME_BATCH_ENV = "MOIRAI_KAFKA_CONSUME_BATCH";
+constexpr std::string_view FLOW_CONTROL_ENV = "MOIRAI_KAFKA_FLOW_CONTROL";
+constexpr std::string_view PAUSE_HIGH_WATERMARK_ENV =
+    "MOIRAI_KAFKA_PAUSE_HIGH_WATERMARK";
+constexpr std::string_view RESUME_LOW_WATERMARK_ENV =
+    "MOIRAI_KAFKA_RESUME_LOW_WATERMARK";
+constexpr std::size_t DEFAULT_PAUSE_HIGH_PERCENT = 80;
+constexpr std::size_t DEFAULT_RESUME_LOW_PERCENT = 40;
 const auto SASL_PROPERTIES = std::to_array<std::string_view>(
     {"sasl.mechanism", "sasl.mechanisms", "sasl.username", "sasl.password"});
 
@@ -24,6 +39,18 @@ auto has_sasl_configuration(
                              });
 }
 
+auto payload_view(const void *payload, size_t length) -> std::string_view {
+  return payload == nullptr
+             ? std::string_view{}
+             : std::string_view(static_cast<const char *>(payload), length);
+}
+
+auto thread_cpu_time() -> std::chrono::nanoseconds {
+  timespec now{};
+  ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+  return std::chrono::seconds{now.tv_sec} + std::chrono::nanoseconds{now.tv_nsec};
+}
+
 } // namespace
 
 void KafkaReader::ConsumerDeleter::operator()(
@@ -39,10 +66,42 @@ KafkaReader::KafkaReader(
     std::chrono::milliseconds timeout, TopicMap topic_map,
     std::unordered_map<std::string, std::string> properties, QueueSet queues)
     : ScanReader(queues.load), m_broker_url(broker_url),
+      m_lanes(std::move(queues.lanes)), m_lane_map(m_lanes.size()),
       m_batch_size(batch_size), m_timeout(timeout),
       m_topic_map(std::move(topic_map)), m_properties(std::move(properties)),
-      m_node_queue(queues.node), m_edge_queue(queues.edge) {
+      m_node_queue(queues.node), m_edge_queue(queues.edge),
+      m_load_compactor(queues.compactor), m_recorder(queues.recorder),
+      m_consume_batch(parse_bool_env(CONSUME_BATCH_ENV, true)),
+      m_flow_control(parse_bool_env(FLOW_CONTROL_ENV, true)),
+      m_pause_high_percent(parse_size_env(PAUSE_HIGH_WATERMARK_ENV,
+                                          DEFAULT_PAUSE_HIGH_PERCENT)),
+      m_resume_low_percent(parse_size_env(
+          RESUME_LOW_WATERMARK_ENV, DEFAULT_RESUME_LOW_PERCENT, true)),
+      m_poll_size(std::max<size_t>(m_batch_size, 1)),
+      m_flow(std::vector<FlowWatermarks>{}) {
   auto &app = moirai::Application::instance();
+  if (m_pause_high_percent > 100 ||
+      m_resume_low_percent >= m_pause_high_percent) {
+    throw std::runtime_error(std::format(
+        "{} and {} must satisfy 0 <= low < high <= 100",
+        RESUME_LOW_WATERMARK_ENV, PAUSE_HIGH_WATERMARK_ENV));
+  }
+  const auto queue_count = std::max<size_t>(m_lanes.size(), 1);
+  for (size_t index = 0; index < queue_count; ++index) {
+    m_poll_size = std::min(m_poll_size, flow_queue(index)->capacity());
+  }
+  std::vector<FlowWatermarks> watermarks;
+  for (size_t index = 0; index < queue_count; ++index) {
+    watermarks.push_back(FlowWatermarks::for_queue(
+        flow_queue(index)->capacity(), m_poll_size, m_pause_high_percent,
+        m_resume_low_percent));
+  }
+  m_flow = PartitionFlow(std::move(watermarks));
+  if (m_poll_size < m_batch_size) {
+    app.logger().information(
+        "Polling at most {} messages at a time to fit the load queues",
+        m_poll_size);
+  }
   app.logger().debug("Configuring kafka reader");
   using ConfigPtr = std::unique_ptr<RdKafka::Conf, void (*)(RdKafka::Conf *)>;
   ConfigPtr config(RdKafka::Conf::create(RdKafka::Conf::CONF_GLOBAL),
@@ -85,6 +144,21 @@ KafkaReader::KafkaReader(
     set_config(key, value);
   }
 
+  // Installed in every mode: flow control has to pause the partitions a
+  // rebalance hands out while their queue is paused.
+  m_rebalancer = std::make_unique<Rebalancer>(*this);
+  if (config->set("rebalance_cb", m_rebalancer.get(), error_string) !=
+      RdKafka::Conf::CONF_OK) {
+    app.logger().error("Error setting kafka rebalance callback: {}",
+                       error_string);
+    throw std::runtime_error(error_string);
+  }
+  if (!m_lanes.empty()) {
+    m_metrics.lane_messages.assign(m_lanes.size(), 0);
+    app.logger().information("Routing loads to {} partition-affine lanes",
+                             m_lanes.size());
+  }
+
   m_consumer.reset(RdKafka::KafkaConsumer::create(config.get(), error_string));
 
   if (!m_consumer) {
@@ -119,6 +193,7 @@ auto KafkaReader::consume_message(std::chrono::milliseconds timeout)
       std::clamp<int64_t>(timeout.count(), 0, std::numeric_limits<int>::max()));
   auto message =
       std::unique_ptr<RdKafka::Message>(m_consumer->consume(timeout_ms));
+  ++m_metrics.polls;
   if (!message) {
     app.logger().error("Kafka consumer returned a null message");
     return nullptr;
@@ -127,44 +202,307 @@ auto KafkaReader::consume_message(std::chrono::milliseconds timeout)
   return message;
 }
 
+auto KafkaReader::queue_for(const std::string &topic) const
+    -> BlockingQueue<std::string> * {
+  if (m_topic_map.contains_topic(topic)) {
+    const std::string &role = m_topic_map.role_for(topic);
+    if (role == "load") {
+      return &m_load_queue;
+    }
+    if (role == "edge") {
+      return m_edge_queue;
+    }
+    if (role == "node") {
+      return m_node_queue;
+    }
+  }
+
+  moirai::Application::instance().logger().error("Unsupported topic: {}",
+                                                  topic);
+  return nullptr;
+}
+
+void KafkaReader::Rebalancer::rebalance_cb(
+    RdKafka::KafkaConsumer *consumer, RdKafka::ErrorCode error,
+    std::vector<RdKafka::TopicPartition *> &partitions) {
+  auto &app = moirai::Application::instance();
+  const bool cooperative = consumer->rebalance_protocol() == "COOPERATIVE";
+  std::unique_ptr<RdKafka::Error> failure;
+  if (error == RdKafka::ERR__ASSIGN_PARTITIONS) {
+    m_reader.assign_lanes(partitions);
+    if (cooperative) {
+      failure.reset(consumer->incremental_assign(partitions));
+    } else {
+      consumer->assign(partitions);
+    }
+    m_reader.pause_assigned(partitions);
+  } else {
+    if (error == RdKafka::ERR__REVOKE_PARTITIONS) {
+      m_reader.revoke_lanes(partitions);
+    } else {
+      app.logger().error("Kafka rebalance failed: {}",
+                         RdKafka::err2str(error));
+    }
+    if (cooperative) {
+      failure.reset(consumer->incremental_unassign(partitions));
+    } else {
+      consumer->unassign();
+    }
+  }
+  if (failure) {
+    app.logger().error("Kafka rebalance failed: {}", failure->str());
+  }
+}
+
+void KafkaReader::assign_lanes(
+    const std::vector<RdKafka::TopicPartition *> &partitions) {
+  if (m_lanes.empty()) {
+    return;
+  }
+  const auto &load_topic = m_topic_map.topic_for("load");
+  std::vector<std::int32_t> assigned;
+  for (const auto *partition : partitions) {
+    if (partition->topic() == load_topic) {
+      assigned.push_back(partition->partition());
+    }
+  }
+  const auto count = assigned.size();
+  m_lane_map.assign(std::move(assigned));
+  ++m_metrics.lane_rebalances;
+  moirai::Application::instance().logger().information(
+      "Assigned {} load partitions to {} lanes", count, m_lanes.size());
+}
+
+void KafkaReader::revoke_lanes(
+    const std::vector<RdKafka::TopicPartition *> &partitions) {
+  if (m_lanes.empty()) {
+    return;
+  }
+  const auto &load_topic = m_topic_map.topic_for("load");
+  std::vector<std::int32_t> revoked;
+  for (const auto *partition : partitions) {
+    if (partition->topic() == load_topic) {
+      revoked.push_back(partition->partition());
+    }
+  }
+  m_lane_map.revoke(revoked);
+}
+
+auto KafkaReader::flow_queue(std::size_t index) const
+    -> BlockingQueue<std::string> * {
+  return m_lanes.empty() ? &m_load_queue : m_lanes[index];
+}
+
+// The load queue a load partition feeds: its lane, or the shared queue.
+auto KafkaReader::flow_queue_of(std::int32_t partition) const
+    -> std::optional<std::size_t> {
+  if (m_lanes.empty()) {
+    return 0;
+  }
+  return m_lane_map.lane_of(partition);
+}
+
+// Pauses a load queue's partitions once it fills past the high watermark, or
+// once another poll might not fit, and resumes them once it drains below the
+// low one. The reader keeps polling while paused, so the consumer stays in
+// the group however long the solvers or OpenSearch stall.
+void KafkaReader::apply_flow_control() {
+  if (!m_flow_control) {
+    return;
+  }
+  for (size_t index = 0; index < m_flow.queue_count(); ++index) {
+    const auto *queue = flow_queue(index);
+    if (queue->capacity() == std::numeric_limits<size_t>::max()) {
+      continue;
+    }
+    if (m_flow.flips(index, queue->size_approx())) {
+      set_paused(index, !m_flow.paused(index));
+    }
+  }
+}
+
+void KafkaReader::set_paused(std::size_t index, bool paused) {
+  auto &app = moirai::Application::instance();
+  std::vector<RdKafka::TopicPartition *> assignment;
+  if (const auto error = m_consumer->assignment(assignment);
+      error != RdKafka::ERR_NO_ERROR) {
+    app.logger().error("Kafka assignment unavailable: {}",
+                       RdKafka::err2str(error));
+    return;
+  }
+
+  const auto &load_topic = m_topic_map.topic_for("load");
+  std::vector<RdKafka::TopicPartition *> selected;
+  for (auto *partition : assignment) {
+    if (partition->topic() == load_topic &&
+        flow_queue_of(partition->partition()) == index) {
+      selected.push_back(partition);
+    }
+  }
+  const auto error =
+      paused ? m_consumer->pause(selected) : m_consumer->resume(selected);
+  RdKafka::TopicPartition::destroy(assignment);
+  if (error != RdKafka::ERR_NO_ERROR) {
+    app.logger().error("Kafka {} failed: {}", paused ? "pause" : "resume",
+                       RdKafka::err2str(error));
+  }
+
+  if (paused && !m_flow.paused(index)) {
+    ++m_metrics.pauses;
+  }
+  m_metrics.paused_time +=
+      m_flow.set_paused(index, paused, std::chrono::steady_clock::now());
+  app.logger().debug("{} {} load partitions of queue {}",
+                     paused ? "Paused" : "Resumed", selected.size(), index);
+}
+
+// A rebalance hands out partitions unpaused; pause again those whose queue
+// is still paused. Its watermarks would not, since the queue's state did not
+// change, and the next poll could then overrun it.
+void KafkaReader::pause_assigned(
+    const std::vector<RdKafka::TopicPartition *> &partitions) {
+  if (!m_flow_control) {
+    return;
+  }
+  const auto &load_topic = m_topic_map.topic_for("load");
+  std::vector<std::int32_t> assigned;
+  for (const auto *partition : partitions) {
+    if (partition->topic() == load_topic) {
+      assigned.push_back(partition->partition());
+    }
+  }
+  const auto repause = m_flow.to_pause(
+      assigned, [this](std::int32_t partition) -> std::optional<std::size_t> {
+        return flow_queue_of(partition);
+      });
+  if (repause.empty()) {
+    return;
+  }
+  std::vector<RdKafka::TopicPartition *> selected;
+  for (auto *partition : partitions) {
+    if (partition->topic() == load_topic &&
+        std::ranges::find(repause, partition->partition()) !=
+            repause.end()) {
+      selected.push_back(partition);
+    }
+  }
+  if (const auto error = m_consumer->pause(selected);
+      error != RdKafka::ERR_NO_ERROR) {
+    moirai::Application::instance().logger().error(
+        "Kafka pause failed: {}", RdKafka::err2str(error));
+  }
+  moirai::Application::instance().logger().debug(
+      "Paused {} newly assigned load partitions", selected.size());
+}
+
 auto KafkaReader::dispatch_message(const RdKafka::Message &message,
                                    const std::stop_token &stop_token) -> bool {
   auto &app = moirai::Application::instance();
   app.logger().debug("Message in {} [{}] at offset {}", message.topic_name(),
                      message.partition(), message.offset());
 
-  const auto *payload = static_cast<const char *>(message.payload());
-  const std::string data =
-      payload == nullptr ? std::string{} : std::string(payload, message.len());
-  if (!m_topic_map.contains_topic(message.topic_name())) {
-    app.logger().error("Unsupported topic: {}", message.topic_name());
+  auto *queue = queue_for(message.topic_name());
+  if (queue == nullptr) {
     return true;
   }
-
-  const std::string &topic_name = m_topic_map.role_for(message.topic_name());
-  if (topic_name == "load") {
-    return m_load_queue.wait_enqueue(data, stop_token);
+  if (queue == &m_load_queue) {
+    if (!m_lanes.empty()) {
+      const auto lane = m_lane_map.lane_for(message.partition());
+      ++m_metrics.lane_messages[lane];
+      queue = m_lanes[lane];
+    }
+    const auto payload = payload_view(message.payload(), message.len());
+    admit_load(queue, payload);
+    record_load(payload, message.timestamp().timestamp, message.partition(),
+                message.offset());
   }
 
-  if (topic_name == "edge") {
-    return m_edge_queue == nullptr ||
-           m_edge_queue->wait_enqueue(data, stop_token);
+  // The only copy of the payload: librdkafka's buffer carries no parser
+  // padding, so it goes straight into a padded string that is moved through
+  // the queue and parsed in place by the consumer.
+  const auto payload = payload_view(message.payload(), message.len());
+  ++m_metrics.messages;
+  m_metrics.payload_bytes += payload.size();
+  return queue->wait_enqueue(moirai::make_padded_payload(payload), stop_token);
+}
+
+// Registers a load with the compactor before it is enqueued, so a solver
+// that dequeues an older scan of the same bag can tell it is stale. The
+// padded copy the solver sees has the same bytes, so the fingerprints match.
+void KafkaReader::admit_load(const BlockingQueue<std::string> *queue,
+                             std::string_view payload) {
+  if (m_load_compactor == nullptr) {
+    return;
   }
+  if (const auto bag = moirai::peek_string_member(payload, "id");
+      bag.has_value()) {
+    (void)m_load_compactor->admit(queue, *bag, payload);
+  }
+}
 
-  if (topic_name == "node") {
-    return m_node_queue == nullptr ||
-           m_node_queue->wait_enqueue(data, stop_token);
+// Hands a consumed load to the capture recorder, which only copies it into
+// its pending frame; compression and writes stay off this thread.
+void KafkaReader::record_load(std::string_view payload,
+                              std::int64_t timestamp_ms,
+                              std::int32_t partition, std::int64_t offset) {
+  if (m_recorder == nullptr) {
+    return;
   }
+  m_recorder->record(moirai::LoadRecord{.timestamp_ms = timestamp_ms,
+                                        .partition = partition,
+                                        .offset = offset,
+                                        .payload = payload});
+}
 
-  app.logger().error("Unsupported topic: {}", message.topic_name());
-  return true;
+auto KafkaReader::metrics() const -> const Metrics & { return m_metrics; }
+
+void KafkaReader::log_metrics() const {
+  const auto messages = std::max<std::uint64_t>(m_metrics.messages, 1);
+  moirai::Application::instance().logger().information(
+      "Kafka reader metrics: mode={} messages={} polls={} "
+      "messages_per_poll={:.2f} cpu_us_per_message={:.2f} payload_bytes={} "
+      "pauses={} paused_ms={}",
+      m_consume_batch ? "batch" : "single", m_metrics.messages,
+      m_metrics.polls,
+      static_cast<double>(m_metrics.messages) /
+          static_cast<double>(std::max<std::uint64_t>(m_metrics.polls, 1)),
+      static_cast<double>(m_metrics.cpu_time.count()) / 1000.0 /
+          static_cast<double>(messages),
+      m_metrics.payload_bytes, m_metrics.pauses,
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          m_metrics.paused_time)
+          .count());
+  if (m_load_compactor != nullptr) {
+    const auto compaction = m_load_compactor->metrics();
+    moirai::Application::instance().logger().information(
+        "Load compaction metrics: tracked={} untracked={} superseded={}",
+        compaction.tracked, compaction.untracked, compaction.superseded);
+  }
+  if (!m_lanes.empty()) {
+    // Skew is the busiest lane's share over an even split; 1.0 is balanced.
+    const auto &lane_messages = m_metrics.lane_messages;
+    const auto busiest = std::ranges::max(lane_messages);
+    const auto total =
+        std::accumulate(lane_messages.begin(), lane_messages.end(),
+                        std::uint64_t{0});
+    moirai::Application::instance().logger().information(
+        "Kafka reader lanes: lanes={} rebalances={} lane_skew={:.2f} "
+        "lane_messages={}",
+        m_lanes.size(), m_metrics.lane_rebalances,
+        total == 0 ? 1.0
+                   : static_cast<double>(busiest) *
+                         static_cast<double>(m_lanes.size()) /
+                         static_cast<double>(total),
+        lane_messages);
+  }
 }
 
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
-void KafkaReader::run(std::stop_token stop_token) {
+void KafkaReader::consume_messages(const std::stop_token &stop_token) {
   auto &app = moirai::Application::instance();
 
   while (!stop_token.stop_requested()) {
+    apply_flow_control();
     auto message = consume_message(m_timeout);
     if (!message) {
       continue;
@@ -182,7 +520,7 @@ void KafkaReader::run(std::stop_token stop_token) {
         if (!dispatch_message(*message, stop_token)) {
           return;
         }
-        message = dispatched < m_batch_size
+        message = dispatched < m_poll_size
                       ? consume_message(IMMEDIATE_POLL_TIMEOUT)
                       : nullptr;
         break;
@@ -198,3 +536,117 @@ void KafkaReader::run(std::stop_token stop_token) {
     }
   }
 }
+
+// Pulls up to --batch-size messages per call from the consumer queue, copies
+// their payloads out and releases them, then hands all loads of the batch to
+// the load queue in one bulk enqueue.
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+void KafkaReader::consume_batches(const std::stop_token &stop_token) {
+  auto &app = moirai::Application::instance();
+  const std::unique_ptr<rd_kafka_queue_t, decltype(&rd_kafka_queue_destroy)>
+      queue(rd_kafka_queue_get_consumer(m_consumer->c_ptr()),
+            &rd_kafka_queue_destroy);
+  if (!queue) {
+    throw std::runtime_error("Kafka consumer queue is unavailable");
+  }
+
+  const auto timeout_ms = static_cast<int>(std::clamp<int64_t>(
+      m_timeout.count(), 0, std::numeric_limits<int>::max()));
+  std::vector<rd_kafka_message_t *> messages(m_poll_size);
+  // One batch per lane, or a single batch for the shared load queue.
+  std::vector<std::vector<std::string>> loads(
+      std::max<size_t>(m_lanes.size(), 1));
+  std::vector<std::pair<BlockingQueue<std::string> *, std::string>> others;
+  const rd_kafka_topic_t *last_topic = nullptr;
+  BlockingQueue<std::string> *last_queue = nullptr;
+
+  while (!stop_token.stop_requested()) {
+    apply_flow_control();
+    const auto count = rd_kafka_consume_batch_queue(
+        queue.get(), timeout_ms, messages.data(), messages.size());
+    ++m_metrics.polls;
+    if (count < 0) {
+      app.logger().error("%% Consumer error: {}",
+                         rd_kafka_err2str(rd_kafka_last_error()));
+      // A failed poll returns at once; without a pause a persistent error
+      // spins the thread and floods the log.
+      moirai::wait_for(stop_token,
+                       std::max(m_timeout, CONSUME_ERROR_MIN_BACKOFF));
+      continue;
+    }
+
+    for (auto &batch : loads) {
+      batch.clear();
+    }
+    others.clear();
+    for (const auto *message :
+         std::span(messages).first(static_cast<size_t>(count))) {
+      if (message->err == RD_KAFKA_RESP_ERR_NO_ERROR) {
+        if (message->rkt != last_topic) {
+          last_topic = message->rkt;
+          last_queue = queue_for(rd_kafka_topic_name(message->rkt));
+        }
+        if (last_queue != nullptr) {
+          const auto payload = payload_view(message->payload, message->len);
+          ++m_metrics.messages;
+          m_metrics.payload_bytes += payload.size();
+          if (last_queue == &m_load_queue) {
+            size_t lane = 0;
+            if (!m_lanes.empty()) {
+              lane = m_lane_map.lane_for(message->partition);
+              ++m_metrics.lane_messages[lane];
+            }
+            admit_load(m_lanes.empty() ? &m_load_queue : m_lanes[lane],
+                       payload);
+            record_load(payload, rd_kafka_message_timestamp(message, nullptr),
+                        message->partition, message->offset);
+            loads[lane].push_back(moirai::make_padded_payload(payload));
+          } else {
+            others.emplace_back(last_queue,
+                                moirai::make_padded_payload(payload));
+          }
+        }
+      } else if (message->err != RD_KAFKA_RESP_ERR__PARTITION_EOF &&
+                 message->err != RD_KAFKA_RESP_ERR__TIMED_OUT) {
+        app.logger().error("%% Consumer error: {}",
+                           rd_kafka_message_errstr(message));
+      }
+    }
+    for (auto *message :
+         std::span(messages).first(static_cast<size_t>(count))) {
+      rd_kafka_message_destroy(message);
+    }
+
+    for (size_t lane = 0; lane < loads.size(); ++lane) {
+      auto *target = m_lanes.empty() ? &m_load_queue : m_lanes[lane];
+      if (!target->wait_enqueue_bulk(std::span(loads[lane]), stop_token)) {
+        return;
+      }
+    }
+    for (auto &[target, payload] : others) {
+      if (!target->wait_enqueue(std::move(payload), stop_token)) {
+        return;
+      }
+    }
+    if (count > 0) {
+      app.logger().debug("Dispatched {} kafka messages", count);
+    }
+  }
+}
+
+void KafkaReader::run(std::stop_token stop_token) {
+  const auto started = thread_cpu_time();
+  if (m_consume_batch) {
+    consume_batches(stop_token);
+  } else {
+    consume_messages(stop_token);
+  }
+  m_metrics.cpu_time = thread_cpu_time() - started;
+  const auto stopped = std::chrono::steady_clock::now();
+  for (size_t index = 0; index < m_flow.queue_count(); ++index) {
+    if (const auto &since = m_flow.paused_since(index)) {
+      m_metrics.paused_time += stopped - *since;
+    }
+  }
+  log_metrics();
+}
@@ -0,0 +1,288 @@
+module;
+
+#include <zlib.h>
+
+module moirai.load_capture;
+
+import std;
+import moirai.app;
+
+namespace {
+
+constexpr std::string_view CAPTURE_MAGIC = "MOIRCAP1";
+constexpr auto CODEC_STORED = std::to_underlying(moirai::CaptureCodec::stored);
+constexpr auto CODEC_ZLIB = std::to_underlying(moirai::CaptureCodec::zlib);
+constexpr std::size_t FRAME_HEADER_BYTES = 16;
+constexpr std::size_t RECORD_HEADER_BYTES = 24;
+// Frames of about this size compress well at zlib's fastest level and keep
+// the reader's buffers small.
+constexpr std::size_t FRAME_BYTES = std::size_t{1} << 20U;
+// The most the reader thread may queue for the writer before loads are
+// dropped.
+constexpr std::size_t MAX_PENDING_BYTES = std::size_t{64} << 20U;
+// Frames larger than this are taken as corruption rather than allocated.
+constexpr std::uint32_t MAX_FRAME_BYTES = std::uint32_t{1} << 30U;
+constexpr auto FLUSH_INTERVAL = std::chrono::seconds{1};
+
+template <typename Integer>
+void store_le(char* output, Integer value) {
+  if constexpr (std::endian::native == std::endian::big) {
+    value = std::byteswap(value);
+  }
+  std::memcpy(output, &value, sizeof(Integer));
+}
+
+template <typename Integer>
+auto load_le(const char* input) -> Integer {
+  Integer value{};
+  std::memcpy(&value, input, sizeof(Integer));
+  if constexpr (std::endian::native == std::endian::big) {
+    value = std::byteswap(value);
+  }
+  return value;
+}
+
+} // namespace
+
+namespace moirai {
+
+auto is_load_capture(const std::filesystem::path& path) -> bool {
+  std::ifstream input(path, std::ios::binary);
+  std::array<char, CAPTURE_MAGIC.size()> magic{};
+  return input.read(magic.data(), magic.size()) &&
+         std::string_view(magic.data(), magic.size()) == CAPTURE_MAGIC;
+}
+
+LoadRecorder::LoadRecorder(const std::filesystem::path& path,
+                           CaptureCodec codec)
+  : m_path(path)
+  , m_output(path, std::ios::binary | std::ios::trunc)
+  , m_codec(codec)
+{
+  if (!m_output.is_open()) {
+    throw std::runtime_error(
+      std::format("Failed to open load capture {}", path.string()));
+  }
+  m_output.write(CAPTURE_MAGIC.data(), CAPTURE_MAGIC.size());
+  m_pending.reserve(FRAME_BYTES + FRAME_BYTES / 4);
+  m_writer = std::jthread([this] { write_frames(); });
+}
+
+LoadRecorder::~LoadRecorder()
+{
+  close();
+}
+
+void
+LoadRecorder::record(const LoadRecord& record)
+{
+  const auto bytes = RECORD_HEADER_BYTES + record.payload.size();
+  std::array<char, RECORD_HEADER_BYTES> header{};
+  store_le(header.data(), record.timestamp_ms);
+  store_le(header.data() + 8, record.offset);
+  store_le(header.data() + 16, record.partition);
+  store_le(header.data() + 20,
+           static_cast<std::uint32_t>(record.payload.size()));
+
+  const std::lock_guard lock(m_mutex);
+  if (m_closing || m_pending.size() + bytes > MAX_PENDING_BYTES) {
+    ++m_metrics.dropped;
+    return;
+  }
+  m_pending.append(header.data(), header.size());
+  m_pending.append(record.payload);
+  ++m_pending_records;
+  ++m_metrics.records;
+  if (m_pending.size() >= FRAME_BYTES) {
+    m_ready.notify_one();
+  }
+}
+
+void
+LoadRecorder::close()
+{
+  {
+    const std::lock_guard lock(m_mutex);
+    m_closing = true;
+  }
+  m_ready.notify_one();
+  if (m_writer.joinable()) {
+    m_writer.join();
+  }
+}
+
+auto
+LoadRecorder::metrics() const -> Metrics
+{
+  const std::lock_guard lock(m_mutex);
+  return m_metrics;
+}
+
+void
+LoadRecorder::write_frames()
+{
+  std::string frame;
+  frame.reserve(m_pending.capacity());
+  bool failed = false;
+  while (true) {
+    std::unique_lock lock(m_mutex);
+    m_ready.wait_for(lock, FLUSH_INTERVAL, [this] {
+      return m_closing || m_pending.size() >= FRAME_BYTES;
+    });
+    std::swap(frame, m_pending);
+    const auto records = std::exchange(m_pending_records, 0);
+    const bool closing = m_closing;
+    lock.unlock();
+
+    if (!frame.empty() && !failed && !write_frame(frame, records)) {
+      failed = true;
+      moirai::Application::instance().logger().error(
+        "Failed to write load capture {}; recording stopped", m_path.string());
+      // Stop taking records rather than queueing them for a dead file.
+      lock.lock();
+      m_closing = true;
+      m_metrics.dropped += records;
+      lock.unlock();
+    }
+    frame.clear();
+    if (closing) {
+      break;
+    }
+  }
+  m_output.close();
+}
+
+auto
+LoadRecorder::write_frame(std::string_view raw, std::uint32_t records)
+  -> bool
+{
+  thread_local std::string compressed;
+  auto codec = CODEC_STORED;
+  auto stored_bytes = static_cast<uLong>(raw.size());
+  if (m_codec == CaptureCodec::zlib) {
+    // Level 1: recording has to keep up with the consumer, and load payloads
+    // are repetitive enough that it already shrinks them several times.
+    auto compressed_bytes = compressBound(static_cast<uLong>(raw.size()));
+    compressed.resize(compressed_bytes);
+    if (compress2(reinterpret_cast<Bytef*>(compressed.data()),
+                  &compressed_bytes,
+                  reinterpret_cast<const Bytef*>(raw.data()),
+                  static_cast<uLong>(raw.size()),
+                  Z_BEST_SPEED) == Z_OK &&
+        compressed_bytes < raw.size()) {
+      codec = CODEC_ZLIB;
+      stored_bytes = compressed_bytes;
+    }
+  }
+  const auto stored = codec == CODEC_ZLIB
+                        ? std::string_view(compressed.data(), stored_bytes)
+                        : raw;
+
+  std::array<char, FRAME_HEADER_BYTES> header{};
+  store_le(header.data(), codec);
+  store_le(header.data() + 4, static_cast<std::uint32_t>(raw.size()));
+  store_le(header.data() + 8, static_cast<std::uint32_t>(stored.size()));
+  store_le(header.data() + 12, records);
+  m_output.write(header.data(), static_cast<std::streamsize>(header.size()));
+  m_output.write(stored.data(), static_cast<std::streamsize>(stored.size()));
+  m_output.flush();
+  if (!m_output.good()) {
+    return false;
+  }
+
+  const std::lock_guard lock(m_mutex);
+  ++m_metrics.frames;
+  m_metrics.raw_bytes += raw.size();
+  m_metrics.stored_bytes += FRAME_HEADER_BYTES + stored.size();
+  return true;
+}
+
+LoadCaptureReader::LoadCaptureReader(const std::filesystem::path& path)
+  : m_path(path)
+  , m_input(path, std::ios::binary)
+{
+  if (!m_input.is_open()) {
+    throw std::runtime_error(
+      std::format("Failed to open load capture {}", path.string()));
+  }
+  std::array<char, CAPTURE_MAGIC.size()> magic{};
+  if (!m_input.read(magic.data(), magic.size()) ||
+      std::string_view(magic.data(), magic.size()) != CAPTURE_MAGIC) {
+    throw std::runtime_error(
+      std::format("{} is not a load capture", path.string()));
+  }
+}
+
+auto
+LoadCaptureReader::next() -> std::optional<LoadRecord>
+{
+  while (m_position == m_frame.size()) {
+    if (!read_frame()) {
+      return std::nullopt;
+    }
+  }
+  const auto corrupt = [this] {
+    return std::runtime_error(
+      std::format("Corrupt frame in load capture {}", m_path.string()));
+  };
+  if (m_frame.size() - m_position < RECORD_HEADER_BYTES) {
+    throw corrupt();
+  }
+  const char* header = m_frame.data() + m_position;
+  LoadRecord record{
+    .timestamp_ms = load_le<std::int64_t>(header),
+    .partition = load_le<std::int32_t>(header + 16),
+    .offset = load_le<std::int64_t>(header + 8),
+    .payload = {},
+  };
+  const auto length = load_le<std::uint32_t>(header + 20);
+  m_position += RECORD_HEADER_BYTES;
+  if (m_frame.size() - m_position < length) {
+    throw corrupt();
+  }
+  record.payload = std::string_view(m_frame.data() + m_position, length);
+  m_position += length;
+  return record;
+}
+
+auto
+LoadCaptureReader::read_frame() -> bool
+{
+  std::array<char, FRAME_HEADER_BYTES> header{};
+  if (!m_input.read(header.data(), header.size())) {
+    m_truncated = m_input.gcount() != 0;
+    return false;
+  }
+  const auto codec = static_cast<std::uint8_t>(header[0]);
+  const auto raw_bytes = load_le<std::uint32_t>(header.data() + 4);
+  const auto stored_bytes = load_le<std::uint32_t>(header.data() + 8);
+  if ((codec != CODEC_STORED && codec != CODEC_ZLIB) ||
+      raw_bytes > MAX_FRAME_BYTES || stored_bytes > MAX_FRAME_BYTES ||
+      (codec == CODEC_STORED && stored_bytes != raw_bytes)) {
+    throw std::runtime_error(
+      std::format("Corrupt frame in load capture {}", m_path.string()));
+  }
+
+  auto& target = codec == CODEC_ZLIB ? m_stored : m_frame;
+  target.resize(stored_bytes);
+  if (!m_input.read(target.data(), stored_bytes)) {
+    m_truncated = true;
+    return false;
+  }
+  if (codec == CODEC_ZLIB) {
+    m_frame.resize(raw_bytes);
+    auto inflated = static_cast<uLongf>(raw_bytes);
+    if (uncompress(reinterpret_cast<Bytef*>(m_frame.data()),
+                   &inflated,
+                   reinterpret_cast<const Bytef*>(m_stored.data()),
+                   static_cast<uLong>(stored_bytes)) != Z_OK ||
+        inflated != raw_bytes) {
+      throw std::runtime_error(
+        std::format("Corrupt frame in load capture {}", m_path.string()));
+    }
+  }
+  m_position = 0;
+  return true;
+}
+
+} // namespace moirai
@@ -0,0 +1,320 @@
+module;
+
+#include "simdjson_module.hxx"
+
+module moirai.load_payload;
+
+import std;
+
+namespace {
+
+namespace ondemand = simdjson::ondemand;
+
+auto load_parser() -> ondemand::parser& {
+  thread_local ondemand::parser parser;
+  return parser;
+}
+
+// Holds a padded copy of payloads that arrive without spare capacity, so the
+// parser never has to allocate one per load.
+auto padded_scratch() -> std::string& {
+  thread_local std::string scratch;
+  return scratch;
+}
+
+auto copied_bytes() -> std::uint64_t& {
+  thread_local std::uint64_t bytes = 0;
+  return bytes;
+}
+
+constexpr std::string_view WHITESPACE = " \t\r\n";
+
+// Keys are matched as written, without unescaping: load producers never
+// escape key names, and an escaped key is simply not recognised.
+auto field_key(ondemand::field& field) -> std::string_view {
+  return field.escaped_key();
+}
+
+// Stores `value` into `field` on the first occurrence of its key, marking
+// `bit` in `present` if the value is a string. A value of another type
+// leaves the field absent, as the DOM lookups did; the object iterator skips
+// it.
+template <typename Bits>
+auto take_string(ondemand::value& value, Bits& seen, Bits& present, Bits bit,
+                 std::string_view& field) -> simdjson::error_code {
+  if ((seen & bit) != 0) {
+    return simdjson::SUCCESS;
+  }
+  seen = static_cast<Bits>(seen | bit);
+  std::string_view text;
+  const auto error = value.get_string().get(text);
+  if (error == simdjson::INCORRECT_TYPE) {
+    return simdjson::SUCCESS;
+  }
+  if (error == simdjson::SUCCESS) {
+    field = text;
+    present = static_cast<Bits>(present | bit);
+  }
+  return error;
+}
+
+auto decode_item(ondemand::value& element, std::size_t index,
+                 moirai::LoadItem& item) -> simdjson::error_code {
+  item = moirai::LoadItem{};
+  item.index = index;
+  ondemand::object object;
+  if (const auto error = element.get_object().get(object);
+      error != simdjson::SUCCESS) {
+    return error == simdjson::INCORRECT_TYPE ? simdjson::SUCCESS : error;
+  }
+
+  std::uint8_t seen{0};
+  for (auto field_result : object) {
+    if (field_result.error() != simdjson::SUCCESS) {
+      return field_result.error();
+    }
+    auto& field = field_result.value_unsafe();
+    const auto key = field_key(field);
+    auto& value = field.value();
+    auto error = simdjson::SUCCESS;
+    if (key == "id") {
+      error = take_string(value, seen, item.present, moirai::LoadItem::ID,
+                          item.id);
+    } else if (key == "cn") {
+      error = take_string(value, seen, item.present, moirai::LoadItem::CN,
+                          item.cn);
+    } else if (key == "ipdd_destination") {
+      error = take_string(value, seen, item.present,
+                          moirai::LoadItem::IPDD_DESTINATION,
+                          item.ipdd_destination);
+    }
+    if (error != simdjson::SUCCESS) {
+      return error;
+    }
+  }
+  return simdjson::SUCCESS;
+}
+
+// Replaces `items` with the waybills of `value` if it is an array. Returns
+// whether it was one through `taken`.
+auto take_items(ondemand::value& value, std::vector<moirai::LoadItem>& items,
+                bool& taken) -> simdjson::error_code {
+  ondemand::array array;
+  if (const auto error = value.get_array().get(array);
+      error != simdjson::SUCCESS) {
+    return error == simdjson::INCORRECT_TYPE ? simdjson::SUCCESS : error;
+  }
+
+  taken = true;
+  items.clear();
+  for (auto element_result : array) {
+    if (element_result.error() != simdjson::SUCCESS) {
+      return element_result.error();
+    }
+    const auto index = items.size();
+    if (const auto error = decode_item(element_result.value_unsafe(), index,
+                                       items.emplace_back());
+        error != simdjson::SUCCESS) {
+      return error;
+    }
+  }
+  return simdjson::SUCCESS;
+}
+
+// Decodes the top-level object of `document`, leaving trailing content and
+// the required fields to the caller.
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+template <typename Document>
+auto decode_object(Document& document, std::vector<moirai::LoadItem>& items)
+    -> std::expected<moirai::LoadFields, moirai::LoadDecodeError> {
+  using moirai::LoadDecodeError;
+  using moirai::LoadFields;
+
+  items.clear();
+  ondemand::object object;
+  if (const auto error = document.get_object().get(object);
+      error != simdjson::SUCCESS) {
+    return std::unexpected{error == simdjson::INCORRECT_TYPE
+                             ? LoadDecodeError::NOT_AN_OBJECT
+                             : LoadDecodeError::INVALID_JSON};
+  }
+
+  LoadFields load;
+  std::uint16_t seen{0};
+  bool seen_items = false;
+  bool seen_item = false;
+  bool from_items = false;
+  bool from_item = false;
+  for (auto field_result : object) {
+    if (field_result.error() != simdjson::SUCCESS) {
+      return std::unexpected{LoadDecodeError::INVALID_JSON};
+    }
+    auto& field = field_result.value_unsafe();
+    const auto key = field_key(field);
+    auto& value = field.value();
+    auto error = simdjson::SUCCESS;
+    if (key == "id") {
+      error = take_string(value, seen, load.present, LoadFields::ID, load.id);
+    } else if (key == "location") {
+      error = take_string(value, seen, load.present, LoadFields::LOCATION,
+                          load.location);
+    } else if (key == "destination") {
+      error = take_string(value, seen, load.present, LoadFields::DESTINATION,
+                          load.destination);
+    } else if (key == "time") {
+      error = take_string(value, seen, load.present, LoadFields::TIME,
+                          load.event_time);
+    } else if (key == "oc") {
+      error = take_string(value, seen, load.present, LoadFields::ORIGIN_CENTER,
+                          load.origin_center);
+    } else if (key == "ipdd_destination") {
+      error = take_string(value, seen, load.present,
+                          LoadFields::IPDD_DESTINATION, load.ipdd_destination);
+    } else if (key == "cs_slid") {
+      error = take_string(value, seen, load.present, LoadFields::CS_SLID,
+                          load.cs_slid);
+    } else if (key == "cs_act") {
+      error = take_string(value, seen, load.present, LoadFields::CS_ACT,
+                          load.cs_act);
+    } else if (key == "pid") {
+      error = take_string(value, seen, load.present, LoadFields::PID,
+                          load.pid);
+    } else if (key == "items" && !std::exchange(seen_items, true)) {
+      error = take_items(value, items, from_items);
+    } else if (key == "item" && !std::exchange(seen_item, true) &&
+               !from_items) {
+      // An `items` array later in the object still replaces these.
+      error = take_items(value, items, from_item);
+    }
+    if (error != simdjson::SUCCESS) {
+      return std::unexpected{LoadDecodeError::INVALID_JSON};
+    }
+  }
+
+  if (from_items || from_item) {
+    load.present |= LoadFields::ITEMS;
+  }
+  return load;
+}
+
+} // namespace
+
+namespace moirai {
+
+auto decode_load(const std::string& payload, std::vector<LoadItem>& items)
+    -> std::expected<LoadFields, LoadDecodeError> {
+  items.clear();
+  const char* buffer = payload.data();
+  std::size_t capacity = payload.capacity();
+  if (capacity - payload.size() < simdjson::SIMDJSON_PADDING) {
+    auto& scratch = padded_scratch();
+    scratch.reserve(payload.size() + simdjson::SIMDJSON_PADDING);
+    scratch.assign(payload);
+    buffer = scratch.data();
+    capacity = scratch.capacity();
+    copied_bytes() += payload.size();
+  }
+
+  ondemand::document document;
+  if (load_parser()
+        .iterate(buffer, payload.size(), capacity)
+        .get(document) != simdjson::SUCCESS) {
+    return std::unexpected{LoadDecodeError::INVALID_JSON};
+  }
+  auto load = decode_object(document, items);
+  if (!load.has_value()) {
+    return load;
+  }
+  if (!document.at_end()) {
+    return std::unexpected{LoadDecodeError::INVALID_JSON};
+  }
+  if (!load->has(LoadFields::REQUIRED)) {
+    return std::unexpected{LoadDecodeError::MISSING_REQUIRED};
+  }
+  return load;
+}
+
+// NOLINTNEXTLINE(readability-function-cognitive-complexity)
+auto decode_loads(std::span<const std::string> payloads,
+                  std::vector<LoadItem>& items, const LoadVisitor& visit)
+    -> std::size_t {
+  if (payloads.size() < 2) {
+    for (std::size_t index = 0; index < payloads.size(); ++index) {
+      visit(index, decode_load(payloads[index], items));
+    }
+    return 0;
+  }
+
+  // Newline-separated payloads, with where each one's JSON starts in the
+  // arena once leading whitespace is skipped.
+  thread_local std::string arena;
+  thread_local std::vector<std::size_t> starts;
+  std::size_t total = 0;
+  for (const auto& payload : payloads) {
+    total += payload.size() + 1;
+  }
+  arena.clear();
+  arena.reserve(total + simdjson::SIMDJSON_PADDING);
+  starts.clear();
+  for (const auto& payload : payloads) {
+    starts.push_back(arena.size() +
+                     std::min(payload.find_first_not_of(WHITESPACE),
+                              payload.size()));
+    arena.append(payload);
+    arena.push_back('\n');
+  }
+  copied_bytes() += total;
+
+  // Documents are handed out while they line up one to one with the
+  // payloads. The first one that does not (a payload that is not exactly one
+  // JSON document, which also shifts every boundary after it) and the rest
+  // of the batch are decoded one payload at a time.
+  std::size_t next = 0;
+  ondemand::document_stream stream;
+  if (load_parser()
+        .iterate_many(arena.data(), arena.size(),
+                      std::max(arena.size(), simdjson::dom::MINIMAL_BATCH_SIZE))
+        .get(stream) == simdjson::SUCCESS) {
+    for (auto document = stream.begin();
+         document != stream.end() && next < payloads.size(); ++document) {
+      ondemand::document_reference reference;
+      if (document.error() != simdjson::SUCCESS ||
+          document.current_index() != starts[next] ||
+          (*document).get(reference) != simdjson::SUCCESS) {
+        break;
+      }
+      // Errors are left to decode_load(), which reports them as it would
+      // for a lone payload.
+      auto load = decode_object(reference, items);
+      if (!load.has_value()) {
+        break;
+      }
+      // A fully decoded object leaves the stream on the next document, which
+      // must be the next payload; past the last payload there is none.
+      const char* after = nullptr;
+      const bool at_end =
+        reference.current_location().get(after) != simdjson::SUCCESS;
+      if (next + 1 == payloads.size()
+            ? !at_end
+            : at_end || after != arena.data() + starts[next + 1]) {
+        break;
+      }
+      if (!load->has(LoadFields::REQUIRED)) {
+        load = std::unexpected{LoadDecodeError::MISSING_REQUIRED};
+      }
+      visit(next++, load);
+    }
+  }
+
+  const auto batched = next;
+  for (; next < payloads.size(); ++next) {
+    visit(next, decode_load(payloads[next], items));
+  }
+  return batched;
+}
+
+auto decode_copied_bytes() -> std::uint64_t {
+  return copied_bytes();
+}
+
+} // namespace moirai
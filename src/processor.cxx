@@ -10,75 +10,48 @@ template <>
 void parse_path_into<PathTraversalMode::FORWARD>(
     const Path& path, std::vector<SearchPathLocation>& response) {
   response.clear();
-  response.reserve(path.steps.size());
-
-  for (const auto& step : path.steps) {
-    if (step.node == nullptr) {
-      continue;
-    }
-    if (step.outbound != nullptr) {
-      const auto departure =
-        get_departure(step.distance, step.outbound->departure);
-      SearchPathLocation entry = {
-        .code = step.node->code,
-        .facility_name = step.node->name,
-        .arrival = format_clock(step.distance),
-        .arrival_ts = step.distance.time_since_epoch().count() * 60,
-        .route = step.outbound->route_prefix,
-        .route_name = step.outbound->name,
-        .departure = format_clock(departure),
-        .departure_ts = departure.time_since_epoch().count() * 60,
-        .has_departure = true,
-      };
-      response.push_back(std::move(entry));
-    } else {
-      SearchPathLocation terminal;
-      terminal.code = step.node->code;
-      terminal.facility_name = step.node->name;
-      terminal.arrival = format_clock(step.distance);
-      terminal.arrival_ts = step.distance.time_since_epoch().count() * 60;
-      response.push_back(std::move(terminal));
-    }
-  }
+  append_path_locations<PathTraversalMode::FORWARD>(path.steps, response);
 }
 
 template <>
 void parse_path_into<PathTraversalMode::REVERSE>(
     const Path& path, std::vector<SearchPathLocation>& response) {
   response.clear();
-  response.reserve(path.steps.size());
+  append_path_locations<PathTraversalMode::REVERSE>(path.steps, response);
+}
 
-  if (!path.steps.empty()) {
-    auto arrival = path.steps.front().distance;
-    for (const auto& step : path.steps) {
-      if (step.node == nullptr) {
-        continue;
-      }
-      if (step.outbound == nullptr) {
-        SearchPathLocation terminal;
-        terminal.code = step.node->code;
-        terminal.facility_name = step.node->name;
-        terminal.arrival = format_clock(arrival);
-        terminal.arrival_ts = arrival.time_since_epoch().count() * 60;
-        response.push_back(std::move(terminal));
-        continue;
-      }
+namespace {
 
-      SearchPathLocation entry = {
-        .code = step.node->code,
-        .facility_name = step.node->name,
-        .arrival = format_clock(arrival),
-        .arrival_ts = arrival.time_since_epoch().count() * 60,
-        .route = step.outbound->route_prefix,
-        .route_name = step.outbound->name,
-        .departure = format_clock(step.distance),
-        .departure_ts = step.distance.time_since_epoch().count() * 60,
-        .has_departure = true,
-      };
-      response.push_back(std::move(entry));
-      arrival = step.distance + step.outbound->duration;
+auto compact_steps(PathTraversalMode mode,
+                   const Path& path) -> CompactPathHandle {
+  auto compact = std::make_shared<CompactPath>();
+  compact->mode = mode;
+  compact->hops.reserve(path.steps.size());
+  for (const auto& step : path.steps) {
+    if (step.node == nullptr) {
+      continue;
     }
+    compact->hops.push_back({
+      .node = step.node,
+      .outbound = step.outbound,
+      .distance = step.distance,
+    });
   }
+  return compact;
+}
+
+} // namespace
+
+template <>
+auto compact_path<PathTraversalMode::FORWARD>(
+    const Path& path) -> CompactPathHandle {
+  return compact_steps(PathTraversalMode::FORWARD, path);
+}
+
+template <>
+auto compact_path<PathTraversalMode::REVERSE>(
+    const Path& path) -> CompactPathHandle {
+  return compact_steps(PathTraversalMode::REVERSE, path);
 }
 
 template <>
@@ -1,6 +1,7 @@
 module;
 
 #include "blocking_queue.hxx"
+#include "stage_profile.hxx"
 #include <librdkafka/rdkafkacpp.h>
 #include <zlib.h>
 
@@ -56,25 +57,6 @@ struct BulkItemFailures {
 
 std::atomic<std::uint64_t> audit_file_sequence{0};
 
-auto parse_size_env(const char* name, std::size_t fallback,
-                    bool allow_zero = false) -> std::size_t {
-  const char* value = std::getenv(name);
-  if (value == nullptr || std::string_view{value}.empty()) {
-    return fallback;
-  }
-
-  std::size_t parsed{};
-  const std::string_view input{value};
-  const auto* begin = input.data();
-  const auto* end = begin + input.size();
-  const auto [ptr, error] = std::from_chars(begin, end, parsed);
-  if (error != std::errc{} || ptr != end || (!allow_zero && parsed == 0)) {
-    throw std::runtime_error(std::format("Invalid {} value '{}'", name, input));
-  }
-
-  return parsed;
-}
-
 auto parse_double_env(const char* name, double fallback) -> double {
   const char* value = std::getenv(name);
   if (value == nullptr || std::string_view{value}.empty()) {
@@ -112,25 +94,6 @@ auto parse_path_env(const char* name, std::filesystem::path fallback)
   return std::filesystem::path{value};
 }
 
-auto parse_bool_env(const char* name, bool fallback) -> bool {
-  const char* value = std::getenv(name);
-  if (value == nullptr || std::string_view{value}.empty()) {
-    return fallback;
-  }
-
-  std::string input{value};
-  std::ranges::transform(input, input.begin(), [](unsigned char chr) {
-    return static_cast<char>(std::tolower(chr));
-  });
-  if (input == "1" || input == "true" || input == "yes" || input == "on") {
-    return true;
-  }
-  if (input == "0" || input == "false" || input == "no" || input == "off") {
-    return false;
-  }
-  throw std::runtime_error(std::format("Invalid {} value '{}'", name, input));
-}
-
 auto parse_optional_string_env(std::initializer_list<const char*> names)
     -> std::string {
   for (const char* name : names) {
@@ -234,6 +197,7 @@ auto audit_timestamp(std::chrono::system_clock::time_point timestamp)
 
 void gzip_append(z_stream& stream, std::string& output, std::string_view input,
                  int flush) {
+  const StageTimer stage(PipelineStage::gzip);
   stream.next_in =
     reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
   stream.avail_in = static_cast<uInt>(input.size());
@@ -688,9 +652,10 @@ void append_bool_field(std::string& output, std::string_view key, bool value,
 }
 
 template <typename SelectValue>
-void append_unique_path_string_array(std::string& output, std::string_view key,
-                                     const SearchPathSection& section,
-                                     bool& first, SelectValue select_value) {
+void append_unique_path_string_array(
+    std::string& output, std::string_view key,
+    std::span<const SearchPathLocation> locations, bool& first,
+    SelectValue select_value) {
   append_field_prefix(output, key, first);
   output.push_back('[');
   constexpr std::size_t STACK_EMITTED_CAPACITY = 16;
@@ -711,12 +676,12 @@ void append_unique_path_string_array(std::string& output, std::string_view key,
       return;
     }
     if (heap_emitted.empty()) {
-      heap_emitted.reserve(section.locations.size() - stack_emitted.size());
+      heap_emitted.reserve(locations.size() - stack_emitted.size());
     }
     heap_emitted.push_back(value);
   };
   bool array_first = true;
-  for (const auto& location : section.locations) {
+  for (const auto& location : locations) {
     const std::string_view value = select_value(location);
     if (value.empty() || already_emitted(value)) {
       continue;
@@ -757,52 +722,57 @@ enum class LocationEncoding {
 };
 
 void append_locations_array(std::string& output,
-                            const SearchPathSection& section) {
+                            std::span<const SearchPathLocation> locations) {
   output.push_back('[');
-  for (std::size_t index = 0; index < section.locations.size(); ++index) {
+  for (std::size_t index = 0; index < locations.size(); ++index) {
     if (index > 0) {
       output.push_back(',');
     }
-    append_location(output, section.locations[index]);
+    append_location(output, locations[index]);
   }
   output.push_back(']');
 }
 
 void append_locations_field(std::string& output,
-                            const SearchPathSection& section,
+                            std::span<const SearchPathLocation> locations,
                             bool& first,
                             LocationEncoding encoding) {
   append_field_prefix(output, "locations", first);
   if (encoding == LocationEncoding::Array) {
-    append_locations_array(output, section);
+    append_locations_array(output, locations);
     return;
   }
 
   std::string encoded;
-  encoded.reserve(section.locations.size() * 160U);
-  append_locations_array(encoded, section);
+  encoded.reserve(locations.size() * 160U);
+  append_locations_array(encoded, locations);
   append_json_string(output, encoded);
 }
 
 void append_path_section(std::string& output, std::string_view key,
                          const SearchPathSection& section, bool& first,
                          LocationEncoding location_encoding) {
-  if (section.locations.empty()) {
+  if (section.empty()) {
     return;
   }
 
+  // Cached sections only carry a compact path handle; expand it once here
+  // and serve every field below from the same storage.
+  std::vector<SearchPathLocation> storage;
+  const auto locations = section.resolve(storage);
+
   append_field_prefix(output, key, first);
   output.push_back('{');
   bool section_first = true;
 
   append_int_field(output,
                    "hop_count",
-                   static_cast<std::int64_t>(section.locations.size()),
+                   static_cast<std::int64_t>(locations.size()),
                    section_first);
   append_unique_path_string_array(
     output,
     "location_codes",
-    section,
+    locations,
     section_first,
     [](const SearchPathLocation& location) -> std::string_view {
       return location.code;
@@ -810,7 +780,7 @@ void append_path_section(std::string& output, std::string_view key,
   append_unique_path_string_array(
     output,
     "route_codes",
-    section,
+    locations,
     section_first,
     [](const SearchPathLocation& location) -> std::string_view {
       if (!location.has_departure) {
@@ -819,13 +789,13 @@ void append_path_section(std::string& output, std::string_view key,
       return location.route;
     });
 
-  append_locations_field(output, section, section_first, location_encoding);
+  append_locations_field(output, locations, section_first, location_encoding);
 
   append_field_prefix(output, "first", section_first);
-  append_location(output, section.locations.front());
-  if (section.locations.size() > 1) {
+  append_location(output, locations.front());
+  if (locations.size() > 1) {
     append_field_prefix(output, "second", section_first);
-    append_location(output, section.locations[1]);
+    append_location(output, locations[1]);
   }
   output.push_back('}');
 }
@@ -835,6 +805,7 @@ auto serialize_document_body(const SearchDocument& document,
                              std::int64_t updated_at_ts,
                              LocationEncoding location_encoding =
                                LocationEncoding::Array) -> std::string {
+  const StageTimer stage(PipelineStage::serialize);
   std::string output;
   output.reserve(512);
   output.push_back('{');
@@ -884,6 +855,7 @@ auto estimate_bulk_payload_bytes(const std::vector<BulkDocument>& documents,
 void append_bulk_payload(std::string& payload,
                          const std::vector<BulkDocument>& documents,
                          std::string_view search_index) {
+  const StageTimer stage(PipelineStage::bulk_assembly);
   const auto bytes = std::accumulate(
     documents.begin(),
     documents.end(),
@@ -908,6 +880,8 @@ void append_bulk_payload(std::string& payload,
 auto gzip_bulk_payload(const std::vector<BulkDocument>& documents,
                        std::string_view search_index,
                        int compression_level) -> std::string {
+  // Deflating is timed apart, inside gzip_append().
+  const StageTimer stage(PipelineStage::bulk_assembly);
   z_stream stream{};
   if (deflateInit2(&stream,
                    compression_level,
@@ -925,8 +899,7 @@ auto gzip_bulk_payload(const std::vector<BulkDocument>& documents,
     std::string metadata;
     metadata.reserve(search_index.size() + 128U);
     for (const auto& document : documents) {
-      gzip_append(stream, output, R"({"index":{"_index":)", Z_NO_FLUSH);
-      metadata.clear();
+      metadata = R"({"index":{"_index":)";
       append_json_string(metadata, search_index);
       metadata += R"(,"_id":)";
       append_json_string(metadata, document.id);
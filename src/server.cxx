@@ -1,6 +1,7 @@
 module;
 
 #include "blocking_queue.hxx"
+#include "load_compactor.hxx"
 #include <getopt.h>
 
 module moirai.server;
@@ -10,6 +11,7 @@ import moirai.app;
 import moirai.file_reader;
 import moirai.http;
 import moirai.kafka_reader;
+import moirai.load_capture;
 import moirai.scan_reader;
 import moirai.search_writer;
 import moirai.solver_wrapper;
@@ -38,7 +40,16 @@ void Moirai::display_help() const {
   std::cout
       << "     security.protocol=SASL_SSL,sasl.mechanisms=SCRAM-SHA-512,\n";
   std::cout << "     sasl.username=...,sasl.password=...\n";
-  std::cout << "  -q, --query-from <path>\n";
+  std::cout << "  --partition-lanes (one load queue and solver per lane, "
+               "by Kafka partition)\n";
+  std::cout << "  --compact-loads (drop queued loads superseded by a newer "
+               "scan of the same bag)\n";
+  std::cout << "  -q, --query-from <path> (repeat to read several files in "
+               "parallel)\n";
+  std::cout << "  --record-to <path> (record consumed loads to a capture "
+               "file)\n";
+  std::cout << "  --record-compress (zlib-compress the capture; replays "
+               "slower)\n";
   std::cout << "  -r, --route-topic <topic> (ignored; compatibility only)\n";
   std::cout << "  --search-writers <count>\n";
   std::cout << "  -t, --batch-timeout <milliseconds>\n";
@@ -78,7 +89,11 @@ void Moirai::parse_options(int argc, char **argv) {
   m_command_name = std::filesystem::path(argv[0]).filename().string();
 
   constexpr int SEARCH_WRITERS_OPTION = 1000;
-  constexpr std::array<option, 20> long_options{{
+  constexpr int PARTITION_LANES_OPTION = 1001;
+  constexpr int COMPACT_LOADS_OPTION = 1002;
+  constexpr int RECORD_TO_OPTION = 1003;
+  constexpr int RECORD_COMPRESS_OPTION = 1004;
+  constexpr std::array<option, 24> long_options{{
       {.name = "help", .has_arg = no_argument, .flag = nullptr, .val = 'h'},
       {.name = "route-api",
        .has_arg = required_argument,
@@ -152,6 +167,22 @@ void Moirai::parse_options(int argc, char **argv) {
        .has_arg = required_argument,
        .flag = nullptr,
        .val = SEARCH_WRITERS_OPTION},
+      {.name = "partition-lanes",
+       .has_arg = no_argument,
+       .flag = nullptr,
+       .val = PARTITION_LANES_OPTION},
+      {.name = "compact-loads",
+       .has_arg = no_argument,
+       .flag = nullptr,
+       .val = COMPACT_LOADS_OPTION},
+      {.name = "record-to",
+       .has_arg = required_argument,
+       .flag = nullptr,
+       .val = RECORD_TO_OPTION},
+      {.name = "record-compress",
+       .has_arg = no_argument,
+       .flag = nullptr,
+       .val = RECORD_COMPRESS_OPTION},
       {.name = nullptr, .has_arg = 0, .flag = nullptr, .val = 0},
   }};
 
@@ -175,7 +206,7 @@ void Moirai::parse_options(int argc, char **argv) {
       m_route_uri = optarg;
       break;
     case 'q':
-      m_scans_query_file = optarg;
+      m_scans_query_files.emplace_back(optarg);
       m_local_mode = true;
       break;
     case 'b':
@@ -235,6 +266,18 @@ void Moirai::parse_options(int argc, char **argv) {
       m_search_writer_threads =
           static_cast<std::uint16_t>(std::stoul(optarg));
       break;
+    case PARTITION_LANES_OPTION:
+      m_partition_lanes = true;
+      break;
+    case COMPACT_LOADS_OPTION:
+      m_compact_loads = true;
+      break;
+    case RECORD_TO_OPTION:
+      m_record_to = optarg;
+      break;
+    case RECORD_COMPRESS_OPTION:
+      m_record_compress = true;
+      break;
     default:
       throw std::runtime_error("Invalid command line option");
     }
@@ -253,6 +296,7 @@ void Moirai::parse_options(int argc, char **argv) {
 namespace {
 
 constexpr std::size_t PIPELINE_QUEUE_CAPACITY = 4096;
+constexpr std::size_t MIN_LANE_QUEUE_CAPACITY = 256;
 
 } // namespace
 
@@ -264,22 +308,89 @@ auto Moirai::run_pipeline() -> int {
   BlockingQueue<std::string> node_queue{1};
   BlockingQueue<std::string> edge_queue{1};
   BlockingQueue<std::string> load_queue{PIPELINE_QUEUE_CAPACITY};
-  BlockingQueue<SearchDocument> solution_queue{PIPELINE_QUEUE_CAPACITY};
+
+  const unsigned int hardware_threads =
+      std::max(3U, std::thread::hardware_concurrency());
+  const int solver_threads =
+      std::max(1, static_cast<int>(hardware_threads) - 2);
+
+  // Partition-affine mode gives every solver thread its own load queue, fed
+  // only with the Kafka partitions mapped to it, so scans of one bag are
+  // solved in order and solvers never contend for a queue.
+  std::vector<std::unique_ptr<BlockingQueue<std::string>>> lanes;
+  if (m_partition_lanes && !m_local_mode) {
+    lanes.reserve(static_cast<std::size_t>(solver_threads));
+    for (int idx = 0; idx < solver_threads; ++idx) {
+      lanes.push_back(std::make_unique<BlockingQueue<std::string>>(
+          std::max(PIPELINE_QUEUE_CAPACITY /
+                       static_cast<std::size_t>(solver_threads),
+                   MIN_LANE_QUEUE_CAPACITY)));
+    }
+  }
+  // Compaction tracks at most one bag id per queued load; the index gets
+  // twice that so uneven shards do not turn bags away.
+  std::unique_ptr<LoadCompactor> compactor;
+  if (m_compact_loads && !m_local_mode) {
+    std::size_t queued_loads = lanes.empty() ? load_queue.capacity() : 0;
+    for (const auto &lane : lanes) {
+      queued_loads += lane->capacity();
+    }
+    compactor = std::make_unique<LoadCompactor>(2 * queued_loads);
+  }
+  const auto solver_load_queue =
+      [&lanes, &load_queue](int idx) -> BlockingQueue<std::string> * {
+    return lanes.empty() ? &load_queue
+                         : lanes[static_cast<std::size_t>(idx)].get();
+  };
+  // Writers share one solution queue unless lanes are on. Then each writer
+  // drains its own queue and every lane feeds exactly one of them, so the
+  // scans of a bag are posted in order instead of racing between concurrent
+  // bulk requests.
+  const std::size_t solution_queue_count =
+      lanes.empty() ? 1 : m_search_writer_threads;
+  std::vector<std::unique_ptr<BlockingQueue<SearchDocument>>> solution_queues;
+  solution_queues.reserve(solution_queue_count);
+  for (std::size_t idx = 0; idx < solution_queue_count; ++idx) {
+    solution_queues.push_back(std::make_unique<BlockingQueue<SearchDocument>>(
+        std::max(PIPELINE_QUEUE_CAPACITY / solution_queue_count,
+                 MIN_LANE_QUEUE_CAPACITY)));
+  }
+  const auto solver_solution_queue =
+      [&solution_queues](int idx) -> BlockingQueue<SearchDocument> * {
+    return solution_queues[static_cast<std::size_t>(idx) %
+                           solution_queues.size()]
+        .get();
+  };
+  const auto close_solution_queues = [&solution_queues] {
+    for (const auto &queue : solution_queues) {
+      queue->close();
+    }
+  };
 
   SolverWrapper wrapper(
       SolverWrapper::RuntimeQueues{.node = &node_queue,
                                    .edge = &edge_queue,
-                                   .load = &load_queue,
-                                   .solution = &solution_queue},
+                                   .load = solver_load_queue(0),
+                                   .solution = solver_solution_queue(0),
+                                   .compactor = compactor.get()},
       SolverWrapper::InitEndpoints{.node_uri = m_facility_uri,
                                    .node_token = m_facility_token,
                                    .edge_uri = m_route_uri,
                                    .edge_token = m_route_token},
       m_facility_timings_filename);
 
+  std::unique_ptr<moirai::LoadRecorder> recorder;
+  if (!m_record_to.empty() && !m_local_mode) {
+    recorder = std::make_unique<moirai::LoadRecorder>(
+        m_record_to, m_record_compress ? moirai::CaptureCodec::zlib
+                                       : moirai::CaptureCodec::stored);
+    app.logger().information("Recording consumed loads to {}",
+                             m_record_to.string());
+  }
+
   std::shared_ptr<ScanReader> reader;
   if (m_local_mode) {
-    reader = std::make_shared<FileReader>(m_scans_query_file, &load_queue);
+    reader = std::make_shared<FileReader>(m_scans_query_files, &load_queue);
     app.logger().set_level("debug");
   } else {
     std::string brokers;
@@ -293,8 +404,22 @@ auto Moirai::run_pipeline() -> int {
     reader = std::make_shared<KafkaReader>(
         brokers, m_batch_size, std::chrono::milliseconds{m_timeout},
         m_topic_map, m_kafka_properties,
+        // Node and edge topics are not consumed at runtime: the graph is
+        // built once at startup and never changes while the server runs.
         KafkaReader::QueueSet{
-            .node = nullptr, .edge = nullptr, .load = &load_queue});
+            .node = nullptr,
+            .edge = nullptr,
+            .load = &load_queue,
+            .lanes = [&lanes] {
+              std::vector<BlockingQueue<std::string> *> queues;
+              queues.reserve(lanes.size());
+              for (const auto &lane : lanes) {
+                queues.push_back(lane.get());
+              }
+              return queues;
+            }(),
+            .compactor = compactor.get(),
+            .recorder = recorder.get()});
   }
 
   std::vector<std::shared_ptr<SearchWriter>> writers;
@@ -302,14 +427,10 @@ auto Moirai::run_pipeline() -> int {
   for (std::uint16_t index = 0; index < m_search_writer_threads; ++index) {
     writers.push_back(std::make_shared<SearchWriter>(
         moirai::parse_uri(m_search_uri), m_search_user, m_search_pass,
-        m_search_index, &solution_queue));
+        m_search_index, solution_queues[index % solution_queue_count].get()));
   }
 
-  const unsigned int hardware_threads =
-      std::max(3U, std::thread::hardware_concurrency());
-  const int solver_threads =
-      std::max(1, static_cast<int>(hardware_threads) - 2);
-  const int num_threads = solver_threads + 1 + m_search_writer_threads;
+  const int num_threads = solver_threads + 4 + m_search_writer_threads;
   std::atomic<int> active_solver_threads{solver_threads};
   app.logger().information(
       "Starting {} solver threads and {} search writer threads on {} hardware "
@@ -323,8 +444,8 @@ auto Moirai::run_pipeline() -> int {
   threads.reserve(num_threads);
 
   try {
-    threads.emplace_back([&app, &reader, &node_queue, &edge_queue,
-                          &load_queue](std::stop_token stop_token) -> void {
+    threads.emplace_back([&app, &reader, &node_queue, &edge_queue, &load_queue,
+                          &lanes](std::stop_token stop_token) -> void {
       try {
         reader->run(std::move(stop_token));
       } catch (const std::exception &exc) {
@@ -338,6 +459,9 @@ auto Moirai::run_pipeline() -> int {
       node_queue.close();
       edge_queue.close();
       load_queue.close();
+      for (const auto &lane : lanes) {
+        lane->close();
+      }
     });
     for (const auto& writer : writers) {
       threads.emplace_back(
@@ -354,7 +478,7 @@ auto Moirai::run_pipeline() -> int {
         });
     }
     threads.emplace_back(
-        [&app, &wrapper, &solution_queue,
+        [&app, &wrapper, &close_solution_queues,
          &active_solver_threads](const std::stop_token &stop_token) -> void {
           try {
             wrapper.run(stop_token);
@@ -367,7 +491,33 @@ auto Moirai::run_pipeline() -> int {
           }
 
           if (active_solver_threads.fetch_sub(1) == 1) {
-            solution_queue.close();
+            close_solution_queues();
+          }
+        });
+
+    threads.emplace_back(
+        [&app, &wrapper](const std::stop_token &stop_token) -> void {
+          try {
+            wrapper.run_path_cache_snapshots(stop_token);
+          } catch (const std::exception &exc) {
+            app.logger().error("Snapshot thread failed: {}", exc.what());
+          }
+        });
+    threads.emplace_back(
+        [&wrapper](const std::stop_token &stop_token) -> void {
+          wrapper.run_missing_facility_reports(stop_token);
+        });
+    threads.emplace_back(
+        [&app, &wrapper, &lanes](const std::stop_token &stop_token) -> void {
+          try {
+            // Lane 0 alone is the primary's queue; idle means every lane.
+            std::vector<BlockingQueue<std::string> *> lane_queues;
+            for (const auto &lane : lanes) {
+              lane_queues.push_back(lane.get());
+            }
+            wrapper.run_prefetcher(stop_token, std::move(lane_queues));
+          } catch (const std::exception &exc) {
+            app.logger().error("Prefetcher thread failed: {}", exc.what());
           }
         });
 
@@ -375,13 +525,14 @@ auto Moirai::run_pipeline() -> int {
       auto secondary_wrapper = std::make_shared<SolverWrapper>(
           SolverWrapper::RuntimeQueues{.node = nullptr,
                                        .edge = nullptr,
-                                       .load = &load_queue,
-                                       .solution = &solution_queue},
+                                       .load = solver_load_queue(idx),
+                                       .solution = solver_solution_queue(idx),
+                                       .compactor = compactor.get()},
           wrapper.get_solver(), m_facility_timings_filename,
-          wrapper.get_cache(), wrapper.get_facility_profiles());
+          wrapper.shared_state());
       secondary.push_back(secondary_wrapper);
       threads.emplace_back(
-          [&app, &solution_queue, &active_solver_threads,
+          [&app, &close_solution_queues, &active_solver_threads,
            secondary_wrapper](const std::stop_token &stop_token) -> void {
             try {
               secondary_wrapper->run(stop_token);
@@ -394,7 +545,7 @@ auto Moirai::run_pipeline() -> int {
             }
 
             if (active_solver_threads.fetch_sub(1) == 1) {
-              solution_queue.close();
+              close_solution_queues();
             }
           });
     }
@@ -411,6 +562,19 @@ auto Moirai::run_pipeline() -> int {
   for (auto &thread : threads) {
     thread.request_stop();
   }
+  // Solvers are done with the cache once their threads have joined.
+  threads.clear();
+  wrapper.save_path_cache_snapshot();
+  wrapper.log_missing_facilities();
+  if (recorder) {
+    recorder->close();
+    const auto capture = recorder->metrics();
+    app.logger().information(
+        "Load capture metrics: records={} dropped={} frames={} raw_bytes={} "
+        "stored_bytes={}",
+        capture.records, capture.dropped, capture.frames, capture.raw_bytes,
+        capture.stored_bytes);
+  }
 
   return 0;
 }
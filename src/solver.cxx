@@ -2,6 +2,7 @@ module moirai.solver;
 
 import std;
 import moirai.date_utils;
+import moirai.route_schedule;
 import moirai.transportation;
 
 namespace {
@@ -11,6 +12,13 @@ constexpr auto DAYS_PER_WEEK = 7U;
 constexpr auto MINUTES_PER_WEEK = DAYS_PER_WEEK * MINUTES_PER_DAY;
 constexpr auto UNIX_EPOCH_WEEKDAY = 4U;
 
+constexpr std::size_t PARALLEL_BUILD_MIN_ITEMS = 16'384;
+constexpr std::size_t PARALLEL_BUILD_CHUNK_ITEMS = 4'096;
+constexpr std::size_t EDGE_CODE_PARTITIONS = 64;
+// A hub costs 2k edges and one node against k*(k-1) direct edges, so it only
+// pays off from four members up.
+constexpr std::size_t COLOCATION_HUB_MIN_MEMBERS = 4;
+
 struct HeapEntry {
   SolverMinute distance{};
   NodeId node{INVALID_NODE};
@@ -114,6 +122,67 @@ thread_local SolverScratch scratch;
   return schedule;
 }
 
+[[nodiscard]] auto make_hot_edge(EdgeId edge_id, NodeId source, NodeId target,
+                                 const TransportEdge& route) -> SolverEdgeHot {
+  const auto forward_cost = route.weight<PathTraversalMode::FORWARD>();
+  const auto reverse_cost = route.weight<PathTraversalMode::REVERSE>();
+  const auto forward_schedule = build_weekly_schedule(forward_cost);
+  const auto reverse_schedule = build_weekly_schedule(reverse_cost);
+  std::array<SolverMinute, DAYS_PER_WEEK> forward_schedule_values{};
+  std::array<SolverMinute, DAYS_PER_WEEK> reverse_schedule_values{};
+  std::ranges::copy(forward_schedule, forward_schedule_values.begin());
+  std::ranges::copy(reverse_schedule, reverse_schedule_values.begin());
+  return SolverEdgeHot{
+      .id = edge_id,
+      .source = source,
+      .target = target,
+      .cold = edge_id,
+      .forward_schedule = forward_schedule_values,
+      .reverse_schedule = reverse_schedule_values,
+      .forward_duration = duration_to_minutes(forward_cost.duration),
+      .reverse_duration = duration_to_minutes(reverse_cost.duration),
+      .reverse_outbound_latency = duration_to_minutes(route.source_offset()),
+      .forward_schedule_count =
+          static_cast<std::uint8_t>(forward_schedule.size()),
+      .reverse_schedule_count =
+          static_cast<std::uint8_t>(reverse_schedule.size()),
+      .vehicle = route.vehicle,
+      .movement = route.movement,
+  };
+}
+
+[[nodiscard]] auto build_worker_count(std::size_t items) -> std::size_t {
+  if (items < PARALLEL_BUILD_MIN_ITEMS) {
+    return 1;
+  }
+  const auto hardware =
+      std::max<std::size_t>(1, std::thread::hardware_concurrency());
+  return std::min(hardware, items / PARALLEL_BUILD_CHUNK_ITEMS);
+}
+
+// Splits [0, count) into `workers` contiguous chunks and runs
+// body(worker, begin, end) for each, chunk 0 on the calling thread. The split
+// depends only on (count, workers), so two passes over the same range see the
+// same chunks.
+template <typename Body>
+void for_each_chunk(std::size_t count, std::size_t workers, Body&& body) {
+  if (workers <= 1) {
+    body(std::size_t{0}, std::size_t{0}, count);
+    return;
+  }
+
+  const auto chunk = (count + workers - 1U) / workers;
+  std::vector<std::jthread> threads;
+  threads.reserve(workers - 1U);
+  for (std::size_t worker = 1; worker < workers; ++worker) {
+    const auto begin = std::min(count, worker * chunk);
+    const auto end = std::min(count, begin + chunk);
+    threads.emplace_back(
+        [&body, worker, begin, end]() { body(worker, begin, end); });
+  }
+  body(std::size_t{0}, std::size_t{0}, std::min(count, chunk));
+}
+
 template <PathTraversalMode P>
 [[nodiscard]] auto traverse(SolverMinute start, const SolverEdgeHot& edge)
     -> SolverMinute {
@@ -237,8 +306,76 @@ auto Solver::valid_node(const NodeId node) const -> bool {
   return node < m_nodes.size();
 }
 
+auto Solver::is_colocation_hub(const NodeId node) const -> bool {
+  return node < m_colocation_hub.size() && m_colocation_hub[node] != 0U;
+}
+
+// Hop records are created on first use so the k*(k-1) pairs of a campus cost
+// nothing until a path actually crosses them.
+auto Solver::colocation_hop(const NodeId source, const NodeId target) const
+    -> const TransportEdge* {
+  const auto key = (static_cast<std::uint64_t>(source) << 32U) | target;
+  {
+    std::shared_lock lock(m_colocation_mutex);
+    if (const auto found = m_colocation_hops.find(key);
+        found != m_colocation_hops.end()) {
+      return &found->second;
+    }
+  }
+
+  std::unique_lock lock(m_colocation_mutex);
+  auto [found, inserted] = m_colocation_hops.try_emplace(key);
+  if (inserted) {
+    const auto name = std::format("CUSTODY-{}-{}", m_nodes[source].code,
+                                  m_nodes[target].code);
+    found->second = TransportEdge{name, name};
+    found->second.update(m_nodes[source], m_nodes[target]);
+  }
+  return &found->second;
+}
+
+// Rewrites every member -> hub -> member pair of steps as the direct custody
+// hop between the two members. Hub edges are zero-cost, so distances on the
+// remaining steps are unchanged; the anchored range shrinks by the hub steps
+// dropped from it.
+void Solver::collapse_colocation_hops(Path& path) const {
+  if (m_colocation_hubs == 0) {
+    return;
+  }
+
+  auto& steps = path.steps;
+  const auto node_of = [this](const PathStep& step) {
+    return static_cast<NodeId>(step.node - m_nodes.data());
+  };
+  const auto anchored_begin = path.anchored_begin;
+  const auto anchored_end = path.anchored_end;
+  std::size_t kept = 0;
+  for (std::size_t index = 0; index < steps.size(); ++index) {
+    if (index > 0 && index + 1U < steps.size() &&
+        is_colocation_hub(node_of(steps[index]))) {
+      auto& member = steps[kept - 1U];
+      member.outbound =
+          colocation_hop(node_of(member), node_of(steps[index + 1U]));
+      if (index < anchored_begin) {
+        --path.anchored_begin;
+      }
+      if (index < anchored_end) {
+        --path.anchored_end;
+      }
+      continue;
+    }
+    steps[kept++] = steps[index];
+  }
+  steps.resize(kept);
+}
+
 void Solver::invalidate_graph() {
   m_csr_dirty.store(true, std::memory_order_release);
+  m_graph_version.fetch_add(1, std::memory_order_acq_rel);
+}
+
+auto Solver::graph_version() const -> std::uint64_t {
+  return m_graph_version.load(std::memory_order_acquire);
 }
 
 void Solver::rebuild_csr() const {
@@ -251,6 +388,13 @@ void Solver::rebuild_csr() const {
     return;
   }
 
+  const auto workers = build_worker_count(m_edges.size());
+  if (workers > 1) {
+    rebuild_csr_parallel(workers);
+    m_csr_dirty.store(false, std::memory_order_release);
+    return;
+  }
+
   m_outgoing_offsets.assign(m_nodes.size() + 1U, 0U);
   m_incoming_offsets.assign(m_nodes.size() + 1U, 0U);
   for (const auto& edge : m_edges) {
@@ -275,6 +419,66 @@ void Solver::rebuild_csr() const {
   m_csr_dirty.store(false, std::memory_order_release);
 }
 
+// Same layout as the serial counting sort: every chunk of edges counts its
+// own degrees, per-node column prefix sums turn those counts into per-chunk
+// cursors, and the scatter walks the same chunks so each adjacency list keeps
+// ascending edge-id order.
+void Solver::rebuild_csr_parallel(std::size_t workers) const {
+  const auto node_count = m_nodes.size();
+  const auto edge_count = m_edges.size();
+  std::vector<std::vector<std::uint32_t>> outgoing_cursors(
+      workers, std::vector<std::uint32_t>(node_count, 0U));
+  std::vector<std::vector<std::uint32_t>> incoming_cursors(
+      workers, std::vector<std::uint32_t>(node_count, 0U));
+
+  for_each_chunk(edge_count, workers,
+                 [&](std::size_t worker, std::size_t begin, std::size_t end) {
+                   auto& outgoing = outgoing_cursors[worker];
+                   auto& incoming = incoming_cursors[worker];
+                   for (auto index = begin; index < end; ++index) {
+                     ++outgoing[m_edges[index].source];
+                     ++incoming[m_edges[index].target];
+                   }
+                 });
+
+  m_outgoing_offsets.assign(node_count + 1U, 0U);
+  m_incoming_offsets.assign(node_count + 1U, 0U);
+  for_each_chunk(node_count, workers,
+                 [&](std::size_t, std::size_t begin, std::size_t end) {
+                   for (auto node = begin; node < end; ++node) {
+                     std::uint32_t outgoing_total = 0;
+                     std::uint32_t incoming_total = 0;
+                     for (std::size_t worker = 0; worker < workers; ++worker) {
+                       outgoing_total += std::exchange(
+                           outgoing_cursors[worker][node], outgoing_total);
+                       incoming_total += std::exchange(
+                           incoming_cursors[worker][node], incoming_total);
+                     }
+                     m_outgoing_offsets[node + 1U] = outgoing_total;
+                     m_incoming_offsets[node + 1U] = incoming_total;
+                   }
+                 });
+  for (std::size_t index = 1; index < m_outgoing_offsets.size(); ++index) {
+    m_outgoing_offsets[index] += m_outgoing_offsets[index - 1U];
+    m_incoming_offsets[index] += m_incoming_offsets[index - 1U];
+  }
+
+  m_outgoing_edges.assign(edge_count, INVALID_EDGE);
+  m_incoming_edges.assign(edge_count, INVALID_EDGE);
+  for_each_chunk(edge_count, workers,
+                 [&](std::size_t worker, std::size_t begin, std::size_t end) {
+                   auto& outgoing = outgoing_cursors[worker];
+                   auto& incoming = incoming_cursors[worker];
+                   for (auto index = begin; index < end; ++index) {
+                     const auto& edge = m_edges[index];
+                     m_outgoing_edges[m_outgoing_offsets[edge.source] +
+                                      outgoing[edge.source]++] = edge.id;
+                     m_incoming_edges[m_incoming_offsets[edge.target] +
+                                      incoming[edge.target]++] = edge.id;
+                   }
+                 });
+}
+
 void Solver::finalize_graph() const {
   rebuild_csr();
 }
@@ -373,6 +577,10 @@ auto Solver::graph_stats() const -> SolverGraphStats {
               : static_cast<double>(m_outgoing_edges.size()) /
                     static_cast<double>(m_nodes.size()),
       .max_out_degree = max_degree,
+      .colocation_hubs = m_colocation_hubs,
+      .custody_edges = m_custody_edges,
+      .custody_edges_saved =
+          m_custody_pairs - std::min(m_custody_pairs, m_custody_edges),
   };
 }
 
@@ -387,36 +595,9 @@ auto Solver::add_edge(const NodeId source, const NodeId target,
   }
 
   route.update(m_nodes[source], m_nodes[target]);
-  const auto forward_cost = route.weight<PathTraversalMode::FORWARD>();
-  const auto reverse_cost = route.weight<PathTraversalMode::REVERSE>();
-  const auto forward_schedule = build_weekly_schedule(forward_cost);
-  const auto reverse_schedule = build_weekly_schedule(reverse_cost);
-  std::array<SolverMinute, DAYS_PER_WEEK> forward_schedule_values{};
-  std::array<SolverMinute, DAYS_PER_WEEK> reverse_schedule_values{};
-  std::ranges::copy(forward_schedule, forward_schedule_values.begin());
-  std::ranges::copy(reverse_schedule, reverse_schedule_values.begin());
-  const auto reverse_outbound_latency = route.source_offset();
   const auto edge_id = static_cast<EdgeId>(m_edges.size());
-  const auto vehicle = route.vehicle;
-  const auto movement = route.movement;
+  m_edges.push_back(make_hot_edge(edge_id, source, target, route));
   m_edge_details.push_back(SolverEdgeCold{.edge = std::move(route)});
-  m_edges.push_back(SolverEdgeHot{
-      .id = edge_id,
-      .source = source,
-      .target = target,
-      .cold = edge_id,
-      .forward_schedule = forward_schedule_values,
-      .reverse_schedule = reverse_schedule_values,
-      .forward_duration = duration_to_minutes(forward_cost.duration),
-      .reverse_duration = duration_to_minutes(reverse_cost.duration),
-      .reverse_outbound_latency = duration_to_minutes(reverse_outbound_latency),
-      .forward_schedule_count =
-          static_cast<std::uint8_t>(forward_schedule.size()),
-      .reverse_schedule_count =
-          static_cast<std::uint8_t>(reverse_schedule.size()),
-      .vehicle = vehicle,
-      .movement = movement,
-  });
   m_edge_by_name[m_edge_details.back().edge.code] = edge_id;
   invalidate_graph();
   return edge_id;
@@ -433,6 +614,154 @@ auto Solver::add_edge(const NodeId source, const NodeId target,
   return add_edge(source, target, *route);
 }
 
+auto Solver::add_edges_bulk(std::span<RouteEdgeSpec> specs)
+    -> std::vector<EdgeId> {
+  enum class SpecState : std::uint8_t { MISSING_NODE, DUPLICATE, INSERT };
+
+  const auto count = specs.size();
+  const auto workers = build_worker_count(count);
+  std::vector<NodeId> sources(count, INVALID_NODE);
+  std::vector<NodeId> targets(count, INVALID_NODE);
+  std::vector<std::uint8_t> partitions(count, 0U);
+  const auto resolve = [this](std::string_view code) -> NodeId {
+    const auto found = m_node_by_name.find(code);
+    return found == m_node_by_name.end() ? INVALID_NODE : found->second;
+  };
+  for_each_chunk(count, workers,
+                 [&](std::size_t, std::size_t begin, std::size_t end) {
+                   for (auto index = begin; index < end; ++index) {
+                     const auto& spec = specs[index];
+                     sources[index] = resolve(spec.source_center_code);
+                     targets[index] = resolve(spec.target_center_code);
+                     partitions[index] = static_cast<std::uint8_t>(
+                         TransparentStringHash{}(spec.edge.code) %
+                         EDGE_CODE_PARTITIONS);
+                   }
+                 });
+
+  // Each worker owns a disjoint range of code partitions and scans specs in
+  // input order, so the first occurrence of a code wins as it does serially.
+  std::vector<SpecState> states(count, SpecState::MISSING_NODE);
+  for_each_chunk(
+      EDGE_CODE_PARTITIONS, std::min(workers, EDGE_CODE_PARTITIONS),
+      [&](std::size_t, std::size_t first_partition,
+          std::size_t last_partition) {
+        std::unordered_set<std::string_view> seen;
+        for (std::size_t index = 0; index < count; ++index) {
+          if (partitions[index] < first_partition ||
+              partitions[index] >= last_partition ||
+              sources[index] == INVALID_NODE ||
+              targets[index] == INVALID_NODE) {
+            continue;
+          }
+          const std::string_view code = specs[index].edge.code;
+          states[index] =
+              m_edge_by_name.contains(code) || !seen.insert(code).second
+                  ? SpecState::DUPLICATE
+                  : SpecState::INSERT;
+        }
+      });
+
+  std::vector<EdgeId> ids(count, INVALID_EDGE);
+  const auto base = m_edges.size();
+  auto next = base;
+  for (std::size_t index = 0; index < count; ++index) {
+    if (states[index] == SpecState::INSERT) {
+      ids[index] = static_cast<EdgeId>(next++);
+    }
+  }
+  if (next == base) {
+    for (std::size_t index = 0; index < count; ++index) {
+      if (states[index] == SpecState::DUPLICATE) {
+        ids[index] = m_edge_by_name.find(specs[index].edge.code)->second;
+      }
+    }
+    return ids;
+  }
+
+  m_edges.resize(next);
+  m_edge_details.resize(next);
+  for_each_chunk(count, workers,
+                 [&](std::size_t, std::size_t begin, std::size_t end) {
+                   for (auto index = begin; index < end; ++index) {
+                     if (states[index] != SpecState::INSERT) {
+                       continue;
+                     }
+                     auto& route = specs[index].edge;
+                     const auto edge_id = ids[index];
+                     route.update(m_nodes[sources[index]],
+                                  m_nodes[targets[index]]);
+                     m_edges[edge_id] = make_hot_edge(
+                         edge_id, sources[index], targets[index], route);
+                     m_edge_details[edge_id].edge = std::move(route);
+                   }
+                 });
+
+  m_edge_by_name.reserve(m_edge_by_name.size() + (next - base));
+  for (auto edge_id = base; edge_id < next; ++edge_id) {
+    m_edge_by_name.emplace(m_edge_details[edge_id].edge.code,
+                           static_cast<EdgeId>(edge_id));
+  }
+  for (std::size_t index = 0; index < count; ++index) {
+    if (states[index] == SpecState::DUPLICATE) {
+      ids[index] = m_edge_by_name.find(specs[index].edge.code)->second;
+    }
+  }
+  invalidate_graph();
+  return ids;
+}
+
+auto Solver::add_colocation_group(std::string_view group,
+                                  std::span<const NodeId> members)
+    -> std::size_t {
+  std::vector<NodeId> valid;
+  valid.reserve(members.size());
+  for (const auto member : members) {
+    if (valid_node(member) && std::ranges::find(valid, member) == valid.end()) {
+      valid.push_back(member);
+    }
+  }
+  if (valid.size() < 2U) {
+    return 0;
+  }
+
+  const auto edges_before = m_edges.size();
+  const auto add_custody_edge = [this](NodeId source, NodeId target) {
+    const auto name = std::format("CUSTODY-{}-{}", m_nodes[source].code,
+                                  m_nodes[target].code);
+    (void)add_edge(source, target, TransportEdge{name, name});
+  };
+
+  if (valid.size() < COLOCATION_HUB_MIN_MEMBERS) {
+    for (const auto source : valid) {
+      for (const auto target : valid) {
+        if (source != target) {
+          add_custody_edge(source, target);
+        }
+      }
+    }
+  } else {
+    const auto hub = add_node(
+        TransportCenter{std::format("COLOCATED-{}", group), std::string{group}});
+    if (m_colocation_hub.size() <= hub) {
+      m_colocation_hub.resize(static_cast<std::size_t>(hub) + 1U, 0U);
+    }
+    if (m_colocation_hub[hub] == 0U) {
+      m_colocation_hub[hub] = 1U;
+      ++m_colocation_hubs;
+    }
+    for (const auto member : valid) {
+      add_custody_edge(member, hub);
+      add_custody_edge(hub, member);
+    }
+  }
+
+  const auto added = m_edges.size() - edges_before;
+  m_custody_edges += added;
+  m_custody_pairs += valid.size() * (valid.size() - 1U);
+  return added;
+}
+
 auto Solver::find_edge(std::string_view edge_code) const
     -> std::optional<EdgeId> {
   if (const auto found = m_edge_by_name.find(edge_code);
@@ -442,6 +771,102 @@ auto Solver::find_edge(std::string_view edge_code) const
   return std::nullopt;
 }
 
+auto Solver::node_id(const TransportCenter* node) const -> NodeId {
+  if (m_nodes.empty() || std::less<>{}(node, m_nodes.data()) ||
+      !std::less<>{}(node, m_nodes.data() + m_nodes.size())) {
+    return INVALID_NODE;
+  }
+  return static_cast<NodeId>(node - m_nodes.data());
+}
+
+// Path steps point at the edge inside its cold record, so the id is the
+// record's index; the address check rejects anything that is not one.
+auto Solver::edge_id(const TransportEdge* edge) const -> EdgeId {
+  const auto* bytes = reinterpret_cast<const std::byte*>(edge);
+  const auto* first = reinterpret_cast<const std::byte*>(m_edge_details.data());
+  if (m_edge_details.empty() || std::less<>{}(bytes, first) ||
+      !std::less<>{}(bytes, first + (m_edge_details.size() *
+                                     sizeof(SolverEdgeCold)))) {
+    return INVALID_EDGE;
+  }
+  const auto index =
+      static_cast<std::size_t>(bytes - first) / sizeof(SolverEdgeCold);
+  return &m_edge_details[index].edge == edge ? static_cast<EdgeId>(index)
+                                             : INVALID_EDGE;
+}
+
+auto Solver::node_record(const NodeId node) const -> const TransportCenter* {
+  return valid_node(node) ? &m_nodes[node] : nullptr;
+}
+
+auto Solver::edge_record(const EdgeId edge) const -> const TransportEdge* {
+  return edge < m_edge_details.size() ? &m_edge_details[edge].edge : nullptr;
+}
+
+auto Solver::custody_hop(const NodeId source, const NodeId target) const
+    -> const TransportEdge* {
+  if (!valid_node(source) || !valid_node(target) || source == target) {
+    return nullptr;
+  }
+  for (const auto inbound : outgoing_edges(source)) {
+    const auto hub = m_edges[inbound].target;
+    if (!is_colocation_hub(hub)) {
+      continue;
+    }
+    for (const auto outbound : outgoing_edges(hub)) {
+      if (m_edges[outbound].target == target) {
+        return colocation_hop(source, target);
+      }
+    }
+  }
+  return nullptr;
+}
+
+// FNV-1a over fixed-width fields and string bytes; std::hash is not stable
+// across builds, and fingerprints have to survive a deploy.
+auto Solver::graph_fingerprint() const -> std::uint64_t {
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+  const auto add_bytes = [&hash](const void* data, std::size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t index = 0; index < size; ++index) {
+      hash = (hash ^ bytes[index]) * 0x100000001b3ULL;
+    }
+  };
+  const auto add_value = [&add_bytes](auto value) {
+    add_bytes(&value, sizeof(value));
+  };
+  const auto add_string = [&add_bytes, &add_value](std::string_view value) {
+    add_value(static_cast<std::uint64_t>(value.size()));
+    add_bytes(value.data(), value.size());
+  };
+
+  add_value(static_cast<std::uint64_t>(m_nodes.size()));
+  for (NodeId node = 0; node < m_nodes.size(); ++node) {
+    add_string(m_nodes[node].code);
+    add_value(static_cast<std::uint8_t>(is_colocation_hub(node)));
+  }
+  add_value(static_cast<std::uint64_t>(m_edges.size()));
+  for (const auto& edge : m_edges) {
+    add_string(m_edge_details[edge.cold].edge.code);
+    add_value(edge.source);
+    add_value(edge.target);
+    for (std::size_t index = 0; index < edge.forward_schedule_count; ++index) {
+      add_value(edge.forward_schedule[index]);
+    }
+    for (std::size_t index = 0; index < edge.reverse_schedule_count; ++index) {
+      add_value(edge.reverse_schedule[index]);
+    }
+    add_value(edge.forward_schedule_count);
+    add_value(edge.reverse_schedule_count);
+    add_value(edge.forward_duration);
+    add_value(edge.reverse_duration);
+    add_value(edge.reverse_outbound_latency);
+    add_value(static_cast<std::uint8_t>(edge.vehicle));
+    add_value(static_cast<std::uint8_t>(edge.movement));
+  }
+  return hash;
+}
+
 auto Solver::build_forward_path(
     const NodeId source, const NodeId target,
     const std::vector<SolverMinute>& distances,
@@ -465,6 +890,23 @@ auto Solver::build_forward_path(
   std::ranges::reverse(scratch.path_nodes);
   std::ranges::reverse(scratch.path_edges);
 
+  // Nodes before the first scheduled edge are reached at the start itself. A
+  // later start only eats into the wait for that departure, so the arrival
+  // holds until the wait is used up; an earlier start might catch an earlier
+  // departure, so the interval opens at this start.
+  auto anchored = scratch.path_nodes.size();
+  std::optional<SolverMinute> slack;
+  for (std::size_t index = 0; index < scratch.path_edges.size(); ++index) {
+    const auto& edge = m_edges[scratch.path_edges[index]];
+    if (edge.forward_schedule_count == 0) {
+      continue;
+    }
+    slack = distances[scratch.path_nodes[index + 1U]] - edge.forward_duration -
+            distances[scratch.path_nodes[index]];
+    anchored = index + 1U;
+    break;
+  }
+
   Path path;
   path.steps.reserve(scratch.path_nodes.size());
   for (std::size_t index = 0; index < scratch.path_nodes.size(); ++index) {
@@ -479,6 +921,15 @@ auto Solver::build_forward_path(
         .distance = minute_to_clock(distances[node]),
     });
   }
+  path.anchored_end = anchored;
+  if (slack.has_value()) {
+    path.valid_from = minute_to_clock(distances[source]);
+    path.valid_until = minute_to_clock(distances[source] + *slack);
+  } else {
+    path.valid_from = CLOCK::min();
+    path.valid_until = CLOCK::max();
+  }
+  collapse_colocation_hops(path);
   return path;
 }
 
@@ -489,6 +940,11 @@ auto Solver::build_reverse_path(
   Path path;
   path.steps.reserve(scratch.path_nodes.capacity());
 
+  // Mirror of the forward case: steps after the scheduled edge nearest the
+  // deadline leave at the deadline itself, and an earlier deadline only eats
+  // into the wait before that edge's departure.
+  std::optional<std::size_t> last_scheduled;
+  SolverMinute slack{0};
   for (NodeId current = target; current != source;) {
     const EdgeId predecessor = predecessors[current];
     if (predecessor == INVALID_EDGE) {
@@ -497,6 +953,12 @@ auto Solver::build_reverse_path(
 
     const auto& edge = m_edges[predecessor];
     const auto distance = distances[current] + edge.reverse_outbound_latency;
+    if (edge.reverse_schedule_count != 0) {
+      last_scheduled = path.steps.size();
+      slack = static_cast<SolverMinute>(std::max<std::int64_t>(
+          0, static_cast<std::int64_t>(distances[edge.target]) -
+                 edge.reverse_duration - distances[current]));
+    }
 
     path.steps.push_back(PathStep{
         .node = &m_nodes[current],
@@ -511,6 +973,16 @@ auto Solver::build_reverse_path(
       .outbound = nullptr,
       .distance = minute_to_clock(distances[source]),
   });
+  path.anchored_end = path.steps.size();
+  if (last_scheduled.has_value()) {
+    path.anchored_begin = *last_scheduled + 1U;
+    path.valid_from = minute_to_clock(distances[source] - slack);
+    path.valid_until = minute_to_clock(distances[source]);
+  } else {
+    path.valid_from = CLOCK::min();
+    path.valid_until = CLOCK::max();
+  }
+  collapse_colocation_hops(path);
   return path;
 }
 
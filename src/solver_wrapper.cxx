@@ -1,6 +1,15 @@
 module;
 
 #include "blocking_queue.hxx"
+#include "concurrent_cache.hxx"
+#include "heavy_hitters.hxx"
+#include "load_compactor.hxx"
+#include "single_flight.hxx"
+#include "stage_profile.hxx"
+#include "work_stealing_executor.hxx"
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
 
 module moirai.solver_wrapper;
 
@@ -9,6 +18,7 @@ import moirai.app;
 import moirai.date_utils;
 import moirai.http;
 import moirai.json_utils;
+import moirai.load_payload;
 import moirai.processor;
 import moirai.route_schedule;
 import moirai.search_document;
@@ -26,27 +36,69 @@ constexpr std::string_view ROUTE_EXPANSION_THREADS_ENV =
   "MOIRAI_ROUTE_EXPANSION_THREADS";
 constexpr std::string_view FACILITY_DETAIL_THREADS_ENV =
   "MOIRAI_FACILITY_DETAIL_THREADS";
+constexpr std::string_view STARTUP_THREADS_ENV = "MOIRAI_STARTUP_THREADS";
+constexpr std::size_t FACILITY_DETAIL_DEFAULT_THREADS = 16;
+constexpr std::size_t ROUTE_PUBLISH_CHUNK = 64;
 constexpr std::string_view PATH_CACHE_ENABLED_ENV = "MOIRAI_PATH_CACHE_ENABLED";
 constexpr std::string_view PATH_CACHE_MAX_ENTRIES_ENV =
   "MOIRAI_PATH_CACHE_MAX_ENTRIES";
-constexpr std::string_view PATH_CACHE_BUCKET_MINUTES_ENV =
-  "MOIRAI_PATH_CACHE_BUCKET_MINUTES";
+constexpr std::string_view PATH_CACHE_INFLIGHT_TIMEOUT_ENV =
+  "MOIRAI_PATH_CACHE_INFLIGHT_TIMEOUT_MS";
+constexpr std::string_view PATH_CACHE_SNAPSHOT_ENV = "MOIRAI_PATH_CACHE_SNAPSHOT";
+constexpr std::string_view PATH_CACHE_SNAPSHOT_INTERVAL_ENV =
+  "MOIRAI_PATH_CACHE_SNAPSHOT_INTERVAL_S";
+constexpr std::string_view PATH_CACHE_PREFETCH_PAIRS_ENV =
+  "MOIRAI_PATH_CACHE_PREFETCH_PAIRS";
+constexpr std::string_view PATH_CACHE_PREFETCH_HORIZON_ENV =
+  "MOIRAI_PATH_CACHE_PREFETCH_HORIZON_MIN";
+constexpr std::string_view ITINERARY_CACHE_ENTRIES_ENV =
+  "MOIRAI_ITINERARY_CACHE_ENTRIES";
+constexpr std::size_t MISSING_FACILITIES_LOGGED = 20;
+constexpr auto MISSING_FACILITY_REPORT_INTERVAL = std::chrono::minutes{ 15 };
+constexpr std::string_view LOAD_BATCH_DECODE_ENV = "MOIRAI_LOAD_BATCH_DECODE";
+constexpr std::string_view LOAD_FANOUT_MIN_CHILDREN_ENV =
+  "MOIRAI_LOAD_FANOUT_MIN_CHILDREN";
+constexpr std::string_view LOAD_FANOUT_THREADS_ENV =
+  "MOIRAI_LOAD_FANOUT_THREADS";
+constexpr std::size_t LOAD_FANOUT_DEFAULT_MIN_CHILDREN = 512;
+// Smallest share of a split load; below this the handoff costs more than the
+// solves it moves.
+constexpr std::size_t LOAD_FANOUT_MIN_PART = 128;
+// Solves per key and pass, so one key cannot fill its interval list or hold
+// the prefetcher while other hot keys wait.
+constexpr std::size_t PREFETCH_SOLVES_PER_KEY = 4;
+constexpr auto PREFETCH_IDLE_POLL = std::chrono::milliseconds{ 200 };
+// Hot-key counts are halved this often, following the daily load cycle.
+constexpr auto PREFETCH_DECAY_INTERVAL = std::chrono::hours{ 1 };
+constexpr int PREFETCH_NICE = 19;
+constexpr std::array<char, 8> PATH_CACHE_SNAPSHOT_MAGIC{ 'M', 'O', 'I', 'R',
+                                                         'A', 'I', 'P', 'C' };
+// Bump whenever the record layout or the solver's answers change.
+constexpr std::uint32_t PATH_CACHE_SNAPSHOT_VERSION = 1;
+// Edge id stored for a custody hop through a co-location hub; the hop is
+// rebuilt from the step's node and the next one.
+constexpr EdgeId SNAPSHOT_CUSTODY_HOP = INVALID_EDGE - 1;
 using PackageInfo = std::tuple<std::string, std::int32_t, std::string>;
+// A child's destination code and deadline in epoch minutes.
+using ChildDeadline = std::pair<std::string_view, std::int32_t>;
 
+// A child's cn and ipdd_destination, viewing the decoded load.
+struct ChildWaybill {
+  std::string_view cn;
+  std::string_view ipdd;
 
-struct LoadPayload {
-  std::string id;
-  std::string location;
-  std::string destination;
-  std::string origin_center;
-  std::string event_time;
-  std::string ipdd_destination;
-  std::string cs_slid;
-  std::string cs_act;
-  std::string pid;
-  std::optional<moirai::Json> items;
+  auto operator==(const ChildWaybill&) const -> bool = default;
 };
 
+struct ChildWaybillHash {
+  auto operator()(const ChildWaybill& waybill) const noexcept -> std::size_t {
+    const auto cn = std::hash<std::string_view>{}(waybill.cn);
+    return cn ^ (std::hash<std::string_view>{}(waybill.ipdd) +
+                 0x9e3779b97f4a7c15ULL + (cn << 6U) + (cn >> 2U));
+  }
+};
+
+
 struct FacilityListEntry {
   std::string code;
   std::string name;
@@ -55,8 +107,17 @@ struct FacilityListEntry {
   SolverWrapper::FacilityProfile profile;
 };
 
+struct FacilityPage {
+  std::vector<FacilityListEntry> facilities;
+  std::size_t listed{0};
+  std::int16_t total_pages{0};
+};
+
 struct WrapperScratch {
+  std::vector<moirai::LoadItem> waybills;
   std::vector<PackageInfo> packages;
+  std::unordered_set<ChildWaybill, ChildWaybillHash> seen_children;
+  std::vector<ChildDeadline> children;
 };
 
 thread_local WrapperScratch wrapper_scratch;
@@ -68,92 +129,39 @@ auto milliseconds_since(std::chrono::steady_clock::time_point start,
     .count();
 }
 
-auto parse_bool_env(std::string_view name, bool fallback) -> bool {
-  const char* value = std::getenv(std::string(name).c_str());
-  if (value == nullptr || std::string_view{value}.empty()) {
-    return fallback;
-  }
-  std::string input{value};
-  std::ranges::transform(input, input.begin(), [](unsigned char chr) {
-    return static_cast<char>(std::tolower(chr));
-  });
-  if (input == "1" || input == "true" || input == "yes" || input == "on") {
-    return true;
-  }
-  if (input == "0" || input == "false" || input == "no" || input == "off") {
-    return false;
-  }
-  throw std::runtime_error(std::format("Invalid {} value '{}'", name, input));
-}
-
-auto parse_size_env(std::string_view name, std::size_t fallback,
-                    bool allow_zero = false) -> std::size_t {
-  const char* value = std::getenv(std::string(name).c_str());
-  if (value == nullptr || std::string_view{value}.empty()) {
-    return fallback;
-  }
-  std::size_t parsed{};
-  const std::string_view input{value};
-  const auto [ptr, error] =
-    std::from_chars(input.data(), input.data() + input.size(), parsed);
-  if (error != std::errc{} || ptr != input.data() + input.size() ||
-      (!allow_zero && parsed == 0)) {
-    throw std::runtime_error(std::format("Invalid {} value '{}'", name, input));
-  }
-  return parsed;
-}
-
 auto path_cache_config_from_environment() -> PathCacheConfig {
   PathCacheConfig cache;
   cache.enabled = parse_bool_env(PATH_CACHE_ENABLED_ENV, cache.enabled);
   cache.max_entries =
     parse_size_env(PATH_CACHE_MAX_ENTRIES_ENV, cache.max_entries, true);
-  cache.bucket_minutes = static_cast<std::uint32_t>(
-    parse_size_env(PATH_CACHE_BUCKET_MINUTES_ENV, cache.bucket_minutes));
+  cache.inflight_timeout = std::chrono::milliseconds{
+    parse_size_env(PATH_CACHE_INFLIGHT_TIMEOUT_ENV,
+                   static_cast<std::size_t>(cache.inflight_timeout.count()),
+                   true)
+  };
+  if (const char* snapshot = std::getenv(PATH_CACHE_SNAPSHOT_ENV.data());
+      snapshot != nullptr) {
+    cache.snapshot_path = snapshot;
+  }
+  cache.snapshot_interval = std::chrono::seconds{
+    parse_size_env(PATH_CACHE_SNAPSHOT_INTERVAL_ENV,
+                   static_cast<std::size_t>(cache.snapshot_interval.count()),
+                   true)
+  };
+  cache.prefetch_pairs =
+    parse_size_env(PATH_CACHE_PREFETCH_PAIRS_ENV, cache.prefetch_pairs, true);
+  cache.prefetch_horizon = std::chrono::minutes{
+    parse_size_env(PATH_CACHE_PREFETCH_HORIZON_ENV,
+                   static_cast<std::size_t>(cache.prefetch_horizon.count()))
+  };
+  cache.itinerary_entries = parse_size_env(
+    ITINERARY_CACHE_ENTRIES_ENV, cache.itinerary_entries, true);
   if (cache.max_entries == 0) {
     cache.enabled = false;
   }
   return cache;
 }
 
-auto optional_string(const moirai::Json& object, const char* key)
-    -> std::string {
-  const auto value = moirai::find_string_member(object, key);
-  return value.has_value() ? std::string(*value) : std::string{};
-}
-
-auto extract_load_payload(const moirai::Json& data)
-    -> std::expected<LoadPayload, std::string> {
-  const auto bag_identifier = moirai::find_string_member(data, "id");
-  const auto current_location = moirai::find_string_member(data, "location");
-  const auto item_destination =
-    moirai::find_string_member(data, "destination");
-  const auto event_time = moirai::find_string_member(data, "time");
-  if (!bag_identifier.has_value() || !current_location.has_value() ||
-      !item_destination.has_value() || !event_time.has_value()) {
-    return std::unexpected{"missing id, location, destination, or time"};
-  }
-
-  const auto* items_ptr = moirai::find_array_member(data, "items");
-  if (items_ptr == nullptr) {
-    items_ptr = moirai::find_array_member(data, "item");
-  }
-
-  return LoadPayload{
-    .id = std::string(*bag_identifier),
-    .location = std::string(*current_location),
-    .destination = std::string(*item_destination),
-    .origin_center = optional_string(data, "oc"),
-    .event_time = std::string(*event_time),
-    .ipdd_destination = optional_string(data, "ipdd_destination"),
-    .cs_slid = optional_string(data, "cs_slid"),
-    .cs_act = optional_string(data, "cs_act"),
-    .pid = optional_string(data, "pid"),
-    .items = items_ptr != nullptr ? std::optional<moirai::Json>(*items_ptr)
-                                  : std::nullopt,
-  };
-}
-
 auto parse_facility_duration(const moirai::Json& object,
                              const char* key) -> std::optional<DURATION>
 {
@@ -253,11 +261,7 @@ auto profile_for(const std::shared_ptr<SolverWrapper::FacilityProfiles>& profile
                                   : found->second;
 }
 
-auto parse_route_expansion_threads(std::size_t route_count) -> std::size_t {
-  if (route_count == 0) {
-    return 0;
-  }
-
+auto parse_route_expansion_threads() -> std::size_t {
   const char* value = std::getenv(ROUTE_EXPANSION_THREADS_ENV.data());
   if (value != nullptr && std::string_view{value}.empty()) {
     value = nullptr;
@@ -282,7 +286,7 @@ auto parse_route_expansion_threads(std::size_t route_count) -> std::size_t {
     }
   }
 
-  return std::clamp(requested, std::size_t{1}, route_count);
+  return requested;
 }
 
 auto parse_facility_detail_threads(std::size_t facility_count) -> std::size_t {
@@ -312,479 +316,1529 @@ auto parse_facility_detail_threads(std::size_t facility_count) -> std::size_t {
     if (requested == 0) {
       requested = 1;
     }
-    requested = std::min<std::size_t>(requested, 16);
+    requested = std::min(requested, FACILITY_DETAIL_DEFAULT_THREADS);
   }
 
   return std::clamp(requested, std::size_t{1}, facility_count);
 }
 
-auto expand_route_specs(const moirai::Json& routes)
-    -> std::vector<std::expected<std::vector<RouteEdgeSpec>, std::string>> {
-  const auto route_count = moirai::json_size(routes);
-  std::vector<std::expected<std::vector<RouteEdgeSpec>, std::string>> expanded(
-    route_count);
-  const auto worker_count = parse_route_expansion_threads(route_count);
-  if (worker_count == 0) {
-    return expanded;
+// Startup mixes blocking API fetches with CPU-bound expansion, so the pool is
+// sized to cover the facility detail fan-out even on small hosts.
+auto parse_startup_threads() -> std::size_t {
+  return parse_size_env(
+    STARTUP_THREADS_ENV,
+    std::max<std::size_t>(std::thread::hardware_concurrency(),
+                          FACILITY_DETAIL_DEFAULT_THREADS));
+}
+
+auto auth_header(std::string_view token) -> std::vector<std::string> {
+  return { std::format("Authorization: Bearer {}", token) };
+}
+
+auto fetch_facility_page(const SolverWrapper::HttpGet& http_get,
+                         const moirai::Uri& facility_uri,
+                         std::string_view token,
+                         std::int16_t page) -> std::optional<FacilityPage>
+{
+  auto& app = moirai::Application::instance();
+  const auto request_uri = moirai::with_query_parameters(
+    facility_uri,
+    { { "page", std::to_string(page) }, { "status", "active" } });
+  const auto response = http_get(request_uri, auth_header(token));
+  if (response.status_code != HTTP_STATUS_OK) {
+    app.logger().error("Unable to fetch facility data: {}", response.body);
+    return std::nullopt;
+  }
+
+  const auto response_json = moirai::parse_json(response.body);
+  if (!response_json.has_value() || !response_json->is_object()) {
+    app.logger().error("Unable to parse facility response");
+    return std::nullopt;
+  }
+
+  const auto* result = moirai::find_object_member(*response_json, "result");
+  const auto* data =
+    result == nullptr ? nullptr : moirai::find_array_member(*result, "data");
+  const auto pages =
+    result == nullptr
+      ? std::nullopt
+      : moirai::find_integer_member<int16_t>(*result, "total_page_count");
+  if (result == nullptr || data == nullptr || !pages.has_value()) {
+    app.logger().error("Facility response is missing result/data metadata");
+    return std::nullopt;
+  }
+
+  FacilityPage facility_page{
+    .facilities = {},
+    .listed = moirai::json_size(*data),
+    .total_pages = *pages,
+  };
+  facility_page.facilities.reserve(facility_page.listed);
+  for (const auto& facility : *data) {
+    const auto facility_code =
+      moirai::find_string_member(facility, "facility_code");
+    if (!facility_code.has_value()) {
+      app.logger().error("Skipping facility without facility_code");
+      continue;
+    }
+
+    const auto facility_name = moirai::find_string_member(facility, "name");
+    const auto property_id =
+      moirai::find_string_member(facility, "property_id");
+    facility_page.facilities.push_back(FacilityListEntry{
+      .code = std::string(*facility_code),
+      .name = facility_name.has_value() ? std::string(*facility_name)
+                                        : std::string{},
+      .property_id = property_id.has_value() ? std::string(*property_id)
+                                             : std::string{},
+      .id = facility_identifier(facility),
+      .profile = parse_facility_profile(facility),
+    });
   }
+  return facility_page;
+}
+
+void
+fetch_facility_details(WorkStealingExecutor& executor,
+                       const SolverWrapper::HttpGet& http_get,
+                       moirai::HttpClientPool* http_pool,
+                       const moirai::Uri& facility_uri,
+                       std::string_view token,
+                       FacilityPage& page)
+{
+  auto& app = moirai::Application::instance();
+  auto& facilities = page.facilities;
+  const auto apply_detail =
+    [&app](FacilityListEntry& facility,
+           const std::expected<moirai::HttpResponse, std::string>& detail) {
+      if (!detail.has_value()) {
+        app.logger().error("Unable to fetch facility detail for {}: {}",
+                           facility.code,
+                           detail.error());
+        return;
+      }
+      if (detail->status_code != HTTP_STATUS_OK) {
+        app.logger().error("Unable to fetch facility detail for {}: {}",
+                           facility.code,
+                           detail->body);
+        return;
+      }
+      const auto detail_json = moirai::parse_json(detail->body);
+      if (detail_json.has_value() && detail_json->is_object()) {
+        facility.profile = parse_facility_profile(*detail_json);
+      } else {
+        app.logger().error("Unable to parse facility detail for {}",
+                           facility.code);
+      }
+    };
 
-  // Build a vector of element pointers for indexed access
-  std::vector<moirai::Json> route_elements;
-  route_elements.reserve(route_count);
-  for (const auto& route : routes) {
-    route_elements.push_back(route);
+  std::vector<std::size_t> detailed;
+  detailed.reserve(facilities.size());
+  for (std::size_t index = 0; index < facilities.size(); ++index) {
+    if (facilities[index].id.has_value()) {
+      detailed.push_back(index);
+    } else {
+      app.logger().debug("No facility id found for {}; using defaults",
+                         facilities[index].code);
+    }
+  }
+  const auto max_in_flight = parse_facility_detail_threads(detailed.size());
+
+  // The pooled client runs the whole page as async transfers from this task
+  // instead of parking one executor thread per request.
+  if (http_pool != nullptr) {
+    std::vector<moirai::Uri> uris;
+    uris.reserve(detailed.size());
+    for (const auto index : detailed) {
+      uris.push_back(
+        moirai::append_path(facility_uri, *facilities[index].id));
+    }
+    const auto responses =
+      http_pool->get_many(uris, auth_header(token), max_in_flight);
+    for (std::size_t offset = 0; offset < detailed.size(); ++offset) {
+      apply_detail(facilities[detailed[offset]], responses[offset]);
+    }
+    return;
   }
 
-  const auto expand_one = [&route_elements, &expanded](std::size_t index) -> void {
+  const auto fetch_detail = [&](std::size_t offset) {
+    auto& facility = facilities[detailed[offset]];
     try {
-      expanded[index] = build_route_edge_specs(route_elements[index], IST_OFFSET);
+      apply_detail(facility,
+                   http_get(moirai::append_path(facility_uri, *facility.id),
+                            auth_header(token)));
     } catch (const std::exception& exc) {
-      expanded[index] = std::unexpected{
-        std::format("route {}: {}", index, exc.what())
-      };
+      apply_detail(facility, std::unexpected{ std::string{ exc.what() } });
     }
   };
+  parallel_for(executor, detailed.size(), max_in_flight, fetch_detail);
+}
 
-  if (worker_count == 1) {
-    for (std::size_t index = 0; index < route_count; ++index) {
-      expand_one(index);
-    }
-    return expanded;
+auto resolve_http_stream(const SolverWrapper::HttpGet& http_get,
+                         SolverWrapper::HttpStream http_stream)
+  -> SolverWrapper::HttpStream
+{
+  if (http_stream) {
+    return http_stream;
   }
-
-  std::atomic_size_t next_route{0};
-  std::vector<std::jthread> workers;
-  workers.reserve(worker_count);
-  for (std::size_t worker = 0; worker < worker_count; ++worker) {
-    workers.emplace_back([&]() {
-      while (true) {
-        const auto index = next_route.fetch_add(1, std::memory_order_relaxed);
-        if (index >= route_count) {
-          return;
-        }
-        expand_one(index);
-      }
-    });
+  if (!http_get) {
+    return moirai::http_get_stream;
   }
+  return [http_get](const moirai::Uri& uri,
+                    const std::vector<std::string>& headers,
+                    const moirai::HttpBodySink& sink) {
+    auto response = http_get(uri, headers);
+    if (response.status_code / 100 == 2) {
+      if (!sink(response.body)) {
+        throw std::runtime_error("Response stream aborted by consumer");
+      }
+      response.body.clear();
+    }
+    return response;
+  };
+}
 
-  return expanded;
+auto make_transport_center(const FacilityListEntry& facility)
+    -> TransportCenter
+{
+  const auto& profile = facility.profile;
+  auto transport_center = TransportCenter{ facility.code, facility.name };
+  transport_center
+    .set_latency<MovementType::CARTING, ProcessType::INBOUND>(DURATION{0});
+  transport_center
+    .set_latency<MovementType::CARTING, ProcessType::OUTBOUND>(
+      profile.outbound_processing);
+  transport_center
+    .set_latency<MovementType::LINEHAUL, ProcessType::INBOUND>(DURATION{0});
+  transport_center
+    .set_latency<MovementType::LINEHAUL, ProcessType::OUTBOUND>(
+      profile.outbound_processing);
+  transport_center.set_fresh_processing_time(profile.fresh_processing);
+  transport_center.set_mixed_bag_processing_time(profile.mixed_bag_processing);
+  transport_center.set_cutoff(profile.center_arrival_cutoff);
+  return transport_center;
 }
 
-} // namespace
+// The time the cache compares when joining intervals: what the query asks
+// for, not where it starts.
+auto path_cache_result(PathTraversalMode mode, const PathCacheEntry& entry)
+  -> CLOCK
+{
+  return mode == PathTraversalMode::FORWARD ? entry.last_distance
+                                            : entry.first_distance;
+}
 
-SolverWrapper::SolverWrapper(
-  RuntimeQueues queues,
-  const std::shared_ptr<Solver>& solver,
-  const std::filesystem::path& center_timings_filename,
-  std::shared_ptr<PathCache> cache,
-  std::shared_ptr<FacilityProfiles> facility_profiles,
-  HttpGet http_get)
-  : m_solver(solver)
-  , m_facility_profiles(facility_profiles != nullptr
-                          ? std::move(facility_profiles)
-                          : std::make_shared<FacilityProfiles>())
-  , m_load_queue(*queues.load)
-  , m_solution_queue(*queues.solution)
-  , m_http_get(std::move(http_get))
-  , m_path_cache(std::move(cache))
-  , m_cache_config(path_cache_config_from_environment())
+auto path_cache_gap(const PathCacheInterval& lhs, const PathCacheInterval& rhs)
+  -> std::uint64_t
 {
-  if (!m_path_cache && m_cache_config.enabled) {
-    m_path_cache = std::make_shared<PathCache>(m_cache_config.max_entries);
+  if (lhs.valid_until < rhs.valid_from) {
+    return rhs.valid_from.time_since_epoch().count() -
+           lhs.valid_until.time_since_epoch().count();
   }
-  init_timings(center_timings_filename);
+  if (rhs.valid_until < lhs.valid_from) {
+    return lhs.valid_from.time_since_epoch().count() -
+           rhs.valid_until.time_since_epoch().count();
+  }
+  return 0;
 }
 
-SolverWrapper::SolverWrapper(
-  RuntimeQueues queues,
-  InitEndpoints endpoints,
-  const std::filesystem::path& center_timings_filename,
-  HttpGet http_get)
-  : m_node_init_uri(moirai::parse_uri(endpoints.node_uri))
-  , m_node_init_auth_token(std::move(endpoints.node_token))
-  , m_edge_init_uri(moirai::parse_uri(endpoints.edge_uri))
-  , m_edge_init_auth_token(std::move(endpoints.edge_token))
-  , m_facility_profiles(std::make_shared<FacilityProfiles>())
-  , m_node_queue(queues.node)
-  , m_edge_queue(queues.edge)
-  , m_load_queue(*queues.load)
-  , m_solution_queue(*queues.solution)
-  , m_http_get(std::move(http_get))
-{
-  auto& app = moirai::Application::instance();
-  const auto total_started = std::chrono::steady_clock::now();
-  auto phase_started = total_started;
-  const auto finish_phase = [&phase_started]() {
-    const auto now = std::chrono::steady_clock::now();
-    const auto elapsed = milliseconds_since(phase_started, now);
-    phase_started = now;
-    return elapsed;
-  };
+// Snapshot layout, integers little-endian:
+//   header  magic[8] version:u32 blocks:u32 fingerprint:u64
+//   table   blocks x { offset:u64 bytes:u64 entries:u64 }
+//   block   entries x { key:u64 intervals:u32 interval... }
+//   interval valid_from:u32 valid_until:u32 solved_at:u32
+//            anchored_begin:u32 anchored_end:u32 first_distance:u32
+//            last_distance:u32 found:u8 hops:u32 hop...
+//   hop     node:u32 edge:u32 distance:u32
+struct SnapshotBlock {
+  std::uint64_t offset{0};
+  std::uint64_t bytes{0};
+  std::uint64_t entries{0};
+};
 
-  m_cache_config = path_cache_config_from_environment();
-  if (m_cache_config.enabled) {
-    m_path_cache = std::make_shared<PathCache>(m_cache_config.max_entries);
+constexpr std::size_t SNAPSHOT_HEADER_BYTES =
+  PATH_CACHE_SNAPSHOT_MAGIC.size() + (2 * sizeof(std::uint32_t)) +
+  sizeof(std::uint64_t);
+
+template <typename T>
+  requires std::is_integral_v<T>
+void
+snapshot_put(std::string& bytes, T value)
+{
+  if constexpr (std::endian::native == std::endian::big) {
+    value = std::byteswap(value);
   }
+  const auto offset = bytes.size();
+  bytes.resize(offset + sizeof(T));
+  std::memcpy(bytes.data() + offset, &value, sizeof(T));
+}
 
-  m_solver = std::make_shared<Solver>();
-  init_timings(center_timings_filename);
-  const auto timings_ms = finish_phase();
-  init_nodes();
-  const auto nodes_ms = finish_phase();
-  init_custody();
-  const auto custody_ms = finish_phase();
-  init_edges();
-  const auto routes_ms = finish_phase();
-  m_solver->finalize_graph();
-  const auto finalize_ms = finish_phase();
-  const auto stats = m_solver->graph_stats();
-  app.logger().information(
-    "Initialized graph: queue={} nodes={} edges={} csr_out={} csr_in={} "
-    "avg_out_degree={} max_out_degree={}",
-    stats.queue,
-    stats.nodes,
-    stats.edges,
-    stats.outgoing_storage,
-    stats.incoming_storage,
-    stats.average_out_degree,
-    stats.max_out_degree);
-  app.logger().information(
-    "Startup timings: timings_ms={} nodes_ms={} custody_ms={} routes_ms={} "
-    "finalize_ms={} total_ms={} path_cache_enabled={} path_cache_max_entries={} "
-    "path_cache_bucket_minutes={}",
-    timings_ms,
-    nodes_ms,
-    custody_ms,
-    routes_ms,
-    finalize_ms,
-    milliseconds_since(total_started, std::chrono::steady_clock::now()),
-    m_cache_config.enabled,
-    m_cache_config.max_entries,
-    m_cache_config.bucket_minutes);
+void
+snapshot_put(std::string& bytes, CLOCK value)
+{
+  snapshot_put(bytes, value.time_since_epoch().count());
 }
 
 void
-SolverWrapper::init_timings(
-  const std::filesystem::path& facility_timings_filename)
+snapshot_put(std::string& bytes, const SnapshotBlock& block)
 {
-  auto& app = moirai::Application::instance();
-  if (!facility_timings_filename.empty()) {
-    app.logger().debug(
-      "Ignoring legacy facility timings file {}; using facility API profiles",
-      facility_timings_filename.string());
-  }
+  snapshot_put(bytes, block.offset);
+  snapshot_put(bytes, block.bytes);
+  snapshot_put(bytes, block.entries);
 }
 
+template <typename T>
+  requires std::is_integral_v<T>
 auto
-SolverWrapper::get_solver() const -> std::shared_ptr<Solver>
+snapshot_get(std::string_view& bytes, T& value) -> bool
 {
-  return m_solver;
+  if (bytes.size() < sizeof(T)) {
+    return false;
+  }
+  std::memcpy(&value, bytes.data(), sizeof(T));
+  if constexpr (std::endian::native == std::endian::big) {
+    value = std::byteswap(value);
+  }
+  bytes.remove_prefix(sizeof(T));
+  return true;
 }
 
+template <std::size_t N>
 auto
-SolverWrapper::get_cache() const -> std::shared_ptr<PathCache>
+snapshot_get(std::string_view& bytes, std::array<char, N>& value) -> bool
 {
-  return m_path_cache;
+  if (bytes.size() < N) {
+    return false;
+  }
+  std::memcpy(value.data(), bytes.data(), N);
+  bytes.remove_prefix(N);
+  return true;
 }
 
 auto
-SolverWrapper::get_facility_profiles() const -> std::shared_ptr<FacilityProfiles>
+snapshot_get(std::string_view& bytes, SnapshotBlock& block) -> bool
 {
-  return m_facility_profiles;
+  return snapshot_get(bytes, block.offset) &&
+         snapshot_get(bytes, block.bytes) &&
+         snapshot_get(bytes, block.entries);
 }
 
-void
-SolverWrapper::init_nodes(int16_t page)
+auto
+snapshot_get(std::string_view& bytes, CLOCK& value) -> bool
 {
-  auto& app = moirai::Application::instance();
-  const auto request_uri = moirai::with_query_parameters(
-    m_node_init_uri,
-    { { "page", std::to_string(page) }, { "status", "active" } });
-  const auto response = m_http_get(
-    request_uri,
-    { std::format("Authorization: Bearer {}", m_node_init_auth_token) });
-
-  if (response.status_code == HTTP_STATUS_OK) {
-    const auto response_json = moirai::parse_json(response.body);
-    if (!response_json.has_value() || !response_json->is_object()) {
-      app.logger().error("Unable to parse facility response");
-      return;
-    }
-
-    const auto* result = moirai::find_object_member(*response_json, "result");
-    const auto* data =
-      result == nullptr ? nullptr : moirai::find_array_member(*result, "data");
-    const auto pages =
-      result == nullptr
-        ? std::nullopt
-        : moirai::find_integer_member<int16_t>(*result, "total_page_count");
-    if (result == nullptr || data == nullptr || !pages.has_value()) {
-      app.logger().error("Facility response is missing result/data metadata");
-      return;
-    }
-
-    if (page == 1) {
-      m_solver->reserve_nodes(moirai::json_size(*data) * static_cast<std::size_t>(*pages));
-    }
-
-    std::vector<FacilityListEntry> facilities;
-    facilities.reserve(moirai::json_size(*data));
-    for (const auto& facility : *data) {
-      const auto facility_code =
-        moirai::find_string_member(facility, "facility_code");
-      if (!facility_code.has_value()) {
-        app.logger().error("Skipping facility without facility_code");
-        continue;
-      }
-
-      const auto facility_name = moirai::find_string_member(facility, "name");
-      const auto property_id =
-        moirai::find_string_member(facility, "property_id");
-      facilities.push_back(FacilityListEntry{
-        .code = std::string(*facility_code),
-        .name = facility_name.has_value() ? std::string(*facility_name)
-                                          : std::string{},
-        .property_id = property_id.has_value() ? std::string(*property_id)
-                                               : std::string{},
-        .id = facility_identifier(facility),
-        .profile = parse_facility_profile(facility),
-      });
-    }
+  CLOCK::rep count{};
+  if (!snapshot_get(bytes, count)) {
+    return false;
+  }
+  value = CLOCK{ CLOCK::duration{ count } };
+  return true;
+}
 
-    std::vector<FacilityProfile> facility_profiles;
-    facility_profiles.reserve(facilities.size());
-    for (const auto& facility : facilities) {
-      facility_profiles.push_back(facility.profile);
+// Appends one key's record to `bytes`. Returns false, leaving `bytes` as it
+// was, when a path points at something that is not part of `solver`.
+auto
+encode_snapshot_entry(std::string& bytes,
+                      const Solver& solver,
+                      std::uint64_t key,
+                      const PathCacheIntervals& intervals) -> bool
+{
+  const auto start = bytes.size();
+  snapshot_put(bytes, key);
+  snapshot_put(bytes, static_cast<std::uint32_t>(intervals.size()));
+  for (const auto& interval : intervals) {
+    snapshot_put(bytes, interval.valid_from);
+    snapshot_put(bytes, interval.valid_until);
+    snapshot_put(bytes, interval.solved_at);
+    snapshot_put(bytes, interval.anchored_begin);
+    snapshot_put(bytes, interval.anchored_end);
+    snapshot_put(bytes, interval.entry.first_distance);
+    snapshot_put(bytes, interval.entry.last_distance);
+    snapshot_put(bytes, static_cast<std::uint8_t>(interval.entry.found));
+    const auto* path = interval.entry.path.get();
+    snapshot_put(bytes,
+                 static_cast<std::uint32_t>(path != nullptr ? path->hops.size()
+                                                            : 0));
+    if (path == nullptr) {
+      continue;
     }
-
-    const auto fetch_facility_profile =
-      [this, &app, &facilities, &facility_profiles](std::size_t index) -> void {
-      const auto& facility = facilities[index];
-      if (!facility.id.has_value()) {
-        app.logger().debug("No facility id found for {}; using defaults",
-                           facility.code);
-        return;
-      }
-
-      auto facility_profile = facility.profile;
-      try {
-        const auto detail_response = m_http_get(
-          moirai::append_path(m_node_init_uri, *facility.id),
-          { std::format("Authorization: Bearer {}", m_node_init_auth_token) });
-        if (detail_response.status_code == HTTP_STATUS_OK) {
-          const auto detail_json = moirai::parse_json(detail_response.body);
-          if (detail_json.has_value() && detail_json->is_object()) {
-            facility_profile = parse_facility_profile(*detail_json);
-          } else {
-            app.logger().error("Unable to parse facility detail for {}",
-                               facility.code);
-          }
-        } else {
-          app.logger().error("Unable to fetch facility detail for {}: {}",
-                             facility.code,
-                             detail_response.body);
+    for (const auto& hop : path->hops) {
+      const auto node = solver.node_id(hop.node);
+      auto edge = INVALID_EDGE;
+      if (hop.outbound != nullptr) {
+        edge = solver.edge_id(hop.outbound);
+        if (edge == INVALID_EDGE) {
+          edge = SNAPSHOT_CUSTODY_HOP;
         }
-      } catch (const std::exception& exc) {
-        app.logger().error("Unable to fetch facility detail for {}: {}",
-                           facility.code,
-                           exc.what());
-      }
-      facility_profiles[index] = facility_profile;
-    };
-
-    const auto detail_worker_count =
-      parse_facility_detail_threads(facilities.size());
-    if (detail_worker_count == 1) {
-      for (std::size_t index = 0; index < facilities.size(); ++index) {
-        fetch_facility_profile(index);
       }
-    } else if (detail_worker_count > 1) {
-      std::atomic_size_t next_facility{0};
-      std::vector<std::jthread> workers;
-      workers.reserve(detail_worker_count);
-      for (std::size_t worker = 0; worker < detail_worker_count; ++worker) {
-        workers.emplace_back([&]() {
-          while (true) {
-            const auto index =
-              next_facility.fetch_add(1, std::memory_order_relaxed);
-            if (index >= facilities.size()) {
-              return;
-            }
-            fetch_facility_profile(index);
-          }
-        });
+      if (node == INVALID_NODE) {
+        bytes.resize(start);
+        return false;
       }
+      snapshot_put(bytes, node);
+      snapshot_put(bytes, edge);
+      snapshot_put(bytes, hop.distance);
     }
+  }
+  return true;
+}
 
-    for (std::size_t index = 0; index < facilities.size(); ++index) {
-      const auto& facility = facilities[index];
-      const auto facility_profile = facility_profiles[index];
-      (*m_facility_profiles)[facility.code] = facility_profile;
-
-      auto transport_center = TransportCenter{
-        facility.code,
-        facility.name
-      };
-      transport_center
-        .set_latency<MovementType::CARTING, ProcessType::INBOUND>(
-          DURATION{0});
-      transport_center
-        .set_latency<MovementType::CARTING, ProcessType::OUTBOUND>(
-          facility_profile.outbound_processing);
-      transport_center
-        .set_latency<MovementType::LINEHAUL, ProcessType::INBOUND>(
-          DURATION{0});
-      transport_center
-        .set_latency<MovementType::LINEHAUL, ProcessType::OUTBOUND>(
-          facility_profile.outbound_processing);
-      transport_center.set_fresh_processing_time(
-        facility_profile.fresh_processing);
-      transport_center.set_mixed_bag_processing_time(
-        facility_profile.mixed_bag_processing);
-      transport_center.set_cutoff(facility_profile.center_arrival_cutoff);
-      (void)m_solver->add_node(std::move(transport_center));
+auto
+decode_snapshot_interval(std::string_view& bytes,
+                         const Solver& solver,
+                         PathTraversalMode mode)
+  -> std::optional<PathCacheInterval>
+{
+  // The fingerprint matched, so the results hold on the graph as it is now.
+  PathCacheInterval interval;
+  interval.graph_version = solver.graph_version();
+  std::uint8_t found{};
+  std::uint32_t hop_count{};
+  if (!snapshot_get(bytes, interval.valid_from) ||
+      !snapshot_get(bytes, interval.valid_until) ||
+      !snapshot_get(bytes, interval.solved_at) ||
+      !snapshot_get(bytes, interval.anchored_begin) ||
+      !snapshot_get(bytes, interval.anchored_end) ||
+      !snapshot_get(bytes, interval.entry.first_distance) ||
+      !snapshot_get(bytes, interval.entry.last_distance) ||
+      !snapshot_get(bytes, found) || !snapshot_get(bytes, hop_count)) {
+    return std::nullopt;
+  }
+  constexpr auto HOP_BYTES = (2 * sizeof(std::uint32_t)) + sizeof(CLOCK::rep);
+  if (interval.valid_until < interval.valid_from || found > 1 ||
+      (found == 0) != (hop_count == 0) ||
+      interval.anchored_begin > interval.anchored_end ||
+      interval.anchored_end > hop_count ||
+      bytes.size() / HOP_BYTES < hop_count) {
+    return std::nullopt;
+  }
+  interval.entry.found = found != 0;
+  if (hop_count == 0) {
+    return interval;
+  }
 
-      if (!facility.property_id.empty()) {
-        m_facility_groups[facility.property_id].push_back(facility.code);
+  auto path = std::make_shared<CompactPath>();
+  path->mode = mode;
+  path->hops.resize(hop_count);
+  // A custody hop is resolved once the next hop's node is known.
+  auto previous_node = INVALID_NODE;
+  auto previous_edge = INVALID_EDGE;
+  for (std::uint32_t index = 0; index < hop_count; ++index) {
+    auto& hop = path->hops[index];
+    NodeId node{};
+    EdgeId edge{};
+    snapshot_get(bytes, node);
+    snapshot_get(bytes, edge);
+    snapshot_get(bytes, hop.distance);
+    hop.node = solver.node_record(node);
+    if (hop.node == nullptr) {
+      return std::nullopt;
+    }
+    if (previous_edge == SNAPSHOT_CUSTODY_HOP) {
+      path->hops[index - 1].outbound = solver.custody_hop(previous_node, node);
+      if (path->hops[index - 1].outbound == nullptr) {
+        return std::nullopt;
+      }
+    }
+    if (edge != INVALID_EDGE && edge != SNAPSHOT_CUSTODY_HOP) {
+      hop.outbound = solver.edge_record(edge);
+      if (hop.outbound == nullptr) {
+        return std::nullopt;
       }
     }
+    previous_node = node;
+    previous_edge = edge;
+  }
+  if (previous_edge == SNAPSHOT_CUSTODY_HOP) {
+    return std::nullopt;
+  }
+  interval.entry.path = std::move(path);
+  return interval;
+}
 
-    if (page < *pages) {
-      init_nodes(static_cast<int16_t>(page + 1));
+// Inserts every entry of one block. Returns false at the first record that
+// does not decode; entries before it stay inserted.
+auto
+load_snapshot_block(PathCache& cache,
+                    const Solver& solver,
+                    std::string_view bytes,
+                    std::uint64_t entries,
+                    PathCacheSnapshotStats& stats) -> bool
+{
+  for (std::uint64_t entry = 0; entry < entries; ++entry) {
+    std::uint64_t key{};
+    std::uint32_t interval_count{};
+    if (!snapshot_get(bytes, key) || !snapshot_get(bytes, interval_count) ||
+        (key >> 63U) == 0 || interval_count == 0 ||
+        interval_count > PATH_CACHE_MAX_INTERVALS) {
+      return false;
     }
-  } else {
-    app.logger().error("Unable to fetch facility data: {}", response.body);
+    const auto mode = ((key >> 62U) & 1U) != 0 ? PathTraversalMode::REVERSE
+                                               : PathTraversalMode::FORWARD;
+    PathCacheIntervals intervals;
+    intervals.reserve(interval_count);
+    for (std::uint32_t index = 0; index < interval_count; ++index) {
+      auto interval = decode_snapshot_interval(bytes, solver, mode);
+      if (!interval.has_value() ||
+          (!intervals.empty() &&
+           interval->valid_from <= intervals.back().valid_until)) {
+        return false;
+      }
+      intervals.push_back(std::move(*interval));
+    }
+    cache.insert(key, std::move(intervals));
+    ++stats.entries;
+    stats.intervals += interval_count;
   }
+  return bytes.empty();
 }
 
-void
-SolverWrapper::init_custody()
+auto
+snapshot_threads(std::size_t requested, std::size_t blocks) -> std::size_t
 {
-  auto& app = moirai::Application::instance();
+  const auto hardware =
+    std::max<std::size_t>(1, std::thread::hardware_concurrency());
+  return std::clamp<std::size_t>(
+    requested != 0 ? requested : hardware, 1, std::max<std::size_t>(1, blocks));
+}
 
-  for (const auto& [key, value] : m_facility_groups) {
-    (void)key;
+// Runs body(index) for every index in [0, count) on `threads` threads, the
+// calling thread included.
+template <typename Body>
+void
+for_each_snapshot_block(std::size_t count, std::size_t threads, Body&& body)
+{
+  std::atomic<std::size_t> next{ 0 };
+  const auto drain = [&]() {
+    for (auto index = next.fetch_add(1, std::memory_order_relaxed);
+         index < count;
+         index = next.fetch_add(1, std::memory_order_relaxed)) {
+      body(index);
+    }
+  };
+  std::vector<std::jthread> workers;
+  workers.reserve(threads - 1);
+  for (std::size_t worker = 1; worker < threads; ++worker) {
+    workers.emplace_back(drain);
+  }
+  drain();
+}
+
+} // namespace
+
+auto
+PathCacheInterval::at(CLOCK query) const -> PathCacheEntry
+{
+  if (query == solved_at || anchored_begin == anchored_end ||
+      entry.path == nullptr) {
+    return entry;
+  }
+
+  // Unsigned minutes wrap, so adding the shift works in both directions.
+  const auto shift = [&](CLOCK value) {
+    return value - solved_at.time_since_epoch() + query.time_since_epoch();
+  };
+  auto path = std::make_shared<CompactPath>(*entry.path);
+  for (auto index = anchored_begin; index < anchored_end; ++index) {
+    path->hops[index].distance = shift(path->hops[index].distance);
+  }
+  PathCacheEntry moved = entry;
+  if (anchored_begin == 0) {
+    moved.first_distance = shift(moved.first_distance);
+  }
+  if (anchored_end == path->hops.size()) {
+    moved.last_distance = shift(moved.last_distance);
+  }
+  moved.path = std::move(path);
+  return moved;
+}
+
+auto
+make_path_cache_interval(PathTraversalMode mode, const Path& path, CLOCK query)
+  -> PathCacheInterval
+{
+  PathCacheInterval interval;
+  interval.solved_at = query;
+  if (path.empty()) {
+    interval.valid_from = CLOCK::min();
+    interval.valid_until = CLOCK::max();
+    return interval;
+  }
+
+  interval.valid_from = path.valid_from;
+  interval.valid_until = path.valid_until;
+  interval.anchored_begin = static_cast<std::uint32_t>(path.anchored_begin);
+  interval.anchored_end = static_cast<std::uint32_t>(path.anchored_end);
+  interval.entry.found = true;
+  interval.entry.first_distance = path.front().distance;
+  interval.entry.last_distance = path.back().distance;
+  interval.entry.path = mode == PathTraversalMode::FORWARD
+                          ? compact_path<PathTraversalMode::FORWARD>(path)
+                          : compact_path<PathTraversalMode::REVERSE>(path);
+  return interval;
+}
+
+auto
+find_path_interval(const PathCacheIntervals& intervals, CLOCK query)
+  -> const PathCacheInterval*
+{
+  const auto found = std::ranges::upper_bound(
+    intervals, query, std::less<>{}, &PathCacheInterval::valid_from);
+  if (found == intervals.begin()) {
+    return nullptr;
+  }
+  const auto& candidate = *std::prev(found);
+  return candidate.contains(query) ? &candidate : nullptr;
+}
+
+auto
+find_path_interval(const PathCacheIntervals& intervals,
+                   CLOCK query,
+                   std::uint64_t graph_version) -> const PathCacheInterval*
+{
+  const auto* interval = find_path_interval(intervals, query);
+  if (interval != nullptr && !interval->entry.found &&
+      interval->graph_version != graph_version) {
+    return nullptr;
+  }
+  return interval;
+}
+
+auto
+merge_path_interval(const PathCacheIntervals* current,
+                    PathCacheInterval added,
+                    PathTraversalMode mode) -> PathCacheIntervals
+{
+  auto merged = current != nullptr ? *current : PathCacheIntervals{};
+  // Joining grows `added`, which may then reach intervals already passed.
+  for (bool joined = true; joined;) {
+    joined = false;
+    for (auto interval = merged.begin(); interval != merged.end();) {
+      if (path_cache_gap(*interval, added) != 0) {
+        ++interval;
+        continue;
+      }
+      if (interval->entry.found == added.entry.found &&
+          path_cache_result(mode, interval->entry) ==
+            path_cache_result(mode, added.entry)) {
+        const auto lasts_longer =
+          mode == PathTraversalMode::FORWARD
+            ? interval->valid_until > added.valid_until
+            : interval->valid_from < added.valid_from;
+        const auto valid_from =
+          std::min(interval->valid_from, added.valid_from);
+        const auto valid_until =
+          std::max(interval->valid_until, added.valid_until);
+        if (lasts_longer) {
+          added = *interval;
+        }
+        added.valid_from = valid_from;
+        added.valid_until = valid_until;
+        joined = true;
+      }
+      interval = merged.erase(interval);
+    }
+  }
+
+  while (merged.size() >= PATH_CACHE_MAX_INTERVALS) {
+    const auto furthest = std::ranges::max_element(
+      merged, std::less<>{}, [&](const PathCacheInterval& interval) {
+        return path_cache_gap(interval, added);
+      });
+    merged.erase(furthest);
+  }
+  merged.insert(std::ranges::upper_bound(merged,
+                                         added.valid_from,
+                                         std::less<>{},
+                                         &PathCacheInterval::valid_from),
+                std::move(added));
+  return merged;
+}
+
+auto
+earliest_path_suffix(const PathCacheEntry& earliest,
+                     const TransportCenter* node,
+                     CLOCK arrival) -> std::optional<PathCacheEntry>
+{
+  if (!earliest.found || earliest.path == nullptr) {
+    return std::nullopt;
+  }
+  const auto& hops = earliest.path->hops;
+  const auto first = std::ranges::find(hops, node, &CompactPathHop::node);
+  if (first == hops.end() || arrival < first->distance) {
+    return std::nullopt;
+  }
+
+  // Custody hops take no time, so the bag waits at the source of the first
+  // scheduled edge from here. It must be there by the time the solver
+  // assumed: the next hop's arrival less the edge's door-to-door duration.
+  const auto scheduled =
+    std::find_if(first, hops.end(), [](const CompactPathHop& hop) {
+      return hop.outbound != nullptr && !hop.outbound->transient;
+    });
+  auto anchored_end = hops.end();
+  if (scheduled != hops.end()) {
+    const auto latest =
+      std::next(scheduled)->distance -
+      scheduled->outbound->weight<PathTraversalMode::FORWARD>().duration;
+    if (arrival > latest) {
+      return std::nullopt;
+    }
+    anchored_end = std::next(scheduled);
+  }
+  if (first == hops.begin() && arrival == first->distance) {
+    return earliest;
+  }
+
+  auto path = std::make_shared<CompactPath>();
+  path->mode = PathTraversalMode::FORWARD;
+  path->hops.assign(first, hops.end());
+  const auto predicted = first->distance;
+  const auto anchored =
+    static_cast<std::size_t>(std::distance(first, anchored_end));
+  for (std::size_t index = 0; index < anchored; ++index) {
+    auto& distance = path->hops[index].distance;
+    distance = distance - predicted.time_since_epoch() +
+               arrival.time_since_epoch();
+  }
+  PathCacheEntry suffix;
+  suffix.found = true;
+  suffix.first_distance = path->hops.front().distance;
+  suffix.last_distance = path->hops.back().distance;
+  suffix.path = std::move(path);
+  return suffix;
+}
+
+auto
+ultimate_path_suffix(const PathCacheEntry& ultimate,
+                     const TransportCenter* node)
+  -> std::optional<PathCacheEntry>
+{
+  if (!ultimate.found || ultimate.path == nullptr) {
+    return std::nullopt;
+  }
+  const auto& hops = ultimate.path->hops;
+  const auto first = std::ranges::find(hops, node, &CompactPathHop::node);
+  if (first == hops.end()) {
+    return std::nullopt;
+  }
+  if (first == hops.begin()) {
+    return ultimate;
+  }
+
+  auto path = std::make_shared<CompactPath>();
+  path->mode = PathTraversalMode::REVERSE;
+  path->hops.assign(first, hops.end());
+  PathCacheEntry suffix = ultimate;
+  suffix.first_distance = path->hops.front().distance;
+  suffix.path = std::move(path);
+  return suffix;
+}
+
+// Flushes `path` to disk. A directory is synced to make a rename in it
+// durable.
+auto
+sync_to_disk(const std::filesystem::path& path, int flags) -> bool
+{
+  const auto fd = ::open(path.c_str(), flags | O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  const auto synced = ::fsync(fd) == 0;
+  ::close(fd);
+  return synced;
+}
+
+auto
+save_path_cache(const PathCache& cache,
+                const Solver& solver,
+                const std::filesystem::path& path)
+  -> std::expected<PathCacheSnapshotStats, std::string>
+{
+  const auto started = std::chrono::steady_clock::now();
+  const auto shards = cache.shard_count();
+  std::vector<std::string> blocks(shards);
+  std::vector<SnapshotBlock> table(shards);
+  std::vector<std::size_t> intervals_per_shard(shards);
+  for_each_snapshot_block(
+    shards, snapshot_threads(0, shards), [&](std::size_t shard) {
+      cache.for_each_in_shard(
+        shard, [&](std::uint64_t key, const PathCacheIntervals& intervals) {
+          if (encode_snapshot_entry(blocks[shard], solver, key, intervals)) {
+            ++table[shard].entries;
+            intervals_per_shard[shard] += intervals.size();
+          }
+        });
+    });
+
+  PathCacheSnapshotStats stats;
+  std::uint64_t offset =
+    SNAPSHOT_HEADER_BYTES + (shards * sizeof(SnapshotBlock));
+  for (std::size_t shard = 0; shard < shards; ++shard) {
+    table[shard].offset = offset;
+    table[shard].bytes = blocks[shard].size();
+    offset += blocks[shard].size();
+    stats.entries += table[shard].entries;
+    stats.intervals += intervals_per_shard[shard];
+  }
+
+  std::string header;
+  header.append(PATH_CACHE_SNAPSHOT_MAGIC.data(),
+                PATH_CACHE_SNAPSHOT_MAGIC.size());
+  snapshot_put(header, PATH_CACHE_SNAPSHOT_VERSION);
+  snapshot_put(header, static_cast<std::uint32_t>(shards));
+  snapshot_put(header, solver.graph_fingerprint());
+  for (const auto& block : table) {
+    snapshot_put(header, block);
+  }
+
+  auto staging = path;
+  staging += ".tmp";
+  {
+    std::ofstream output(staging, std::ios::binary | std::ios::trunc);
+    output.write(header.data(), static_cast<std::streamsize>(header.size()));
+    for (const auto& block : blocks) {
+      output.write(block.data(), static_cast<std::streamsize>(block.size()));
+    }
+    if (!output.flush()) {
+      return std::unexpected{ std::format("cannot write {}",
+                                          staging.string()) };
+    }
+  }
+  // Without the sync a crash can leave the rename on disk ahead of the
+  // contents, replacing the last good snapshot with an empty file.
+  if (!sync_to_disk(staging, 0)) {
+    return std::unexpected{ std::format("cannot sync {}", staging.string()) };
+  }
+  std::error_code error;
+  std::filesystem::rename(staging, path, error);
+  if (error) {
+    return std::unexpected{ std::format(
+      "cannot rename {} to {}: {}", staging.string(), path.string(),
+      error.message()) };
+  }
+  auto directory = path.parent_path();
+  if (directory.empty()) {
+    directory = ".";
+  }
+  if (!sync_to_disk(directory, O_DIRECTORY)) {
+    return std::unexpected{ std::format("cannot sync {}", directory.string()) };
+  }
+
+  stats.bytes = offset;
+  stats.elapsed_ms =
+    milliseconds_since(started, std::chrono::steady_clock::now());
+  return stats;
+}
+
+auto
+load_path_cache(PathCache& cache,
+                const Solver& solver,
+                const std::filesystem::path& path,
+                std::size_t threads)
+  -> std::expected<PathCacheSnapshotStats, std::string>
+{
+  const auto started = std::chrono::steady_clock::now();
+  std::ifstream input(path, std::ios::binary);
+  if (!input) {
+    return std::unexpected{ std::format("cannot open {}", path.string()) };
+  }
+  std::error_code error;
+  const auto size = std::filesystem::file_size(path, error);
+  if (error) {
+    return std::unexpected{ std::format(
+      "cannot stat {}: {}", path.string(), error.message()) };
+  }
+  std::string contents(size, '\0');
+  if (!input.read(contents.data(), static_cast<std::streamsize>(size))) {
+    return std::unexpected{ std::format("cannot read {}", path.string()) };
+  }
+
+  std::string_view header{ contents };
+  std::array<char, PATH_CACHE_SNAPSHOT_MAGIC.size()> magic{};
+  std::uint32_t version{};
+  std::uint32_t block_count{};
+  std::uint64_t fingerprint{};
+  if (!snapshot_get(header, magic) || magic != PATH_CACHE_SNAPSHOT_MAGIC ||
+      !snapshot_get(header, version) || !snapshot_get(header, block_count) ||
+      !snapshot_get(header, fingerprint)) {
+    return std::unexpected{ std::format("{} is not a path cache snapshot",
+                                        path.string()) };
+  }
+  if (version != PATH_CACHE_SNAPSHOT_VERSION) {
+    return std::unexpected{ std::format(
+      "snapshot version {} does not match {}",
+      version,
+      PATH_CACHE_SNAPSHOT_VERSION) };
+  }
+  if (fingerprint != solver.graph_fingerprint()) {
+    return std::unexpected{ "snapshot was taken on a different graph" };
+  }
+  std::vector<SnapshotBlock> table(block_count);
+  for (auto& block : table) {
+    if (!snapshot_get(header, block) || block.offset > contents.size() ||
+        block.bytes > contents.size() - block.offset) {
+      return std::unexpected{ "snapshot block table is truncated" };
+    }
+  }
+
+  std::vector<PathCacheSnapshotStats> block_stats(table.size());
+  std::atomic<std::size_t> corrupt{ 0 };
+  for_each_snapshot_block(
+    table.size(), snapshot_threads(threads, table.size()),
+    [&](std::size_t index) {
+      const auto& block = table[index];
+      if (!load_snapshot_block(cache,
+                               solver,
+                               std::string_view{ contents }.substr(
+                                 block.offset, block.bytes),
+                               block.entries,
+                               block_stats[index])) {
+        corrupt.fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+
+  PathCacheSnapshotStats stats;
+  for (const auto& block : block_stats) {
+    stats.entries += block.entries;
+    stats.intervals += block.intervals;
+  }
+  stats.bytes = contents.size();
+  stats.corrupt_blocks = corrupt.load(std::memory_order_relaxed);
+  stats.elapsed_ms =
+    milliseconds_since(started, std::chrono::steady_clock::now());
+  return stats;
+}
+
+SolverWrapper::SolverWrapper(
+  RuntimeQueues queues,
+  const std::shared_ptr<Solver>& solver,
+  const std::filesystem::path& center_timings_filename,
+  SharedState shared,
+  HttpGet http_get)
+  : m_solver(solver)
+  , m_facility_profiles(shared.facility_profiles != nullptr
+                          ? std::move(shared.facility_profiles)
+                          : std::make_shared<FacilityProfiles>())
+  , m_load_queue(*queues.load)
+  , m_solution_queue(*queues.solution)
+  , m_load_compactor(queues.compactor)
+  , m_batch_decode(parse_bool_env(LOAD_BATCH_DECODE_ENV, true))
+  , m_http_get(std::move(http_get))
+  , m_path_cache(std::move(shared.path_cache))
+  , m_cache_config(path_cache_config_from_environment())
+  , m_itineraries(std::move(shared.itineraries))
+  , m_missing_facilities(
+      shared.missing_facilities != nullptr
+        ? std::move(shared.missing_facilities)
+        : std::make_shared<MissingFacilitySketch>(MISSING_FACILITY_KEYS))
+{
+  if (!m_path_cache && m_cache_config.enabled) {
+    m_path_cache = std::make_shared<PathCache>(m_cache_config.max_entries);
+  }
+  if (!m_itineraries && m_cache_config.enabled &&
+      m_cache_config.itinerary_entries > 0) {
+    m_itineraries =
+      std::make_shared<BagItineraryCache>(m_cache_config.itinerary_entries);
+  }
+  init_load_fanout(std::move(shared.load_fanout));
+  init_timings(center_timings_filename);
+}
+
+// Route data shared between the streaming fetch branch and the inserter.
+// Chunks are appended in route order as the download is split; each one
+// carries the raw element text until a task expands it and publishes it.
+struct SolverWrapper::StartupRoutes {
+  struct Chunk {
+    std::size_t first_route{0};
+    std::vector<std::string> documents;
+    std::vector<std::expected<std::vector<RouteEdgeSpec>, std::string>>
+      expanded;
+    bool ready{false};
+  };
+
+  std::vector<std::unique_ptr<Chunk>> chunks;
+  std::mutex mutex;
+  std::condition_variable published;
+  bool listed{false};
+  bool finished{false};
+  std::size_t buffered_bytes{0};
+  std::size_t peak_buffered_bytes{0};
+  std::int64_t fetch_ms{0};
+  std::int64_t parse_ms{0};
+  std::int64_t expansion_ms{0};
+  std::chrono::steady_clock::time_point finished_at{};
+
+  auto add(std::unique_ptr<Chunk> chunk) -> Chunk&
+  {
+    std::scoped_lock lock(mutex);
+    for (const auto& document : chunk->documents) {
+      buffered_bytes += document.size();
+    }
+    peak_buffered_bytes = std::max(peak_buffered_bytes, buffered_bytes);
+    chunks.push_back(std::move(chunk));
+    return *chunks.back();
+  }
+
+  // Parses and expands every route document of `chunk`, drops the raw text
+  // and hands the chunk to the inserter.
+  void expand(Chunk& chunk)
+  {
+    std::size_t released = 0;
+    chunk.expanded.reserve(chunk.documents.size());
+    for (std::size_t offset = 0; offset < chunk.documents.size(); ++offset) {
+      const auto index = chunk.first_route + offset;
+      const auto& document = chunk.documents[offset];
+      released += document.size();
+      const auto route = moirai::parse_json(document);
+      if (!route.has_value()) {
+        chunk.expanded.emplace_back(
+          std::unexpected{ std::format("route {}: invalid JSON", index) });
+        continue;
+      }
+      try {
+        chunk.expanded.emplace_back(build_route_edge_specs(*route, IST_OFFSET));
+      } catch (const std::exception& exc) {
+        chunk.expanded.emplace_back(
+          std::unexpected{ std::format("route {}: {}", index, exc.what()) });
+      }
+    }
+    chunk.documents = {};
+
+    {
+      std::scoped_lock lock(mutex);
+      chunk.ready = true;
+      buffered_bytes -= released;
+    }
+    published.notify_all();
+  }
+
+  void finish(bool found_routes)
+  {
+    {
+      std::scoped_lock lock(mutex);
+      if (!finished) {
+        listed = found_routes;
+        finished = true;
+        finished_at = std::chrono::steady_clock::now();
+      }
+    }
+    published.notify_all();
+  }
+
+  // Blocks until chunk `first` is expanded and returns the contiguous run of
+  // expanded chunks starting there. Returns an empty run once the branch
+  // finished without producing it (end of the stream or a failed fetch).
+  auto wait_ready(std::size_t first) -> std::vector<Chunk*>
+  {
+    std::unique_lock lock(mutex);
+    published.wait(lock, [this, first]() {
+      return finished || (first < chunks.size() && chunks[first]->ready);
+    });
+    std::vector<Chunk*> ready;
+    for (auto index = first; index < chunks.size() && chunks[index]->ready;
+         ++index) {
+      ready.push_back(chunks[index].get());
+    }
+    return ready;
+  }
+};
+
+SolverWrapper::SolverWrapper(
+  RuntimeQueues queues,
+  InitEndpoints endpoints,
+  const std::filesystem::path& center_timings_filename,
+  HttpGet http_get,
+  HttpStream http_stream)
+  : m_node_init_uri(moirai::parse_uri(endpoints.node_uri))
+  , m_node_init_auth_token(std::move(endpoints.node_token))
+  , m_edge_init_uri(moirai::parse_uri(endpoints.edge_uri))
+  , m_edge_init_auth_token(std::move(endpoints.edge_token))
+  , m_facility_profiles(std::make_shared<FacilityProfiles>())
+  , m_node_queue(queues.node)
+  , m_edge_queue(queues.edge)
+  , m_load_queue(*queues.load)
+  , m_solution_queue(*queues.solution)
+  , m_load_compactor(queues.compactor)
+  , m_batch_decode(parse_bool_env(LOAD_BATCH_DECODE_ENV, true))
+  , m_http_get(http_get ? http_get : HttpGet{ moirai::http_get })
+  , m_http_stream(resolve_http_stream(http_get, std::move(http_stream)))
+  , m_http_pool(http_get ? nullptr : &moirai::shared_http_pool())
+{
+  auto& app = moirai::Application::instance();
+  const auto total_started = std::chrono::steady_clock::now();
+  auto phase_started = total_started;
+  const auto finish_phase = [&phase_started]() {
+    const auto now = std::chrono::steady_clock::now();
+    const auto elapsed = milliseconds_since(phase_started, now);
+    phase_started = now;
+    return elapsed;
+  };
+
+  m_cache_config = path_cache_config_from_environment();
+  if (m_cache_config.enabled) {
+    m_path_cache = std::make_shared<PathCache>(m_cache_config.max_entries);
+    if (m_cache_config.itinerary_entries > 0) {
+      m_itineraries =
+        std::make_shared<BagItineraryCache>(m_cache_config.itinerary_entries);
+    }
+  }
+  init_load_fanout();
+
+  const auto http_started = m_http_pool != nullptr ? m_http_pool->stats()
+                                                   : moirai::HttpPoolStats{};
+  m_solver = std::make_shared<Solver>();
+  init_timings(center_timings_filename);
+  const auto timings_ms = finish_phase();
+
+  // The route branch (fetch, parse, expand) runs on the executor while this
+  // thread loads facilities and custody edges. Route edges are then inserted
+  // in route order as their expansion lands, after the custody edges, so
+  // node and edge ids match a serial build.
+  WorkStealingExecutor executor(parse_startup_threads());
+  StartupRoutes routes;
+  WorkStealingExecutor::TaskGroup route_branch(executor);
+  route_branch.run([this, &executor, &routes]() {
+    try {
+      fetch_routes(executor, routes);
+    } catch (...) {
+      routes.finish(false);
+      throw;
+    }
+  });
+
+  load_facilities(executor, 1);
+  const auto nodes_ms = finish_phase();
+  init_custody();
+  const auto custody_ms = finish_phase();
+  const auto custody_finished = phase_started;
+  insert_routes(routes);
+  route_branch.wait();
+  const auto routes_ms = finish_phase();
+  m_solver->finalize_graph();
+  const auto finalize_ms = finish_phase();
+  const auto stats = m_solver->graph_stats();
+  app.logger().information(
+    "Initialized graph: queue={} nodes={} edges={} csr_out={} csr_in={} "
+    "avg_out_degree={} max_out_degree={} colocation_hubs={} custody_edges={} "
+    "custody_edges_saved={}",
+    stats.queue,
+    stats.nodes,
+    stats.edges,
+    stats.outgoing_storage,
+    stats.incoming_storage,
+    stats.average_out_degree,
+    stats.max_out_degree,
+    stats.colocation_hubs,
+    stats.custody_edges,
+    stats.custody_edges_saved);
+  app.logger().information(
+    "Startup timings: timings_ms={} nodes_ms={} custody_ms={} routes_ms={} "
+    "finalize_ms={} total_ms={} route_fetch_ms={} route_parse_ms={} "
+    "route_expansion_ms={} critical_path={} startup_threads={} "
+    "startup_steals={} path_cache_enabled={} path_cache_max_entries={} "
+    "path_cache_inflight_timeout_ms={}",
+    timings_ms,
+    nodes_ms,
+    custody_ms,
+    routes_ms,
+    finalize_ms,
+    milliseconds_since(total_started, std::chrono::steady_clock::now()),
+    routes.fetch_ms,
+    routes.parse_ms,
+    routes.expansion_ms,
+    routes.finished_at > custody_finished ? "routes" : "facilities",
+    executor.worker_count(),
+    executor.steals(),
+    m_cache_config.enabled,
+    m_cache_config.max_entries,
+    m_cache_config.inflight_timeout.count());
+  if (m_path_cache && !m_cache_config.snapshot_path.empty()) {
+    const auto loaded =
+      load_path_cache(*m_path_cache, *m_solver, m_cache_config.snapshot_path);
+    if (loaded.has_value()) {
+      app.logger().information(
+        "Path cache snapshot loaded: path={} entries={} intervals={} bytes={} "
+        "corrupt_blocks={} elapsed_ms={}",
+        m_cache_config.snapshot_path.string(),
+        loaded->entries,
+        loaded->intervals,
+        loaded->bytes,
+        loaded->corrupt_blocks,
+        loaded->elapsed_ms);
+    } else {
+      app.logger().information("Path cache snapshot not loaded: {}",
+                               loaded.error());
+    }
+  }
+  if (m_http_pool != nullptr) {
+    const auto http_finished = m_http_pool->stats();
+    const auto requests = http_finished.requests - http_started.requests;
+    const auto new_connections =
+      http_finished.new_connections - http_started.new_connections;
+    app.logger().information(
+      "Startup HTTP: requests={} new_connections={} reused_connections={}",
+      requests,
+      new_connections,
+      requests - std::min(requests, new_connections));
+  }
+}
+
+void
+SolverWrapper::init_load_fanout(std::shared_ptr<WorkStealingExecutor> shared)
+{
+  m_fanout_min_children = parse_size_env(
+    LOAD_FANOUT_MIN_CHILDREN_ENV, LOAD_FANOUT_DEFAULT_MIN_CHILDREN, true);
+  if (m_fanout_min_children == 0) {
+    return;
+  }
+  if (shared != nullptr) {
+    m_load_fanout = std::move(shared);
+    return;
+  }
+  m_load_fanout = std::make_shared<WorkStealingExecutor>(parse_size_env(
+    LOAD_FANOUT_THREADS_ENV,
+    std::max<std::size_t>(std::thread::hardware_concurrency(), 1)));
+}
+
+void
+SolverWrapper::init_timings(
+  const std::filesystem::path& facility_timings_filename)
+{
+  auto& app = moirai::Application::instance();
+  if (!facility_timings_filename.empty()) {
+    app.logger().debug(
+      "Ignoring legacy facility timings file {}; using facility API profiles",
+      facility_timings_filename.string());
+  }
+}
+
+auto
+SolverWrapper::get_solver() const -> std::shared_ptr<Solver>
+{
+  return m_solver;
+}
+
+auto
+SolverWrapper::get_cache() const -> std::shared_ptr<PathCache>
+{
+  return m_path_cache;
+}
+
+auto
+SolverWrapper::get_itineraries() const -> std::shared_ptr<BagItineraryCache>
+{
+  return m_itineraries;
+}
+
+auto
+SolverWrapper::get_facility_profiles() const -> std::shared_ptr<FacilityProfiles>
+{
+  return m_facility_profiles;
+}
+
+auto
+SolverWrapper::get_load_fanout() const -> std::shared_ptr<WorkStealingExecutor>
+{
+  return m_load_fanout;
+}
+
+auto
+SolverWrapper::get_missing_facility_sketch() const
+  -> std::shared_ptr<MissingFacilitySketch>
+{
+  return m_missing_facilities;
+}
+
+auto
+SolverWrapper::shared_state() const -> SharedState
+{
+  return SharedState{ .path_cache = m_path_cache,
+                      .facility_profiles = m_facility_profiles,
+                      .itineraries = m_itineraries,
+                      .missing_facilities = m_missing_facilities,
+                      .load_fanout = m_load_fanout };
+}
+
+auto
+SolverWrapper::missing_facilities(std::size_t count) const
+  -> std::vector<MissingFacility>
+{
+  std::vector<MissingFacility> missing;
+  for (auto& item : m_missing_facilities->top(MISSING_FACILITY_KEYS)) {
+    if (missing.size() == count) {
+      break;
+    }
+    if (!m_solver->find_node(item.payload).has_value()) {
+      missing.push_back(
+        MissingFacility{ .code = std::move(item.payload), .loads = item.count });
+    }
+  }
+  return missing;
+}
+
+void
+SolverWrapper::init_nodes(int16_t page)
+{
+  WorkStealingExecutor executor(parse_startup_threads());
+  load_facilities(executor, page);
+}
+
+void
+SolverWrapper::load_facilities(WorkStealingExecutor& executor,
+                               std::int16_t first_page)
+{
+  auto first = fetch_facility_page(
+    m_http_get, m_node_init_uri, m_node_init_auth_token, first_page);
+  if (!first.has_value()) {
+    return;
+  }
+
+  if (first_page == 1) {
+    m_solver->reserve_nodes(first->listed *
+                            static_cast<std::size_t>(first->total_pages));
+  }
+
+  // Remaining pages and every facility detail fetch run concurrently; nodes
+  // are committed afterwards in page order so node ids stay deterministic.
+  const auto page_count =
+    first->total_pages > first_page
+      ? static_cast<std::size_t>(first->total_pages - first_page) + 1U
+      : std::size_t{1};
+  std::vector<std::optional<FacilityPage>> pages(page_count);
+  pages.front() = std::move(first);
+  parallel_for(executor, page_count, page_count, [&](std::size_t offset) {
+    if (offset > 0) {
+      pages[offset] = fetch_facility_page(
+        m_http_get,
+        m_node_init_uri,
+        m_node_init_auth_token,
+        static_cast<std::int16_t>(first_page + static_cast<int>(offset)));
+    }
+    if (pages[offset].has_value()) {
+      fetch_facility_details(executor,
+                             m_http_get,
+                             m_http_pool,
+                             m_node_init_uri,
+                             m_node_init_auth_token,
+                             *pages[offset]);
+    }
+  });
 
-    for (size_t i = 0; i < value.size(); ++i) {
-      for (size_t j = 0; j < value.size(); ++j) {
-        if (i == j) {
-          continue;
-        }
+  for (const auto& page : pages) {
+    if (!page.has_value()) {
+      continue;
+    }
+    for (const auto& facility : page->facilities) {
+      (*m_facility_profiles)[facility.code] = facility.profile;
+      (void)m_solver->add_node(make_transport_center(facility));
+      if (!facility.property_id.empty()) {
+        m_facility_groups[facility.property_id].push_back(facility.code);
+      }
+    }
+  }
+}
 
-        const auto vertex_primary = m_solver->find_node(value[i]);
-        const auto vertex_secondary = m_solver->find_node(value[j]);
-
-        if (vertex_primary.has_value() and vertex_secondary.has_value()) {
-          const std::string name =
-            std::format("CUSTODY-{}-{}", value[i], value[j]);
-          const auto edge_id = m_solver->add_edge(
-              *vertex_primary, *vertex_secondary,
-              TransportEdge{name, name});
-          if (edge_id != INVALID_EDGE) {
-            app.logger().debug("Added custody edge: {}", name);
-          }
-        } else {
-          app.logger().error("Colocated facilities {}:{} or {}:{} missing",
-                             value[i],
-                             vertex_primary.has_value(),
-                             value[j],
-                             vertex_secondary.has_value());
-        }
+void
+SolverWrapper::init_custody()
+{
+  auto& app = moirai::Application::instance();
+
+  for (const auto& [key, value] : m_facility_groups) {
+    std::vector<NodeId> members;
+    members.reserve(value.size());
+    for (const auto& facility : value) {
+      if (const auto vertex = m_solver->find_node(facility);
+          vertex.has_value()) {
+        members.push_back(*vertex);
+      } else {
+        app.logger().error(
+          "Colocated facility {} of {} missing", facility, key);
       }
     }
+
+    const auto edges = m_solver->add_colocation_group(key, members);
+    app.logger().debug(
+      "Added {} custody edges for {} colocated facilities of {}",
+      edges,
+      members.size(),
+      key);
   }
 }
 
-// NOLINTNEXTLINE(readability-function-cognitive-complexity)
 void
 SolverWrapper::init_edges()
+{
+  WorkStealingExecutor executor(parse_startup_threads());
+  StartupRoutes routes;
+  fetch_routes(executor, routes);
+  insert_routes(routes);
+}
+
+void
+SolverWrapper::fetch_routes(WorkStealingExecutor& executor,
+                            StartupRoutes& routes)
 {
   auto& app = moirai::Application::instance();
-  const auto response = m_http_get(
-    m_edge_init_uri,
-    { std::format("Authorization: Bearer {}", m_edge_init_auth_token) });
-
-  if (response.status_code == HTTP_STATUS_OK) {
-    const auto response_json = moirai::parse_json(response.body);
-    if (!response_json.has_value() || !response_json->is_object()) {
-      app.logger().error("Unable to parse route response");
+  const auto fetch_started = std::chrono::steady_clock::now();
+  const auto expansion_threads = parse_route_expansion_threads();
+  // Enough chunks in flight to keep every expansion worker busy; beyond that
+  // the transfer stalls, which bounds the raw JSON held in memory.
+  const auto max_in_flight = expansion_threads * 2;
+
+  std::atomic<std::size_t> in_flight{0};
+  std::chrono::steady_clock::duration dispatch_time{};
+  std::unique_ptr<StartupRoutes::Chunk> pending;
+  std::size_t next_route = 0;
+  WorkStealingExecutor::TaskGroup expansion(executor);
+
+  const auto dispatch = [&]() {
+    if (pending == nullptr) {
       return;
     }
-    const auto* data = moirai::find_array_member(*response_json, "data");
-    if (data == nullptr) {
-      app.logger().error("Route response is missing data array");
-      return;
+    const auto dispatch_started = std::chrono::steady_clock::now();
+    auto& chunk = routes.add(std::move(pending));
+    if (expansion_threads == 1) {
+      routes.expand(chunk);
+    } else {
+      while (in_flight.load(std::memory_order_acquire) >= max_in_flight) {
+        if (!executor.try_run_one()) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+      }
+      in_flight.fetch_add(1, std::memory_order_acq_rel);
+      expansion.run([&routes, &chunk, &in_flight]() {
+        routes.expand(chunk);
+        in_flight.fetch_sub(1, std::memory_order_acq_rel);
+      });
     }
+    dispatch_time += std::chrono::steady_clock::now() - dispatch_started;
+  };
 
-    app.logger().debug("Got {} routes", moirai::json_size(*data));
-    const auto expansion_started = std::chrono::steady_clock::now();
-    auto expanded_routes = expand_route_specs(*data);
-    const auto expansion_ms =
-      milliseconds_since(expansion_started, std::chrono::steady_clock::now());
-    const auto route_edge_count = std::accumulate(
-      expanded_routes.begin(),
-      expanded_routes.end(),
-      std::size_t{0},
-      [](std::size_t total, const auto& route_specs) {
-        return total + (route_specs.has_value() ? route_specs->size() : 0U);
-      });
-    m_solver->reserve_edges(route_edge_count);
-
-    std::unordered_map<std::string,
-                       std::optional<NodeId>,
-                       TransparentStringHash,
-                       TransparentStringEqual>
-      node_cache;
-    node_cache.reserve(route_edge_count == 0 ? 0 : route_edge_count / 2U);
-    const auto resolve_node =
-      [this, &node_cache](std::string_view center_code) -> std::optional<NodeId> {
-      if (const auto cached = node_cache.find(center_code);
-          cached != node_cache.end()) {
-        return cached->second;
+  moirai::JsonArrayStreamSplitter splitter(
+    "data", [&](std::string_view element) {
+      if (pending == nullptr) {
+        pending = std::make_unique<StartupRoutes::Chunk>();
+        pending->first_route = next_route;
+        pending->documents.reserve(ROUTE_PUBLISH_CHUNK);
       }
-      auto node = m_solver->find_node(center_code);
-      node_cache.emplace(std::string(center_code), node);
-      return node;
-    };
-
-    const auto insertion_started = std::chrono::steady_clock::now();
-    std::size_t inserted_edges = 0;
-    for (auto& route_specs : expanded_routes) {
-      if (!route_specs.has_value()) {
-        app.logger().error("Skipping route: {}", route_specs.error());
-        continue;
+      pending->documents.emplace_back(element);
+      ++next_route;
+      if (pending->documents.size() == ROUTE_PUBLISH_CHUNK) {
+        dispatch();
       }
+    });
+  std::chrono::steady_clock::duration sink_time{};
+  const moirai::HttpBodySink sink = [&](std::string_view bytes) {
+    const auto sink_started = std::chrono::steady_clock::now();
+    const auto accepted = splitter.feed(bytes);
+    sink_time += std::chrono::steady_clock::now() - sink_started;
+    return accepted;
+  };
 
-      for (auto& spec : *route_specs) {
-        const auto source_vertex = resolve_node(spec.source_center_code);
-        const auto target_vertex = resolve_node(spec.target_center_code);
-        if (source_vertex.has_value() && target_vertex.has_value()) {
-          (void)m_solver->add_edge(*source_vertex,
-                                   *target_vertex,
-                                   std::move(spec.edge));
-          ++inserted_edges;
-        } else {
-          app.logger().error(
-            "Edge<{}>: Source<{}>:{} or Target<{}>:{} vertex missing",
-            spec.edge.code,
-            spec.source_center_code,
-            source_vertex.has_value(),
-            spec.target_center_code,
-            target_vertex.has_value());
+  std::optional<moirai::HttpResponse> response;
+  try {
+    response = m_http_stream(
+      m_edge_init_uri, auth_header(m_edge_init_auth_token), sink);
+  } catch (...) {
+    // A malformed body aborts the transfer from the sink; that is reported
+    // below like any other parse failure.
+    if (!splitter.failed()) {
+      throw;
+    }
+  }
+  routes.fetch_ms =
+    milliseconds_since(fetch_started, std::chrono::steady_clock::now());
+  routes.parse_ms =
+    std::chrono::duration_cast<std::chrono::milliseconds>(sink_time -
+                                                          dispatch_time)
+      .count();
+
+  if (response.has_value() && response->status_code != HTTP_STATUS_OK) {
+    app.logger().error("Unable to fetch route data: {}", response->body);
+  } else if (splitter.failed() || !splitter.complete()) {
+    app.logger().error("Unable to parse route response");
+  } else if (!splitter.found_member()) {
+    app.logger().error("Route response is missing data array");
+  } else {
+    app.logger().debug("Got {} routes", splitter.elements());
+  }
+
+  // Routes split before a truncated or malformed tail are still inserted.
+  dispatch();
+  expansion.wait();
+  routes.expansion_ms =
+    milliseconds_since(fetch_started, std::chrono::steady_clock::now());
+  routes.finish(splitter.found_member());
+}
+
+void
+SolverWrapper::insert_routes(StartupRoutes& routes)
+{
+  auto& app = moirai::Application::instance();
+  const auto insertion_started = std::chrono::steady_clock::now();
+  std::int64_t wait_ms = 0;
+  std::size_t route_count = 0;
+  std::size_t expanded_edges = 0;
+  std::size_t inserted_edges = 0;
+  std::size_t first = 0;
+  std::vector<RouteEdgeSpec> batch;
+  while (true) {
+    const auto wait_started = std::chrono::steady_clock::now();
+    const auto ready = routes.wait_ready(first);
+    wait_ms +=
+      milliseconds_since(wait_started, std::chrono::steady_clock::now());
+    if (ready.empty()) {
+      break;
+    }
+    first += ready.size();
+
+    // Everything expanded so far goes in as one bulk insert, in route order,
+    // so batches grow when insertion falls behind expansion.
+    batch.clear();
+    for (auto* chunk : ready) {
+      route_count += chunk->expanded.size();
+      for (auto& route_specs : chunk->expanded) {
+        if (!route_specs.has_value()) {
+          app.logger().error("Skipping route: {}", route_specs.error());
+          continue;
         }
+        std::ranges::move(*route_specs, std::back_inserter(batch));
       }
+      chunk->expanded = {};
+    }
+
+    expanded_edges += batch.size();
+    const auto edge_ids = m_solver->add_edges_bulk(batch);
+    for (std::size_t index = 0; index < batch.size(); ++index) {
+      if (edge_ids[index] != INVALID_EDGE) {
+        ++inserted_edges;
+        continue;
+      }
+      const auto& spec = batch[index];
+      app.logger().error(
+        "Edge<{}>: Source<{}>:{} or Target<{}>:{} vertex missing",
+        spec.edge.code,
+        spec.source_center_code,
+        m_solver->find_node(spec.source_center_code).has_value(),
+        spec.target_center_code,
+        m_solver->find_node(spec.target_center_code).has_value());
     }
-    app.logger().information(
-      "Route timings: routes={} expanded_edges={} inserted_edges={} "
-      "expansion_ms={} insertion_ms={}",
-      moirai::json_size(*data),
-      route_edge_count,
-      inserted_edges,
-      expansion_ms,
-      milliseconds_since(insertion_started, std::chrono::steady_clock::now()));
-  } else {
-    app.logger().error("Unable to fetch route data: {}", response.body);
   }
+
+  if (!routes.listed) {
+    return;
+  }
+  app.logger().information(
+    "Route timings: routes={} expanded_edges={} inserted_edges={} "
+    "expansion_ms={} insertion_ms={} insertion_wait_ms={} "
+    "peak_buffered_bytes={}",
+    route_count,
+    expanded_edges,
+    inserted_edges,
+    routes.expansion_ms,
+    milliseconds_since(insertion_started, std::chrono::steady_clock::now()),
+    wait_ms,
+    routes.peak_buffered_bytes);
 }
 
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
@@ -800,6 +1854,7 @@ SolverWrapper::find_paths(
   std::vector<PackageInfo>& packages) const
   -> SearchDocument
 {
+  const StageTimer stage(PipelineStage::find_paths);
   auto& app = moirai::Application::instance();
   const CLOCK zero = CLOCK{ std::chrono::minutes{ 0 } };
   const CLOCK start =
@@ -822,13 +1877,14 @@ SolverWrapper::find_paths(
   response.package_id = bag;
 
   if (!source.has_value() || !target.has_value()) {
-    app.logger().debug(
-      "{}: Pathing failed. Source <{}>: {} or Target <{}>: {} missing",
-      bag,
-      bag_source,
-      source.has_value(),
-      bag_target,
-      target.has_value());
+    if (!source.has_value()) {
+      m_missing_facilities->record(std::hash<std::string_view>{}(bag_source),
+                                   bag_source);
+    }
+    if (!target.has_value()) {
+      m_missing_facilities->record(std::hash<std::string_view>{}(bag_target),
+                                   bag_target);
+    }
     response.fail = std::format(
       "{}: Pathing failed. Source <{}>: {} or Target <{}>: {} missing",
       bag,
@@ -836,57 +1892,105 @@ SolverWrapper::find_paths(
       source.has_value(),
       bag_target,
       target.has_value());
+    app.logger().debug(response.fail);
     response.is_critical = true;
     return response;
   }
 
-  const auto cache_bucket = [this](CLOCK timestamp) -> std::uint32_t {
-    return m_cache_config.bucket_minutes == 0
-             ? timestamp.time_since_epoch().count()
-             : timestamp.time_since_epoch().count() /
-                 m_cache_config.bucket_minutes;
-  };
-  const auto cache_key = [&](std::string_view mode,
+  const auto cache_key = [&](PathTraversalMode mode,
                              NodeId source_node,
-                             NodeId target_node,
-                             CLOCK timestamp) -> std::string {
-    return std::format("{}:{}:{}:{}",
-                       mode,
-                       source_node,
-                       target_node,
-                       cache_bucket(timestamp));
-  };
-  const auto cache_lookup = [this](std::string_view key)
-      -> std::shared_ptr<const PathCache::Entry> {
+                             NodeId target_node) -> std::optional<std::uint64_t> {
     if (!m_path_cache) {
-      return nullptr;
+      return std::nullopt;
     }
-    return m_path_cache->find(key);
+    return make_path_cache_key(
+      mode, VehicleType::SURFACE, source_node, target_node);
   };
-  const auto cache_store = [this](std::string_view key,
-                                   PathCacheEntry entry) -> PathCacheEntry {
-    if (m_path_cache) {
-      PathCacheEntry copy = entry;
-      m_path_cache->insert(std::string(key), std::move(copy));
+  // Cached "unreachable" results from an older graph are misses.
+  const auto graph_version = m_solver->graph_version();
+  const auto cache_lookup =
+    [this, graph_version](std::optional<std::uint64_t> key,
+                          CLOCK query) -> std::optional<PathCacheEntry> {
+    std::optional<PathCacheEntry> cached;
+    if (key.has_value()) {
+      m_path_cache->hot_keys.record(*key, query);
+      std::optional<CLOCK> prefetched;
+      m_path_cache->visit(*key, [&](const PathCacheIntervals& intervals) {
+        const auto* interval =
+          find_path_interval(intervals, query, graph_version);
+        if (interval != nullptr) {
+          cached = interval->at(query);
+          if (interval->prefetched) {
+            prefetched = interval->valid_from;
+          }
+        }
+        return interval != nullptr;
+      });
+      if (prefetched.has_value()) {
+        claim_prefetch_hit(*key, *prefetched);
+      }
+      if (cached.has_value() && !cached->found) {
+        m_path_cache->unreachable_hits.fetch_add(1, std::memory_order_relaxed);
+      }
     }
-    return entry;
+    return cached;
+  };
+  const auto solve = [this, graph_version](PathTraversalMode mode,
+                                           std::optional<std::uint64_t> key,
+                                           NodeId source_node,
+                                           NodeId target_node,
+                                           CLOCK query) -> PathCacheEntry {
+    // Held until the result is in the cache, so followers find it there.
+    SingleFlight::Ticket flight;
+    if (key.has_value() && m_cache_config.inflight_timeout.count() > 0) {
+      flight =
+        m_path_cache->inflight.join(*key, m_cache_config.inflight_timeout);
+      // Whether this thread waited on a flight or leads a new one, a solve
+      // for the pair may have landed since the miss was counted.
+      std::optional<PathCacheEntry> landed;
+      m_path_cache->peek(*key, [&](const PathCacheIntervals& intervals) {
+        const auto* interval =
+          find_path_interval(intervals, query, graph_version);
+        if (interval != nullptr) {
+          landed = interval->at(query);
+        }
+        return interval != nullptr;
+      });
+      if (landed.has_value()) {
+        return *std::move(landed);
+      }
+    }
+    return solve_path(mode, key, source_node, target_node, query).entry;
   };
+  // A re-scan where the bag's previous earliest path said it would be, in
+  // time for that path's next departure, continues on the path's suffix.
+  const auto* scanned_at = m_solver->node_record(*source);
+  std::shared_ptr<const BagItineraryCache::Entry> itinerary;
+  std::optional<PathCacheEntry> continued;
+  if (m_itineraries) {
+    itinerary = m_itineraries->find(bag);
+    if (itinerary == nullptr) {
+      m_itineraries->misses.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      if (itinerary->value.target == *target) {
+        continued = earliest_path_suffix(
+          itinerary->value.earliest, scanned_at, start);
+      }
+      auto& counter = continued.has_value() ? m_itineraries->hits
+                                            : m_itineraries->deviations;
+      counter.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
   const auto forward_path = [&]() -> PathCacheEntry {
-    const auto key = cache_key("F:S", *source, *target, start);
-    if (auto cached = cache_lookup(key)) {
-      return cached->value;
-    }
-    const auto path =
-      m_solver->find_path<PathTraversalMode::FORWARD, VehicleType::SURFACE>(
-        *source, *target, start);
-    PathCacheEntry entry;
-    entry.found = !path.empty();
-    if (entry.found) {
-      entry.first_distance = path.front().distance;
-      entry.last_distance = path.back().distance;
-      parse_path_into<PathTraversalMode::FORWARD>(path, entry.locations);
-    }
-    return cache_store(key, std::move(entry));
+    if (continued.has_value()) {
+      return *std::move(continued);
+    }
+    const auto key = cache_key(PathTraversalMode::FORWARD, *source, *target);
+    if (auto cached = cache_lookup(key, start)) {
+      return *std::move(cached);
+    }
+    return solve(PathTraversalMode::FORWARD, key, *source, *target, start);
   }();
 
   bool critical = false;
@@ -900,47 +2004,153 @@ SolverWrapper::find_paths(
     if (bag_pdd < bag_earliest_pdd) {
       critical = true;
     } else if (!packages.empty()) {
-      CLOCK required_parent_deadline = CLOCK::max();
+      // Children with the same destination and deadline need one deadline
+      // computation; their package ids only matter for the response.
+      auto& children = wrapper_scratch.children;
+      children.clear();
+      children.reserve(packages.size());
       for (const auto& package : packages) {
-        const auto child_pdd =
-          zero + std::chrono::minutes(std::get<1>(package));
-        const auto child_target = m_solver->find_node(std::get<0>(package));
-        if (!child_target.has_value()) {
-          continue;
+        children.emplace_back(std::get<0>(package), std::get<1>(package));
+      }
+      // Latest deadline first per destination: a reverse solve stays valid
+      // for earlier deadlines down to its slack, so the rest of the
+      // destination's children usually hit the cache.
+      std::ranges::sort(
+        children, [](const ChildDeadline& lhs, const ChildDeadline& rhs) {
+          return lhs.first != rhs.first ? lhs.first < rhs.first
+                                        : lhs.second > rhs.second;
+        });
+      children.erase(std::ranges::unique(children).begin(), children.end());
+
+      // The latest arrival at the parent target that still gets every child
+      // in `part` to its destination by its deadline. Resolves child targets
+      // and probes the cache for the whole part in one batch; only the
+      // misses are solved.
+      const auto required_deadline =
+        [&](std::span<const ChildDeadline> part) -> CLOCK {
+        std::vector<std::optional<NodeId>> child_targets;
+        std::vector<std::optional<std::uint64_t>> child_keys;
+        std::vector<std::uint64_t> batch_keys;
+        std::vector<CLOCK> batch_deadlines;
+        child_targets.reserve(part.size());
+        child_keys.reserve(part.size());
+        batch_keys.reserve(part.size());
+        batch_deadlines.reserve(part.size());
+        for (const auto& [child_code, child_minutes] : part) {
+          const auto& child_target =
+            child_targets.emplace_back(m_solver->find_node(child_code));
+          const auto& child_key = child_keys.emplace_back(
+            child_target.has_value() && child_target != target
+              ? cache_key(PathTraversalMode::REVERSE, *child_target, *target)
+              : std::nullopt);
+          if (child_key.has_value()) {
+            batch_keys.push_back(*child_key);
+            batch_deadlines.push_back(zero +
+                                      std::chrono::minutes(child_minutes));
+          }
+        }
+        std::vector<std::optional<PathCacheEntry>> batch_hits(
+          batch_keys.size());
+        std::vector<std::pair<std::uint64_t, CLOCK>> batch_prefetched;
+        if (!batch_keys.empty()) {
+          for (std::size_t index = 0; index < batch_keys.size(); ++index) {
+            m_path_cache->hot_keys.record(batch_keys[index],
+                                          batch_deadlines[index]);
+          }
+          m_path_cache->visit_many(
+            batch_keys,
+            [&](std::size_t index, const PathCacheIntervals& intervals) {
+              const auto* interval = find_path_interval(
+                intervals, batch_deadlines[index], graph_version);
+              if (interval != nullptr) {
+                batch_hits[index] = interval->at(batch_deadlines[index]);
+                if (interval->prefetched) {
+                  batch_prefetched.emplace_back(batch_keys[index],
+                                                interval->valid_from);
+                }
+              }
+              return interval != nullptr;
+            });
+        }
+        for (const auto& [prefetched_key, valid_from] : batch_prefetched) {
+          claim_prefetch_hit(prefetched_key, valid_from);
+        }
+        for (const auto& hit : batch_hits) {
+          if (hit.has_value() && !hit->found) {
+            m_path_cache->unreachable_hits.fetch_add(
+              1, std::memory_order_relaxed);
+          }
         }
 
-        CLOCK child_pdd_at_parent_target = child_pdd;
-        if (child_target != target) {
-          const auto child_key =
-            cache_key("R:S", *child_target, *target, child_pdd);
-          const auto child_critical_path = [&]() -> PathCacheEntry {
-            if (auto cached = cache_lookup(child_key)) {
-              return cached->value;
-            }
-            const auto path =
-              m_solver
-                ->find_path<PathTraversalMode::REVERSE, VehicleType::SURFACE>(
-                  *child_target, *target, child_pdd);
-            PathCacheEntry entry;
-            entry.found = !path.empty();
-            if (entry.found) {
-              entry.first_distance = path.front().distance;
-              entry.last_distance = path.back().distance;
-              parse_path_into<PathTraversalMode::REVERSE>(path, entry.locations);
-            }
-            return cache_store(child_key, std::move(entry));
-          }();
-
-          if (!child_critical_path.found) {
+        CLOCK required = CLOCK::max();
+        std::size_t batch_index = 0;
+        for (std::size_t index = 0; index < part.size(); ++index) {
+          const auto child_pdd =
+            zero + std::chrono::minutes(part[index].second);
+          const auto& child_target = child_targets[index];
+          const auto& child_key = child_keys[index];
+          auto cached_child = child_key.has_value()
+                                ? std::move(batch_hits[batch_index++])
+                                : std::nullopt;
+          if (!child_target.has_value()) {
             continue;
           }
-          child_pdd_at_parent_target =
-            child_critical_path.first_distance - mixed_bag_processing;
+
+          CLOCK child_pdd_at_parent_target = child_pdd;
+          if (child_target != target) {
+            const auto child_critical_path = [&]() -> PathCacheEntry {
+              if (cached_child.has_value()) {
+                return *std::move(cached_child);
+              }
+              // An earlier child with the same key may have just stored it.
+              if (auto cached = cache_lookup(child_key, child_pdd)) {
+                return *std::move(cached);
+              }
+              return solve(PathTraversalMode::REVERSE,
+                           child_key,
+                           *child_target,
+                           *target,
+                           child_pdd);
+            }();
+
+            if (!child_critical_path.found) {
+              continue;
+            }
+            child_pdd_at_parent_target =
+              child_critical_path.first_distance - mixed_bag_processing;
+          }
+
+          required = std::min(required, child_pdd_at_parent_target);
         }
+        return required;
+      };
 
-        if (child_pdd_at_parent_target < required_parent_deadline) {
-          required_parent_deadline = child_pdd_at_parent_target;
+      CLOCK required_parent_deadline = CLOCK::max();
+      if (m_load_fanout != nullptr && m_fanout_min_children > 0 &&
+          children.size() >= m_fanout_min_children) {
+        // The calling thread runs parts too while it waits for the group.
+        const auto wanted_parts =
+          std::min(m_load_fanout->worker_count() + 1,
+                   (children.size() + LOAD_FANOUT_MIN_PART - 1) /
+                     LOAD_FANOUT_MIN_PART);
+        const auto part_size =
+          (children.size() + wanted_parts - 1) / wanted_parts;
+        const auto parts = (children.size() + part_size - 1) / part_size;
+        std::vector<CLOCK> deadlines(parts, CLOCK::max());
+        WorkStealingExecutor::TaskGroup group(*m_load_fanout);
+        for (std::size_t part = 0; part < parts; ++part) {
+          const auto first = part * part_size;
+          const auto count = std::min(part_size, children.size() - first);
+          group.run([&, part, first, count]() {
+            const StageTimer stage(PipelineStage::find_paths);
+            deadlines[part] = required_deadline(
+              std::span<const ChildDeadline>(children).subspan(first, count));
+          });
         }
+        group.wait();
+        required_parent_deadline = std::ranges::min(deadlines);
+      } else {
+        required_parent_deadline = required_deadline(children);
       }
 
       if (required_parent_deadline != CLOCK::max()) {
@@ -962,26 +2172,25 @@ SolverWrapper::find_paths(
 
   response.is_critical = critical;
 
+  PathCacheEntry ultimate_path;
   if (!critical) {
-    const auto key = cache_key("R:S", *target, *source, bag_pdd);
-    const auto ultimate_path = [&]() -> PathCacheEntry {
-      if (auto cached = cache_lookup(key)) {
-        return cached->value;
+    const auto key = cache_key(PathTraversalMode::REVERSE, *target, *source);
+    ultimate_path = [&]() -> PathCacheEntry {
+      if (itinerary != nullptr && itinerary->value.target == *target &&
+          itinerary->value.deadline == bag_pdd) {
+        if (auto suffix =
+              ultimate_path_suffix(itinerary->value.ultimate, scanned_at)) {
+          return *std::move(suffix);
+        }
       }
-      const auto path =
-        m_solver->find_path<PathTraversalMode::REVERSE, VehicleType::SURFACE>(
-          *target, *source, bag_pdd);
-      PathCacheEntry entry;
-      entry.found = !path.empty();
-      if (entry.found) {
-        entry.first_distance = path.front().distance;
-        entry.last_distance = path.back().distance;
-        parse_path_into<PathTraversalMode::REVERSE>(path, entry.locations);
+      if (auto cached = cache_lookup(key, bag_pdd)) {
+        return *std::move(cached);
       }
-      return cache_store(key, std::move(entry));
+      return solve(
+        PathTraversalMode::REVERSE, key, *target, *source, bag_pdd);
     }();
     if (ultimate_path.found) {
-      response.ultimate.locations = ultimate_path.locations;
+      response.ultimate.path = ultimate_path.path;
     }
   }
 
@@ -990,15 +2199,74 @@ SolverWrapper::find_paths(
   }
 
   if (forward_path.found) {
-    response.earliest.locations = forward_path.locations;
+    response.earliest.path = forward_path.path;
   }
 
   response.pdd = format_clock(bag_pdd);
   response.pdd_ts = bag_pdd.time_since_epoch().count() * 60;
 
+  if (m_itineraries && forward_path.found) {
+    m_itineraries->insert(std::move(bag),
+                          BagItinerary{
+                            .target = *target,
+                            .earliest = forward_path,
+                            .deadline = bag_pdd,
+                            .ultimate = std::move(ultimate_path),
+                          });
+  }
+
   return response;
 }
 
+auto
+SolverWrapper::solve_path(PathTraversalMode mode,
+                          std::optional<std::uint64_t> key,
+                          NodeId source,
+                          NodeId target,
+                          CLOCK query,
+                          bool prefetch) const -> PathCacheInterval
+{
+  if (m_path_cache) {
+    m_path_cache->solves.fetch_add(1, std::memory_order_relaxed);
+  }
+  // Read before solving: a change during the solve must invalidate it.
+  const auto graph_version = m_solver->graph_version();
+  const auto path =
+    mode == PathTraversalMode::FORWARD
+      ? m_solver->find_path<PathTraversalMode::FORWARD, VehicleType::SURFACE>(
+          source, target, query)
+      : m_solver->find_path<PathTraversalMode::REVERSE, VehicleType::SURFACE>(
+          source, target, query);
+  auto interval = make_path_cache_interval(mode, path, query);
+  interval.graph_version = graph_version;
+  interval.prefetched = prefetch;
+  if (key.has_value()) {
+    m_path_cache->update(*key, [&](const PathCacheIntervals* current) {
+      return merge_path_interval(current, interval, mode);
+    });
+  }
+  return interval;
+}
+
+void
+SolverWrapper::claim_prefetch_hit(std::uint64_t key, CLOCK valid_from) const
+{
+  bool claimed = false;
+  m_path_cache->update_existing(key, [&](const PathCacheIntervals& current) {
+    auto intervals = current;
+    for (auto& interval : intervals) {
+      if (interval.valid_from == valid_from && interval.prefetched) {
+        interval.prefetched = false;
+        claimed = true;
+      }
+    }
+    return intervals;
+  });
+  if (claimed) {
+    m_path_cache->prefetch_hits.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
 // NOLINTNEXTLINE(readability-function-cognitive-complexity)
 void
 SolverWrapper::run(const std::stop_token& stop_token)
@@ -1011,153 +2279,192 @@ SolverWrapper::run(const std::stop_token& stop_token)
                        ? std::size_t{0}
                        : m_facility_profiles->size());
 
-  while (true) {
-    try {
-      std::array<std::string, SOLVER_BATCH_SIZE> payloads;
-      if (const size_t num_packages =
-            m_load_queue.wait_dequeue_bulk(std::span(payloads), stop_token);
-          num_packages > 0) {
-        std::for_each(
-          payloads.begin(),
-          payloads.begin() + static_cast<std::ptrdiff_t>(num_packages),
-          // NOLINTNEXTLINE(readability-function-cognitive-complexity)
-          [&app, &stop_token, this](const std::string& payload) -> void {
-            const auto data = moirai::parse_json(payload);
-            if (!data.has_value() || !data->is_object()) {
-              app.logger().error("Invalid load payload");
-              return;
-            }
+  auto& waybills = wrapper_scratch.waybills;
+  // NOLINTNEXTLINE(readability-function-cognitive-complexity)
+  const moirai::LoadVisitor solve_load =
+    [&app, &stop_token, &waybills, this](
+      std::size_t /*index*/,
+      const std::expected<moirai::LoadFields, moirai::LoadDecodeError>& load)
+    -> void {
+    // Everything but find_paths(): waybill checks, deadlines and the
+    // document's load fields.
+    const StageTimer stage(PipelineStage::document);
+    if (!load.has_value()) {
+      if (load.error() == moirai::LoadDecodeError::MISSING_REQUIRED) {
+        app.logger().error("Load payload is invalid: missing id, "
+                           "location, destination, or time");
+      } else {
+        app.logger().error("Invalid load payload");
+      }
+      return;
+    }
 
-            const auto load = extract_load_payload(*data);
-            if (!load.has_value()) {
-              app.logger().error("Load payload is invalid: {}", load.error());
-              return;
-            }
+    auto& packages = wrapper_scratch.packages;
+    packages.clear();
+    auto& seen_children = wrapper_scratch.seen_children;
+    seen_children.clear();
+    bool has_mixed_child_destinations = false;
+    const bool has_items = load->has(moirai::LoadFields::ITEMS);
+
+    packages.reserve(waybills.size());
+    for (const auto& waybill : waybills) {
+      if (!waybill.has(moirai::LoadItem::REQUIRED)) {
+        std::string invalid_fields;
+        if (!waybill.has(moirai::LoadItem::IPDD_DESTINATION)) {
+          invalid_fields += "ipdd_destination";
+        }
+        if (!waybill.has(moirai::LoadItem::CN)) {
+          if (!invalid_fields.empty()) {
+            invalid_fields += ", ";
+          }
+          invalid_fields += "cn";
+        }
+        if (!waybill.has(moirai::LoadItem::ID)) {
+          if (!invalid_fields.empty()) {
+            invalid_fields += ", ";
+          }
+          invalid_fields += "id";
+        }
+        app.logger().error(
+          "Load {} contains invalid waybill entry. "
+          "Invalid/missing fields: {}. Waybill index: {}",
+          load->id,
+          invalid_fields,
+          waybill.index);
+        continue;
+      }
+      try {
+        auto cn = std::string(waybill.cn);
+        const auto ipdd = std::string(waybill.ipdd_destination);
+        if (ipdd.length() <= MIN_IPDD_LENGTH) {
+          throw std::runtime_error(
+            std::format("ipdd_destination too short: '{}'", ipdd));
+        }
+        const auto destination_profile =
+          profile_for(m_facility_profiles, cn);
+        const auto waybill_tmax = iso_to_date_utc_cutoff(
+          ipdd,
+          destination_profile.center_arrival_cutoff);
+
+        // Children with the same cn and ipdd share a deadline, and only the
+        // first valid child's id is reported. Invalid children are never
+        // recorded, so each one is still logged.
+        if (!seen_children
+               .emplace(ChildWaybill{ .cn = waybill.cn,
+                                      .ipdd = waybill.ipdd_destination })
+               .second) {
+          continue;
+        }
+        if (cn != load->destination) {
+          has_mixed_child_destinations = true;
+        }
+        packages.emplace_back(std::move(cn),
+                              waybill_tmax.time_since_epoch().count(),
+                              std::string(waybill.id));
+      } catch (const std::exception& exc) {
+        app.logger().error(
+          "Load {} contains invalid waybill entry. "
+          "Failed to parse waybill: {}. Waybill index: {}",
+          load->id,
+          exc.what(),
+          waybill.index);
+      }
+    }
 
-            auto& packages = wrapper_scratch.packages;
-            packages.clear();
-            bool has_mixed_child_destinations = false;
-
-            if (load->items.has_value()) {
-              packages.reserve(moirai::json_size(*load->items));
-              for (const auto& waybill : *load->items) {
-                const auto waybill_ipdd =
-                  moirai::find_string_member(waybill, "ipdd_destination");
-                const auto waybill_cn =
-                  moirai::find_string_member(waybill, "cn");
-                const auto waybill_id =
-                  moirai::find_string_member(waybill, "id");
-                if (!waybill_ipdd.has_value() || !waybill_cn.has_value() ||
-                    !waybill_id.has_value()) {
-                  std::string invalid_fields;
-                  if (!waybill_ipdd.has_value()) {
-                    invalid_fields += "ipdd_destination";
-                  }
-                  if (!waybill_cn.has_value()) {
-                    if (!invalid_fields.empty()) {
-                      invalid_fields += ", ";
-                    }
-                    invalid_fields += "cn";
-                  }
-                  if (!waybill_id.has_value()) {
-                    if (!invalid_fields.empty()) {
-                      invalid_fields += ", ";
-                    }
-                    invalid_fields += "id";
-                  }
-                  app.logger().error(
-                    "Load {} contains invalid waybill entry. "
-                    "Invalid/missing fields: {}. Waybill payload: {}",
-                    load->id,
-                    invalid_fields,
-                    moirai::dump(waybill));
-                  continue;
-                }
+    if (load->location.empty() || load->destination.empty() ||
+        load->location == load->destination) {
+      return;
+    }
 
-                try {
-                  const auto cn = std::string(*waybill_cn);
-                  const auto ipdd = std::string(*waybill_ipdd);
-                  if (ipdd.length() <= MIN_IPDD_LENGTH) {
-                    throw std::runtime_error(
-                      std::format("ipdd_destination too short: '{}'", ipdd));
-                  }
-                  if (cn != load->destination) {
-                    has_mixed_child_destinations = true;
-                  }
-                  const auto destination_profile =
-                    profile_for(m_facility_profiles, cn);
-                  const auto waybill_tmax = iso_to_date_utc_cutoff(
-                    ipdd,
-                    destination_profile.center_arrival_cutoff);
-
-                  packages.emplace_back(std::move(cn),
-                                        waybill_tmax.time_since_epoch().count(),
-                                        std::string(*waybill_id));
-                } catch (const std::exception& exc) {
-                  app.logger().error(
-                    "Load {} contains invalid waybill entry. "
-                    "Failed to parse waybill: {}. Waybill payload: {}",
-                    load->id,
-                    exc.what(),
-                    moirai::dump(waybill));
-                }
-              }
-            }
+    CLOCK tmax = CLOCK::max();
 
-            if (load->location.empty() || load->destination.empty() ||
-                load->location == load->destination) {
-              return;
-            }
+    const auto destination_profile =
+      profile_for(m_facility_profiles, load->destination);
+    if (!has_items &&
+        load->ipdd_destination.length() > MIN_IPDD_LENGTH) {
+      tmax = iso_to_date_utc_cutoff(
+        std::string(load->ipdd_destination),
+        destination_profile.center_arrival_cutoff);
+    }
 
-            CLOCK tmax = CLOCK::max();
+    SearchDocument solution;
+    try {
+      DURATION source_processing_offset{0};
+      if (!has_items &&
+          !load->origin_center.empty() &&
+          load->origin_center == load->location) {
+        source_processing_offset =
+          profile_for(m_facility_profiles, load->location)
+            .fresh_processing;
+      }
+      const DURATION mixed_bag_processing =
+        has_items && has_mixed_child_destinations
+          ? destination_profile.mixed_bag_processing
+          : DURATION{0};
+      solution = find_paths(
+        std::string(load->id),
+        std::string(load->location),
+        std::string(load->destination),
+        static_cast<int32_t>(iso_to_date(std::string(load->event_time))
+                               .time_since_epoch()
+                               .count()),
+        source_processing_offset,
+        tmax,
+        mixed_bag_processing,
+        packages);
+    } catch (const std::exception& exc) {
+      app.logger().error(
+        "Failed to process load {}: {}", load->id, exc.what());
+      return;
+    }
 
-            const auto destination_profile =
-              profile_for(m_facility_profiles, load->destination);
-            if (!load->items.has_value() &&
-                load->ipdd_destination.length() > MIN_IPDD_LENGTH) {
-              tmax = iso_to_date_utc_cutoff(
-                load->ipdd_destination,
-                destination_profile.center_arrival_cutoff);
-            }
+    solution.cs_slid = load->cs_slid;
+    solution.cs_act = load->cs_act;
+    solution.pid = load->pid;
+    if (!m_solution_queue.wait_enqueue(std::move(solution), stop_token)) {
+      return;
+    }
+  };
 
-            SearchDocument solution;
-            try {
-              DURATION source_processing_offset{0};
-              if (!load->items.has_value() &&
-                  !load->origin_center.empty() &&
-                  load->origin_center == load->location) {
-                source_processing_offset =
-                  profile_for(m_facility_profiles, load->location)
-                    .fresh_processing;
-              }
-              const DURATION mixed_bag_processing =
-                load->items.has_value() && has_mixed_child_destinations
-                  ? destination_profile.mixed_bag_processing
-                  : DURATION{0};
-              solution = find_paths(
-                load->id,
-                load->location,
-                load->destination,
-                static_cast<int32_t>(iso_to_date(load->event_time)
-                                       .time_since_epoch()
-                                       .count()),
-                source_processing_offset,
-                tmax,
-                mixed_bag_processing,
-                packages);
-            } catch (const std::exception& exc) {
-              app.logger().error(
-                "Failed to process load {}: {}", load->id, exc.what());
-              return;
+  std::uint64_t decoded_loads = 0;
+  std::uint64_t batched_loads = 0;
+  const auto copied_before = moirai::decode_copied_bytes();
+  while (true) {
+    try {
+      std::array<std::string, SOLVER_BATCH_SIZE> payloads;
+      if (const size_t num_packages =
+            m_load_queue.wait_dequeue_bulk(std::span(payloads), stop_token);
+          num_packages > 0) {
+        std::size_t loads = 0;
+        for (std::size_t index = 0; index < num_packages; ++index) {
+          if (m_load_compactor != nullptr) {
+            const auto bag = moirai::peek_string_member(payloads[index], "id");
+            if (bag.has_value() &&
+                m_load_compactor->superseded(
+                  &m_load_queue, *bag, payloads[index])) {
+              continue;
             }
+          }
+          if (loads != index) {
+            payloads[loads] = std::move(payloads[index]);
+          }
+          ++loads;
+        }
 
-            solution.cs_slid = load->cs_slid;
-            solution.cs_act = load->cs_act;
-            solution.pid = load->pid;
-            if (!m_solution_queue.wait_enqueue(std::move(solution), stop_token)) {
-              return;
-            }
-          });
+        decoded_loads += loads;
+        // Loads are solved from inside the decode callback; their timers
+        // take that time out of the decode stage.
+        const StageTimer stage(PipelineStage::decode);
+        if (m_batch_decode) {
+          batched_loads += moirai::decode_loads(
+            std::span<const std::string>(payloads.data(), loads),
+            waybills,
+            solve_load);
+        } else {
+          for (std::size_t index = 0; index < loads; ++index) {
+            solve_load(index, moirai::decode_load(payloads[index], waybills));
+          }
+        }
       } else if (m_load_queue.closed()) {
         break;
       }
@@ -1165,15 +2472,237 @@ SolverWrapper::run(const std::stop_token& stop_token)
       app.logger().error("Exception occurred: {}", exc.what());
     }
   }
+  app.logger().information(
+    "Load decode metrics: batch_decode={} loads={} batched={} "
+    "copied_bytes={}",
+    m_batch_decode,
+    decoded_loads,
+    batched_loads,
+    moirai::decode_copied_bytes() - copied_before);
   if (m_path_cache) {
     const auto cache_metrics = m_path_cache->metrics();
+    const auto inflight_metrics = m_path_cache->inflight.metrics();
     app.logger().information(
-      "Path cache metrics: enabled=true entries={} hits={} misses={} evictions={}",
+      "Path cache metrics: enabled=true entries={} hits={} misses={} "
+      "evictions={} admission_rejects={} promotions={} ghost_admissions={} "
+      "main_requeues={} main_evictions={} solves={} coalesced_waits={} "
+      "coalesce_timeouts={} prefetched={} prefetch_hits={} "
+      "unreachable_hits={}",
       cache_metrics.occupied,
       cache_metrics.hits,
       cache_metrics.misses,
-      cache_metrics.evictions);
+      cache_metrics.evictions,
+      cache_metrics.admission_rejects,
+      cache_metrics.policy.promotions,
+      cache_metrics.policy.ghost_admissions,
+      cache_metrics.policy.main_requeues,
+      cache_metrics.policy.main_evictions,
+      m_path_cache->solves.load(std::memory_order_relaxed),
+      inflight_metrics.coalesced_waits,
+      inflight_metrics.timeouts,
+      m_path_cache->prefetched.load(std::memory_order_relaxed),
+      m_path_cache->prefetch_hits.load(std::memory_order_relaxed),
+      m_path_cache->unreachable_hits.load(std::memory_order_relaxed));
   } else {
     app.logger().information("Path cache metrics: enabled=false");
   }
+  if (m_itineraries) {
+    const auto itinerary_metrics = m_itineraries->metrics();
+    app.logger().information(
+      "Itinerary cache metrics: entries={} hits={} misses={} deviations={} "
+      "evictions={}",
+      itinerary_metrics.occupied,
+      m_itineraries->hits.load(std::memory_order_relaxed),
+      m_itineraries->misses.load(std::memory_order_relaxed),
+      m_itineraries->deviations.load(std::memory_order_relaxed),
+      itinerary_metrics.evictions);
+  }
+}
+
+void
+SolverWrapper::log_missing_facilities() const
+{
+  auto& app = moirai::Application::instance();
+  for (const auto& missing : missing_facilities(MISSING_FACILITIES_LOGGED)) {
+    app.logger().information("Missing facility: code={} loads={}",
+                             missing.code,
+                             missing.loads);
+  }
+}
+
+void
+SolverWrapper::run_missing_facility_reports(
+  const std::stop_token& stop_token) const
+{
+  std::mutex mutex;
+  std::condition_variable_any wake;
+  std::unique_lock lock(mutex);
+  while (true) {
+    // Only a stop request wakes this early.
+    wake.wait_for(
+      lock, stop_token, MISSING_FACILITY_REPORT_INTERVAL, [] { return false; });
+    if (stop_token.stop_requested()) {
+      return;
+    }
+    log_missing_facilities();
+  }
+}
+
+void
+SolverWrapper::save_path_cache_snapshot() const
+{
+  if (!m_path_cache || m_cache_config.snapshot_path.empty()) {
+    return;
+  }
+  auto& app = moirai::Application::instance();
+  const auto saved =
+    save_path_cache(*m_path_cache, *m_solver, m_cache_config.snapshot_path);
+  if (saved.has_value()) {
+    app.logger().information(
+      "Path cache snapshot saved: path={} entries={} intervals={} bytes={} "
+      "elapsed_ms={}",
+      m_cache_config.snapshot_path.string(),
+      saved->entries,
+      saved->intervals,
+      saved->bytes,
+      saved->elapsed_ms);
+  } else {
+    app.logger().error("Path cache snapshot failed: {}", saved.error());
+  }
+}
+
+void
+SolverWrapper::run_path_cache_snapshots(const std::stop_token& stop_token) const
+{
+  if (!m_path_cache || m_cache_config.snapshot_path.empty() ||
+      m_cache_config.snapshot_interval.count() == 0) {
+    return;
+  }
+  std::mutex mutex;
+  std::condition_variable_any wake;
+  std::unique_lock lock(mutex);
+  while (true) {
+    // Only a stop request wakes this early.
+    wake.wait_for(
+      lock, stop_token, m_cache_config.snapshot_interval, [] { return false; });
+    if (stop_token.stop_requested()) {
+      return;
+    }
+    save_path_cache_snapshot();
+  }
+}
+
+auto
+SolverWrapper::prefetch_hot_pairs(
+  const std::stop_token& stop_token,
+  std::span<BlockingQueue<std::string>* const> load_queues) const
+  -> std::size_t
+{
+  if (!m_path_cache || m_cache_config.prefetch_pairs == 0) {
+    return 0;
+  }
+  const auto loads_waiting = [&]() {
+    if (stop_token.stop_requested()) {
+      return true;
+    }
+    if (load_queues.empty()) {
+      return !m_load_queue.empty();
+    }
+    return std::ranges::any_of(
+      load_queues, [](const auto* queue) { return !queue->empty(); });
+  };
+
+  const StageTimer stage(PipelineStage::prefetch);
+  const auto horizon = CLOCK::duration{ static_cast<CLOCK::rep>(
+    m_cache_config.prefetch_horizon.count()) };
+  const auto graph_version = m_solver->graph_version();
+  std::size_t solved = 0;
+  for (const auto& hot :
+       m_path_cache->hot_keys.top(m_cache_config.prefetch_pairs)) {
+    const auto query = unpack_path_cache_key(hot.key);
+    if (query.vehicle != VehicleType::SURFACE ||
+        hot.payload > CLOCK::max() - horizon) {
+      continue;
+    }
+    // Forward intervals run from the start to the next departure and reverse
+    // ones from the latest departure up to the deadline, so forward keys are
+    // walked up from the latest query and reverse keys down to it.
+    const auto forward = query.mode == PathTraversalMode::FORWARD;
+    const auto first = hot.payload;
+    const auto last = hot.payload + horizon;
+    auto cursor = forward ? first : last;
+    for (std::size_t solves = 0; solves < PREFETCH_SOLVES_PER_KEY;) {
+      if (loads_waiting()) {
+        return solved;
+      }
+      std::optional<std::pair<CLOCK, CLOCK>> covered;
+      m_path_cache->peek(hot.key, [&](const PathCacheIntervals& intervals) {
+        const auto* interval =
+          find_path_interval(intervals, cursor, graph_version);
+        if (interval != nullptr) {
+          covered.emplace(interval->valid_from, interval->valid_until);
+        }
+        return interval != nullptr;
+      });
+      if (!covered.has_value()) {
+        // A load solving this key right now will cover it.
+        const auto flight = m_path_cache->inflight.try_join(hot.key);
+        if (!flight.leader()) {
+          break;
+        }
+        const auto interval = solve_path(
+          query.mode, hot.key, query.source, query.target, cursor, true);
+        covered.emplace(interval.valid_from, interval.valid_until);
+        m_path_cache->prefetched.fetch_add(1, std::memory_order_relaxed);
+        ++solves;
+        ++solved;
+      }
+      if (forward ? covered->second >= last : covered->first <= first) {
+        break;
+      }
+      cursor = forward ? covered->second + CLOCK::duration{ 1 }
+                       : covered->first - CLOCK::duration{ 1 };
+    }
+  }
+  return solved;
+}
+
+void
+SolverWrapper::run_prefetcher(
+  const std::stop_token& stop_token,
+  std::vector<BlockingQueue<std::string>*> load_queues) const
+{
+  if (!m_path_cache || m_cache_config.prefetch_pairs == 0) {
+    return;
+  }
+  auto& app = moirai::Application::instance();
+  if (::setpriority(PRIO_PROCESS, static_cast<id_t>(::gettid()),
+                    PREFETCH_NICE) != 0) {
+    app.logger().debug("Prefetcher keeps the default thread priority");
+  }
+
+  std::mutex mutex;
+  std::condition_variable_any wake;
+  std::unique_lock lock(mutex);
+  auto decayed_at = std::chrono::steady_clock::now();
+  if (load_queues.empty()) {
+    load_queues.push_back(&m_load_queue);
+  }
+  const auto idle = [&load_queues] {
+    return std::ranges::all_of(load_queues,
+                               [](const auto* queue) { return queue->empty(); });
+  };
+  while (!stop_token.stop_requested() && !m_load_queue.closed()) {
+    const auto solved =
+      idle() ? prefetch_hot_pairs(stop_token, load_queues) : 0;
+    if (const auto now = std::chrono::steady_clock::now();
+        now - decayed_at >= PREFETCH_DECAY_INTERVAL) {
+      m_path_cache->hot_keys.decay();
+      decayed_at = now;
+    }
+    if (solved == 0) {
+      // Only a stop request wakes this early.
+      wake.wait_for(lock, stop_token, PREFETCH_IDLE_POLL, [] { return false; });
+    }
+  }
 }
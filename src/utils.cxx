@@ -90,3 +90,36 @@ void to_lower(std::string &value) {
     return std::tolower(chr);
   });
 }
+
+auto parse_bool_env(std::string_view name, bool fallback) -> bool {
+  const char *value = std::getenv(std::string(name).c_str());
+  if (value == nullptr || std::string_view{value}.empty()) {
+    return fallback;
+  }
+  std::string input{value};
+  to_lower(input);
+  if (input == "1" || input == "true" || input == "yes" || input == "on") {
+    return true;
+  }
+  if (input == "0" || input == "false" || input == "no" || input == "off") {
+    return false;
+  }
+  throw std::runtime_error(std::format("Invalid {} value '{}'", name, input));
+}
+
+auto parse_size_env(std::string_view name, std::size_t fallback,
+                    bool allow_zero) -> std::size_t {
+  const char *value = std::getenv(std::string(name).c_str());
+  if (value == nullptr || std::string_view{value}.empty()) {
+    return fallback;
+  }
+  std::size_t parsed{};
+  const std::string_view input{value};
+  const auto [ptr, error] =
+      std::from_chars(input.data(), input.data() + input.size(), parsed);
+  if (error != std::errc{} || ptr != input.data() + input.size() ||
+      (!allow_zero && parsed == 0)) {
+    throw std::runtime_error(std::format("Invalid {} value '{}'", name, input));
+  }
+  return parsed;
+}
@@ -79,6 +79,59 @@ void test_endpoint_initialization_builds_graph() {
               "missing route node logged");
 }
 
+void test_route_stream_split_across_small_pieces() {
+  const auto routes_body = moirai_tests::read_fixture("routes.json");
+  const auto piecewise_stream = [](std::string body) {
+    return [body = std::move(body)](const moirai::Uri& uri,
+                                    const std::vector<std::string>& headers,
+                                    const moirai::HttpBodySink& sink)
+               -> moirai::HttpResponse {
+      (void)uri;
+      (void)headers;
+      constexpr std::size_t PIECE_BYTES = 7;
+      for (std::size_t offset = 0; offset < body.size();
+           offset += PIECE_BYTES) {
+        if (!sink(std::string_view{body}.substr(offset, PIECE_BYTES))) {
+          throw std::runtime_error("Response stream aborted by consumer");
+        }
+      }
+      return {.status_code = 200, .body = {}};
+    };
+  };
+
+  WrapperHarness buffered_harness;
+  SolverWrapper buffered(buffered_harness.queues(),
+                         endpoints(),
+                         fixture_path("timings.json"),
+                         default_fake_http());
+
+  WrapperHarness streamed_harness;
+  ScopedLogCapture logs;
+  SolverWrapper streamed(streamed_harness.queues(),
+                         endpoints(),
+                         fixture_path("timings.json"),
+                         default_fake_http(),
+                         piecewise_stream(routes_body));
+  expect_eq(streamed.get_solver()->show(), std::string{"Graph<5, 6>"},
+            "route stream split into small pieces builds the graph");
+  expect_eq(streamed.get_solver()->show_all(),
+            buffered.get_solver()->show_all(),
+            "streamed routes match the buffered response");
+  expect_true(logs.contains("peak_buffered_bytes="),
+              "route timings report buffered route bytes");
+
+  WrapperHarness truncated_harness;
+  ScopedLogCapture truncated_logs;
+  SolverWrapper truncated(
+    truncated_harness.queues(),
+    endpoints(),
+    fixture_path("timings.json"),
+    default_fake_http(),
+    piecewise_stream(routes_body.substr(0, routes_body.size() / 2)));
+  expect_true(truncated_logs.contains("Unable to parse route response"),
+              "truncated route stream logged");
+}
+
 void test_initialization_handles_bad_http_responses() {
   WrapperHarness harness;
   ScopedLogCapture logs;
@@ -143,6 +196,7 @@ void test_initialization_handles_invalid_json_logs() {
 auto main() -> int {
   test_init_timings_legacy_file_is_ignored();
   test_endpoint_initialization_builds_graph();
+  test_route_stream_split_across_small_pieces();
   test_initialization_handles_bad_http_responses();
   test_initialization_handles_invalid_json_logs();
   return 0;
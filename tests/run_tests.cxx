@@ -1,7 +1,16 @@
 #include <cstdlib>
+#include <unistd.h>
+#include "flow_watermarks.hxx"
+#include "lane_map.hxx"
+#include "load_compactor.hxx"
+#include "partition_flow.hxx"
 #include "test_helpers.hxx"
 
 import std;
+import moirai.file_reader;
+import moirai.json_utils;
+import moirai.load_capture;
+import moirai.load_payload;
 
 namespace {
 
@@ -87,13 +96,86 @@ void test_valid_payload_produces_solution() {
             "valid payload produces one solution");
   const auto& solution = result.outputs[0];
   expect_eq(solution.waybill, std::string{"bag-normal"}, "solution waybill");
-  expect_true(!solution.earliest.locations.empty(),
+  expect_true(!solution.earliest.empty(),
               "solution contains earliest");
   expect_eq(solution.cs_slid, std::string{"SLID"}, "cs_slid copied");
   expect_eq(solution.cs_act, std::string{"ACT"}, "cs_act copied");
   expect_eq(solution.pid, std::string{"PID"}, "pid copied");
 }
 
+void test_padded_payload_is_parsed_in_place() {
+  auto payload = moirai::make_padded_payload(read_fixture("load_normal.json"));
+  expect_true(payload.capacity() - payload.size() >= moirai::JSON_PADDING,
+              "padded payload reserves parser padding");
+  const auto parsed = moirai::parse_padded_json(payload);
+  expect_true(parsed.has_value() && parsed->is_object(),
+              "padded payload parses in place");
+
+  const auto result = run_single_payload(std::move(payload));
+  expect_eq(result.outputs.size(), std::size_t{1},
+            "padded payload produces one solution");
+  expect_eq(result.outputs[0].waybill, std::string{"bag-normal"},
+            "padded payload solution waybill");
+}
+
+void test_load_decoder_follows_dom_lookup_rules() {
+  std::vector<moirai::LoadItem> waybills;
+  const auto load = moirai::decode_load(moirai::make_padded_payload(R"({
+    "id":"bag-\"quoted\"",
+    "location":"A",
+    "destination":"C",
+    "time":"2026-06-08 08:00:00",
+    "oc":7,
+    "id":"ignored",
+    "items":{"id":"not-an-array"},
+    "item":[
+      {"id":"child","cn":"D","ipdd_destination":"2026-06-08 12:00:00"},
+      "not-an-object"
+    ]
+  })"), waybills);
+  expect_true(load.has_value(), "load with mistyped fields decodes");
+  expect_eq(std::string(load->id), std::string{"bag-\"quoted\""},
+            "first id wins and is unescaped");
+  expect_eq(load->has(moirai::LoadFields::ORIGIN_CENTER), false,
+            "non-string field counts as absent");
+  expect_eq(load->has(moirai::LoadFields::ITEMS), true,
+            "item alias used when items is not an array");
+  expect_eq(waybills.size(), std::size_t{2}, "every waybill entry decoded");
+  expect_eq(std::string(waybills[0].cn), std::string{"D"}, "waybill cn");
+  expect_eq(waybills[1].present, std::uint8_t{0},
+            "non-object waybill has no fields");
+
+  expect_true(moirai::decode_load(R"({"id":"x"} [])", waybills).error() ==
+                moirai::LoadDecodeError::INVALID_JSON,
+              "trailing content rejected");
+  expect_true(moirai::decode_load(R"({"id":"x"})", waybills).error() ==
+                moirai::LoadDecodeError::MISSING_REQUIRED,
+              "missing required fields reported");
+}
+
+void test_batch_decode_matches_single_decodes() {
+  const auto valid = read_fixture("load_normal.json");
+  const std::vector<std::string> payloads{
+    valid, valid + " " + valid, "not-json", R"({"id":"missing"})", valid,
+  };
+  std::vector<moirai::LoadItem> waybills;
+  std::vector<std::string> results;
+  const auto streamed = moirai::decode_loads(
+    payloads, waybills,
+    [&](std::size_t index,
+        const std::expected<moirai::LoadFields, moirai::LoadDecodeError>& load) {
+      expect_eq(index, results.size(), "batch visited in order");
+      results.push_back(load.has_value() ? std::string(load->id)
+                                         : std::string{"error"});
+    });
+  expect_eq(streamed, std::size_t{1},
+            "batch falls back after a multi-document payload");
+  expect_eq(results,
+            std::vector<std::string>{"bag-normal", "error", "error", "error",
+                                     "bag-normal"},
+            "batch results match single decodes");
+}
+
 void test_invalid_payloads_produce_no_solution() {
   const auto invalid_json = run_single_payload("not-json");
   expect_eq(invalid_json.outputs.empty(), true,
@@ -179,6 +261,34 @@ void test_invalid_waybill_date_is_logged_and_skipped() {
               "bad waybill date logged");
 }
 
+void test_repeated_children_log_each_invalid_entry() {
+  const auto payload = R"({
+    "id":"bag-repeated-children",
+    "location":"A",
+    "destination":"C",
+    "time":"2026-06-08 08:00:00",
+    "items":[
+      {"id":"bad-1","cn":"D","ipdd_destination":"bad-date"},
+      {"id":"child-1","cn":"D","ipdd_destination":"2026-06-08 12:00:00"},
+      {"id":"bad-2","cn":"D","ipdd_destination":"bad-date"},
+      {"id":"child-2","cn":"D","ipdd_destination":"2026-06-08 12:00:00"}
+    ]
+  })";
+  const auto result = run_single_payload(payload);
+  expect_eq(result.outputs.size(), std::size_t{1},
+            "repeated children produce one solution");
+  expect_eq(std::ranges::count_if(result.logs,
+                                  [](const auto& record) {
+                                    return record.message.find(
+                                             "Failed to parse waybill") !=
+                                           std::string::npos;
+                                  }),
+            std::ptrdiff_t{2},
+            "every repeated invalid child is logged");
+  expect_eq(result.outputs[0].package_id, std::string{"child-1"},
+            "the first valid child of a repeated pair is reported");
+}
+
 void test_route_expansion_thread_override_is_deterministic() {
   const auto payload = read_fixture("load_normal.json");
   const auto single_thread = run_single_payload(payload, "1");
@@ -188,14 +298,14 @@ void test_route_expansion_thread_override_is_deterministic() {
             "single-thread route expansion produces solution");
   expect_eq(multi_thread.outputs.size(), std::size_t{1},
             "multi-thread route expansion produces solution");
-  expect_eq(single_thread.outputs[0].earliest.locations.size(),
-            multi_thread.outputs[0].earliest.locations.size(),
+  expect_eq(single_thread.outputs[0].earliest.size(),
+            multi_thread.outputs[0].earliest.size(),
             "route expansion thread count preserves path size");
-  expect_eq(single_thread.outputs[0].earliest.locations.front().code,
-            multi_thread.outputs[0].earliest.locations.front().code,
+  expect_eq(single_thread.outputs[0].earliest.expand().front().code,
+            multi_thread.outputs[0].earliest.expand().front().code,
             "route expansion thread count preserves first path node");
-  expect_eq(single_thread.outputs[0].earliest.locations.back().code,
-            multi_thread.outputs[0].earliest.locations.back().code,
+  expect_eq(single_thread.outputs[0].earliest.expand().back().code,
+            multi_thread.outputs[0].earliest.expand().back().code,
             "route expansion thread count preserves last path node");
   expect_true(multi_thread.contains_log("Initialized graph: queue="),
               "startup graph stats are logged after finalize");
@@ -203,6 +313,28 @@ void test_route_expansion_thread_override_is_deterministic() {
               "startup timing summary is logged");
 }
 
+void test_startup_thread_count_builds_identical_graph() {
+  const auto build_graph = [](const char* startup_threads) {
+    WrapperHarness harness;
+    ScopedLogCapture logs;
+    ScopedEnv thread_override("MOIRAI_STARTUP_THREADS", startup_threads);
+    SolverWrapper wrapper(harness.queues(),
+                          endpoints(),
+                          fixture_path("timings.json"),
+                          default_fake_http());
+    expect_true(logs.contains("critical_path="),
+                "startup timings report the critical path");
+    expect_true(logs.contains("route_expansion_ms="),
+                "startup timings report route expansion");
+    return wrapper.get_solver()->show_all();
+  };
+
+  const auto single_worker = build_graph("1");
+  const auto many_workers = build_graph("8");
+  expect_eq(single_worker, many_workers,
+            "startup executor size preserves node and edge order");
+}
+
 void test_path_cache_hits_repeated_loads() {
   WrapperHarness harness;
   ScopedLogCapture logs;
@@ -225,15 +357,512 @@ void test_path_cache_hits_repeated_loads() {
   expect_true(logs.contains("hits="), "path cache hit count logged");
 }
 
+void test_batch_with_invalid_payload_solves_the_rest() {
+  WrapperHarness harness;
+  ScopedLogCapture logs;
+  SolverWrapper wrapper(harness.queues(),
+                        endpoints(),
+                        fixture_path("timings.json"),
+                        default_fake_http());
+
+  const auto valid = read_fixture("load_normal.json");
+  for (const auto& payload : {valid, std::string{"not-json"}, valid}) {
+    harness.load_queue.enqueue(payload);
+  }
+  harness.load_queue.close();
+  wrapper.run(std::stop_token{});
+
+  std::array<SearchDocument, 4> output;
+  const auto count = harness.solution_queue.try_dequeue_bulk(output.data(),
+                                                             output.size());
+  expect_eq(count, std::size_t{2}, "valid loads around a bad one are solved");
+  expect_true(logs.contains("Invalid load payload"), "bad payload logged");
+  expect_true(logs.contains("Load decode metrics: batch_decode=true loads=3"),
+              "batch decode metrics logged");
+}
+
+// Dequeues until `count` payloads arrived or `limit` passed.
+auto dequeue_payloads(BlockingQueue<std::string>& queue, std::size_t count,
+                      std::chrono::milliseconds limit)
+    -> std::vector<std::string> {
+  std::vector<std::string> payloads;
+  std::array<std::string, 16> chunk;
+  const auto deadline = std::chrono::steady_clock::now() + limit;
+  while (payloads.size() < count && std::chrono::steady_clock::now() < deadline) {
+    const auto dequeued = queue.try_dequeue_bulk(chunk.data(), chunk.size());
+    std::move(chunk.begin(),
+              chunk.begin() + static_cast<std::ptrdiff_t>(dequeued),
+              std::back_inserter(payloads));
+    if (dequeued == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{5});
+    }
+  }
+  return payloads;
+}
+
+void test_file_reader_replays_and_follows_files() {
+  const auto directory = std::filesystem::temp_directory_path() /
+                         std::format("moirai-file-reader-{}", ::getpid());
+  std::filesystem::create_directories(directory);
+  const auto first = directory / "first.jsonl";
+  const auto second = directory / "second.jsonl";
+  {
+    std::ofstream output(first);
+    output << "{\"id\":\"one\"}\r\n\n   \n{\"id\":\"two\"}\n";
+  }
+  {
+    std::ofstream output(second);
+    output << "{\"id\":\"three\"}\n{\"id\":\"tail\"}";
+  }
+
+  BlockingQueue<std::string> queue(4);
+  FileReader reader(std::vector{first, second}, &queue);
+  std::jthread thread([&reader](std::stop_token stop_token) {
+    reader.run(std::move(stop_token));
+  });
+
+  auto payloads = dequeue_payloads(queue, 4, std::chrono::seconds{10});
+  expect_eq(payloads.size(), std::size_t{4},
+            "both files replayed, unterminated tail included");
+  expect_true(std::ranges::all_of(payloads,
+                                  [](const std::string& payload) {
+                                    return payload.capacity() -
+                                             payload.size() >=
+                                           moirai::JSON_PADDING;
+                                  }),
+              "lines enqueued with parser padding");
+  std::ranges::sort(payloads);
+  expect_eq(payloads,
+            std::vector<std::string>{R"({"id":"one"})", R"({"id":"tail"})",
+                                     R"({"id":"three"})", R"({"id":"two"})"},
+            "blank lines skipped and carriage returns dropped");
+
+  {
+    std::ofstream output(first, std::ios::app);
+    output << "{\"id\":\"appended\"}\n";
+  }
+  const auto appended = dequeue_payloads(queue, 1, std::chrono::seconds{10});
+  expect_eq(appended, std::vector<std::string>{R"({"id":"appended"})"},
+            "appended line followed");
+
+  thread.request_stop();
+  thread.join();
+  expect_eq(reader.metrics().lines, std::uint64_t{5}, "lines counted");
+  std::filesystem::remove_all(directory);
+}
+
+void test_file_reader_follows_truncation_and_rotation() {
+  const auto directory = std::filesystem::temp_directory_path() /
+                         std::format("moirai-file-rotation-{}", ::getpid());
+  std::filesystem::create_directories(directory);
+  const auto path = directory / "loads.jsonl";
+  {
+    std::ofstream output(path);
+    output << "{\"id\":\"one\"}\n{\"id\":\"two\"}\n";
+  }
+
+  // One slot: the reader blocks on the second line while the file shrinks.
+  BlockingQueue<std::string> queue(1);
+  FileReader reader(path.string(), &queue);
+  std::jthread thread([&reader](std::stop_token stop_token) {
+    reader.run(std::move(stop_token));
+  });
+  expect_eq(dequeue_payloads(queue, 1, std::chrono::seconds{10}),
+            std::vector<std::string>{R"({"id":"one"})"}, "first line read");
+  std::filesystem::resize_file(path, 0);
+  expect_eq(dequeue_payloads(queue, 1, std::chrono::seconds{10}),
+            std::vector<std::string>{R"({"id":"two"})"},
+            "line read before the truncation delivered");
+  {
+    std::ofstream output(path);
+    output << "{\"id\":\"rewritten\"}\n";
+  }
+  expect_eq(dequeue_payloads(queue, 1, std::chrono::seconds{10}),
+            std::vector<std::string>{R"({"id":"rewritten"})"},
+            "truncated file read from the start");
+
+  {
+    std::ofstream output(path, std::ios::app);
+    output << "{\"id\":\"tail\"}";
+  }
+  std::filesystem::rename(path, directory / "loads.jsonl.1");
+  {
+    std::ofstream output(path);
+    output << "{\"id\":\"rotated\"}\n";
+  }
+  expect_eq(dequeue_payloads(queue, 2, std::chrono::seconds{10}),
+            std::vector<std::string>{R"({"id":"tail"})",
+                                     R"({"id":"rotated"})"},
+            "old file drained, then the new file followed");
+
+  thread.request_stop();
+  queue.close();
+  thread.join();
+  std::filesystem::remove_all(directory);
+}
+
+void test_load_capture_round_trips_and_replays(moirai::CaptureCodec codec) {
+  const auto path = std::filesystem::temp_directory_path() /
+                    std::format("moirai-capture-{}-{}.cap",
+                                ::getpid(),
+                                std::to_underlying(codec));
+  const std::vector<moirai::LoadRecord> records{
+    {.timestamp_ms = 1'780'000'000'000,
+     .partition = 3,
+     .offset = 41,
+     .payload = R"({"id":"one"})"},
+    {.timestamp_ms = -1, .partition = 0, .offset = 0, .payload = ""},
+    {.timestamp_ms = 1'780'000'000'500,
+     .partition = 11,
+     .offset = 9'000'000'000,
+     .payload = R"({"id":"two"})"},
+  };
+  {
+    moirai::LoadRecorder recorder(path, codec);
+    for (const auto& record : records) {
+      recorder.record(record);
+    }
+    recorder.close();
+    recorder.record(records.front());
+    const auto metrics = recorder.metrics();
+    expect_eq(metrics.records, std::uint64_t{3}, "loads recorded");
+    expect_eq(metrics.dropped, std::uint64_t{1}, "record after close dropped");
+    expect_eq(metrics.frames, std::uint64_t{1}, "loads written as one frame");
+    if (codec == moirai::CaptureCodec::stored) {
+      expect_eq(metrics.stored_bytes, metrics.raw_bytes + 16,
+                "frame stored as is");
+    }
+  }
+  expect_true(moirai::is_load_capture(path), "capture detected by magic");
+  expect_true(!moirai::is_load_capture(fixture_path("load_normal.json")),
+              "JSON load is not a capture");
+
+  moirai::LoadCaptureReader capture(path);
+  for (const auto& expected : records) {
+    const auto record = capture.next();
+    expect_true(record.has_value(), "recorded load read back");
+    expect_eq(record->timestamp_ms, expected.timestamp_ms, "timestamp kept");
+    expect_eq(record->partition, expected.partition, "partition kept");
+    expect_eq(record->offset, expected.offset, "offset kept");
+    expect_eq(record->payload, expected.payload, "payload kept");
+  }
+  expect_true(!capture.next().has_value(), "capture ends after its loads");
+  expect_true(!capture.truncated(), "complete capture is not truncated");
+
+  BlockingQueue<std::string> queue(8);
+  FileReader reader(path.string(), &queue);
+  reader.run(std::stop_token{});
+  const auto payloads = dequeue_payloads(queue, 3, std::chrono::seconds{1});
+  expect_eq(payloads,
+            std::vector<std::string>{R"({"id":"one"})", "", R"({"id":"two"})"},
+            "capture replayed once, in order");
+  expect_eq(reader.metrics().lines, std::uint64_t{3}, "replayed loads counted");
+
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+  moirai::LoadCaptureReader cut(path);
+  expect_true(!cut.next().has_value(), "partly written frame not read");
+  expect_true(cut.truncated(), "partly written frame reported");
+  std::filesystem::remove(path);
+}
+
+void test_load_capture_compresses_on_request() {
+  const auto path = std::filesystem::temp_directory_path() /
+                    std::format("moirai-capture-zlib-{}.cap", ::getpid());
+  const auto payload = read_fixture("load_normal.json");
+  constexpr std::size_t LOADS = 1'000;
+  for (const auto codec :
+       {moirai::CaptureCodec::stored, moirai::CaptureCodec::zlib}) {
+    moirai::LoadRecorder::Metrics metrics;
+    {
+      moirai::LoadRecorder recorder(path, codec);
+      for (std::size_t index = 0; index < LOADS; ++index) {
+        recorder.record({.payload = payload});
+      }
+      recorder.close();
+      metrics = recorder.metrics();
+    }
+    const bool compressed = metrics.stored_bytes < metrics.raw_bytes;
+    expect_eq(compressed,
+              codec == moirai::CaptureCodec::zlib,
+              "only a zlib recorder compresses");
+
+    std::size_t read = 0;
+    moirai::LoadCaptureReader capture(path);
+    while (const auto record = capture.next()) {
+      expect_eq(record->payload, std::string_view{payload}, "payload kept");
+      ++read;
+    }
+    expect_eq(read, LOADS, "every load read back");
+  }
+  std::filesystem::remove(path);
+}
+
+void test_superseded_loads_are_dropped() {
+  WrapperHarness harness;
+  ScopedLogCapture logs;
+  LoadCompactor compactor(64);
+  auto queues = harness.queues();
+  queues.compactor = &compactor;
+  SolverWrapper wrapper(queues,
+                        endpoints(),
+                        fixture_path("timings.json"),
+                        default_fake_http());
+
+  const auto stale = read_fixture("load_normal.json");
+  auto fresh = stale;
+  fresh.replace(fresh.find("\"PID\""), 5, "\"PID-2\"");
+  for (const auto& payload : {stale, fresh}) {
+    expect_true(compactor.admit(&harness.load_queue, "bag-normal", payload),
+                "load admitted to the compaction index");
+    harness.load_queue.enqueue(payload);
+  }
+  harness.load_queue.close();
+  wrapper.run(std::stop_token{});
+
+  std::array<SearchDocument, 4> output;
+  const auto count = harness.solution_queue.try_dequeue_bulk(output.data(),
+                                                             output.size());
+  expect_eq(count, std::size_t{1}, "superseded load produces no solution");
+  expect_eq(output[0].pid, std::string{"PID-2"}, "newest load is solved");
+  expect_eq(compactor.metrics().superseded, std::uint64_t{1},
+            "superseded drop counted");
+}
+
+void test_compactor_ignores_check_order() {
+  LoadCompactor compactor(64);
+  const int queue = 0;
+  expect_true(compactor.admit(&queue, "bag", "scan-1"), "older scan admitted");
+  expect_true(compactor.admit(&queue, "bag", "scan-2"), "newer scan admitted");
+  // Two solvers on one queue: the newer scan can be checked first.
+  expect_true(!compactor.superseded(&queue, "bag", "scan-2"),
+              "newest scan kept when checked first");
+  expect_true(compactor.superseded(&queue, "bag", "scan-1"),
+              "older scan dropped when checked last");
+
+  // A redelivered scan is the same scan; both copies are solved.
+  (void)compactor.admit(&queue, "bag", "scan-3");
+  (void)compactor.admit(&queue, "bag", "scan-3");
+  expect_true(!compactor.superseded(&queue, "bag", "scan-3"),
+              "first copy kept");
+  expect_true(!compactor.superseded(&queue, "bag", "scan-3"),
+              "second copy kept");
+  expect_eq(compactor.metrics().superseded, std::uint64_t{1},
+            "one superseded scan counted");
+}
+
+void test_superseded_loads_are_dropped_across_solvers() {
+  WrapperHarness harness;
+  ScopedLogCapture logs;
+  LoadCompactor compactor(256);
+  auto queues = harness.queues();
+  queues.compactor = &compactor;
+  SolverWrapper primary(queues,
+                        endpoints(),
+                        fixture_path("timings.json"),
+                        default_fake_http());
+  queues.node = nullptr;
+  queues.edge = nullptr;
+  SolverWrapper secondary(queues,
+                          primary.get_solver(),
+                          fixture_path("timings.json"),
+                          {.path_cache = primary.get_cache(),
+                           .facility_profiles =
+                             primary.get_facility_profiles()});
+
+  constexpr int BAGS = 64;
+  const auto fixture = read_fixture("load_normal.json");
+  for (const auto* scan : {"old", "new"}) {
+    for (int bag = 0; bag < BAGS; ++bag) {
+      auto payload = fixture;
+      payload.replace(payload.find("\"bag-normal\""),
+                      12,
+                      std::format("\"bag-{}\"", bag));
+      payload.replace(payload.find("\"PID\""),
+                      5,
+                      std::format("\"PID-{}\"", scan));
+      expect_true(compactor.admit(&harness.load_queue,
+                                  std::format("bag-{}", bag),
+                                  payload),
+                  "load admitted to the compaction index");
+      harness.load_queue.enqueue(std::move(payload));
+    }
+  }
+  harness.load_queue.close();
+  {
+    std::jthread other([&secondary] { secondary.run(std::stop_token{}); });
+    primary.run(std::stop_token{});
+  }
+
+  std::array<SearchDocument, 2 * BAGS> output;
+  const auto count = harness.solution_queue.try_dequeue_bulk(output.data(),
+                                                             output.size());
+  expect_eq(count, std::size_t{BAGS}, "one solution per bag");
+  expect_true(std::ranges::all_of(std::span(output).first(count),
+                                  [](const SearchDocument& document) {
+                                    return document.pid == "PID-new";
+                                  }),
+              "only the newest scan of each bag is solved");
+  expect_eq(compactor.metrics().superseded, std::uint64_t{BAGS},
+            "every older scan dropped");
+}
+
+void test_lane_map_balances_new_partitions() {
+  LaneMap lanes(3);
+  // Listed out of order; mapped in ascending order.
+  lanes.assign({4, 0, 2, 1, 3});
+  for (const auto& [partition, lane] :
+       std::array<std::pair<std::int32_t, std::size_t>, 5>{
+         {{0, 0}, {1, 1}, {2, 2}, {3, 0}, {4, 1}}}) {
+    expect_eq(lanes.lane_of(partition), std::optional<std::size_t>{lane},
+              "partition goes to the least-loaded lane");
+  }
+  expect_eq(lanes.active_partitions(2), std::size_t{1}, "lane 2 load");
+
+  // A partition first seen on a message is mapped the same way.
+  expect_eq(lanes.lane_for(9), std::size_t{2}, "unseen partition balanced");
+  expect_eq(lanes.lane_of(7), std::optional<std::size_t>{},
+            "unmapped partition has no lane");
+}
+
+void test_lane_map_keeps_lanes_under_eager_rebalance() {
+  LaneMap lanes(2);
+  lanes.assign({0, 1, 2, 3});
+  // Eager: everything is revoked, then the new full assignment arrives.
+  lanes.revoke(std::array<std::int32_t, 4>{0, 1, 2, 3});
+  expect_eq(lanes.active_partitions(0), std::size_t{0}, "lane 0 drained");
+  expect_eq(lanes.active_partitions(1), std::size_t{0}, "lane 1 drained");
+  lanes.assign({1, 3, 4});
+  expect_eq(lanes.lane_of(1), std::optional<std::size_t>{1},
+            "reassigned partition keeps its lane");
+  expect_eq(lanes.lane_of(3), std::optional<std::size_t>{1},
+            "reassigned partition keeps its lane");
+  expect_eq(lanes.lane_of(4), std::optional<std::size_t>{0},
+            "new partition goes to the idle lane");
+  expect_eq(lanes.active_partitions(0), std::size_t{1}, "lane 0 load");
+  expect_eq(lanes.active_partitions(1), std::size_t{2}, "lane 1 load");
+
+  // Revoking twice, or a partition never seen, changes nothing.
+  lanes.revoke(std::array<std::int32_t, 3>{1, 1, 8});
+  expect_eq(lanes.active_partitions(1), std::size_t{1}, "one revoke counted");
+}
+
+void test_lane_map_keeps_lanes_under_cooperative_rebalance() {
+  LaneMap lanes(2);
+  lanes.assign({0, 1, 2, 3});
+  // Cooperative: only the partitions that move are revoked or assigned.
+  lanes.revoke(std::array<std::int32_t, 2>{0, 2});
+  expect_eq(lanes.active_partitions(0), std::size_t{0}, "lane 0 drained");
+  expect_eq(lanes.lane_for(3), std::size_t{1}, "kept partition unchanged");
+  lanes.assign({5, 2});
+  expect_eq(lanes.lane_of(2), std::optional<std::size_t>{0},
+            "returning partition keeps its lane");
+  expect_eq(lanes.lane_of(5), std::optional<std::size_t>{0},
+            "new partition goes to the least-loaded lane");
+  expect_eq(lanes.active_partitions(0), std::size_t{2}, "lane 0 load");
+  expect_eq(lanes.active_partitions(1), std::size_t{2}, "lane 1 load");
+}
+
+void test_flow_watermarks_leave_room_for_a_poll() {
+  // Large queue: the percentages decide.
+  const auto shared = FlowWatermarks::for_queue(4096, 100, 80, 40);
+  expect_eq(shared.pause_at, std::size_t{3276}, "shared queue pause point");
+  expect_eq(shared.resume_at, std::size_t{1638}, "shared queue resume point");
+
+  // Small lane: 80% would leave 51 free slots for a poll of 100.
+  const auto lane = FlowWatermarks::for_queue(256, 100, 80, 40);
+  expect_eq(lane.pause_at, std::size_t{156},
+            "lane pauses before a poll can block");
+  expect_eq(lane.resume_at, std::size_t{102}, "lane resume point");
+
+  // Hysteresis: between the two points the current state holds.
+  bool paused = false;
+  for (const auto& [queued, expected] :
+       std::array<std::pair<std::size_t, bool>, 7>{{{150, false},
+                                                    {156, true},
+                                                    {200, true},
+                                                    {103, true},
+                                                    {102, false},
+                                                    {155, false},
+                                                    {0, false}}}) {
+    paused = lane.paused(paused, queued);
+    expect_eq(paused, expected, "lane pause state follows the watermarks");
+  }
+
+  // A poll as large as the queue: pause on anything queued, resume empty.
+  const auto tight = FlowWatermarks::for_queue(256, 256, 80, 40);
+  expect_eq(tight.pause_at, std::size_t{1}, "full-size poll pause point");
+  expect_eq(tight.resume_at, std::size_t{0}, "full-size poll resume point");
+  expect_true(!tight.paused(false, 0), "empty queue stays open");
+  expect_true(tight.paused(true, 1), "queue stays paused until empty");
+}
+
+// The reader's rebalance callback runs to_pause() over each assignment.
+void test_partition_flow_repauses_assigned_partitions() {
+  using Clock = PartitionFlow::Clock;
+  const auto started = Clock::now();
+  const auto shared_queue = [](std::int32_t) -> std::optional<std::size_t> {
+    return 0;
+  };
+
+  // Shared queue over its high watermark when a rebalance assigns partitions.
+  PartitionFlow shared({FlowWatermarks::for_queue(4096, 100, 80, 40)});
+  expect_true(shared.flips(0, 3300), "shared queue over the watermark");
+  (void)shared.set_paused(0, true, started);
+  expect_true(!shared.flips(0, 3300), "paused queue stays paused");
+  const std::array<std::int32_t, 3> assigned{0, 1, 2};
+  expect_eq(shared.to_pause(assigned, shared_queue),
+            std::vector<std::int32_t>{0, 1, 2},
+            "partitions assigned to a paused queue are paused again");
+
+  expect_true(shared.flips(0, 1000), "drained queue resumes");
+  expect_eq(shared.set_paused(0, false, started + std::chrono::seconds{3}),
+            Clock::duration{std::chrono::seconds{3}}, "paused time measured");
+  expect_true(shared.to_pause(assigned, shared_queue).empty(),
+              "partitions of a running queue are left alone");
+
+  // Lanes: only the partitions mapped to the paused lane are paused again.
+  LaneMap lanes(2);
+  lanes.assign({0, 1, 2, 3});
+  PartitionFlow lane_flow({FlowWatermarks::for_queue(256, 100, 80, 40),
+                           FlowWatermarks::for_queue(256, 100, 80, 40)});
+  expect_true(lane_flow.flips(1, 200), "lane 1 over the watermark");
+  (void)lane_flow.set_paused(1, true, started);
+  expect_eq(lane_flow.to_pause(std::array<std::int32_t, 5>{0, 1, 2, 3, 9},
+                               [&lanes](std::int32_t partition) {
+                                 return lanes.lane_of(partition);
+                               }),
+            std::vector<std::int32_t>{1, 3},
+            "only the paused lane's partitions are paused again");
+}
+
 } // namespace
 
 auto main() -> int {
   test_valid_payload_produces_solution();
+  test_padded_payload_is_parsed_in_place();
+  test_load_decoder_follows_dom_lookup_rules();
+  test_batch_decode_matches_single_decodes();
   test_invalid_payloads_produce_no_solution();
   test_waybill_items_are_filtered_and_used();
   test_item_alias_is_supported();
   test_invalid_waybill_date_is_logged_and_skipped();
+  test_repeated_children_log_each_invalid_entry();
   test_route_expansion_thread_override_is_deterministic();
+  test_startup_thread_count_builds_identical_graph();
   test_path_cache_hits_repeated_loads();
+  test_batch_with_invalid_payload_solves_the_rest();
+  test_superseded_loads_are_dropped();
+  test_compactor_ignores_check_order();
+  test_superseded_loads_are_dropped_across_solvers();
+  test_lane_map_balances_new_partitions();
+  test_lane_map_keeps_lanes_under_eager_rebalance();
+  test_lane_map_keeps_lanes_under_cooperative_rebalance();
+  test_flow_watermarks_leave_room_for_a_poll();
+  test_partition_flow_repauses_assigned_partitions();
+  test_file_reader_replays_and_follows_files();
+  test_file_reader_follows_truncation_and_rotation();
+  test_load_capture_round_trips_and_replays(moirai::CaptureCodec::stored);
+  test_load_capture_round_trips_and_replays(moirai::CaptureCodec::zlib);
+  test_load_capture_compresses_on_request();
   return 0;
 }
@@ -535,6 +535,68 @@ void test_reverse_path_selection() {
   expect_eq(missing_path.empty(), true, "unreachable reverse target");
 }
 
+void test_path_validity_intervals() {
+  GraphBuilder graph;
+  const auto x = graph.add_center("X");
+  const auto a = graph.add_center("A");
+  const auto b = graph.add_center("B");
+  (void)graph.solver.add_edge(x, a, TransportEdge{"CUSTODY-X-A", "CUSTODY-X-A"});
+  graph.add_edge(a, b, "A-B", 9 * 60, 60);
+
+  const auto forward = [&](CLOCK start) {
+    return graph.solver
+      .find_path<PathTraversalMode::FORWARD, VehicleType::SURFACE>(x, b, start);
+  };
+  const auto start = iso_to_date("2026-06-08 08:00:00");
+  const auto path = forward(start);
+  expect_not_empty(path, "forward path exists");
+  expect_eq(path.valid_from, start, "forward interval opens at the start");
+  expect_eq(path.valid_until, iso_to_date("2026-06-08 09:00:00"),
+            "forward interval closes at the first departure");
+  expect_eq(path.anchored_begin, std::size_t{0}, "forward anchors a prefix");
+  expect_eq(path.anchored_end, std::size_t{2},
+            "custody hop before the departure is anchored");
+  expect_eq(last_step(forward(path.valid_until)).distance,
+            last_step(path).distance,
+            "arrival holds through the interval");
+  expect_true(last_step(forward(path.valid_until + DURATION{1})).distance >
+                last_step(path).distance,
+              "arrival moves once the departure is missed");
+
+  const auto reverse = [&](CLOCK deadline) {
+    return graph.solver
+      .find_path<PathTraversalMode::REVERSE, VehicleType::SURFACE>(
+        b, x, deadline);
+  };
+  const auto deadline = iso_to_date("2026-06-08 12:00:00");
+  const auto reverse_path = reverse(deadline);
+  expect_not_empty(reverse_path, "reverse path exists");
+  expect_eq(reverse_path.valid_from, iso_to_date("2026-06-08 10:00:00"),
+            "reverse interval opens at the arrival");
+  expect_eq(reverse_path.valid_until, deadline,
+            "reverse interval closes at the deadline");
+  expect_eq(reverse_path.anchored_begin, std::size_t{2},
+            "reverse anchors a suffix");
+  expect_eq(reverse_path.anchored_end, std::size_t{3},
+            "reverse suffix ends at the deadline");
+  expect_eq(reverse(reverse_path.valid_from).front().distance,
+            reverse_path.front().distance,
+            "departure holds through the interval");
+  expect_true(reverse(reverse_path.valid_from - DURATION{1}).front().distance <
+                reverse_path.front().distance,
+              "departure moves once the arrival is too late");
+
+  const auto custody_only =
+    graph.solver.find_path<PathTraversalMode::FORWARD, VehicleType::SURFACE>(
+      x, a, start);
+  expect_eq(custody_only.valid_from, CLOCK::min(),
+            "unscheduled paths hold at every start");
+  expect_eq(custody_only.valid_until, CLOCK::max(),
+            "unscheduled paths never expire");
+  expect_eq(custody_only.anchored_end, custody_only.steps.size(),
+            "every unscheduled step is anchored");
+}
+
 void test_days_of_week_graph_behavior() {
   const auto monday_start = iso_to_date("2026-06-08 08:00:00");
   const auto monday_after = iso_to_date("2026-06-08 10:00:00");
@@ -837,6 +899,176 @@ void test_large_route_edge_spec_expansion() {
               "large route expansion smoke test stays bounded");
 }
 
+void test_bulk_edge_insertion_matches_serial() {
+  constexpr int NODE_COUNT = 160;
+  constexpr std::size_t SPEC_COUNT = 40'000;
+
+  Solver serial;
+  Solver bulk;
+  for (int index = 0; index < NODE_COUNT; ++index) {
+    (void)serial.add_node(TransportCenter{std::format("N{}", index)});
+    (void)bulk.add_node(TransportCenter{std::format("N{}", index)});
+  }
+  const auto custody = TransportEdge{"CUSTODY-N0-N1", "CUSTODY-N0-N1"};
+  (void)serial.add_edge(0, 1, custody);
+  (void)bulk.add_edge(0, 1, custody);
+
+  std::uint32_t state = 12345U;
+  const auto next_random = [&state]() {
+    state = (state * 1'103'515'245U) + 12'345U;
+    return state >> 8U;
+  };
+  std::vector<RouteEdgeSpec> specs;
+  specs.reserve(SPEC_COUNT);
+  for (std::size_t index = 0; index < SPEC_COUNT; ++index) {
+    const auto source = static_cast<int>(next_random() % NODE_COUNT);
+    const auto target = static_cast<int>(next_random() % NODE_COUNT);
+    // Every 7th spec repeats an earlier code, every 101st has an unknown
+    // endpoint, and one reuses the pre-existing custody code.
+    const auto code = index % 7 == 6 ? std::format("E{}", index / 2)
+                      : index == 500 ? custody.code
+                                     : std::format("E{}", index);
+    specs.push_back(RouteEdgeSpec{
+      .source_center_code = index % 101 == 100 ? std::string{"MISSING"}
+                                               : std::format("N{}", source),
+      .target_center_code = std::format("N{}", target),
+      .edge = TransportEdge{
+        code,
+        "bulk",
+        DURATION{static_cast<std::int16_t>(next_random() % 1440)},
+        DURATION{static_cast<std::int16_t>(30 + (next_random() % 600))},
+        DURATION{static_cast<std::int16_t>(next_random() % 30)},
+        DURATION{static_cast<std::int16_t>(next_random() % 30)},
+        VehicleType::SURFACE,
+        MovementType::LINEHAUL,
+        false,
+        static_cast<std::uint8_t>(1U + (next_random() % 127U))},
+    });
+  }
+
+  std::vector<EdgeId> serial_ids;
+  serial_ids.reserve(specs.size());
+  for (const auto& spec : specs) {
+    const auto source = serial.find_node(spec.source_center_code);
+    const auto target = serial.find_node(spec.target_center_code);
+    serial_ids.push_back(source.has_value() && target.has_value()
+                           ? serial.add_edge(*source, *target, spec.edge)
+                           : INVALID_EDGE);
+  }
+  const auto bulk_ids = bulk.add_edges_bulk(specs);
+
+  expect_eq(bulk_ids, serial_ids, "bulk insertion returns serial edge ids");
+  expect_eq(bulk.show_all(), serial.show_all(),
+            "bulk insertion preserves edge order");
+  expect_eq(bulk.graph_stats().max_out_degree,
+            serial.graph_stats().max_out_degree,
+            "bulk CSR matches serial degrees");
+
+  const auto start = CLOCK{std::chrono::minutes{28'000'000}};
+  for (NodeId target = 1; target < 40; ++target) {
+    const auto serial_path =
+      serial.find_path<PathTraversalMode::FORWARD, VehicleType::SURFACE>(
+        0, target, start);
+    const auto bulk_path =
+      bulk.find_path<PathTraversalMode::FORWARD, VehicleType::SURFACE>(
+        0, target, start);
+    expect_eq(node_codes(bulk_path), node_codes(serial_path),
+              "bulk graph forward path matches serial");
+    if (!serial_path.empty()) {
+      expect_eq(bulk_path.back().distance, serial_path.back().distance,
+                "bulk graph forward arrival matches serial");
+    }
+
+    const auto serial_reverse =
+      serial.find_path<PathTraversalMode::REVERSE, VehicleType::SURFACE>(
+        target, 0, start);
+    const auto bulk_reverse =
+      bulk.find_path<PathTraversalMode::REVERSE, VehicleType::SURFACE>(
+        target, 0, start);
+    expect_eq(node_codes(bulk_reverse), node_codes(serial_reverse),
+              "bulk graph reverse path matches serial");
+  }
+}
+
+void test_colocation_hub_matches_direct_custody_edges() {
+  GraphBuilder hub_graph;
+  GraphBuilder pairs_graph;
+  std::vector<NodeId> members;
+  for (auto* graph : {&hub_graph, &pairs_graph}) {
+    graph->add_center("X");
+    graph->add_center("Y");
+    members.clear();
+    for (int index = 0; index < 5; ++index) {
+      members.push_back(graph->add_center(std::format("C{}", index)));
+    }
+    graph->add_edge(0, members[0], "X-C0", 8 * 60, 60);
+    graph->add_edge(members[3], 1, "C3-Y", 10 * 60, 30);
+  }
+  for (const auto source : members) {
+    for (const auto target : members) {
+      if (source == target) {
+        continue;
+      }
+      const auto name = std::format("CUSTODY-C{}-C{}", source - 2, target - 2);
+      (void)pairs_graph.solver.add_edge(source, target,
+                                        TransportEdge{name, name});
+    }
+  }
+  expect_eq(hub_graph.solver.add_colocation_group("P1", members),
+            std::size_t{10}, "hub adds one edge in and out per member");
+
+  const auto stats = hub_graph.solver.graph_stats();
+  expect_eq(stats.colocation_hubs, std::size_t{1}, "one hub per group");
+  expect_eq(stats.custody_edges, std::size_t{10}, "hub custody edges");
+  expect_eq(stats.custody_edges_saved, std::size_t{10},
+            "hub saves all-pairs edges");
+
+  const auto start = iso_to_date("2026-06-08 07:00:00");
+  const auto deadline = iso_to_date("2026-06-08 12:00:00");
+  for (auto* graph : {&hub_graph, &pairs_graph}) {
+    const auto forward =
+      graph->solver.find_path<PathTraversalMode::FORWARD,
+                              VehicleType::SURFACE>(0, 1, start);
+    expect_not_empty(forward, "forward path across campus");
+    expect_eq(node_codes(forward),
+              std::vector<std::string>({"X", "C0", "C3", "Y"}),
+              "forward path hides the hub");
+    expect_eq(edge_codes(forward),
+              std::vector<std::string>({"X-C0", "CUSTODY-C0-C3", "C3-Y"}),
+              "forward path reports the direct custody hop");
+    expect_eq(minutes_between(last_step(forward).distance, start),
+              (3 * 60) + 30, "custody hop is free");
+
+    const auto reverse =
+      graph->solver.find_path<PathTraversalMode::REVERSE,
+                              VehicleType::SURFACE>(1, 0, deadline);
+    expect_not_empty(reverse, "reverse path across campus");
+    expect_eq(node_codes(reverse),
+              std::vector<std::string>({"X", "C0", "C3", "Y"}),
+              "reverse path hides the hub");
+    expect_eq(edge_codes(reverse),
+              std::vector<std::string>({"X-C0", "CUSTODY-C0-C3", "C3-Y"}),
+              "reverse path reports the direct custody hop");
+    expect_eq(minutes_between(deadline, reverse.front().distance), 4 * 60,
+              "reverse latest departure is unchanged");
+    expect_eq(reverse.anchored_begin, std::size_t{3},
+              "anchored range skips the collapsed hub");
+    expect_eq(reverse.anchored_end, std::size_t{4},
+              "anchored range ends at the deadline");
+  }
+
+  GraphBuilder small_graph;
+  const std::array<NodeId, 3> small_members{
+    small_graph.add_center("S0"), small_graph.add_center("S1"),
+    small_graph.add_center("S2")};
+  expect_eq(small_graph.solver.add_colocation_group("P2", small_members),
+            std::size_t{6}, "small groups keep direct custody edges");
+  expect_true(small_graph.solver.find_edge("CUSTODY-S0-S2").has_value(),
+              "direct custody edge exists");
+  expect_eq(small_graph.solver.graph_stats().colocation_hubs, std::size_t{0},
+            "small groups get no hub");
+}
+
 void test_real_route_fixture_edge_expansion() {
   const auto fixture = load_json_fixture("real_routes.json");
   const auto* routes = moirai::find_array_member(fixture, "data");
@@ -959,10 +1191,13 @@ auto main() -> int {
   test_concurrent_lazy_csr_rebuild_is_thread_safe();
   test_forward_path_selection();
   test_reverse_path_selection();
+  test_path_validity_intervals();
   test_days_of_week_graph_behavior();
   test_vehicle_filtering();
   test_route_edge_spec_expansion();
   test_large_route_edge_spec_expansion();
+  test_bulk_edge_insertion_matches_serial();
+  test_colocation_hub_matches_direct_custody_edges();
   test_real_route_fixture_edge_expansion();
   test_real_route_fixture_scheduled_paths();
   return 0;
@@ -1,5 +1,12 @@
 #include "blocking_queue.hxx"
+#include "concurrent_cache.hxx"
+#include "heavy_hitters.hxx"
+#include "packed_key_cache.hxx"
+#include "single_flight.hxx"
+#include "work_stealing_executor.hxx"
 #include <nlohmann/json.hpp>
+#include <stdlib.h>
+#include <unistd.h>
 #include "test_helpers.hxx"
 
 import std;
@@ -65,7 +72,7 @@ auto add_edge(Solver& solver, NodeId source, NodeId target,
 }
 
 auto make_wrapper(std::shared_ptr<Solver> solver,
-                  std::shared_ptr<PathCache> cache = nullptr) -> SolverWrapper {
+                  SolverWrapper::SharedState shared = {}) -> SolverWrapper {
   static const auto timings_path =
     std::filesystem::temp_directory_path() / "moirae-wrapper-empty-timings.json";
   static std::once_flag timings_once;
@@ -82,7 +89,7 @@ auto make_wrapper(std::shared_ptr<Solver> solver,
     .load = &load_queue,
     .solution = &solution_queue,
   };
-  return SolverWrapper(queues, solver, timings_path, std::move(cache));
+  return SolverWrapper(queues, solver, timings_path, std::move(shared));
 }
 
 void test_find_paths_non_critical_returns_earliest_and_ultimate() {
@@ -105,11 +112,11 @@ void test_find_paths_non_critical_returns_earliest_and_ultimate() {
 
   expect_eq(response.waybill, std::string{"bag"}, "waybill copied");
   expect_eq(response.is_critical, false, "non-critical flag");
-  expect_true(!response.earliest.locations.empty(), "earliest path present");
-  expect_true(!response.ultimate.locations.empty(), "ultimate path present");
-  expect_eq(response.earliest.locations.size(), std::size_t{2},
+  expect_true(!response.earliest.empty(), "earliest path present");
+  expect_true(!response.ultimate.empty(), "ultimate path present");
+  expect_eq(response.earliest.size(), std::size_t{2},
             "earliest has source and target");
-  expect_eq(response.ultimate.locations.size(), std::size_t{2},
+  expect_eq(response.ultimate.size(), std::size_t{2},
             "ultimate has source and target");
   expect_eq(response.pdd_ts,
             static_cast<std::int64_t>(
@@ -138,10 +145,10 @@ void test_find_paths_critical_omits_ultimate() {
     DURATION{0},
     packages);
 
-  expect_true(!response.earliest.locations.empty(),
+  expect_true(!response.earliest.empty(),
               "critical still returns earliest");
   expect_eq(response.is_critical, true, "critical flag");
-  expect_eq(response.ultimate.locations.empty(), true,
+  expect_eq(response.ultimate.empty(), true,
             "critical path omits ultimate");
 }
 
@@ -167,6 +174,62 @@ void test_find_paths_missing_node_returns_fail() {
   expect_eq(response.is_critical, true, "missing node critical flag");
   expect_true(logs.contains("Pathing failed"), "missing node debug log");
   moirai::Application::instance().logger().set_level("information");
+
+  // A second solver thread counts into the same sketch.
+  auto secondary = make_wrapper(
+    solver, {.missing_facilities = wrapper.get_missing_facility_sketch()});
+  (void)secondary.find_paths("bag-2",
+                             "A",
+                             "missing",
+                             epoch_minutes("2026-06-08 08:00:00"),
+                             DURATION{0},
+                             iso_to_date("2026-06-08 12:00:00"),
+                             DURATION{0},
+                             packages);
+  const auto missing = wrapper.missing_facilities(5);
+  expect_eq(missing.size(), std::size_t{1}, "one missing facility tracked");
+  expect_eq(missing.front().code, std::string{"missing"},
+            "missing facility code exported");
+  expect_eq(missing.front().loads, std::uint64_t{2},
+            "loads per missing facility counted across solver threads");
+  add_center(*solver, "missing");
+  expect_true(wrapper.missing_facilities(5).empty(),
+              "facilities added since are no longer reported");
+}
+
+// The server has no runtime graph update path yet, so this changes the
+// Solver directly, as such a path would.
+void test_find_paths_unreachable_pair_cached_until_graph_changes() {
+  auto solver = std::make_shared<Solver>();
+  const auto a = add_center(*solver, "A");
+  const auto b = add_center(*solver, "B");
+  auto cache = std::make_shared<PathCache>(16);
+  auto wrapper = make_wrapper(solver, {.path_cache = cache});
+
+  std::vector<std::tuple<std::string, int32_t, std::string>> packages;
+  const auto find = [&](std::string bag) {
+    return wrapper.find_paths(std::move(bag),
+                              "A",
+                              "B",
+                              epoch_minutes("2026-06-08 08:00:00"),
+                              DURATION{0},
+                              iso_to_date("2026-06-08 12:00:00"),
+                              DURATION{0},
+                              packages);
+  };
+
+  expect_true(find("bag-1").earliest.empty(), "unconnected pair has no path");
+  expect_true(find("bag-2").earliest.empty(), "still no path");
+  expect_eq(cache->solves.load(), std::uint64_t{1},
+            "the unreachable result is served from the cache");
+  expect_eq(cache->unreachable_hits.load(), std::uint64_t{1},
+            "unreachable hits counted");
+
+  add_edge(*solver, a, b, "A-B", 9 * 60, 60);
+  expect_true(!find("bag-3").earliest.empty(),
+              "a new edge invalidates the unreachable result");
+  expect_eq(cache->solves.load(), std::uint64_t{3},
+            "forward and ultimate solved on the new graph");
 }
 
 void test_find_paths_child_can_make_parent_critical() {
@@ -193,10 +256,10 @@ void test_find_paths_child_can_make_parent_critical() {
 
   expect_eq(response.package_id, std::string{"child"},
             "package id comes from child");
-  expect_true(!response.earliest.locations.empty(),
+  expect_true(!response.earliest.empty(),
               "child critical returns earliest");
   expect_eq(response.is_critical, true, "child critical flag");
-  expect_eq(response.ultimate.locations.empty(), true,
+  expect_eq(response.ultimate.empty(), true,
             "child critical omits ultimate");
 }
 
@@ -271,6 +334,618 @@ void test_find_paths_mixed_bag_processing_can_make_parent_critical() {
             "mixed bag processing can consume parent slack");
 }
 
+void test_find_paths_fans_out_large_loads() {
+  auto solver = std::make_shared<Solver>();
+  const auto a = add_center(*solver, "A");
+  const auto b = add_center(*solver, "B");
+  const auto c = add_center(*solver, "C");
+  const auto d = add_center(*solver, "D");
+  add_edge(*solver, a, b, "A-B", 9 * 60, 60);
+  add_edge(*solver, b, c, "B-C", 14 * 60, 60);
+  add_edge(*solver, b, d, "B-D", 16 * 60, 60);
+
+  // 300 distinct deadlines, each child listed twice, plus one child whose
+  // destination is unknown.
+  std::vector<std::tuple<std::string, int32_t, std::string>> packages;
+  for (int index = 0; index < 600; ++index) {
+    packages.emplace_back((index / 2) % 2 == 0 ? "C" : "D",
+                          epoch_minutes("2026-06-09 18:00:00") + (index / 2),
+                          std::format("child-{}", index));
+  }
+  packages.emplace_back("missing", epoch_minutes("2026-06-08 12:00:00"),
+                        "child-missing");
+
+  const auto find = [&](const char* min_children) {
+    (void)::setenv("MOIRAI_LOAD_FANOUT_MIN_CHILDREN", min_children, 1);
+    (void)::setenv("MOIRAI_LOAD_FANOUT_THREADS", "2", 1);
+    auto wrapper = make_wrapper(
+      solver, {.path_cache = std::make_shared<PathCache>(1'024)});
+    // Secondary solvers split their loads over the primary's pool.
+    const auto secondary = make_wrapper(solver, wrapper.shared_state());
+    expect_true(secondary.get_load_fanout() == wrapper.get_load_fanout(),
+                "one fan-out pool is shared across wrappers");
+    (void)::unsetenv("MOIRAI_LOAD_FANOUT_MIN_CHILDREN");
+    (void)::unsetenv("MOIRAI_LOAD_FANOUT_THREADS");
+    auto response = wrapper.find_paths("bag",
+                                       "A",
+                                       "B",
+                                       epoch_minutes("2026-06-08 08:00:00"),
+                                       DURATION{0},
+                                       iso_to_date("2026-06-10 00:00:00"),
+                                       DURATION{0},
+                                       packages);
+    return std::pair{ response, wrapper.get_cache()->solves.load() };
+  };
+
+  const auto [serial, serial_solves] = find("0");
+  const auto [split, split_solves] = find("2");
+  expect_eq(serial.pdd_ts,
+            std::int64_t{epoch_minutes("2026-06-09 14:00:00")} * 60,
+            "earliest child deadline wins");
+  expect_eq(split.pdd_ts, serial.pdd_ts,
+            "split load reduces to the same deadline");
+  expect_eq(split.is_critical, serial.is_critical, "same critical flag");
+  expect_eq(split.package_id, std::string{"child-0"},
+            "package id still comes from the first child");
+  expect_eq(serial_solves, std::uint64_t{4},
+            "one reverse solve per child destination, latest deadline first");
+  expect_true(split_solves >= serial_solves, "split load solves every part");
+}
+
+void test_find_paths_cache_hit_shares_compact_path() {
+  auto solver = std::make_shared<Solver>();
+  const auto a = add_center(*solver, "A");
+  const auto b = add_center(*solver, "B");
+  add_edge(*solver, a, b, "A-B", 9 * 60, 60);
+  auto cache = std::make_shared<PathCache>(16);
+  auto wrapper = make_wrapper(solver, {.path_cache = cache});
+
+  std::vector<std::tuple<std::string, int32_t, std::string>> packages;
+  const auto find = [&](std::string bag) {
+    return wrapper.find_paths(std::move(bag),
+                              "A",
+                              "B",
+                              epoch_minutes("2026-06-08 08:00:00"),
+                              DURATION{0},
+                              iso_to_date("2026-06-08 12:00:00"),
+                              DURATION{0},
+                              packages);
+  };
+  const auto miss = find("bag-miss");
+  const auto hit = find("bag-hit");
+
+  expect_true(cache->metrics().hits >= 2, "second lookup hits the cache");
+  expect_true(miss.earliest.path != nullptr, "earliest holds a path handle");
+  expect_true(miss.earliest.path == hit.earliest.path,
+              "cache hit shares the earliest path");
+  expect_true(miss.ultimate.path == hit.ultimate.path,
+              "cache hit shares the ultimate path");
+
+  const auto earliest = hit.earliest.expand();
+  expect_eq(earliest.size(), std::size_t{2}, "expanded earliest hops");
+  expect_eq(earliest.front().code, std::string{"A"}, "expanded source code");
+  expect_eq(earliest.front().route, std::string{"A-B"},
+            "expanded outbound route");
+  expect_eq(earliest.front().has_departure, true,
+            "source hop has a departure");
+  expect_eq(earliest.back().code, std::string{"B"}, "expanded target code");
+  expect_eq(earliest.back().has_departure, false,
+            "target hop has no departure");
+}
+
+void test_find_paths_cache_intervals_cover_later_starts() {
+  auto solver = std::make_shared<Solver>();
+  const auto a = add_center(*solver, "A");
+  const auto b = add_center(*solver, "B");
+  add_edge(*solver, a, b, "A-B", 9 * 60, 60);
+  auto cache = std::make_shared<PathCache>(16);
+  auto wrapper = make_wrapper(solver, {.path_cache = cache});
+
+  std::vector<std::tuple<std::string, int32_t, std::string>> packages;
+  const auto find = [&](std::string bag, std::string_view start) {
+    return wrapper.find_paths(std::move(bag),
+                              "A",
+                              "B",
+                              epoch_minutes(start),
+                              DURATION{0},
+                              iso_to_date("2026-06-08 12:00:00"),
+                              DURATION{0},
+                              packages);
+  };
+  const auto arrival_ts = [](std::string_view timestamp) {
+    return std::int64_t{epoch_minutes(timestamp)} * 60;
+  };
+
+  (void)find("bag-solved", "2026-06-08 08:00:00");
+  const auto later = find("bag-later", "2026-06-08 08:40:00");
+  expect_eq(cache->metrics().hits, std::uint64_t{2},
+            "a later start before the departure reuses both solves");
+  expect_eq(cache->metrics().misses, std::uint64_t{2},
+            "only the first load solved");
+  const auto earliest = later.earliest.expand();
+  expect_eq(earliest.front().arrival_ts, arrival_ts("2026-06-08 08:40:00"),
+            "cached source hop is re-timed to the query start");
+  expect_eq(earliest.back().arrival_ts, arrival_ts("2026-06-08 10:00:00"),
+            "cached arrival is unchanged");
+
+  const auto missed = find("bag-missed", "2026-06-08 09:01:00");
+  expect_eq(missed.is_critical, true,
+            "a start after the departure is solved again");
+  const auto intervals =
+    cache->find(*make_path_cache_key(
+      PathTraversalMode::FORWARD, VehicleType::SURFACE, a, b));
+  expect_true(intervals.has_value(), "forward pair is cached");
+  expect_eq(intervals->size(), std::size_t{2},
+            "the pair holds one interval per departure");
+}
+
+void test_find_paths_coalesces_concurrent_misses() {
+  auto solver = std::make_shared<Solver>();
+  const auto a = add_center(*solver, "A");
+  const auto b = add_center(*solver, "B");
+  add_edge(*solver, a, b, "A-B", 9 * 60, 60);
+  auto cache = std::make_shared<PathCache>(16);
+  auto wrapper = make_wrapper(solver, {.path_cache = cache});
+  const auto key = *make_path_cache_key(
+    PathTraversalMode::FORWARD, VehicleType::SURFACE, a, b);
+
+  // The bag is already late, so only the forward path is looked up.
+  std::vector<std::tuple<std::string, int32_t, std::string>> packages;
+  const auto find = [&](std::string_view start) {
+    return wrapper.find_paths("bag",
+                              "A",
+                              "B",
+                              epoch_minutes(start),
+                              DURATION{0},
+                              iso_to_date("2026-06-08 09:30:00"),
+                              DURATION{0},
+                              packages);
+  };
+
+  SearchDocument coalesced;
+  {
+    auto leader = cache->inflight.join(key, std::chrono::milliseconds{0});
+    expect_true(leader.leader(), "first join leads");
+    std::jthread follower(
+      [&] { coalesced = find("2026-06-08 08:00:00"); });
+    while (cache->inflight.metrics().coalesced_waits == 0) {
+      std::this_thread::yield();
+    }
+    const auto start = iso_to_date("2026-06-08 08:00:00");
+    const auto path =
+      solver->find_path<PathTraversalMode::FORWARD, VehicleType::SURFACE>(
+        a, b, start);
+    cache->update(key, [&](const PathCacheIntervals* current) {
+      return merge_path_interval(
+        current,
+        make_path_cache_interval(PathTraversalMode::FORWARD, path, start),
+        PathTraversalMode::FORWARD);
+    });
+    leader = SingleFlight::Ticket{};
+  }
+  expect_eq(cache->solves.load(), std::uint64_t{0},
+            "the waiting miss reuses the leader's solve");
+  expect_true(!coalesced.earliest.empty(), "coalesced miss returns a path");
+  expect_eq(cache->metrics().misses, std::uint64_t{1},
+            "re-reading after the wait is not a second miss");
+
+  const auto stuck = cache->inflight.join(key, std::chrono::milliseconds{0});
+  const auto timed_out = find("2026-06-08 09:30:00");
+  expect_eq(cache->inflight.metrics().timeouts, std::uint64_t{1},
+            "a stuck leader times the wait out");
+  expect_eq(cache->solves.load(), std::uint64_t{1},
+            "the timed-out miss solves on its own");
+  expect_true(!timed_out.earliest.empty(), "timed-out miss returns a path");
+}
+
+void test_prefetcher_solves_next_interval_of_hot_pairs() {
+  auto solver = std::make_shared<Solver>();
+  const auto a = add_center(*solver, "A");
+  const auto b = add_center(*solver, "B");
+  add_edge(*solver, a, b, "A-B", 9 * 60, 60);
+  auto cache = std::make_shared<PathCache>(16);
+  // Every lookup reaches the sketch, so one load makes its pairs hot.
+  cache->hot_keys.set_sample_period(1);
+  auto wrapper = make_wrapper(solver, {.path_cache = cache});
+
+  std::vector<std::tuple<std::string, int32_t, std::string>> packages;
+  const auto find = [&](std::string_view start) {
+    return wrapper.find_paths("bag",
+                              "A",
+                              "B",
+                              epoch_minutes(start),
+                              DURATION{0},
+                              iso_to_date("2026-06-08 12:00:00"),
+                              DURATION{0},
+                              packages);
+  };
+  // Covers starts up to the 09:00 departure.
+  (void)find("2026-06-08 08:00:00");
+  const auto solves_before = cache->solves.load();
+
+  expect_true(wrapper.prefetch_hot_pairs({}) > 0,
+              "idle prefetch solves ahead for the hot pair");
+  expect_eq(cache->prefetched.load(), cache->solves.load() - solves_before,
+            "every prefetch solve is counted");
+  expect_eq(wrapper.prefetch_hot_pairs({}), std::size_t{0},
+            "a second pass finds the horizon covered");
+
+  const auto solves_after_prefetch = cache->solves.load();
+  const auto late = find("2026-06-08 10:00:00");
+  expect_true(!late.earliest.empty(), "start after the departure is served");
+  expect_eq(cache->solves.load(), solves_after_prefetch,
+            "the later start hits the prefetched interval");
+  expect_eq(cache->prefetch_hits.load(), std::uint64_t{1},
+            "prefetched interval hit once");
+  (void)find("2026-06-08 10:05:00");
+  expect_eq(cache->prefetch_hits.load(), std::uint64_t{1},
+            "each prefetched interval counts one hit");
+
+  HeavyHitters<int> hitters(8, 2);
+  for (int round = 0; round < 100; ++round) {
+    hitters.record(7, round);
+    hitters.record(static_cast<std::uint64_t>(1000 + round), round);
+  }
+  const auto top = hitters.top(1);
+  expect_eq(top.front().key, std::uint64_t{7}, "frequent key stays tracked");
+  expect_eq(top.front().payload, 99, "latest payload kept");
+
+  HeavyHitters<int> sampled(8, 2, 3);
+  for (int round = 0; round < 400; ++round) {
+    sampled.record(7, round);
+  }
+  expect_eq(sampled.top(1).front().count, std::uint64_t{400},
+            "sampled records are weighted by the period");
+}
+
+void test_find_paths_continues_bag_itinerary_on_rescan() {
+  auto solver = std::make_shared<Solver>();
+  const auto a = add_center(*solver, "A");
+  const auto b = add_center(*solver, "B");
+  const auto c = add_center(*solver, "C");
+  add_edge(*solver, a, b, "A-B", 9 * 60, 60);
+  add_edge(*solver, b, c, "B-C", 12 * 60, 60);
+  auto cache = std::make_shared<PathCache>(16);
+  auto wrapper = make_wrapper(solver, {.path_cache = cache});
+  const auto itineraries = wrapper.get_itineraries();
+  expect_true(itineraries != nullptr, "itinerary cache enabled by default");
+  // Re-scans land on any solver thread; secondaries share the primary's
+  // itineraries.
+  auto secondary = make_wrapper(
+    solver, {.path_cache = cache, .itineraries = itineraries});
+  expect_true(secondary.get_itineraries() == itineraries,
+              "secondary wrapper shares the itinerary cache");
+
+  std::vector<std::tuple<std::string, int32_t, std::string>> packages;
+  const auto scan = [&](std::string_view facility,
+                        std::string_view start,
+                        SolverWrapper* on = nullptr) {
+    auto& scanner = on != nullptr ? *on : wrapper;
+    return scanner.find_paths("bag-route",
+                              std::string{facility},
+                              "C",
+                              epoch_minutes(start),
+                              DURATION{0},
+                              iso_to_date("2026-06-09 20:00:00"),
+                              DURATION{0},
+                              packages);
+  };
+  const auto arrival_ts = [](std::string_view timestamp) {
+    return std::int64_t{epoch_minutes(timestamp)} * 60;
+  };
+
+  (void)scan("A", "2026-06-08 08:00:00");
+  const auto solves = cache->solves.load();
+  expect_eq(itineraries->misses.load(), std::uint64_t{1},
+            "first scan of a bag is an itinerary miss");
+
+  // Predicted at B at 10:00; 10:30 still makes the 12:00 departure.
+  const auto on_time = scan("B", "2026-06-08 10:30:00", &secondary);
+  expect_eq(itineraries->hits.load(), std::uint64_t{1},
+            "on-time re-scan on another thread continues the stored path");
+  expect_eq(cache->solves.load(), solves, "no search for an on-time re-scan");
+  const auto earliest = on_time.earliest.expand();
+  expect_eq(earliest.size(), std::size_t{2}, "suffix starts at the scan");
+  expect_eq(earliest.front().code, std::string{"B"}, "suffix source code");
+  expect_eq(earliest.front().arrival_ts, arrival_ts("2026-06-08 10:30:00"),
+            "suffix source hop is re-timed to the scan");
+  expect_eq(earliest.back().arrival_ts, arrival_ts("2026-06-08 13:00:00"),
+            "suffix arrival is unchanged");
+  expect_eq(on_time.ultimate.size(), std::size_t{2},
+            "ultimate suffix starts at the scan");
+
+  const auto late = scan("B", "2026-06-08 12:30:00");
+  expect_eq(itineraries->deviations.load(), std::uint64_t{1},
+            "a scan past the next departure deviates");
+  expect_true(cache->solves.load() > solves, "a deviating scan is solved");
+  expect_eq(late.earliest.expand().back().arrival_ts,
+            arrival_ts("2026-06-09 13:00:00"),
+            "the late bag takes the next day's departure");
+
+  (void)scan("B", "2026-06-08 11:00:00");
+  expect_eq(itineraries->deviations.load(), std::uint64_t{2},
+            "a scan earlier than predicted is solved");
+  (void)scan("D", "2026-06-08 11:00:00");
+  expect_eq(itineraries->hits.load(), std::uint64_t{1},
+            "an unknown facility never continues an itinerary");
+}
+
+void test_path_cache_snapshot_round_trip() {
+  // Five co-located members get a hub, so the X-Y path crosses a custody hop
+  // that is not a graph edge.
+  const auto build = [](bool extra_edge) {
+    auto solver = std::make_shared<Solver>();
+    const auto x = add_center(*solver, "X");
+    const auto y = add_center(*solver, "Y");
+    std::vector<NodeId> members;
+    for (int index = 0; index < 5; ++index) {
+      members.push_back(add_center(*solver, std::format("C{}", index)));
+    }
+    add_edge(*solver, x, members[0], "X-C0", 8 * 60, 60);
+    add_edge(*solver, members[3], y, "C3-Y", 10 * 60, 30);
+    (void)solver->add_colocation_group("P1", members);
+    if (extra_edge) {
+      add_edge(*solver, y, x, "Y-X", 12 * 60, 30);
+    }
+    solver->finalize_graph();
+    return std::make_tuple(solver, x, y);
+  };
+
+  const auto [solver, x, y] = build(false);
+  PathCache cache(64);
+  const auto start = iso_to_date("2026-06-08 07:00:00");
+  const auto deadline = iso_to_date("2026-06-08 12:00:00");
+  const auto forward_key = *make_path_cache_key(
+    PathTraversalMode::FORWARD, VehicleType::SURFACE, x, y);
+  const auto reverse_key = *make_path_cache_key(
+    PathTraversalMode::REVERSE, VehicleType::SURFACE, y, x);
+  const auto unreachable_key = *make_path_cache_key(
+    PathTraversalMode::FORWARD, VehicleType::SURFACE, y, x);
+  cache.insert(forward_key,
+               { make_path_cache_interval(
+                 PathTraversalMode::FORWARD,
+                 solver->find_path<PathTraversalMode::FORWARD,
+                                   VehicleType::SURFACE>(x, y, start),
+                 start) });
+  cache.insert(reverse_key,
+               { make_path_cache_interval(
+                 PathTraversalMode::REVERSE,
+                 solver->find_path<PathTraversalMode::REVERSE,
+                                   VehicleType::SURFACE>(y, x, deadline),
+                 deadline) });
+  cache.insert(unreachable_key,
+               { make_path_cache_interval(
+                 PathTraversalMode::FORWARD,
+                 solver->find_path<PathTraversalMode::FORWARD,
+                                   VehicleType::SURFACE>(y, x, start),
+                 start) });
+
+  const auto snapshot =
+    std::filesystem::temp_directory_path() /
+    std::format("moirai-path-cache-snapshot-{}.bin", ::getpid());
+  const auto saved = save_path_cache(cache, *solver, snapshot);
+  expect_true(saved.has_value(), "snapshot saved");
+  expect_eq(saved->entries, std::size_t{3}, "every cached key saved");
+  expect_eq(saved->intervals, std::size_t{3}, "every interval saved");
+
+  const auto [restarted, restarted_x, restarted_y] = build(false);
+  PathCache warm(64);
+  const auto loaded = load_path_cache(warm, *restarted, snapshot, 4);
+  expect_true(loaded.has_value(), "snapshot loads on an identical graph");
+  expect_eq(loaded->entries, std::size_t{3}, "every key loaded");
+  expect_eq(loaded->corrupt_blocks, std::size_t{0}, "no corrupt blocks");
+  expect_eq(loaded->bytes, saved->bytes, "whole snapshot read");
+
+  for (const auto key : { forward_key, reverse_key, unreachable_key }) {
+    const auto original = cache.find(key);
+    const auto reloaded = warm.find(key);
+    expect_true(reloaded.has_value(), "snapshot key cached after load");
+    expect_eq(reloaded->size(), original->size(), "interval count kept");
+    const auto& before = original->front();
+    const auto& after = reloaded->front();
+    expect_true(after.valid_from == before.valid_from &&
+                  after.valid_until == before.valid_until &&
+                  after.solved_at == before.solved_at,
+                "validity interval kept");
+    expect_eq(after.anchored_begin, before.anchored_begin,
+              "anchored begin kept");
+    expect_eq(after.anchored_end, before.anchored_end, "anchored end kept");
+    expect_eq(after.entry.found, before.entry.found, "found flag kept");
+    expect_true(after.entry.first_distance == before.entry.first_distance &&
+                  after.entry.last_distance == before.entry.last_distance,
+                "path times kept");
+    if (before.entry.path == nullptr) {
+      expect_true(after.entry.path == nullptr, "unreachable stays pathless");
+      continue;
+    }
+    expect_eq(after.entry.path->mode, before.entry.path->mode, "mode kept");
+    expect_eq(after.entry.path->hops.size(), before.entry.path->hops.size(),
+              "hop count kept");
+    for (std::size_t index = 0; index < before.entry.path->hops.size();
+         ++index) {
+      const auto& old_hop = before.entry.path->hops[index];
+      const auto& new_hop = after.entry.path->hops[index];
+      expect_eq(new_hop.node->code, old_hop.node->code, "hop node kept");
+      expect_true(new_hop.node == restarted->node_record(
+                                    restarted->node_id(new_hop.node)),
+                  "hop node points into the new graph");
+      expect_true(new_hop.distance == old_hop.distance, "hop time kept");
+      expect_eq(new_hop.outbound == nullptr, old_hop.outbound == nullptr,
+                "hop outbound presence kept");
+      if (old_hop.outbound != nullptr) {
+        expect_eq(new_hop.outbound->code, old_hop.outbound->code,
+                  "hop outbound edge kept");
+      }
+    }
+  }
+  expect_eq(warm.find(forward_key)->front().entry.path->hops[1].outbound->code,
+            std::string{"CUSTODY-C0-C3"}, "custody hop rebuilt on load");
+
+  const auto [changed, changed_x, changed_y] = build(true);
+  expect_true(changed->graph_fingerprint() != solver->graph_fingerprint(),
+              "an added edge changes the fingerprint");
+  PathCache cold(64);
+  expect_true(!load_path_cache(cold, *changed, snapshot).has_value(),
+              "snapshot of another graph is rejected");
+  expect_eq(cold.metrics().occupied, std::size_t{0},
+            "rejected snapshot leaves the cache empty");
+  std::filesystem::remove(snapshot);
+}
+
+void test_path_cache_interval_merging() {
+  const auto minute = [](std::uint32_t value) {
+    return CLOCK{CLOCK::duration{value}};
+  };
+  const auto interval = [&](std::uint32_t from, std::uint32_t until,
+                            std::uint32_t arrival) {
+    PathCacheInterval result;
+    result.valid_from = minute(from);
+    result.valid_until = minute(until);
+    result.solved_at = minute(from);
+    result.entry.found = true;
+    result.entry.first_distance = minute(from);
+    result.entry.last_distance = minute(arrival);
+    return result;
+  };
+
+  auto intervals = merge_path_interval(
+    nullptr, interval(0, 10, 100), PathTraversalMode::FORWARD);
+  intervals = merge_path_interval(
+    &intervals, interval(5, 20, 100), PathTraversalMode::FORWARD);
+  expect_eq(intervals.size(), std::size_t{1},
+            "overlapping intervals with one arrival are joined");
+  expect_eq(intervals.front().valid_from, minute(0), "joined lower bound");
+  expect_eq(intervals.front().valid_until, minute(20), "joined upper bound");
+  expect_eq(intervals.front().solved_at, minute(5),
+            "joined interval keeps the path feasible the longest");
+
+  intervals = merge_path_interval(
+    &intervals, interval(30, 40, 200), PathTraversalMode::FORWARD);
+  expect_eq(intervals.size(), std::size_t{2}, "disjoint intervals are kept");
+  expect_true(find_path_interval(intervals, minute(25)) == nullptr,
+              "gaps between intervals miss");
+  expect_eq(find_path_interval(intervals, minute(35))->entry.last_distance,
+            minute(200),
+            "lookup picks the containing interval");
+
+  intervals = merge_path_interval(
+    &intervals, interval(15, 35, 300), PathTraversalMode::FORWARD);
+  expect_eq(intervals.size(), std::size_t{1},
+            "disagreeing overlaps are replaced");
+
+  for (std::uint32_t index = 0; index < 2 * PATH_CACHE_MAX_INTERVALS;
+       ++index) {
+    intervals = merge_path_interval(&intervals,
+                                    interval(1'000 + (index * 10),
+                                             1'005 + (index * 10),
+                                             5'000 + index),
+                                    PathTraversalMode::FORWARD);
+  }
+  expect_eq(intervals.size(), PATH_CACHE_MAX_INTERVALS,
+            "intervals per pair stay bounded");
+  expect_true(find_path_interval(intervals, minute(1'000)) == nullptr,
+              "the interval furthest from the newest is dropped");
+  expect_true(std::ranges::is_sorted(intervals, std::less<>{},
+                                     &PathCacheInterval::valid_from),
+              "intervals stay ordered");
+}
+
+void test_path_cache_packed_keys_and_batched_lookup() {
+  const auto forward = make_path_cache_key(
+    PathTraversalMode::FORWARD, VehicleType::SURFACE, 3, 7);
+  const auto reverse = make_path_cache_key(
+    PathTraversalMode::REVERSE, VehicleType::SURFACE, 3, 7);
+  const auto swapped = make_path_cache_key(
+    PathTraversalMode::FORWARD, VehicleType::SURFACE, 7, 3);
+  expect_true(forward.has_value() && reverse.has_value() &&
+                swapped.has_value(),
+              "in-range queries pack into keys");
+  expect_true(*forward != *reverse && *forward != *swapped,
+              "mode and direction are part of the key");
+  expect_true(!make_path_cache_key(PathTraversalMode::FORWARD,
+                                   VehicleType::SURFACE,
+                                   1U << 29U,
+                                   7)
+                 .has_value(),
+              "oversized node ids are not cached");
+  expect_true(*make_path_cache_key(PathTraversalMode::FORWARD,
+                                   static_cast<VehicleType>(0),
+                                   0,
+                                   1) > PathCache::TOMBSTONE_KEY,
+              "low node ids do not collide with reserved keys");
+
+  PathCache cache(64, 4);
+  for (NodeId source = 0; source < 256; ++source) {
+    PathCacheInterval interval;
+    interval.entry.found = true;
+    interval.entry.first_distance = CLOCK{CLOCK::duration{source}};
+    cache.insert(*make_path_cache_key(PathTraversalMode::FORWARD,
+                                      VehicleType::SURFACE,
+                                      source,
+                                      2),
+                 PathCacheIntervals{interval});
+  }
+  expect_true(cache.metrics().evictions > 0, "full shards evict");
+  expect_true(cache.metrics().occupied <= 64 + 4, "occupancy stays bounded");
+
+  const std::array<std::uint64_t, 3> keys{
+    *make_path_cache_key(
+      PathTraversalMode::FORWARD, VehicleType::SURFACE, 9, 9),
+    *make_path_cache_key(
+      PathTraversalMode::FORWARD, VehicleType::SURFACE, 255, 2),
+    *make_path_cache_key(
+      PathTraversalMode::REVERSE, VehicleType::SURFACE, 255, 2),
+  };
+  std::array<std::optional<PathCacheIntervals>, 3> results;
+  cache.find_many(keys, results);
+  expect_true(!results[0].has_value(), "batched lookup reports misses");
+  expect_true(results[1].has_value(), "batched lookup finds latest entry");
+  expect_eq(results[1]->front().entry.first_distance.time_since_epoch().count(),
+            255U,
+            "batched lookup returns the entry for its key");
+  expect_true(!results[2].has_value(), "batched lookup keeps result order");
+}
+
+template <typename Cache>
+auto hot_keys_after_scan(Cache& cache) -> std::size_t {
+  const auto key = [](NodeId source, NodeId target) {
+    return *make_path_cache_key(
+      PathTraversalMode::FORWARD, VehicleType::SURFACE, source, target);
+  };
+  constexpr NodeId HOT_PAIRS = 40;
+  for (NodeId pair = 0; pair < HOT_PAIRS; ++pair) {
+    cache.insert(key(pair, 0), PathCacheIntervals{});
+    (void)cache.find(key(pair, 0));
+    (void)cache.find(key(pair, 0));
+  }
+  for (NodeId pair = 0; pair < 500; ++pair) {
+    cache.insert(key(pair, 1), PathCacheIntervals{});
+  }
+
+  std::size_t resident = 0;
+  for (NodeId pair = 0; pair < HOT_PAIRS; ++pair) {
+    resident += cache.find(key(pair, 0)).has_value() ? 1U : 0U;
+  }
+  return resident;
+}
+
+void test_path_cache_resists_one_off_scan() {
+  PathCache s3fifo(64, 1);
+  expect_eq(hot_keys_after_scan(s3fifo), std::size_t{40},
+            "S3-FIFO keeps hit pairs through a burst of one-off pairs");
+  const auto metrics = s3fifo.metrics();
+  expect_true(metrics.admission_rejects >= 400,
+              "one-off pairs are rejected from probation");
+  expect_eq(metrics.policy.promotions, std::uint64_t{40},
+            "hit pairs are promoted to main");
+
+  PackedKeyCache<PathCacheIntervals, ClockEviction> clock(64, 1);
+  expect_true(hot_keys_after_scan(clock) < 40,
+              "CLOCK lets the burst flush hit pairs");
+  expect_eq(clock.metrics().admission_rejects, std::uint64_t{0},
+            "CLOCK admits every entry");
+}
+
 void test_find_paths_shared_cache_is_thread_safe() {
   auto solver = std::make_shared<Solver>();
   std::vector<NodeId> nodes;
@@ -305,7 +980,7 @@ void test_find_paths_shared_cache_is_thread_safe() {
 
   for (int worker = 0; worker < worker_count; ++worker) {
     workers.emplace_back([solver, cache, worker, &failures]() {
-      auto wrapper = make_wrapper(solver, cache);
+      auto wrapper = make_wrapper(solver, {.path_cache = cache});
       std::vector<std::tuple<std::string, int32_t, std::string>> packages;
       packages.emplace_back("N31",
                             epoch_minutes("2026-06-08 18:00:00"),
@@ -322,7 +997,7 @@ void test_find_paths_shared_cache_is_thread_safe() {
           iso_to_date("2026-06-10 12:00:00"),
           DURATION{0},
           packages);
-        if (response.failed() || response.earliest.locations.empty()) {
+        if (response.failed() || response.earliest.empty()) {
           failures.fetch_add(1, std::memory_order_relaxed);
         }
       }
@@ -336,15 +1011,94 @@ void test_find_paths_shared_cache_is_thread_safe() {
   expect_true(metrics.misses > 0, "shared path cache records misses");
 }
 
+// The worker blocks in its task until a task it submits later has run, so
+// only the waiting thread can run that one: wait() has to wake on the
+// submission, then again on the group completing.
+void test_task_group_wait_wakes_on_submit_and_completion() {
+  WorkStealingExecutor executor(1);
+  WorkStealingExecutor::TaskGroup group(executor);
+  std::latch started(1);
+  std::atomic<bool> helped{false};
+  std::thread::id helper;
+  group.run([&] {
+    started.count_down();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    group.run([&] {
+      helper = std::this_thread::get_id();
+      helped.store(true);
+      helped.notify_all();
+    });
+    helped.wait(false);
+  });
+  started.wait();
+  group.wait();
+  expect_true(helped.load(), "task submitted while waiting ran");
+  expect_true(helper == std::this_thread::get_id(),
+              "waiting thread ran the task the busy worker submitted");
+}
+
+void test_blocking_queue_bulk_enqueue_respects_capacity() {
+  BlockingQueue<std::string> queue(4);
+  std::vector<std::string> payloads;
+  for (int index = 0; index < 10; ++index) {
+    payloads.push_back(std::format("payload-{}", index));
+  }
+
+  std::vector<std::string> received;
+  {
+    std::jthread producer([&queue, &payloads] {
+      expect_true(queue.wait_enqueue_bulk(std::span(payloads)),
+                  "bulk enqueue admits a batch larger than the capacity");
+      queue.close();
+    });
+    std::array<std::string, 3> batch;
+    while (true) {
+      const auto count =
+        queue.wait_dequeue_bulk(std::span(batch), std::stop_token{});
+      if (count == 0) {
+        break;
+      }
+      received.insert(received.end(),
+                      batch.begin(),
+                      batch.begin() + static_cast<std::ptrdiff_t>(count));
+    }
+  }
+  expect_eq(received.size(), std::size_t{10}, "bulk enqueue delivers all");
+  for (std::size_t index = 0; index < received.size(); ++index) {
+    expect_eq(received[index],
+              std::format("payload-{}", index),
+              "bulk enqueue keeps order");
+  }
+
+  std::vector<std::string> late{"late"};
+  expect_true(!queue.wait_enqueue_bulk(std::span(late)),
+              "bulk enqueue into a closed queue fails");
+  expect_eq(late.front(), std::string{"late"},
+            "rejected items stay with the caller");
+}
+
 } // namespace
 
 auto main() -> int {
   test_find_paths_non_critical_returns_earliest_and_ultimate();
   test_find_paths_critical_omits_ultimate();
   test_find_paths_missing_node_returns_fail();
+  test_find_paths_unreachable_pair_cached_until_graph_changes();
   test_find_paths_child_can_make_parent_critical();
   test_find_paths_source_processing_offset_can_make_critical();
   test_find_paths_mixed_bag_processing_can_make_parent_critical();
+  test_find_paths_fans_out_large_loads();
+  test_find_paths_cache_hit_shares_compact_path();
+  test_find_paths_cache_intervals_cover_later_starts();
+  test_find_paths_coalesces_concurrent_misses();
+  test_prefetcher_solves_next_interval_of_hot_pairs();
+  test_find_paths_continues_bag_itinerary_on_rescan();
+  test_path_cache_snapshot_round_trip();
+  test_path_cache_interval_merging();
+  test_path_cache_packed_keys_and_batched_lookup();
+  test_path_cache_resists_one_off_scan();
   test_find_paths_shared_cache_is_thread_safe();
+  test_blocking_queue_bulk_enqueue_respects_capacity();
+  test_task_group_wait_wakes_on_submit_and_completion();
   return 0;
 }
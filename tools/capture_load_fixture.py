@@ -7,8 +7,10 @@ import argparse
 import hashlib
 import json
 import os
+import struct
 import sys
 import time
+import zlib
 from typing import Any
 
 try:
@@ -18,6 +20,12 @@ except ImportError:  # pragma: no cover - exercised on production capture host
     KafkaException = Exception
 
 
+# Layout of moirai load captures (see modules/moirai.load_capture.cxx).
+CAPTURE_MAGIC = b"MOIRCAP1"
+CAPTURE_FRAME = struct.Struct("<B3xIII")
+CAPTURE_RECORD = struct.Struct("<qqiI")
+CAPTURE_FRAME_BYTES = 1 << 20
+
 ROUTING_FIELDS = (
     "id",
     "location",
@@ -93,6 +101,18 @@ def sanitize_payload(payload: Any, salt: str) -> dict[str, Any] | None:
     return output
 
 
+# A sanitized load with the Kafka timestamp (ms), partition and offset it was
+# consumed at.
+Record = tuple[dict[str, Any], tuple[int, int, int]]
+
+
+def message_position(message: Any) -> tuple[int, int, int]:
+    timestamp_type, timestamp = message.timestamp()
+    if timestamp_type == 0:  # TIMESTAMP_NOT_AVAILABLE
+        timestamp = -1
+    return timestamp, message.partition(), message.offset()
+
+
 def consumer_config(args: argparse.Namespace) -> dict[str, str]:
     config = {
         "bootstrap.servers": require_env("BROKER_URI"),
@@ -113,14 +133,48 @@ def consumer_config(args: argparse.Namespace) -> dict[str, str]:
     return config
 
 
-def write_output(path: str, records: list[dict[str, Any]], output_format: str) -> None:
+def write_capture_frame(handle: Any, raw: bytearray, records: int, compress: bool) -> None:
+    stored = bytes(raw)
+    codec = 0
+    if compress:
+        compressed = zlib.compress(stored, 1)
+        if len(compressed) < len(stored):
+            stored = compressed
+            codec = 1
+    handle.write(CAPTURE_FRAME.pack(codec, len(raw), len(stored), records))
+    handle.write(stored)
+
+
+def write_capture(path: str, records: list[Record], compress: bool) -> None:
+    with open(path, "wb") as handle:
+        handle.write(CAPTURE_MAGIC)
+        raw = bytearray()
+        count = 0
+        for record, (timestamp_ms, partition, offset) in records:
+            payload = json.dumps(record, sort_keys=True, separators=(",", ":")).encode("utf-8")
+            raw += CAPTURE_RECORD.pack(timestamp_ms, offset, partition, len(payload))
+            raw += payload
+            count += 1
+            if len(raw) >= CAPTURE_FRAME_BYTES:
+                write_capture_frame(handle, raw, count, compress)
+                raw = bytearray()
+                count = 0
+        if raw:
+            write_capture_frame(handle, raw, count, compress)
+
+
+def write_output(path: str, records: list[Record], output_format: str, compress: bool) -> None:
+    if output_format == "capture":
+        write_capture(path, records, compress)
+        return
+    payloads = [record for record, _ in records]
     with open(path, "w", encoding="utf-8") as handle:
         if output_format == "jsonl":
-            for record in records:
+            for record in payloads:
                 handle.write(json.dumps(record, sort_keys=True, separators=(",", ":")))
                 handle.write("\n")
         else:
-            json.dump(records, handle, indent=2, sort_keys=True)
+            json.dump(payloads, handle, indent=2, sort_keys=True)
             handle.write("\n")
 
 
@@ -128,12 +182,13 @@ def parse_args() -> argparse.Namespace:
     parser = argparse.ArgumentParser(description=__doc__)
     parser.add_argument("--topic", default=os.environ.get("LOAD_TOPIC"))
     parser.add_argument("--output", default="benchmarks/fixtures/production_loads.sanitized.jsonl")
-    parser.add_argument("--format", choices=("jsonl", "json"), default="jsonl")
+    parser.add_argument("--format", choices=("jsonl", "json", "capture"), default="jsonl")
     parser.add_argument("--max-records", type=int, default=100_000)
     parser.add_argument("--max-seconds", type=int, default=300)
     parser.add_argument("--poll-timeout", type=float, default=1.0)
     parser.add_argument("--hash-salt", default=os.environ.get("MOIRAI_FIXTURE_HASH_SALT", "moirai-fixture"))
     parser.add_argument("--group-id", default=None)
+    parser.add_argument("--compress", action="store_true", help="zlib-compress capture frames (smaller, slower to replay)")
     return parser.parse_args()
 
 
@@ -149,7 +204,7 @@ def main() -> int:
         raise SystemExit("--max-seconds must be positive")
 
     consumer = Consumer(consumer_config(args))
-    records: list[dict[str, Any]] = []
+    records: list[Record] = []
     deadline = time.monotonic() + args.max_seconds
     try:
         consumer.subscribe([args.topic])
@@ -165,12 +220,12 @@ def main() -> int:
                 continue
             sanitized = sanitize_payload(payload, args.hash_salt)
             if sanitized is not None:
-                records.append(sanitized)
+                records.append((sanitized, message_position(message)))
     finally:
         consumer.close()
 
     os.makedirs(os.path.dirname(args.output) or ".", exist_ok=True)
-    write_output(args.output, records, args.format)
+    write_output(args.output, records, args.format, args.compress)
     print(f"wrote {len(records)} sanitized load records to {args.output}", file=sys.stderr)
     return 0
 